@@ -0,0 +1,441 @@
+#include "HeapProfile.h"
+#include "../multitasking/UninterruptableSection.h"
+#include "../arithmetic/countLeadingZeros.h"
+
+#if defined(USE_HEAP_PROFILING)
+	// allocation statistics of the runtime heap
+	HeapProfile heapProfile;
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::recordAllocation
+//
+// Records that <size> bytes have been allocated from <pCallSite> and charges them to the current
+// task. <pBlock> must hold getBlockSize(<size>) bytes, the header is written to its front.
+// Returns the memory to hand out, behind the header.
+//------------------------------------------------------------------------------------------------
+
+void *HeapProfile::recordAllocation(void *pBlock, UInt size, const void *pCallSite)
+{
+	Header *pHeader = (Header *)pBlock;
+	const UInt32 callSiteHandle = (UInt32)subtractPointers(pCallSite, null);
+
+	// check if the RTOS has started
+	if(TaskScheduler::isInitialized())
+	{
+		// RTOS is running, charge the current task within a critical section
+		const UInt32 ownerHandle = (UInt32)subtractPointers(
+			TaskScheduler::getCurrentTaskScheduler()->getCurrentTask(),
+			null);
+		UninterruptableSection criticalSection;
+		appendAllocation(pHeader, size, ownerHandle, callSiteHandle);
+	}
+	else
+	{
+		// RTOS not yet started, there is no task to charge
+		appendAllocation(pHeader, size, 0, callSiteHandle);
+	}
+
+	return pHeader + 1;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::recordFree
+//
+// Records that the memory at <pMemory> has been freed and charges it back to its owner and call
+// site. Returns the block that was taken from the heap for it.
+//------------------------------------------------------------------------------------------------
+
+void *HeapProfile::recordFree(void *pMemory)
+{
+	Header *pHeader = (Header *)pMemory - 1;
+
+	// check if the RTOS has started
+	if(TaskScheduler::isInitialized())
+	{
+		// RTOS is running, charge back within a critical section
+		UninterruptableSection criticalSection;
+		appendFree(pHeader);
+	}
+	else
+	{
+		// RTOS not yet started, charge back without a critical section
+		appendFree(pHeader);
+	}
+
+	return pHeader;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::recordLargestFreeBlock
+//
+// Records that the largest block the heap can currently allocate holds <size> bytes.
+//------------------------------------------------------------------------------------------------
+
+void HeapProfile::recordLargestFreeBlock(UInt size)
+{
+	UninterruptableSection criticalSection;
+
+	totals.largestFreeBlock = size;
+	if(totals.smallestLargestFreeBlock == 0 || size < totals.smallestLargestFreeBlock)
+	{
+		totals.smallestLargestFreeBlock = size;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::releaseOwner
+//
+// Records that the task at <pOwner> is being destroyed, so that its owner entry can be used by
+// another task. The entry is kept until the blocks still charged to it have been freed.
+//------------------------------------------------------------------------------------------------
+
+void HeapProfile::releaseOwner(const void *pOwner)
+{
+	const UInt32 handle = (UInt32)subtractPointers(pOwner, null);
+	UninterruptableSection criticalSection;
+
+	// check if the task has an entry of its own
+	UInt8 *pFreeSlot;
+	UInt8 *pSlot = probeSlots(ownerSlots, log2NumberOfOwnerSlots, owners, handle, pFreeSlot);
+	if(pSlot == null)
+	{
+		return;
+	}
+
+	// a new task at the same address must get a new entry
+	const UInt index = *pSlot;
+	*pSlot = releasedSlot;
+	if(owners[index].liveBlocks == 0)
+	{
+		usedOwners &= ~(1u << index);
+	}
+	else
+	{
+		retiredOwners |= 1u << index;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::getTotals
+//
+// Copies the statistics of the whole heap to <totals>.
+//------------------------------------------------------------------------------------------------
+
+void HeapProfile::getTotals(Totals &totals) const
+{
+	UninterruptableSection criticalSection;
+	totals = this->totals;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::getSizeHistogram
+//
+// Copies the number of allocations counted in every bucket of the size histogram to
+// <pHistogram>, which must hold numberOfSizeBuckets counts.
+//------------------------------------------------------------------------------------------------
+
+void HeapProfile::getSizeHistogram(UInt32 *pHistogram) const
+{
+	UninterruptableSection criticalSection;
+	for(UInt bucket = 0; bucket < numberOfSizeBuckets; ++bucket)
+	{
+		pHistogram[bucket] = sizeHistogram[bucket];
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::getOwner
+//
+// Copies the statistics of the owner at <index> to <owner>. The handle of an owner is the
+// address of its task, the first owner has handle 0 and holds everything that could not be
+// charged to a task. The owners of destroyed tasks are only listed while they have live blocks.
+// Returns false if there is no owner at <index>.
+//------------------------------------------------------------------------------------------------
+
+Bool HeapProfile::getOwner(UInt index, Entry &owner) const
+{
+	UninterruptableSection criticalSection;
+
+	// skip the owners before <index>, released entries leave gaps in the table
+	UInt32 remainingOwners = usedOwners;
+	for(UInt skippedOwners = 0; skippedOwners < index && remainingOwners != 0; ++skippedOwners)
+	{
+		remainingOwners &= remainingOwners - 1;
+	}
+	if(remainingOwners == 0)
+	{
+		return false;
+	}
+	owner = owners[indexOfLowestSetBit(remainingOwners)];
+	return true;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::getCallSite
+//
+// Copies the statistics of the call site at <index> to <callSite>. The handle of a call site is
+// the return address of its call to the allocation function, the first call site has handle 0
+// and holds everything that could not be charged to a call site.
+// Returns false if there is no call site at <index>.
+//------------------------------------------------------------------------------------------------
+
+Bool HeapProfile::getCallSite(UInt index, Entry &callSite) const
+{
+	UninterruptableSection criticalSection;
+	return getEntry(callSites, numberOfCallSites, index, callSite);
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::getBucket
+//
+// Returns the bucket of the size histogram that counts allocations of <size> bytes.
+//------------------------------------------------------------------------------------------------
+
+UInt HeapProfile::getBucket(UInt size)
+{
+	UInt bucket = 0;
+	while(bucket < numberOfSizeBuckets - 1 && size > getBucketLimit(bucket))
+	{
+		++bucket;
+	}
+	return bucket;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::probeSlots
+//
+// Looks up <handle> in the hash table of <1 << log2NumberOfSlots> <pSlots>, which hold indices
+// into <pEntries>. Only maximumNumberOfProbes slots are looked at.
+// Returns the slot that holds the entry with <handle>, or null if there is none. <pFreeSlot> is
+// set to the first slot looked at that a new entry could be put in, or to null.
+//------------------------------------------------------------------------------------------------
+
+UInt8 *HeapProfile::probeSlots(
+	UInt8 *pSlots,
+	UInt log2NumberOfSlots,
+	const Entry *pEntries,
+	UInt32 handle,
+	UInt8 *&pFreeSlot)
+{
+	// start where the handle hashes to and move on through the following slots
+	const UInt slotMask = (1u << log2NumberOfSlots) - 1;
+	UInt slot = (UInt)((UInt32)(handle * 2654435761u) >> (32 - log2NumberOfSlots));
+	pFreeSlot = null;
+	for(UInt probe = 0; probe < maximumNumberOfProbes; ++probe)
+	{
+		UInt8 &slotEntry = pSlots[slot];
+		if(slotEntry == emptySlot)
+		{
+			// the handle would have been put in this slot or before
+			if(pFreeSlot == null)
+			{
+				pFreeSlot = &slotEntry;
+			}
+			return null;
+		}
+		else if(slotEntry == releasedSlot)
+		{
+			// the handle may still be in a later slot
+			if(pFreeSlot == null)
+			{
+				pFreeSlot = &slotEntry;
+			}
+		}
+		else if(pEntries[slotEntry].handle == handle)
+		{
+			return &slotEntry;
+		}
+		slot = (slot + 1) & slotMask;
+	}
+	return null;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::findOwner
+//
+// Returns the index of the owner entry with <handle>, adding the entry if it is new.
+// The first entry is kept for handle 0 and for the handles that do not fit.
+//------------------------------------------------------------------------------------------------
+
+UInt HeapProfile::findOwner(UInt32 handle)
+{
+	// keep the first entry for everything that cannot be charged elsewhere
+	if(usedOwners == 0)
+	{
+		clearEntry(owners[0], 0);
+		usedOwners = 1;
+	}
+	if(handle == 0)
+	{
+		return 0;
+	}
+
+	// search the known owners
+	UInt8 *pFreeSlot;
+	UInt8 *pSlot = probeSlots(ownerSlots, log2NumberOfOwnerSlots, owners, handle, pFreeSlot);
+	if(pSlot != null)
+	{
+		return *pSlot;
+	}
+
+	// add a new owner in the first unused entry if there is room
+	if(pFreeSlot == null || ~usedOwners == 0)
+	{
+		return 0;
+	}
+	const UInt index = indexOfLowestSetBit(~usedOwners);
+	usedOwners |= 1u << index;
+	clearEntry(owners[index], handle);
+	*pFreeSlot = (UInt8)index;
+	return index;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::findCallSite
+//
+// Returns the index of the call site entry with <handle>, adding the entry if it is new.
+// The first entry is kept for handle 0 and for the handles that do not fit.
+//------------------------------------------------------------------------------------------------
+
+UInt HeapProfile::findCallSite(UInt32 handle)
+{
+	// keep the first entry for everything that cannot be charged elsewhere
+	if(numberOfCallSites == 0)
+	{
+		clearEntry(callSites[0], 0);
+		numberOfCallSites = 1;
+	}
+	if(handle == 0)
+	{
+		return 0;
+	}
+
+	// search the known call sites
+	UInt8 *pFreeSlot;
+	UInt8 *pSlot = probeSlots(callSiteSlots, log2NumberOfCallSiteSlots, callSites, handle, pFreeSlot);
+	if(pSlot != null)
+	{
+		return *pSlot;
+	}
+
+	// add a new call site if there is room, call sites are never removed
+	if(pFreeSlot == null || numberOfCallSites == maximumNumberOfCallSites)
+	{
+		return 0;
+	}
+	clearEntry(callSites[numberOfCallSites], handle);
+	*pFreeSlot = (UInt8)numberOfCallSites;
+	return numberOfCallSites++;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::clearEntry
+//
+// Starts <entry> afresh for <handle>.
+//------------------------------------------------------------------------------------------------
+
+void HeapProfile::clearEntry(Entry &entry, UInt32 handle)
+{
+	entry.handle = handle;
+	entry.liveBytes = 0;
+	entry.peakLiveBytes = 0;
+	entry.liveBlocks = 0;
+	entry.numberOfAllocations = 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::chargeEntry
+//
+// Charges an allocation of <size> bytes to <entry>.
+//------------------------------------------------------------------------------------------------
+
+void HeapProfile::chargeEntry(Entry &entry, UInt size)
+{
+	entry.liveBytes += size;
+	if(entry.liveBytes > entry.peakLiveBytes)
+	{
+		entry.peakLiveBytes = entry.liveBytes;
+	}
+	++entry.liveBlocks;
+	++entry.numberOfAllocations;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::appendAllocation
+//
+// Fills in <pHeader> for an allocation of <size> bytes and charges it to the owner with
+// <ownerHandle> and the call site with <callSiteHandle>.
+//------------------------------------------------------------------------------------------------
+
+void HeapProfile::appendAllocation(
+	Header *pHeader,
+	UInt size,
+	UInt32 ownerHandle,
+	UInt32 callSiteHandle)
+{
+	// remember whom to charge back when the block is freed
+	pHeader->size = size;
+	pHeader->ownerIndex = (UInt16)findOwner(ownerHandle);
+	pHeader->callSiteIndex = (UInt16)findCallSite(callSiteHandle);
+
+	// charge the owner and the call site
+	chargeEntry(owners[pHeader->ownerIndex], size);
+	chargeEntry(callSites[pHeader->callSiteIndex], size);
+
+	// count the allocation for the whole heap
+	++sizeHistogram[getBucket(size)];
+	totals.liveBytes += size;
+	if(totals.liveBytes > totals.peakLiveBytes)
+	{
+		totals.peakLiveBytes = totals.liveBytes;
+	}
+	++totals.liveBlocks;
+	++totals.numberOfAllocations;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::appendFree
+//
+// Charges the block with <pHeader> back to its owner and call site.
+//------------------------------------------------------------------------------------------------
+
+void HeapProfile::appendFree(const Header *pHeader)
+{
+	Entry &owner = owners[pHeader->ownerIndex];
+	owner.liveBytes -= pHeader->size;
+	--owner.liveBlocks;
+
+	// the owner of a destroyed task goes with its last block
+	const UInt32 ownerBit = 1u << pHeader->ownerIndex;
+	if(owner.liveBlocks == 0 && (retiredOwners & ownerBit) != 0)
+	{
+		retiredOwners &= ~ownerBit;
+		usedOwners &= ~ownerBit;
+	}
+
+	Entry &callSite = callSites[pHeader->callSiteIndex];
+	callSite.liveBytes -= pHeader->size;
+	--callSite.liveBlocks;
+
+	totals.liveBytes -= pHeader->size;
+	--totals.liveBlocks;
+	++totals.numberOfFrees;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::getEntry
+//
+// Copies the entry at <index> of <pEntries> to <entry>.
+// Returns false if there is no entry at <index>.
+//------------------------------------------------------------------------------------------------
+
+Bool HeapProfile::getEntry(const Entry *pEntries, UInt numberOfEntries, UInt index, Entry &entry)
+{
+	if(index >= numberOfEntries)
+	{
+		return false;
+	}
+	entry = pEntries[index];
+	return true;
+}
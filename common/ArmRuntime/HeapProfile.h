@@ -0,0 +1,145 @@
+#ifndef _HeapProfile_h_
+#define _HeapProfile_h_
+
+#include "../cPrimitiveTypes.h"
+#include "../pointerArithmetic.h"
+
+// the address an allocation function was called from
+#if defined(__ARMCC_VERSION)
+	#define HEAP_PROFILE_CALL_SITE() ((const void *)__return_address())
+#elif defined(__GNUC__)
+	#define HEAP_PROFILE_CALL_SITE() ((const void *)__builtin_return_address(0))
+#else
+	#define HEAP_PROFILE_CALL_SITE() ((const void *)null)
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * class HeapProfile
+//
+// Keeps statistics of the allocations made through the runtime heap: a histogram of the
+// allocated sizes, the live bytes of every owning task and of every call site, the peak usage
+// and the smallest largest free block seen so far.
+// Every block carries a small header in front of the memory handed out, which names the owner
+// and call site that the block is charged to, so that a free is charged back in constant time.
+// Owners and call sites are kept in small tables, allocations by tasks or call sites that do
+// not fit are charged to the first entry, which also holds the allocations made before the
+// RTOS was started. Entries are looked up through a hash table of entry indices that is
+// probed at most maximumNumberOfProbes times, so that recording takes constant time with
+// interrupts disabled.
+// A task releases its owner entry when it is destroyed. An entry that still has live blocks
+// is kept, under the handle of the destroyed task, until the last of them is freed.
+// There is no constructor because allocations can be made before static construction.
+//------------------------------------------------------------------------------------------------
+
+class HeapProfile
+{
+public:
+	// geometry
+	enum
+	{
+		numberOfSizeBuckets = 16,
+		maximumNumberOfOwners = 32, // one bit each in usedOwners and retiredOwners
+		maximumNumberOfCallSites = 64,
+		maximumNumberOfProbes = 8,
+		log2NumberOfOwnerSlots = 6,
+		log2NumberOfCallSiteSlots = 7
+	};
+
+	// types
+	struct Header
+	{
+		UInt32 size;
+		UInt16 ownerIndex;
+		UInt16 callSiteIndex;
+	};
+	struct Totals
+	{
+		UInt32 liveBytes;
+		UInt32 peakLiveBytes;
+		UInt32 liveBlocks;
+		UInt32 numberOfAllocations;
+		UInt32 numberOfFrees;
+		UInt32 largestFreeBlock;
+		UInt32 smallestLargestFreeBlock;
+	};
+	struct Entry
+	{
+		UInt32 handle;
+		UInt32 liveBytes;
+		UInt32 peakLiveBytes;
+		UInt32 liveBlocks;
+		UInt32 numberOfAllocations;
+	};
+
+	// recording
+	static inline UInt getBlockSize(UInt size);
+	void *recordAllocation(void *pBlock, UInt size, const void *pCallSite);
+	void *recordFree(void *pMemory);
+	void recordLargestFreeBlock(UInt size);
+	void releaseOwner(const void *pOwner);
+
+	// querying
+	void getTotals(Totals &totals) const;
+	void getSizeHistogram(UInt32 *pHistogram) const;
+	Bool getOwner(UInt index, Entry &owner) const;
+	Bool getCallSite(UInt index, Entry &callSite) const;
+	static inline UInt getBucketLimit(UInt bucket);
+
+private:
+	// hash table slots that do not hold an entry index
+	enum
+	{
+		emptySlot = 0,
+		releasedSlot = 0xFF
+	};
+
+	// recording
+	static UInt getBucket(UInt size);
+	static UInt8 *probeSlots(UInt8 *pSlots, UInt log2NumberOfSlots, const Entry *pEntries,
+		UInt32 handle, UInt8 *&pFreeSlot);
+	UInt findOwner(UInt32 handle);
+	UInt findCallSite(UInt32 handle);
+	static void clearEntry(Entry &entry, UInt32 handle);
+	static void chargeEntry(Entry &entry, UInt size);
+	void appendAllocation(Header *pHeader, UInt size, UInt32 ownerHandle, UInt32 callSiteHandle);
+	void appendFree(const Header *pHeader);
+
+	// querying
+	static Bool getEntry(const Entry *pEntries, UInt numberOfEntries, UInt index, Entry &entry);
+
+	// representation
+	Totals totals;
+	UInt32 sizeHistogram[numberOfSizeBuckets];
+	UInt32 usedOwners;
+	UInt32 retiredOwners;
+	UInt numberOfCallSites;
+	Entry owners[maximumNumberOfOwners];
+	Entry callSites[maximumNumberOfCallSites];
+	UInt8 ownerSlots[1 << log2NumberOfOwnerSlots];
+	UInt8 callSiteSlots[1 << log2NumberOfCallSiteSlots];
+};
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::getBlockSize
+//
+// Returns the number of bytes to take from the heap for an allocation of <size> bytes.
+//------------------------------------------------------------------------------------------------
+
+inline UInt HeapProfile::getBlockSize(UInt size)
+{
+	return size + sizeof(Header);
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapProfile::getBucketLimit
+//
+// Returns the largest size that is counted in <bucket> of the size histogram, the last bucket
+// counts all larger sizes as well.
+//------------------------------------------------------------------------------------------------
+
+inline UInt HeapProfile::getBucketLimit(UInt bucket)
+{
+	return 8u << bucket;
+}
+
+#endif // _HeapProfile_h_
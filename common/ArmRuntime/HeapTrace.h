@@ -0,0 +1,149 @@
+#ifndef _HeapTrace_h_
+#define _HeapTrace_h_
+
+#include "../cPrimitiveTypes.h"
+#include "../pointerArithmetic.h"
+#include "../multitasking/UninterruptableSection.h"
+
+#if !defined(HEAP_TRACE_LENGTH)
+	#define HEAP_TRACE_LENGTH 8192
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * class HeapTrace
+//
+// Records the allocations and frees made through the runtime heap, in order, so that they can
+// be read from the target and replayed on the host by heapBenchmark.
+// A record holds the address and size of an allocation, or the address and a zero size for a
+// free. Recording stops when the trace is full so that every replayed free has its allocation.
+// There is no constructor because allocations can be made before static construction.
+//------------------------------------------------------------------------------------------------
+
+class HeapTrace
+{
+public:
+	// types
+	struct Record
+	{
+		UInt32 address;
+		UInt32 size;
+	};
+
+	// recording
+	inline void recordAllocation(const void *pMemory, UInt size);
+	inline void recordFree(const void *pMemory);
+
+	// querying
+	inline const Record *getRecords() const;
+	inline UInt getNumberOfRecords() const;
+	inline UInt getNumberOfDroppedRecords() const;
+
+private:
+	// recording
+	inline void addRecord(const void *pMemory, UInt size);
+	inline void appendRecord(const void *pMemory, UInt size);
+
+	// representation
+	UInt numberOfRecords;
+	UInt numberOfDroppedRecords;
+	Record records[HEAP_TRACE_LENGTH];
+};
+
+//------------------------------------------------------------------------------------------------
+// * HeapTrace::recordAllocation
+//
+// Records that <size> bytes have been allocated at <pMemory>.
+//------------------------------------------------------------------------------------------------
+
+inline void HeapTrace::recordAllocation(const void *pMemory, UInt size)
+{
+	addRecord(pMemory, size);
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapTrace::recordFree
+//
+// Records that the block at <pMemory> has been freed.
+//------------------------------------------------------------------------------------------------
+
+inline void HeapTrace::recordFree(const void *pMemory)
+{
+	addRecord(pMemory, 0);
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapTrace::getRecords
+//
+// Returns the records made so far.
+//------------------------------------------------------------------------------------------------
+
+inline const HeapTrace::Record *HeapTrace::getRecords() const
+{
+	return records;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapTrace::getNumberOfRecords
+//
+// Returns the number of records made so far.
+//------------------------------------------------------------------------------------------------
+
+inline UInt HeapTrace::getNumberOfRecords() const
+{
+	return numberOfRecords;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapTrace::getNumberOfDroppedRecords
+//
+// Returns the number of allocations and frees that did not fit into the trace.
+//------------------------------------------------------------------------------------------------
+
+inline UInt HeapTrace::getNumberOfDroppedRecords() const
+{
+	return numberOfDroppedRecords;
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapTrace::addRecord
+//
+// Appends a record of <pMemory> and <size> atomically.
+//------------------------------------------------------------------------------------------------
+
+inline void HeapTrace::addRecord(const void *pMemory, UInt size)
+{
+	// check if the RTOS has started
+	if(TaskScheduler::isInitialized())
+	{
+		// RTOS is running, append within a critical section
+		UninterruptableSection criticalSection;
+		appendRecord(pMemory, size);
+	}
+	else
+	{
+		// RTOS not yet started, append without a critical section
+		appendRecord(pMemory, size);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * HeapTrace::appendRecord
+//
+// Appends a record of <pMemory> and <size>, if there is room.
+//------------------------------------------------------------------------------------------------
+
+inline void HeapTrace::appendRecord(const void *pMemory, UInt size)
+{
+	if(numberOfRecords < HEAP_TRACE_LENGTH)
+	{
+		records[numberOfRecords].address = (UInt32)subtractPointers(pMemory, null);
+		records[numberOfRecords].size = size;
+		++numberOfRecords;
+	}
+	else
+	{
+		++numberOfDroppedRecords;
+	}
+}
+
+#endif // _HeapTrace_h_
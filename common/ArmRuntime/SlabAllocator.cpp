@@ -0,0 +1,173 @@
+#include "SlabAllocator.h"
+#include "../multitasking/UninterruptableSection.h"
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::blockSizes
+//
+// The block size of every size class.
+//------------------------------------------------------------------------------------------------
+
+const UInt16 SlabAllocator::blockSizes[numberOfSizeClasses] =
+{
+	8, 16, 24, 32, 48, 64, 96, 128, 192, 256
+};
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::sizeClassesOfGranules
+//
+// The smallest size class that can hold the given number of granules.
+//------------------------------------------------------------------------------------------------
+
+const UInt8 SlabAllocator::sizeClassesOfGranules[maximumBlockSize / granularity + 1] =
+{
+	0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+	8, 8, 8, 8, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9, 9
+};
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::initialize
+//
+// Takes the pages from <arenaSize> bytes at <pArena>. All free lists start out empty.
+//------------------------------------------------------------------------------------------------
+
+void SlabAllocator::initialize(void *pArena, UInt arenaSize)
+{
+	// align the arena to the granularity and use whole pages only
+	const UInt alignment = (granularity - (UInt)subtractPointers(pArena, null) % granularity) % granularity;
+	const UInt numberOfPages = arenaSize > alignment
+		? minimum((arenaSize - alignment) / pageSize, (UInt)maximumNumberOfPages)
+		: 0;
+	this->pArena = addToPointer((UInt8 *)pArena, alignment);
+	pArenaLimit = addToPointer(this->pArena, numberOfPages * pageSize);
+
+	numberOfUsedPages = 0;
+	allocatedSize = 0;
+	for(UInt sizeClass = 0; sizeClass < numberOfSizeClasses; ++sizeClass)
+	{
+		freeLists[sizeClass] = null;
+		carvePositions[sizeClass] = null;
+		carveLimits[sizeClass] = null;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::allocate
+//
+// Allocates a block of at least <size> bytes.
+// Returns null if <size> is too large for the slabs or the arena has run out of pages.
+//------------------------------------------------------------------------------------------------
+
+void *SlabAllocator::allocate(UInt size)
+{
+	if(size > maximumBlockSize)
+	{
+		return null;
+	}
+	const UInt sizeClass = sizeClassesOfGranules[(size + granularity - 1) / granularity];
+
+	// check if the RTOS has started
+	if(TaskScheduler::isInitialized())
+	{
+		// RTOS is running, allocate within a critical section
+		UninterruptableSection criticalSection;
+		return allocateBlock(sizeClass);
+	}
+	else
+	{
+		// RTOS not yet started, allocate without a critical section
+		return allocateBlock(sizeClass);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::deallocate
+//
+// Deallocates the block at <pMemory>, which must have been allocated from the slabs.
+//------------------------------------------------------------------------------------------------
+
+void SlabAllocator::deallocate(void *pMemory)
+{
+	// check if the RTOS has started
+	if(TaskScheduler::isInitialized())
+	{
+		// RTOS is running, deallocate within a critical section
+		UninterruptableSection criticalSection;
+		deallocateBlock(pMemory);
+	}
+	else
+	{
+		// RTOS not yet started, deallocate without a critical section
+		deallocateBlock(pMemory);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::allocateBlock
+//
+// Takes a block of the given <sizeClass> from its free list, or carves a new one.
+// Returns null if the arena has run out of pages.
+//------------------------------------------------------------------------------------------------
+
+void *SlabAllocator::allocateBlock(UInt sizeClass)
+{
+	const UInt blockSize = blockSizes[sizeClass];
+
+	// reuse a freed block if there is one
+	FreeBlock *pBlock = freeLists[sizeClass];
+	if(pBlock != null)
+	{
+		freeLists[sizeClass] = pBlock->pNext;
+	}
+	else
+	{
+		// carve a new block, starting another page if the current one is used up
+		if(subtractPointers(carveLimits[sizeClass], carvePositions[sizeClass]) < (SInt)blockSize
+			&& !addPage(sizeClass))
+		{
+			return null;
+		}
+		pBlock = (FreeBlock *)carvePositions[sizeClass];
+		carvePositions[sizeClass] += blockSize;
+	}
+
+	allocatedSize += blockSize;
+	return pBlock;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::deallocateBlock
+//
+// Puts the block at <pMemory> onto the free list of the size class of its page.
+//------------------------------------------------------------------------------------------------
+
+void SlabAllocator::deallocateBlock(void *pMemory)
+{
+	const UInt sizeClass = pageSizeClasses[subtractPointers(pMemory, pArena) >> pageBits];
+
+	FreeBlock *pBlock = (FreeBlock *)pMemory;
+	pBlock->pNext = freeLists[sizeClass];
+	freeLists[sizeClass] = pBlock;
+
+	allocatedSize -= blockSizes[sizeClass];
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::addPage
+//
+// Takes the next page from the arena and makes it the current page of <sizeClass>.
+// Returns false if there are no pages left.
+//------------------------------------------------------------------------------------------------
+
+Bool SlabAllocator::addPage(UInt sizeClass)
+{
+	UInt8 *pPage = addToPointer(pArena, numberOfUsedPages * pageSize);
+	if(pPage >= pArenaLimit)
+	{
+		return false;
+	}
+
+	pageSizeClasses[numberOfUsedPages++] = (UInt8)sizeClass;
+	carvePositions[sizeClass] = pPage;
+	carveLimits[sizeClass] = addToPointer(pPage, pageSize);
+	return true;
+}
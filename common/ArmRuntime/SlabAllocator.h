@@ -0,0 +1,121 @@
+#ifndef _SlabAllocator_h_
+#define _SlabAllocator_h_
+
+#include "../cPrimitiveTypes.h"
+#include "../pointerArithmetic.h"
+
+//------------------------------------------------------------------------------------------------
+// * class SlabAllocator
+//
+// Allocates small blocks from pages of an arena, in front of the runtime heap.
+// Every page holds blocks of a single size class, so a block is found, and its size class looked
+// up, in constant time. Freed blocks go onto a free list per size class, blocks that have never
+// been used are carved from the current page of their size class.
+// The lists are only briefly protected by an uninterruptable section, the heap mutex is not
+// needed. Pages are never given back to the arena, requests that the slabs cannot satisfy
+// return null so that the caller can fall back to the heap.
+// There is no constructor because the allocator can be initialized before static construction.
+//------------------------------------------------------------------------------------------------
+
+class SlabAllocator
+{
+public:
+	// geometry
+	enum
+	{
+		granularity = 8,
+		maximumBlockSize = 256,
+		pageBits = 10,
+		pageSize = 1 << pageBits,
+		maximumNumberOfPages = 256,
+		numberOfSizeClasses = 10
+	};
+
+	// initialization
+	void initialize(void *pArena, UInt arenaSize);
+
+	// testing
+	inline Bool contains(const void *pMemory) const;
+
+	// allocating
+	void *allocate(UInt size);
+	void deallocate(void *pMemory);
+
+	// statistics
+	inline UInt getArenaSize() const;
+	inline UInt getUsedArenaSize() const;
+	inline UInt getAllocatedSize() const;
+
+private:
+	// types
+	struct FreeBlock
+	{
+		FreeBlock *pNext;
+	};
+
+	// allocating
+	void *allocateBlock(UInt sizeClass);
+	void deallocateBlock(void *pMemory);
+	Bool addPage(UInt sizeClass);
+
+	// size classes
+	static const UInt16 blockSizes[numberOfSizeClasses];
+	static const UInt8 sizeClassesOfGranules[maximumBlockSize / granularity + 1];
+
+	// representation
+	UInt8 *pArena;
+	UInt8 *pArenaLimit;
+	UInt numberOfUsedPages;
+	UInt allocatedSize;
+	FreeBlock *freeLists[numberOfSizeClasses];
+	UInt8 *carvePositions[numberOfSizeClasses];
+	UInt8 *carveLimits[numberOfSizeClasses];
+	UInt8 pageSizeClasses[maximumNumberOfPages];
+};
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::contains
+//
+// Tests whether <pMemory> was allocated from the slabs.
+//------------------------------------------------------------------------------------------------
+
+inline Bool SlabAllocator::contains(const void *pMemory) const
+{
+	return pMemory >= pArena && pMemory < pArenaLimit;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::getArenaSize
+//
+// Returns the number of bytes in the arena that can be used for pages.
+//------------------------------------------------------------------------------------------------
+
+inline UInt SlabAllocator::getArenaSize() const
+{
+	return subtractPointers(pArenaLimit, pArena);
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::getUsedArenaSize
+//
+// Returns the number of bytes in the pages that have been taken from the arena.
+//------------------------------------------------------------------------------------------------
+
+inline UInt SlabAllocator::getUsedArenaSize() const
+{
+	return numberOfUsedPages * pageSize;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlabAllocator::getAllocatedSize
+//
+// Returns the number of bytes in the blocks that are currently allocated, rounded up to their
+// size classes.
+//------------------------------------------------------------------------------------------------
+
+inline UInt SlabAllocator::getAllocatedSize() const
+{
+	return allocatedSize;
+}
+
+#endif // _SlabAllocator_h_
@@ -106,6 +106,19 @@
 #define Heap_Realloc            __Heap7_Realloc
 #define Heap_Stats              __Heap7_Stats
 #define Heap_TraceAlloc         __Heap7_TraceAlloc
+#elif HEAPTYPE==8
+#ifndef _HEAP8_H
+#  include "heap8.h"
+#endif
+#define Heap_Descriptor         Heap8_Descriptor
+#define Heap_Initialise         __Heap8_Initialise
+#define Heap_InitMemory         __Heap8_ProvideMemory
+#define Heap_ProvideMemory      __Heap8_ProvideMemory
+#define Heap_Alloc              __Heap8_Alloc
+#define Heap_Free               __Heap8_Free
+#define Heap_Realloc            __Heap8_Realloc
+#define Heap_Stats              __Heap8_Stats
+#define Heap_TraceAlloc         __Heap8_TraceAlloc
 #endif
 
 /* End of file heap.h */
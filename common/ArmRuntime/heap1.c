@@ -120,6 +120,7 @@ extern void *__Heap1_Alloc(Heap1_Descriptor *h, size_t size)
              rover != NULL;
              prev = rover, rover = prev->next)
         {
+            Heap_CountStep();
             if (rover->size >= size)
             {
                 /* Block large enough for job */
@@ -161,6 +162,7 @@ extern void *__Heap1_Alloc(Heap1_Descriptor *h, size_t size)
         Heap1_FreeBlock *rover = prev->next;
         do
         {
+            Heap_CountStep();
             if (rover != NULL)
             {
                 if (rover->size >= size)
@@ -221,6 +223,7 @@ extern void *__Heap1_Alloc(Heap1_Descriptor *h, size_t size)
              rover != NULL;
              prev = rover, rover = prev->next)
         {
+            Heap_CountStep();
             if (rover->size >= size)
             {
                 /* Block large enough for job */
@@ -314,7 +317,7 @@ extern void __Heap1_Free(Heap1_Descriptor *h, void *_blk)
     for (prev = &h->freechain, rover = prev->next;
          rover != NULL && rover < blk;
          prev = rover, rover = prev->next)
-        continue;
+        Heap_CountStep();
 
     /* Check for merging with the block before blk */
     if ((char *)prev + prev->size == (char *)blk)
@@ -383,7 +386,7 @@ void *__Heap1_Realloc(Heap1_Descriptor *h, void *_blk, size_t size)
     for (prev = &h->freechain, rover = prev->next;
          rover != NULL && rover < blk;
          prev = rover, rover = prev->next)
-        continue;
+        Heap_CountStep();
 
     if ((char *)blk + blk->size == (char *)rover && blk->size + rover->size >= size)
     {
@@ -436,6 +439,7 @@ void *__Heap1_Stats(int (*dprint)(char const *format, ...), Heap1_Descriptor *h)
     size_t size;
     char *hwm = NULL;
     size_t totsize = 0;
+    size_t largest = 0;
     int numblocks = 0;
 
     for (i = 0; i < 32; i++)
@@ -452,6 +456,10 @@ void *__Heap1_Stats(int (*dprint)(char const *format, ...), Heap1_Descriptor *h)
         numblocks += 1;
         size = rover->size;
         totsize += size;
+        if (size > largest)
+        {
+            largest = size;
+        }
         for (i = 0; i < 32; i++)
         {
             size >>= 1;
@@ -463,7 +471,8 @@ void *__Heap1_Stats(int (*dprint)(char const *format, ...), Heap1_Descriptor *h)
         sizecount[i]++;
     }
 
-    dprint("%d bytes in %d free blocks (avge size %d)\n", totsize, numblocks, totsize/(numblocks==0?1:numblocks));
+    dprint(HEAP_STATS_SUMMARY, (int)totsize, numblocks, (int)(totsize/(numblocks==0?1:numblocks)),
+           (int)largest);
     for (i = 0; i < 32; i++)
     {
         if (sizecount[i] != 0)
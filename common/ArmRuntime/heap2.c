@@ -485,6 +485,7 @@ extern void *__Heap2_Stats(int (*dprint)(char const *format, ...), Heap2_Descrip
 {
     Heap2_FreeBlock *rover;
     size_t totsize;
+    size_t largest;
     int numblocks;
     int sizecount[32];
     int i;
@@ -493,6 +494,7 @@ extern void *__Heap2_Stats(int (*dprint)(char const *format, ...), Heap2_Descrip
 
     hwm = 0;
     totsize = 0;
+    largest = 0;
     numblocks = 0;
 
     for (i = 0; i < 32; i++)
@@ -509,6 +511,10 @@ extern void *__Heap2_Stats(int (*dprint)(char const *format, ...), Heap2_Descrip
         numblocks += 1;
         size = rover->size;
         totsize += size;
+        if ((size & ~Heap2_FreeMark) > largest)
+        {
+            largest = size & ~Heap2_FreeMark;
+        }
         for (i = 0; i < 32; i++)
         {
             size >>= 1;
@@ -520,8 +526,8 @@ extern void *__Heap2_Stats(int (*dprint)(char const *format, ...), Heap2_Descrip
         sizecount[i]++;
     }
 
-    dprint("%d bytes in %d free blocks (avge size %d)\n",
-           totsize, numblocks, totsize/(numblocks==0?1:numblocks) );
+    dprint(HEAP_STATS_SUMMARY,
+           (int)totsize, numblocks, (int)(totsize/(numblocks==0?1:numblocks)), (int)largest );
     for (i = 0; i < 32; i++)
     {
         if (sizecount[i] != 0)
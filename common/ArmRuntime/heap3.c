@@ -187,13 +187,13 @@ static void Heap3_TreeInitialise(Heap3_Tree *t,Heap3_Node *n,
  */
 static int Heap3_CompareSize(Heap3_FreeBlock const *a, Heap3_FreeBlock const *b)
 {
-    int res = (int)a->size - (int)b->size;
-    if (res != 0)
+    if (a->size != b->size)
     {
-        return res;
+        return a->size < b->size ? -1 : 1;
     }
 
-    return (int)a - (int)b;
+    /* compare rather than subtract, the difference of two addresses need not fit in an int */
+    return a < b ? -1 : (a > b ? 1 : 0);
 }
 
 
@@ -203,7 +203,7 @@ static int Heap3_CompareSize(Heap3_FreeBlock const *a, Heap3_FreeBlock const *b)
  */
 static int Heap3_CompareAddress(Heap3_FreeBlock const *a, Heap3_FreeBlock const *b)
 {
-    return (int)a - (int)b;
+    return a < b ? -1 : (a > b ? 1 : 0);
 }
 
 
@@ -1047,6 +1047,7 @@ typedef struct Heap3_StatsBlk
 {
     char *hwm;
     size_t totsize;
+    size_t largest;
     int numblocks;
     int sizecount[32];
 } Heap3_StatsBlk;
@@ -1069,6 +1070,10 @@ static void Heap3_AccumulateBlock(void *param, Heap3_FreeBlock *blk)
     stats->numblocks += 1;
     size = blk->size;
     stats->totsize += size;
+    if (size > stats->largest)
+    {
+        stats->largest = size;
+    }
     for (i = 0; i < 32; i++)
     {
         size >>= 1;
@@ -1092,6 +1097,7 @@ extern void *__Heap3_Stats(int (*dprint)(char const *format, ...), Heap3_Descrip
 
     stats.hwm = 0;
     stats.totsize = 0;
+    stats.largest = 0;
     stats.numblocks = 0;
 
     for (i = 0; i < 32; i++)
@@ -1101,8 +1107,9 @@ extern void *__Heap3_Stats(int (*dprint)(char const *format, ...), Heap3_Descrip
 
     Heap3_NodeEnumerate( Heap3_AccumulateBlock, &stats, h->free_byaddress.root );
 
-    dprint("%d bytes in %d free blocks (avge size %d)\n",
-           stats.totsize, stats.numblocks, stats.totsize/(stats.numblocks==0?1:stats.numblocks));
+    dprint(HEAP_STATS_SUMMARY,
+           (int)stats.totsize, stats.numblocks,
+           (int)(stats.totsize/(stats.numblocks==0?1:stats.numblocks)), (int)stats.largest);
     for (i = 0; i < 32; i++)
     {
         if (stats.sizecount[i] != 0)
@@ -333,7 +333,7 @@ extern void __Heap4_Free(Heap4_Descriptor *h, void *_blk)
         bkt->link.next = (Heap4_Link *)&ch->used.marker;
         bkt->link.prev->next = ch->used.prev = &bkt->link;
     }
-    else if (bkt->usedcount == NULL)
+    else if (bkt->usedcount == 0)
     {
         /* Now empty - move from used list to empty list tail */
         bkt->link.prev->next = bkt->link.next;
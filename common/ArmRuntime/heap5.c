@@ -81,7 +81,7 @@ extern void __Heap5_ProvideMemory(Heap5_Descriptor *h, void *_blk, size_t size)
  */
 void __Heap5_MarkBlock(Heap5_AllocedBlock *blk, size_t size)
 {
-    int i;
+    size_t i;
 
     blk->startmark = Heap5_MarkerValue;
     blk->endmark = (Heap5_Marker *)((char *)(blk+1) + size);
@@ -139,7 +139,7 @@ extern void *__Heap5_TraceAlloc(Heap5_Descriptor *h, size_t size, char const *f,
  */
 void __Heap5_CheckBlock(Heap5_Descriptor *h, Heap5_AllocedBlock *blk)
 {
-    int i;
+    size_t i;
     int broken = 0;
 
     /* Check start mark */
@@ -955,6 +955,7 @@ void *__Heap7_Stats
 {
         Heap7_Block *rover;
         size_t totsize;
+        size_t largest;
         int numblocks;
         int sizecount[32];
         int i;
@@ -964,6 +965,7 @@ void *__Heap7_Stats
 
         hwm = 0;
         totsize = 0;
+        largest = 0;
         numblocks = 0;
 
         for ( i = 0; i < 32; i++ )
@@ -983,6 +985,10 @@ void *__Heap7_Stats
                         numblocks += 1;
                         size = rover->size;
                         totsize += size;
+                        if ( size > largest )
+                        {
+                                largest = size;
+                        }
                         for ( i = 0; i < 32; i++ )
                         {
                                 size >>= 1;
@@ -995,7 +1001,7 @@ void *__Heap7_Stats
                 }
         }
 
-        dprint( "%d bytes in %d free blocks (avge size %d)\n", totsize, numblocks, totsize/(numblocks==0?1:numblocks) );
+        dprint( HEAP_STATS_SUMMARY, (int)totsize, numblocks, (int)(totsize/(numblocks==0?1:numblocks)), (int)largest );
         for ( i = 0; i < 32; i++ )
         {
                 if ( sizecount[i] )
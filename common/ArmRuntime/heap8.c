@@ -0,0 +1,665 @@
+/*
+ * heap8.c
+ */
+
+ /* Code for a type (8) two level segregated fit heap
+
+The Heap8 algorithm:
+* The heap block structure:
+        Alloced                 Free
+        (prevphys)              (prevphys)
+        size                    size
+        <user>                  nextfree
+                                prevfree
+                                <unused>
+* Free blocks are kept in doubly linked lists, one list for each range of
+        sizes. A first level bitmap shows which powers of two have free
+        blocks and a second level bitmap for each power of two shows which
+        of its lists have free blocks.
+* Allocation rounds the size up to the start of the next range so that
+        the first block of any list that is found by the bitmaps is large
+        enough (good fit). The block is split and the remainder freed.
+* Blocks are merged with their free physical neighbours as soon as they
+        are freed (immediate coalescing).
+* Allocation and freeing take a bounded number of steps, however many
+        blocks there are and however fragmented the heap is.
+* Provided blocks may be anywhere, each ends with a used zero sized
+        sentinel block so that blocks are never merged across them.
+* Allocations larger than 1 << HEAP8_FL_MAX bytes fail.
+
+*/
+
+#include "heap8.h"
+#include <string.h>
+
+#define Heap8_FreeBit           1U
+#define Heap8_PrevFreeBit       2U
+#define Heap8_FlagBits          (Heap8_FreeBit | Heap8_PrevFreeBit)
+
+/* the size word that a used block adds to the user size */
+#define Heap8_Overhead          sizeof(size_t)
+
+/* offset from the start of a block to its user memory */
+#define Heap8_UserOffset        (sizeof(Heap8_Block *) + sizeof(size_t))
+
+/* smallest size that holds the free list links and the next block's prevphys */
+#define Heap8_MinimumSize       (sizeof(Heap8_Block) - sizeof(Heap8_Block *))
+#define Heap8_MaximumSize       ((size_t)1 << HEAP8_FL_MAX)
+
+
+/* <Heap8_LastBit>
+ * Return the index of the most significant set bit of a non-zero word.
+ * ARMv4 has no count leading zeros instruction, so search in five steps.
+ */
+static inline int Heap8_LastBit(unsigned int word)
+{
+#if defined(__GNUC__)
+    return 31 - __builtin_clz(word);
+#else
+    int bit = 31;
+    if ((word & 0xffff0000) == 0)
+    {
+        word <<= 16;
+        bit -= 16;
+    }
+    if ((word & 0xff000000) == 0)
+    {
+        word <<= 8;
+        bit -= 8;
+    }
+    if ((word & 0xf0000000) == 0)
+    {
+        word <<= 4;
+        bit -= 4;
+    }
+    if ((word & 0xc0000000) == 0)
+    {
+        word <<= 2;
+        bit -= 2;
+    }
+    if ((word & 0x80000000) == 0)
+    {
+        bit -= 1;
+    }
+    return bit;
+#endif
+}
+
+
+/* <Heap8_FirstBit>
+ * Return the index of the least significant set bit of a non-zero word.
+ */
+static inline int Heap8_FirstBit(unsigned int word)
+{
+    return Heap8_LastBit(word & (0U - word));
+}
+
+
+/* <Heap8_Size>
+ * Return the number of bytes in a block, not counting the size word
+ */
+static inline size_t Heap8_Size(const Heap8_Block *blk)
+{
+    return blk->size & ~(size_t)Heap8_FlagBits;
+}
+
+
+/* <Heap8_SetSize>
+ * Set the number of bytes in a block, keeping its flags
+ */
+static inline void Heap8_SetSize(Heap8_Block *blk, size_t size)
+{
+    blk->size = size | (blk->size & Heap8_FlagBits);
+}
+
+
+/* <Heap8_UserToBlock>
+ * Return the block of some user memory
+ */
+static inline Heap8_Block *Heap8_UserToBlock(void *_blk)
+{
+    return (Heap8_Block *)((char *)_blk - Heap8_UserOffset);
+}
+
+
+/* <Heap8_BlockToUser>
+ * Return the user memory of a block
+ */
+static inline void *Heap8_BlockToUser(Heap8_Block *blk)
+{
+    return (char *)blk + Heap8_UserOffset;
+}
+
+
+/* <Heap8_Next>
+ * Return the physically next block, its prevphys is the last word of blk
+ */
+static inline Heap8_Block *Heap8_Next(Heap8_Block *blk)
+{
+    return (Heap8_Block *)((char *)Heap8_BlockToUser(blk) + Heap8_Size(blk) - Heap8_Overhead);
+}
+
+
+/* <Heap8_LinkNext>
+ * Return the physically next block and point its prevphys back to blk
+ */
+static inline Heap8_Block *Heap8_LinkNext(Heap8_Block *blk)
+{
+    Heap8_Block *next = Heap8_Next(blk);
+    next->prevphys = blk;
+    return next;
+}
+
+
+/* <Heap8_MarkFree>
+ * Flag a block, and the previous block flag of the next block, as free
+ */
+static inline void Heap8_MarkFree(Heap8_Block *blk)
+{
+    Heap8_Block *next = Heap8_LinkNext(blk);
+    next->size |= Heap8_PrevFreeBit;
+    blk->size |= Heap8_FreeBit;
+}
+
+
+/* <Heap8_MarkUsed>
+ * Flag a block, and the previous block flag of the next block, as used
+ */
+static inline void Heap8_MarkUsed(Heap8_Block *blk)
+{
+    Heap8_Block *next = Heap8_Next(blk);
+    next->size &= ~(size_t)Heap8_PrevFreeBit;
+    blk->size &= ~(size_t)Heap8_FreeBit;
+}
+
+
+/* <Heap8_SizeAdjust>
+ * Round the user size up to a valid block size, or return 0 if it is too large
+ */
+static inline size_t Heap8_SizeAdjust(size_t size)
+{
+    if (size >= Heap8_MaximumSize)
+    {
+        return 0;
+    }
+
+    size = (size + HEAP8_ALIGN - 1) & ~(size_t)(HEAP8_ALIGN - 1);
+    if (size < Heap8_MinimumSize)
+    {
+        size = Heap8_MinimumSize;
+    }
+
+    return size;
+}
+
+
+/* <Heap8_Mapping>
+ * Find the first and second level list that a block size belongs to
+ */
+static inline void Heap8_Mapping(size_t size, int *fl, int *sl)
+{
+    if (size < (1 << HEAP8_FL_SHIFT))
+    {
+        /* Small blocks are spread linearly over first level list 0 */
+        *fl = 0;
+        *sl = (int)(size >> HEAP8_ALIGN_LOG2);
+    }
+    else
+    {
+        int lastbit = Heap8_LastBit((unsigned int)size);
+        *sl = (int)(size >> (lastbit - HEAP8_SL_LOG2)) ^ HEAP8_SL_COUNT;
+        *fl = lastbit - (HEAP8_FL_SHIFT - 1);
+    }
+}
+
+
+/* <Heap8_MappingSearch>
+ * Find the first list whose blocks are all at least the given size
+ */
+static inline void Heap8_MappingSearch(size_t size, int *fl, int *sl)
+{
+    if (size >= (1 << HEAP8_FL_SHIFT))
+    {
+        size += ((size_t)1 << (Heap8_LastBit((unsigned int)size) - HEAP8_SL_LOG2)) - 1;
+    }
+    Heap8_Mapping(size, fl, sl);
+}
+
+
+/* <Heap8_FindSuitable>
+ * Return the first block from the given list or a list of larger blocks,
+ * updating fl and sl to its list, or NULL if there is none
+ */
+static inline Heap8_Block *Heap8_FindSuitable(Heap8_Descriptor *h, int *fl, int *sl)
+{
+    unsigned int slmap;
+    unsigned int flmap;
+
+    if (*fl >= HEAP8_FL_COUNT)
+    {
+        return NULL;
+    }
+
+    /* Look for a large enough list on the same first level */
+    Heap_CountStep();
+    slmap = h->slbitmap[*fl] & (~0U << *sl);
+    if (slmap == 0)
+    {
+        /* Take the smallest list of a larger first level */
+        Heap_CountStep();
+        flmap = h->flbitmap & (~0U << (*fl + 1));
+        if (flmap == 0)
+        {
+            return NULL;
+        }
+        *fl = Heap8_FirstBit(flmap);
+        slmap = h->slbitmap[*fl];
+    }
+    *sl = Heap8_FirstBit(slmap);
+
+    return h->blocks[*fl][*sl];
+}
+
+
+/* <Heap8_RemoveFree>
+ * Take a free block off the given list
+ */
+static inline void Heap8_RemoveFree(Heap8_Descriptor *h, Heap8_Block *blk, int fl, int sl)
+{
+    Heap8_Block *prev = blk->prevfree;
+    Heap8_Block *next = blk->nextfree;
+
+    Heap_CountStep();
+    if (next != NULL)
+    {
+        next->prevfree = prev;
+    }
+    if (prev != NULL)
+    {
+        prev->nextfree = next;
+    }
+    else
+    {
+        /* Block was the head of its list */
+        h->blocks[fl][sl] = next;
+        if (next == NULL)
+        {
+            /* List is empty now, so may be the first level */
+            h->slbitmap[fl] &= ~(1U << sl);
+            if (h->slbitmap[fl] == 0)
+            {
+                h->flbitmap &= ~(1U << fl);
+            }
+        }
+    }
+}
+
+
+/* <Heap8_InsertFree>
+ * Put a free block at the head of the given list
+ */
+static inline void Heap8_InsertFree(Heap8_Descriptor *h, Heap8_Block *blk, int fl, int sl)
+{
+    Heap8_Block *head = h->blocks[fl][sl];
+
+    Heap_CountStep();
+    blk->nextfree = head;
+    blk->prevfree = NULL;
+    if (head != NULL)
+    {
+        head->prevfree = blk;
+    }
+    h->blocks[fl][sl] = blk;
+    h->flbitmap |= 1U << fl;
+    h->slbitmap[fl] |= 1U << sl;
+}
+
+
+/* <Heap8_Remove>
+ * Take a free block off the list of its size
+ */
+static inline void Heap8_Remove(Heap8_Descriptor *h, Heap8_Block *blk)
+{
+    int fl;
+    int sl;
+
+    Heap8_Mapping(Heap8_Size(blk), &fl, &sl);
+    Heap8_RemoveFree(h, blk, fl, sl);
+}
+
+
+/* <Heap8_Insert>
+ * Put a free block on the list of its size
+ */
+static inline void Heap8_Insert(Heap8_Descriptor *h, Heap8_Block *blk)
+{
+    int fl;
+    int sl;
+
+    Heap8_Mapping(Heap8_Size(blk), &fl, &sl);
+    Heap8_InsertFree(h, blk, fl, sl);
+}
+
+
+/* <Heap8_CanSplit>
+ * Check if a block is large enough to be split into one of the given size and another block
+ */
+static inline int Heap8_CanSplit(const Heap8_Block *blk, size_t size)
+{
+    return Heap8_Size(blk) >= sizeof(Heap8_Block) + size;
+}
+
+
+/* <Heap8_Split>
+ * Cut a block to the given size and return the remainder, flagged as free
+ */
+static inline Heap8_Block *Heap8_Split(Heap8_Block *blk, size_t size)
+{
+    Heap8_Block *remainder = (Heap8_Block *)((char *)Heap8_BlockToUser(blk) + size - Heap8_Overhead);
+
+    remainder->size = 0;
+    Heap8_SetSize(remainder, Heap8_Size(blk) - (size + Heap8_Overhead));
+    Heap8_SetSize(blk, size);
+    Heap8_MarkFree(remainder);
+
+    return remainder;
+}
+
+
+/* <Heap8_Absorb>
+ * Merge a block into the physically previous block
+ */
+static inline Heap8_Block *Heap8_Absorb(Heap8_Block *prev, Heap8_Block *blk)
+{
+    prev->size += Heap8_Size(blk) + Heap8_Overhead;
+    Heap8_LinkNext(prev);
+    return prev;
+}
+
+
+/* <Heap8_MergePrev>
+ * Merge a block with the physically previous block if that is free
+ */
+static inline Heap8_Block *Heap8_MergePrev(Heap8_Descriptor *h, Heap8_Block *blk)
+{
+    if (blk->size & Heap8_PrevFreeBit)
+    {
+        Heap8_Block *prev = blk->prevphys;
+        Heap8_Remove(h, prev);
+        blk = Heap8_Absorb(prev, blk);
+    }
+    return blk;
+}
+
+
+/* <Heap8_MergeNext>
+ * Merge a block with the physically next block if that is free
+ */
+static inline Heap8_Block *Heap8_MergeNext(Heap8_Descriptor *h, Heap8_Block *blk)
+{
+    Heap8_Block *next = Heap8_Next(blk);
+    if (next->size & Heap8_FreeBit)
+    {
+        Heap8_Remove(h, next);
+        blk = Heap8_Absorb(blk, next);
+    }
+    return blk;
+}
+
+
+/* <Heap8_TrimUsed>
+ * Give back the end of a used block, beyond the given size, to the heap
+ */
+static inline void Heap8_TrimUsed(Heap8_Descriptor *h, Heap8_Block *blk, size_t size)
+{
+    if (Heap8_CanSplit(blk, size))
+    {
+        Heap8_Block *remainder = Heap8_Split(blk, size);
+        remainder->size &= ~(size_t)Heap8_PrevFreeBit;
+        remainder = Heap8_MergeNext(h, remainder);
+        Heap8_Insert(h, remainder);
+    }
+}
+
+
+#if defined alloc_c || defined SHARED_C_LIBRARY
+
+/* <Heap8_Initialise>
+ * Initialise the heap
+ */
+extern void __Heap8_Initialise(
+    Heap8_Descriptor *h,
+    int (*full)(void *, size_t), void *fullparam,
+    void (*broken)(void *), void *brokenparam)
+{
+    int fl;
+    int sl;
+
+    h->full = full;
+    h->fullparam = fullparam;
+    h->broken = broken;
+    h->brokenparam = brokenparam;
+    h->flbitmap = 0;
+    for (fl = 0; fl < HEAP8_FL_COUNT; fl++)
+    {
+        h->slbitmap[fl] = 0;
+        for (sl = 0; sl < HEAP8_SL_COUNT; sl++)
+        {
+            h->blocks[fl][sl] = NULL;
+        }
+    }
+}
+
+
+/* <Heap8_Alloc>
+ * Allocate some memory from the heap
+ */
+extern void *__Heap8_Alloc(Heap8_Descriptor *h, size_t size)
+{
+    Heap8_Block *blk;
+    int fl;
+    int sl;
+
+    size = Heap8_SizeAdjust(size);
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    /* Loop around until allocated, or full function returns 0 to indicate no
+    extra memory released to heap */
+    do
+    {
+        Heap8_MappingSearch(size, &fl, &sl);
+        blk = Heap8_FindSuitable(h, &fl, &sl);
+        if (blk != NULL)
+        {
+            Heap8_RemoveFree(h, blk, fl, sl);
+
+            /* Free the end of the block if it is large enough to split */
+            if (Heap8_CanSplit(blk, size))
+            {
+                Heap8_Block *remainder = Heap8_Split(blk, size);
+                Heap8_LinkNext(blk);
+                Heap8_Insert(h, remainder);
+            }
+            Heap8_MarkUsed(blk);
+
+            return Heap8_BlockToUser(blk);
+        }
+    } while (h->full != NULL && h->full(h->fullparam, size));
+
+    return NULL;
+}
+
+#endif
+
+
+#if defined extend_c || defined SHARED_C_LIBRARY
+
+/* <Heap8_ProvideMemory>
+ * Provide memory to the heap
+ */
+extern void __Heap8_ProvideMemory(Heap8_Descriptor *h, void *_blk, size_t size)
+{
+    Heap8_Block *blk;
+    Heap8_Block *sentinel;
+    size_t alignment = (HEAP8_ALIGN - ((size_t)_blk & (HEAP8_ALIGN - 1))) & (HEAP8_ALIGN - 1);
+
+    /* Leave room for the size words of the block and the sentinel */
+    if (size < alignment + 2 * Heap8_Overhead + Heap8_MinimumSize)
+    {
+        return;
+    }
+    size = (size - alignment - 2 * Heap8_Overhead) & ~(size_t)(HEAP8_ALIGN - 1);
+    if (size >= Heap8_MaximumSize)
+    {
+        size = Heap8_MaximumSize - HEAP8_ALIGN;
+    }
+
+    /* Turn the memory into a free block, its prevphys is never used */
+    blk = (Heap8_Block *)((char *)_blk + alignment - sizeof(Heap8_Block *));
+    blk->size = size | Heap8_FreeBit;
+    Heap8_Insert(h, blk);
+
+    /* End it with a used sentinel that is never merged */
+    sentinel = Heap8_LinkNext(blk);
+    sentinel->size = Heap8_PrevFreeBit;
+}
+
+#endif
+
+
+#if defined free_c || defined SHARED_C_LIBRARY
+
+/* <Heap8_Free>
+ * Free some memory back to the heap
+ */
+extern void __Heap8_Free(Heap8_Descriptor *h, void *_blk)
+{
+    Heap8_Block *blk;
+
+    if (_blk == NULL)
+    {
+        return;
+    }
+
+    blk = Heap8_UserToBlock(_blk);
+    if (blk->size & Heap8_FreeBit)
+    {
+        /* Freed twice */
+        if (h->broken != NULL)
+        {
+            h->broken(h->brokenparam);
+        }
+        return;
+    }
+
+    Heap8_MarkFree(blk);
+    blk = Heap8_MergePrev(h, blk);
+    blk = Heap8_MergeNext(h, blk);
+    Heap8_Insert(h, blk);
+}
+
+#endif
+
+#if defined realloc_c || defined SHARED_C_LIBRARY
+
+/* <Heap8_Realloc>
+ * Re-allocate the given block, ensuring the newly allocated block has the same
+ * min(newsize,oldsize) bytes at its start
+ */
+void *__Heap8_Realloc(Heap8_Descriptor *h, void *_blk, size_t size)
+{
+    Heap8_Block *blk;
+    Heap8_Block *next;
+    size_t adjusted;
+    void *moved;
+
+    if (_blk == NULL)
+    {
+        return __Heap8_Alloc(h, size);
+    }
+
+    blk = Heap8_UserToBlock(_blk);
+    adjusted = Heap8_SizeAdjust(size);
+    if (adjusted == 0)
+    {
+        return NULL;
+    }
+
+    if (adjusted > Heap8_Size(blk))
+    {
+        next = Heap8_Next(blk);
+        if (!(next->size & Heap8_FreeBit)
+            || adjusted > Heap8_Size(blk) + Heap8_Size(next) + Heap8_Overhead)
+        {
+            /* No free block of sufficient size follows blk, so do an alloc,copy,free sequence */
+            moved = __Heap8_Alloc(h, size);
+            if (moved != NULL)
+            {
+                memcpy(moved, _blk, Heap8_Size(blk));
+                __Heap8_Free(h, _blk);
+            }
+            return moved;
+        }
+
+        /* Engulf the free block that follows blk */
+        Heap8_MergeNext(h, blk);
+        Heap8_MarkUsed(blk);
+    }
+
+    /* Give back what is not needed */
+    Heap8_TrimUsed(h, blk, adjusted);
+
+    return _blk;
+}
+
+#endif
+
+#if defined stats_c || defined SHARED_C_LIBRARY
+
+/* <Heap8_Stats>
+ * Print stats on the given heap, returning the largest free block
+ */
+void *__Heap8_Stats(int (*dprint)(char const *format, ...), Heap8_Descriptor *h)
+{
+    Heap8_Block *rover;
+    Heap8_Block *largest = NULL;
+    int fl;
+    int sl;
+    int flcount;
+    size_t totsize = 0;
+    int numblocks = 0;
+
+    for (fl = 0; fl < HEAP8_FL_COUNT; fl++)
+    {
+        flcount = 0;
+        for (sl = 0; sl < HEAP8_SL_COUNT; sl++)
+        {
+            for (rover = h->blocks[fl][sl]; rover != NULL; rover = rover->nextfree)
+            {
+                if (largest == NULL || Heap8_Size(rover) > Heap8_Size(largest))
+                {
+                    largest = rover;
+                }
+                totsize += Heap8_Size(rover);
+                flcount++;
+            }
+        }
+        numblocks += flcount;
+        if (flcount != 0)
+        {
+            dprint("%d blocks in first level %d\n", flcount, fl);
+        }
+    }
+
+    dprint(HEAP_STATS_SUMMARY, (int)totsize, numblocks,
+        (int)(totsize/(numblocks==0?1:numblocks)), largest == NULL ? 0 : (int)Heap8_Size(largest));
+
+    return largest == NULL ? NULL : Heap8_BlockToUser(largest);
+}
+
+#endif
+
+/* End of file heap8.c */
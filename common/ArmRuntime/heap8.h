@@ -0,0 +1,68 @@
+/*
+ * heap8.h
+ */
+
+/* Header for a type (8) two level segregated fit heap
+This sort of heap keeps free blocks in segregated lists, one for each range of
+sizes. The first level divides sizes into powers of two, the second level
+divides every power of two into HEAP8_SL_COUNT equal ranges. A bitmap for each
+level shows which lists have blocks, so a suitable free block is found, and a
+freed block is merged with its free neighbours, in constant time.
+Each block has this format:
+<prevphys><size><user or nextfree, prevfree>
+<prevphys> is only used while the previous block is free and overlaps the last
+word of the previous block. The bottom two bits of <size> flag whether the
+block and the previous block are free.
+*/
+#ifdef _HEAP8_H
+#  error "heap8.h has been included more than once"
+#else
+#  define _HEAP8_H
+
+#include "heapCommon.h"
+
+/* all blocks are aligned to, and are a multiple of, the size of a pointer */
+#define HEAP8_ALIGN_LOG2        (sizeof(void *) == 8 ? 3 : 2)
+#define HEAP8_ALIGN             (1 << HEAP8_ALIGN_LOG2)
+
+/* second level lists per power of two */
+#define HEAP8_SL_LOG2           4
+#define HEAP8_SL_COUNT          (1 << HEAP8_SL_LOG2)
+
+/* blocks smaller than (1 << HEAP8_FL_SHIFT) are all kept on the first level list 0 */
+#define HEAP8_FL_SHIFT          (HEAP8_SL_LOG2 + HEAP8_ALIGN_LOG2)
+#define HEAP8_FL_MAX            28
+#define HEAP8_FL_COUNT          (HEAP8_FL_MAX - HEAP8_FL_SHIFT + 1)
+
+typedef struct Heap8_Block
+{
+    struct Heap8_Block *prevphys;
+    size_t size;
+    struct Heap8_Block *nextfree;
+    struct Heap8_Block *prevfree;
+} Heap8_Block;
+
+typedef struct Heap8_Descriptor
+{
+    int (*full)(void *, size_t);
+    void *fullparam;
+    void (*broken)(void *);
+    void *brokenparam;
+    unsigned int flbitmap;
+    unsigned int slbitmap[HEAP8_FL_COUNT];
+    Heap8_Block *blocks[HEAP8_FL_COUNT][HEAP8_SL_COUNT];
+} Heap8_Descriptor;
+
+#define inline __inline
+
+extern void __Heap8_Initialise(Heap8_Descriptor *h, int (*full)(void *, size_t), void *fullparam, void (*broken)(void *), void *brokenparam);
+extern void __Heap8_ProvideMemory(Heap8_Descriptor *h, void *blk, size_t size);
+extern void *__Heap8_Alloc(Heap8_Descriptor *h, size_t size);
+extern void __Heap8_Free(Heap8_Descriptor *h, void *blk);
+extern void *__Heap8_Realloc(Heap8_Descriptor *h, void *_blk, size_t size);
+extern void *__Heap8_Stats(int (*pr)(char const *format, ...), Heap8_Descriptor *h);
+#define __Heap8_TraceAlloc(h,s,f,l) __Heap8_Alloc(h,s)
+
+#endif
+
+/* End of file heap8.h */
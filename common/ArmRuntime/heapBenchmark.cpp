@@ -0,0 +1,559 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Timer.h"
+#include "HeapTrace.h"
+extern "C"
+{
+	#include "heap1.h"
+	#include "heap2.h"
+	#include "heap3.h"
+	#include "heap4.h"
+	#include "heap6.h"
+	#include "heap5.h"
+	#include "heap7.h"
+	#include "heap8.h"
+}
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <iomanip>
+	#include <stdio.h>
+	#include <stdlib.h>
+#endif
+
+// every heap is measured on the same arena, with its descriptor at the start
+static const UInt arenaSize = 4 * 1024 * 1024;
+static UInt64 heapArena[arenaSize / sizeof(UInt64)];
+
+//------------------------------------------------------------------------------------------------
+// * heapFull
+//
+// Tells the heaps that no more memory can be provided.
+//------------------------------------------------------------------------------------------------
+
+static int heapFull(void *, size_t)
+{
+	return 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * heapBroken
+//
+// Counts the corruptions that the heaps have detected.
+//------------------------------------------------------------------------------------------------
+
+static UInt heapBrokenCount = 0;
+static void heapBroken(void *)
+{
+	++heapBrokenCount;
+}
+
+//------------------------------------------------------------------------------------------------
+// * struct HeapType
+//
+// The entry points of one heap implementation, on a descriptor at the start of an arena.
+//------------------------------------------------------------------------------------------------
+
+struct HeapType
+{
+	UInt number;
+	Bool isPortable;
+	void (*initialise)(void *pArena, UInt size);
+	void *(*allocate)(void *pArena, UInt size);
+	void (*free)(void *pArena, void *pMemory);
+	void *(*reallocate)(void *pArena, void *pMemory, UInt size);
+};
+
+#define defineHeapType(number, provideMemory) \
+	static void initialiseHeap##number(void *pArena, UInt size) \
+	{ \
+		Heap##number##_Descriptor *pHeap = (Heap##number##_Descriptor *)pArena; \
+		__Heap##number##_Initialise(pHeap, &heapFull, null, &heapBroken, null); \
+		provideMemory(pHeap, pHeap + 1, size - sizeof(Heap##number##_Descriptor)); \
+	} \
+	static void *allocateHeap##number(void *pArena, UInt size) \
+	{ \
+		return __Heap##number##_Alloc((Heap##number##_Descriptor *)pArena, size); \
+	} \
+	static void freeHeap##number(void *pArena, void *pMemory) \
+	{ \
+		__Heap##number##_Free((Heap##number##_Descriptor *)pArena, pMemory); \
+	} \
+	static void *reallocateHeap##number(void *pArena, void *pMemory, UInt size) \
+	{ \
+		return __Heap##number##_Realloc((Heap##number##_Descriptor *)pArena, pMemory, size); \
+	}
+
+defineHeapType(1, __Heap1_InitMemory)
+defineHeapType(2, __Heap2_ProvideMemory)
+defineHeapType(3, __Heap3_ProvideMemory)
+defineHeapType(4, __Heap4_ProvideMemory)
+defineHeapType(5, __Heap5_ProvideMemory)
+defineHeapType(6, __Heap6_ProvideMemory)
+#if !defined(__LP64__)
+	defineHeapType(7, __Heap7_ProvideMemory)
+#endif
+defineHeapType(8, __Heap8_ProvideMemory)
+
+#define heapType(number, isPortable) \
+	{number, isPortable, &initialiseHeap##number, &allocateHeap##number, &freeHeap##number, \
+		&reallocateHeap##number}
+
+// heap 7 keeps 32 bit addresses and is only built where pointers have 32 bits
+static const HeapType heapTypes[] =
+{
+	heapType(1, true),
+	heapType(2, true),
+	heapType(3, true),
+	heapType(4, true),
+	heapType(5, true),
+	heapType(6, true),
+	#if !defined(__LP64__)
+		heapType(7, false),
+	#else
+		{7, false, null, null, null, null},
+	#endif
+	heapType(8, true)
+};
+
+
+//------------------------------------------------------------------------------------------------
+// * class HeapBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class HeapBenchmarkTask : public Task
+{
+public:
+	// constructor
+	HeapBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// types
+	enum
+	{
+		maximumNumberOfBlocks = 4096,
+		maximumNumberOfReplayOperations = HEAP_TRACE_LENGTH
+	};
+	struct Block
+	{
+		void *pMemory;
+		UInt size;
+	};
+	struct ReplayOperation
+	{
+		UInt16 block;
+		UInt size;
+	};
+
+	// measured operations
+	void allocateBlock(UInt block, UInt size);
+	void freeBlock(UInt block);
+	void reallocateBlock(UInt block, UInt size);
+	void startTiming();
+	void stopTiming();
+
+	// workloads
+	typedef void (HeapBenchmarkTask::*Workload)();
+	void runWorkload(const char *pName, Workload workload);
+	void runPacketChurn();
+	void runTaskChurn();
+	void runReallocGrowth();
+	void runTraceReplay();
+	Bool loadTrace();
+	UInt getRandom();
+
+	// reporting
+	UInt findLargestFreeBlock();
+	void reportHeader();
+	void report(const char *pName);
+
+	// representation
+	Timer *pTimer;
+	const HeapType *pHeapType;
+	UInt seed;
+	TimeValue operationStartTime;
+	UInt operationCount;
+	UInt failureCount;
+	TimeValue totalTicks;
+	TimeValue worstTicks;
+	UInt peakExtent;
+	UInt liveBytes;
+	Block blocks[maximumNumberOfBlocks];
+	UInt numberOfReplayOperations;
+	ReplayOperation replayOperations[maximumNumberOfReplayOperations];
+};
+
+HeapBenchmarkTask::HeapBenchmarkTask() :
+	Task(defaultPriority + 1, 20000)
+{
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	pHeapType = null;
+	seed = 1;
+	numberOfReplayOperations = 0;
+}
+
+UInt HeapBenchmarkTask::getRandom()
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+void HeapBenchmarkTask::startTiming()
+{
+	operationStartTime = pTimer->getTime();
+}
+
+void HeapBenchmarkTask::stopTiming()
+{
+	const TimeValue ticks = compareTimes(pTimer->getTime(), operationStartTime);
+	++operationCount;
+	totalTicks += ticks;
+	if(ticks > worstTicks)
+	{
+		worstTicks = ticks;
+	}
+}
+
+void HeapBenchmarkTask::allocateBlock(UInt block, UInt size)
+{
+	startTiming();
+	void *pMemory = pHeapType->allocate(heapArena, size);
+	stopTiming();
+
+	if(pMemory == null)
+	{
+		++failureCount;
+		return;
+	}
+	blocks[block].pMemory = pMemory;
+	blocks[block].size = size;
+	liveBytes += size;
+
+	// keep track of how far into the arena the heap has had to go
+	const UInt extent = subtractPointers(pMemory, heapArena) + size;
+	if(extent > peakExtent)
+	{
+		peakExtent = extent;
+	}
+}
+
+void HeapBenchmarkTask::freeBlock(UInt block)
+{
+	startTiming();
+	pHeapType->free(heapArena, blocks[block].pMemory);
+	stopTiming();
+
+	liveBytes -= blocks[block].size;
+	blocks[block].pMemory = null;
+	blocks[block].size = 0;
+}
+
+void HeapBenchmarkTask::reallocateBlock(UInt block, UInt size)
+{
+	startTiming();
+	void *pMemory = pHeapType->reallocate(heapArena, blocks[block].pMemory, size);
+	stopTiming();
+
+	if(pMemory == null)
+	{
+		// the block is left as it was
+		++failureCount;
+		return;
+	}
+	liveBytes += size - blocks[block].size;
+	blocks[block].pMemory = pMemory;
+	blocks[block].size = size;
+
+	const UInt extent = subtractPointers(pMemory, heapArena) + size;
+	if(extent > peakExtent)
+	{
+		peakExtent = extent;
+	}
+}
+
+void HeapBenchmarkTask::runPacketChurn()
+{
+	// mostly headers and small packets, some full sized packets
+	const UInt numberOfBlocks = 512;
+	for(UInt operation = 0; operation < 200000; ++operation)
+	{
+		const UInt block = getRandom() % numberOfBlocks;
+		if(blocks[block].pMemory != null)
+		{
+			freeBlock(block);
+		}
+		else
+		{
+			const UInt random = getRandom();
+			allocateBlock(block, random % 10 < 7 ? 64 + random / 10 % 193 : 512 + random / 10 % 1025);
+		}
+	}
+}
+
+void HeapBenchmarkTask::runTaskChurn()
+{
+	// each task owns a control block, a stack and a few small objects
+	const UInt numberOfTasks = 32;
+	const UInt blocksPerTask = 8;
+	for(UInt cycle = 0; cycle < 20000; ++cycle)
+	{
+		const UInt task = getRandom() % numberOfTasks;
+		const UInt firstBlock = task * blocksPerTask;
+		if(blocks[firstBlock].pMemory != null)
+		{
+			// destroy the task
+			for(UInt block = firstBlock; block < firstBlock + blocksPerTask; ++block)
+			{
+				if(blocks[block].pMemory != null)
+				{
+					freeBlock(block);
+				}
+			}
+		}
+		else
+		{
+			// create the task
+			allocateBlock(firstBlock, 320);
+			allocateBlock(firstBlock + 1, 2048 + getRandom() % 14337);
+			const UInt numberOfObjects = 2 + getRandom() % (blocksPerTask - 2);
+			for(UInt object = 0; object < numberOfObjects; ++object)
+			{
+				allocateBlock(firstBlock + 2 + object, 16 + getRandom() % 113);
+			}
+		}
+	}
+}
+
+void HeapBenchmarkTask::runReallocGrowth()
+{
+	// buffers grow by half again until they are dropped, between churning small objects
+	const UInt numberOfBuffers = 64;
+	const UInt numberOfObjects = 512;
+	for(UInt operation = 0; operation < 100000; ++operation)
+	{
+		const UInt random = getRandom();
+		if(random % 2 == 0)
+		{
+			const UInt buffer = random / 2 % numberOfBuffers;
+			if(blocks[buffer].pMemory == null)
+			{
+				allocateBlock(buffer, 16);
+			}
+			else if(blocks[buffer].size > 64 * 1024)
+			{
+				freeBlock(buffer);
+			}
+			else
+			{
+				reallocateBlock(buffer, blocks[buffer].size * 3 / 2 + 16);
+			}
+		}
+		else
+		{
+			const UInt object = numberOfBuffers + random / 2 % numberOfObjects;
+			if(blocks[object].pMemory != null)
+			{
+				freeBlock(object);
+			}
+			else
+			{
+				allocateBlock(object, 8 + random / 1024 % 121);
+			}
+		}
+	}
+}
+
+Bool HeapBenchmarkTask::loadTrace()
+{
+	#if defined(PRINT) && defined(HEAP_TRACE_FILE)
+		// read the records of a trace taken with RECORD_HEAP_TRACE
+		FILE *pFile = fopen(HEAP_TRACE_FILE, "rb");
+		if(pFile == null)
+		{
+			std::cout << "Cannot open " << HEAP_TRACE_FILE << "\n";
+			return false;
+		}
+
+		// give every live block of the trace a block of its own
+		static UInt32 blockAddresses[maximumNumberOfBlocks];
+		{
+			for(UInt block = 0; block < maximumNumberOfBlocks; ++block)
+			{
+				blockAddresses[block] = 0;
+			}
+		}
+		HeapTrace::Record record;
+		numberOfReplayOperations = 0;
+		while(numberOfReplayOperations < maximumNumberOfReplayOperations
+			&& fread(&record, sizeof(record), 1, pFile) == 1)
+		{
+			const UInt32 wantedAddress = record.size != 0 ? 0 : record.address;
+			UInt block = 0;
+			while(block < maximumNumberOfBlocks && blockAddresses[block] != wantedAddress)
+			{
+				++block;
+			}
+			if(block == maximumNumberOfBlocks)
+			{
+				// too many live blocks, or a free of a block allocated before the trace
+				continue;
+			}
+			blockAddresses[block] = record.size != 0 ? record.address : 0;
+			replayOperations[numberOfReplayOperations].block = (UInt16)block;
+			replayOperations[numberOfReplayOperations].size = record.size;
+			++numberOfReplayOperations;
+		}
+		fclose(pFile);
+		return true;
+	#else
+		return false;
+	#endif
+}
+
+void HeapBenchmarkTask::runTraceReplay()
+{
+	for(UInt operation = 0; operation < numberOfReplayOperations; ++operation)
+	{
+		const ReplayOperation &replayOperation = replayOperations[operation];
+		if(replayOperation.size != 0)
+		{
+			allocateBlock(replayOperation.block, replayOperation.size);
+		}
+		else if(blocks[replayOperation.block].pMemory != null)
+		{
+			freeBlock(replayOperation.block);
+		}
+	}
+}
+
+UInt HeapBenchmarkTask::findLargestFreeBlock()
+{
+	// narrow down the largest size that the heap can still allocate in one piece
+	UInt lowerSize = 0;
+	UInt upperSize = arenaSize;
+	while(upperSize - lowerSize > 16)
+	{
+		const UInt size = (lowerSize + upperSize) / 2;
+		void *pMemory = pHeapType->allocate(heapArena, size);
+		if(pMemory != null)
+		{
+			pHeapType->free(heapArena, pMemory);
+			lowerSize = size;
+		}
+		else
+		{
+			upperSize = size;
+		}
+	}
+	return lowerSize;
+}
+
+void HeapBenchmarkTask::reportHeader()
+{
+	#if defined(PRINT)
+		std::cout << "workload        heap  kops/s  worst us  peak KB  frag %  failed\n";
+	#endif
+}
+
+void HeapBenchmarkTask::report(const char *pName)
+{
+	#if defined(PRINT)
+		std::cout << std::setiosflags(std::ios::left) << std::setw(16) << pName
+			<< std::resetiosflags(std::ios::left) << std::setw(4) << pHeapType->number;
+		if(!pHeapType->isPortable && sizeof(void *) != sizeof(UInt32))
+		{
+			std::cout << "  needs 32 bit pointers\n";
+			return;
+		}
+
+		// the free memory that is not in the largest free block is lost to fragmentation
+		const UInt largestFreeBlock = findLargestFreeBlock();
+		const UInt freeBytes = arenaSize - liveBytes;
+		const UInt fragmentation = largestFreeBlock < freeBytes
+			? (UInt)((UInt64)(freeBytes - largestFreeBlock) * 100 / freeBytes)
+			: 0;
+		const UInt64 microseconds = (UInt64)totalTicks * 1000000 / pTimer->getFrequency();
+		std::cout << std::setw(8) << (UInt)(microseconds != 0 ? (UInt64)operationCount * 1000 / microseconds : 0)
+			<< std::setw(10) << (UInt)((UInt64)worstTicks * 1000000 / pTimer->getFrequency())
+			<< std::setw(9) << peakExtent / 1024
+			<< std::setw(8) << fragmentation
+			<< std::setw(8) << failureCount << "\n";
+	#endif
+}
+
+void HeapBenchmarkTask::runWorkload(const char *pName, Workload workload)
+{
+	for(UInt heapTypeNumber = 0; heapTypeNumber < arrayDimension(heapTypes); ++heapTypeNumber)
+	{
+		pHeapType = &heapTypes[heapTypeNumber];
+		if(!pHeapType->isPortable && sizeof(void *) != sizeof(UInt32))
+		{
+			report(pName);
+			continue;
+		}
+
+		// start every heap on an empty arena with the same random sequence
+		pHeapType->initialise(heapArena, arenaSize);
+		seed = 1;
+		operationCount = 0;
+		failureCount = 0;
+		totalTicks = 0;
+		worstTicks = 0;
+		peakExtent = 0;
+		liveBytes = 0;
+		{
+			for(UInt block = 0; block < maximumNumberOfBlocks; ++block)
+			{
+				blocks[block].pMemory = null;
+				blocks[block].size = 0;
+			}
+		}
+
+		// run the workload and measure the fragmentation that is left with its live blocks
+		(this->*workload)();
+		report(pName);
+	}
+}
+
+void HeapBenchmarkTask::main()
+{
+	reportHeader();
+	runWorkload("packet churn", &HeapBenchmarkTask::runPacketChurn);
+	runWorkload("task churn", &HeapBenchmarkTask::runTaskChurn);
+	runWorkload("realloc growth", &HeapBenchmarkTask::runReallocGrowth);
+	if(loadTrace())
+	{
+		runWorkload("trace replay", &HeapBenchmarkTask::runTraceReplay);
+	}
+
+	#if defined(PRINT)
+		if(heapBrokenCount != 0)
+		{
+			std::cout << heapBrokenCount << " heap corruptions detected\n";
+		}
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * heapBenchmark
+//------------------------------------------------------------------------------------------------
+
+void heapBenchmark()
+{
+	(new HeapBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
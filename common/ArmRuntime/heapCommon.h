@@ -19,8 +19,34 @@
 #ifndef extend_c
 	#define extend_c
 #endif
-#ifndef size_t
-	#define size_t unsigned int
+#ifndef realloc_c
+	#define realloc_c
+#endif
+#ifndef stats_c
+	#define stats_c
+#endif
+
+// the summary line that Heap_Stats prints, the runtime reads the largest free block from it
+#define HEAP_STATS_SUMMARY "%d bytes in %d free blocks (avge size %d, largest %d)\n"
+#if defined(__ARMCC_VERSION)
+	#ifndef size_t
+		#define size_t unsigned int
+	#endif
+#else
+	// hosted builds must agree with the C library on the size of a pointer
+	#include <stddef.h>
+
+	// the realloc paths copy blocks with memcpy
+	#include <string.h>
+#endif
+
+// hosted builds count the steps that the heaps take through their free lists and bitmaps, so that
+// heapTimingTest can check the worst case of an operation without relying on timing it
+#if !defined(__ARMCC_VERSION)
+	extern unsigned int Heap_StepCount;
+	#define Heap_CountStep() (++Heap_StepCount)
+#else
+	#define Heap_CountStep() ((void)0)
 #endif
 
 #endif // _heapCommon_h_
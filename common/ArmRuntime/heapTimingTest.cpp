@@ -0,0 +1,289 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Timer.h"
+extern "C"
+{
+	#include "heap.h"
+}
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the heap under test, of the type selected by HEAPTYPE
+static const UInt heapSize = 1024 * 1024;
+static UInt64 heapArena[heapSize / sizeof(UInt64)];
+
+// the steps that the heaps take through their free lists and bitmaps, see heapCommon.h
+unsigned int Heap_StepCount = 0;
+
+// heap 8 promises a bounded number of steps per operation however fragmented it is, the
+// steps of the other heaps are only reported
+#if HEAPTYPE == 8
+	static const Bool boundedSteps = true;
+#else
+	static const Bool boundedSteps = false;
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * class HeapTimingTask
+//------------------------------------------------------------------------------------------------
+
+class HeapTimingTask : public Task
+{
+public:
+	// constructor
+	HeapTimingTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// timing
+	enum
+	{
+		numberOfFragments = 2000,
+		fragmentSize = 24,
+		numberOfLargeBlocks = 500,
+		largeBlockSize = 200,
+		numberOfSlots = 512,
+		numberOfOperations = 100000
+	};
+	void initializeHeap();
+	void *timeAllocate(UInt size);
+	void timeFree(void *pMemory);
+	void runFragmentedRound(UInt numberOfHoles);
+	Bool runRandomRound();
+	void report(const char *pDescription);
+
+	// checking
+	void fillBlock(UInt slot, UInt size);
+	Bool verifyBlock(UInt slot) const;
+
+	// representation
+	UInt seed;
+	Timer *pTimer;
+	Heap_Descriptor *pHeap;
+	UInt operationCount;
+	TimeValue totalTicks;
+	TimeValue worstAllocateTicks;
+	TimeValue worstFreeTicks;
+	UInt worstAllocateSteps;
+	UInt worstFreeSteps;
+	void *blocks[numberOfFragments];
+	UInt blockSizes[numberOfSlots];
+};
+
+HeapTimingTask::HeapTimingTask() :
+	Task(defaultPriority + 1, 10000)
+{
+	seed = 1;
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	pHeap = (Heap_Descriptor *)heapArena;
+}
+
+void HeapTimingTask::initializeHeap()
+{
+	Heap_Initialise(pHeap, null, null, null, null);
+	Heap_InitMemory(pHeap, pHeap + 1, heapSize - sizeof(Heap_Descriptor));
+	operationCount = 0;
+	totalTicks = 0;
+	worstAllocateTicks = 0;
+	worstFreeTicks = 0;
+	worstAllocateSteps = 0;
+	worstFreeSteps = 0;
+}
+
+void *HeapTimingTask::timeAllocate(UInt size)
+{
+	const UInt startSteps = Heap_StepCount;
+	const TimeValue startTime = pTimer->getTime();
+	void *pMemory = Heap_Alloc(pHeap, size);
+	const TimeValue ticks = compareTimes(pTimer->getTime(), startTime);
+
+	++operationCount;
+	totalTicks += ticks;
+	if(ticks > worstAllocateTicks)
+	{
+		worstAllocateTicks = ticks;
+	}
+	worstAllocateSteps = maximum(worstAllocateSteps, Heap_StepCount - startSteps);
+	return pMemory;
+}
+
+void HeapTimingTask::timeFree(void *pMemory)
+{
+	const UInt startSteps = Heap_StepCount;
+	const TimeValue startTime = pTimer->getTime();
+	Heap_Free(pHeap, pMemory);
+	const TimeValue ticks = compareTimes(pTimer->getTime(), startTime);
+
+	++operationCount;
+	totalTicks += ticks;
+	if(ticks > worstFreeTicks)
+	{
+		worstFreeTicks = ticks;
+	}
+	worstFreeSteps = maximum(worstFreeSteps, Heap_StepCount - startSteps);
+}
+
+void HeapTimingTask::report(const char *pDescription)
+{
+	#if defined(PRINT)
+		const UInt64 frequency = pTimer->getFrequency();
+		std::cout << "HEAPTYPE " << HEAPTYPE << " " << pDescription << ": "
+			<< operationCount << " operations in " << (UInt)((UInt64)totalTicks * 1000000 / frequency)
+			<< "us, worst allocate " << (UInt)((UInt64)worstAllocateTicks * 1000000 / frequency)
+			<< "us, worst free " << (UInt)((UInt64)worstFreeTicks * 1000000 / frequency) << "us, "
+			<< "worst steps " << worstAllocateSteps << " allocate, " << worstFreeSteps << " free\n";
+	#endif
+}
+
+void HeapTimingTask::fillBlock(UInt slot, UInt size)
+{
+	// fill the block with a pattern of its own, which another block overlapping it would break
+	blockSizes[slot] = size;
+	UInt8 *pBytes = (UInt8 *)blocks[slot];
+	for(UInt i = 0; i < size; ++i)
+	{
+		pBytes[i] = (UInt8)(slot + i);
+	}
+}
+
+Bool HeapTimingTask::verifyBlock(UInt slot) const
+{
+	const UInt8 *pBytes = (const UInt8 *)blocks[slot];
+	for(UInt i = 0; i < blockSizes[slot]; ++i)
+	{
+		if(pBytes[i] != (UInt8)(slot + i))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void HeapTimingTask::runFragmentedRound(UInt numberOfHoles)
+{
+	initializeHeap();
+
+	// leave a long trail of small holes that no large block fits into
+	const UInt fragmentCount = 2 * numberOfHoles;
+	{
+		for(UInt fragment = 0; fragment < fragmentCount; ++fragment)
+		{
+			blocks[fragment] = Heap_Alloc(pHeap, fragmentSize);
+		}
+	}
+	{
+		for(UInt fragment = 0; fragment < fragmentCount; fragment += 2)
+		{
+			Heap_Free(pHeap, blocks[fragment]);
+			blocks[fragment] = null;
+		}
+	}
+
+	// allocate and free large blocks past all of the holes
+	{
+		for(UInt block = 0; block < numberOfLargeBlocks; ++block)
+		{
+			blocks[2 * block] = timeAllocate(largeBlockSize);
+		}
+	}
+	{
+		for(UInt block = numberOfLargeBlocks; block > 0; --block)
+		{
+			timeFree(blocks[2 * (block - 1)]);
+		}
+	}
+	#if defined(PRINT)
+		std::cout << numberOfHoles << " holes, ";
+	#endif
+	report("fragmented");
+}
+
+Bool HeapTimingTask::runRandomRound()
+{
+	initializeHeap();
+	seed = 1;
+	{
+		for(UInt slot = 0; slot < numberOfSlots; ++slot)
+		{
+			blocks[slot] = null;
+		}
+	}
+
+	// allocate and free blocks of random sizes in random order, checking that every block still
+	// holds what was written to it when it is freed
+	UInt numberOfBrokenBlocks = 0;
+	for(UInt operation = 0; operation < numberOfOperations; ++operation)
+	{
+		seed = seed * 1664525 + 1013904223;
+		const UInt slot = (seed >> 8) % numberOfSlots;
+		if(blocks[slot] != null)
+		{
+			if(!verifyBlock(slot))
+			{
+				++numberOfBrokenBlocks;
+			}
+			timeFree(blocks[slot]);
+			blocks[slot] = null;
+		}
+		else
+		{
+			const UInt size = 8 + (seed >> 16) % 2041;
+			blocks[slot] = timeAllocate(size);
+			if(blocks[slot] != null)
+			{
+				fillBlock(slot, size);
+			}
+		}
+	}
+	report("random");
+	#if defined(PRINT)
+		std::cout << "  " << numberOfBrokenBlocks << " blocks overwritten\n";
+	#endif
+	return numberOfBrokenBlocks == 0;
+}
+
+void HeapTimingTask::main()
+{
+	// the steps of a bounded heap do not grow when the number of holes doubles, unlike the time
+	// of an operation, which the host can stretch at any moment
+	runFragmentedRound(numberOfFragments / 4);
+	const UInt fewerHolesAllocateSteps = worstAllocateSteps;
+	const UInt fewerHolesFreeSteps = worstFreeSteps;
+	runFragmentedRound(numberOfFragments / 2);
+	const Bool stepsGrew = worstAllocateSteps > fewerHolesAllocateSteps
+		|| worstFreeSteps > fewerHolesFreeSteps;
+	#if defined(PRINT)
+		std::cout << "  steps " << (stepsGrew ? "grow" : "do not grow") << " with the holes"
+			<< (boundedSteps && stepsGrew ? " FAILED" : "") << "\n";
+	#endif
+
+	const Bool blocksIntact = runRandomRound();
+	#if defined(PRINT)
+		exit(blocksIntact && !(boundedSteps && stepsGrew) ? 0 : 1);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * heapTimingTest
+//------------------------------------------------------------------------------------------------
+
+void heapTimingTest()
+{
+	(new HeapTimingTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
@@ -1,7 +1,7 @@
 #ifndef _runtime_h_
 #define _runtime_h_
 
-#include "cPrimitiveTypes.h"
+#include "../cPrimitiveTypes.h"
 
 extern "C"
 {
@@ -9,4 +9,12 @@ extern "C"
 	void handleFatalError();
 }
 
+#if defined(USE_HEAP_PROFILING)
+	#include "HeapProfile.h"
+
+	// allocation statistics of the runtime heap
+	extern HeapProfile heapProfile;
+	UInt measureLargestFreeHeapBlock();
+#endif
+
 #endif // _runtime_h_
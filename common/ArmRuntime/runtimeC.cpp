@@ -3,6 +3,19 @@
 #include "../multitasking/Mutex.h"
 #include "../multitasking/LockedSection.h"
 #include "../Devices/WatchdogSection.h"
+#if defined(USE_SLAB_ALLOCATOR)
+	#include "SlabAllocator.h"
+#endif
+#if defined(RECORD_HEAP_TRACE)
+	#include "HeapTrace.h"
+#endif
+#if defined(USE_HEAP_PROFILING)
+	#include "HeapProfile.h"
+	#include <stdarg.h>
+	#include <string.h>
+#else
+	#define HEAP_PROFILE_CALL_SITE() null
+#endif
 #if defined(__TARGET_CPU_SA_1100)
 	#include "../Sa1110Devices/Sa1110GpioOutput.h"
 #endif
@@ -16,6 +29,34 @@ extern "C"
 
 Heap_Descriptor *pGlobalHeap;
 Mutex heapMutex;
+#if defined(USE_SLAB_ALLOCATOR)
+	#if !defined(SLAB_ARENA_SIZE)
+		#define SLAB_ARENA_SIZE (64 * 1024)
+	#endif
+	SlabAllocator slabAllocator;
+#endif
+#if defined(RECORD_HEAP_TRACE)
+	HeapTrace heapTrace;
+#endif
+#if defined(USE_HEAP_PROFILING)
+	static UInt largestFreeHeapBlock;
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * refuseHeapExtension
+//
+// Called by the heap when it has run out of memory. There is no more memory to provide, so the
+// allocation fails and returns null.
+//------------------------------------------------------------------------------------------------
+
+static int refuseHeapExtension(void *pParameter, size_t size)
+{
+	// unused arguments
+	pParameter = pParameter;
+	size = size;
+
+	return 0;
+}
 
 //------------------------------------------------------------------------------------------------
 // * initializeHeap
@@ -25,19 +66,72 @@ Mutex heapMutex;
 
 void initializeHeap(UInt heapBaseAddress, UInt heapLimitAddress)
 {
+	#if defined(USE_SLAB_ALLOCATOR)
+		// keep the top of the heap for the pages of the slab allocator
+		heapLimitAddress -= SLAB_ARENA_SIZE;
+		slabAllocator.initialize((void *)heapLimitAddress, SLAB_ARENA_SIZE);
+	#endif
+
 	pGlobalHeap = (Heap_Descriptor *)heapBaseAddress;
-	Heap_Initialise(pGlobalHeap, null, null, null, null);
+	Heap_Initialise(pGlobalHeap, &refuseHeapExtension, null, null, null);
 	Heap_InitMemory(pGlobalHeap, pGlobalHeap + 1,
 		heapLimitAddress - heapBaseAddress - sizeof(Heap_Descriptor));
 }
 
+#if defined(USE_HEAP_PROFILING)
+
 //------------------------------------------------------------------------------------------------
-// * operator new
+// * collectHeapStatistics
 //
-// Allocates memory from the heap.
+// Receives the lines printed by Heap_Stats and keeps the largest free block from the summary.
 //------------------------------------------------------------------------------------------------
 
-void *operator new(UInt size)
+static int collectHeapStatistics(const char *pFormat, ...)
+{
+	if(strcmp(pFormat, HEAP_STATS_SUMMARY) == 0)
+	{
+		// skip the total size, the number of blocks and the average size
+		va_list arguments;
+		va_start(arguments, pFormat);
+		va_arg(arguments, int);
+		va_arg(arguments, int);
+		va_arg(arguments, int);
+		largestFreeHeapBlock = (UInt)va_arg(arguments, int);
+		va_end(arguments);
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * measureLargestFreeHeapBlock
+//
+// Measures the largest free block of the heap, outside the slabs, and records it in the heap
+// profile. The size is read from the heap's own statistics, which walk its free blocks once
+// while the heap is locked, nothing is allocated.
+//------------------------------------------------------------------------------------------------
+
+UInt measureLargestFreeHeapBlock()
+{
+	UInt largestSize = 0;
+	{
+		LockedSection heapLock(heapMutex);
+		Heap_Stats(&collectHeapStatistics, pGlobalHeap);
+		largestSize = largestFreeHeapBlock;
+	}
+
+	heapProfile.recordLargestFreeBlock(largestSize);
+	return largestSize;
+}
+
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * allocateMemory
+//
+// Allocates <size> bytes from the slabs or the heap, on behalf of <pCallSite>.
+//------------------------------------------------------------------------------------------------
+
+static void *allocateMemory(UInt size, const void *pCallSite)
 {
 	if(size == 0)
 	{
@@ -45,19 +139,36 @@ void *operator new(UInt size)
 	}
 	else
 	{
-		void *pMemory;
+		#if defined(USE_HEAP_PROFILING)
+			// make room for the header that names the owner and call site
+			const UInt blockSize = HeapProfile::getBlockSize(size);
+		#else
+			// unused argument
+			pCallSite = pCallSite;
+			const UInt blockSize = size;
+		#endif
+
+		void *pMemory = null;
+
+		#if defined(USE_SLAB_ALLOCATOR)
+			// small blocks come from the slabs without taking the heap mutex
+			pMemory = slabAllocator.allocate(blockSize);
+		#endif
 
-		// check if the RTOS has started
-		if(TaskScheduler::isInitialized())
-		{
-			// RTOS is running, allocate within a lock
-			LockedSection heapLock(heapMutex);
-			pMemory = Heap_Alloc(pGlobalHeap, size);
-		}
-		else
+		if(pMemory == null)
 		{
-			// RTOS not yet started, allocate without locking
-			pMemory = Heap_Alloc(pGlobalHeap, size);
+			// check if the RTOS has started
+			if(TaskScheduler::isInitialized())
+			{
+				// RTOS is running, allocate within a lock
+				LockedSection heapLock(heapMutex);
+				pMemory = Heap_Alloc(pGlobalHeap, blockSize);
+			}
+			else
+			{
+				// RTOS not yet started, allocate without locking
+				pMemory = Heap_Alloc(pGlobalHeap, blockSize);
+			}
 		}
 
 		if(pMemory == null)
@@ -66,10 +177,31 @@ void *operator new(UInt size)
 			handleFatalError();
 		}
 
+		#if defined(RECORD_HEAP_TRACE)
+			// keep the allocation for replaying on the host
+			heapTrace.recordAllocation(pMemory, blockSize);
+		#endif
+
+		#if defined(USE_HEAP_PROFILING)
+			// charge the allocation to the current task and the call site
+			pMemory = heapProfile.recordAllocation(pMemory, size, pCallSite);
+		#endif
+
 		return pMemory;
 	}
 }
 
+//------------------------------------------------------------------------------------------------
+// * operator new
+//
+// Allocates memory from the heap.
+//------------------------------------------------------------------------------------------------
+
+void *operator new(UInt size)
+{
+	return allocateMemory(size, HEAP_PROFILE_CALL_SITE());
+}
+
 //------------------------------------------------------------------------------------------------
 // * operator delete
 //
@@ -80,6 +212,25 @@ void operator delete(void *pMemory)
 {
 	if(pMemory != null)
 	{
+		#if defined(USE_HEAP_PROFILING)
+			// charge the block back to its owner and call site
+			pMemory = heapProfile.recordFree(pMemory);
+		#endif
+
+		#if defined(RECORD_HEAP_TRACE)
+			// keep the free for replaying on the host
+			heapTrace.recordFree(pMemory);
+		#endif
+
+		#if defined(USE_SLAB_ALLOCATOR)
+			// small blocks go back to the slabs without taking the heap mutex
+			if(slabAllocator.contains(pMemory))
+			{
+				slabAllocator.deallocate(pMemory);
+				return;
+			}
+		#endif
+
 		// check if the RTOS has started
 		if(TaskScheduler::isInitialized())
 		{
@@ -103,7 +254,7 @@ void operator delete(void *pMemory)
 
 extern "C" void *malloc(UInt size)
 {
-	return operator new(size);
+	return allocateMemory(size, HEAP_PROFILE_CALL_SITE());
 }
 
 //------------------------------------------------------------------------------------------------
@@ -125,7 +276,7 @@ extern "C" void free(void *pMemory)
 
 void *operator new[](UInt size)
 {
-	return operator new(size);
+	return allocateMemory(size, HEAP_PROFILE_CALL_SITE());
 }
 
 //------------------------------------------------------------------------------------------------
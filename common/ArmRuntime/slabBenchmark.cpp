@@ -0,0 +1,251 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Mutex.h"
+#include "../multitasking/LockedSection.h"
+#include "../multitasking/Timer.h"
+#include "SlabAllocator.h"
+extern "C"
+{
+	#include "heap.h"
+}
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the benchmark heap, the slab allocator takes its pages from the top of it
+static const UInt heapSize = 512 * 1024;
+static const UInt slabArenaSize = 64 * 1024;
+static UInt64 heapArena[heapSize / sizeof(UInt64)];
+
+//------------------------------------------------------------------------------------------------
+// * class SlabBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class SlabBenchmarkTask : public Task
+{
+public:
+	// constructor
+	SlabBenchmarkTask(UInt numberOfOperations);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// allocating
+	void *allocate(UInt size);
+	void deallocate(void *pMemory);
+	UInt findLargestFreeBlock();
+
+	// benchmarking
+	enum
+	{
+		numberOfSlots = 512,
+		survivorSpacing = 8
+	};
+	void runRound(Bool useSlabs);
+	UInt getRandomSize();
+	void report(const char *pDescription, TimeValue elapsedTicks, TimeValue worstTicks,
+		UInt largestFreeBlock);
+
+	// representation
+	UInt numberOfOperations;
+	UInt seed;
+	Timer *pTimer;
+	Heap_Descriptor *pHeap;
+	Mutex heapMutex;
+	Bool useSlabs;
+	SlabAllocator slabAllocator;
+	void *blocks[numberOfSlots];
+};
+
+SlabBenchmarkTask::SlabBenchmarkTask(UInt numberOfOperations) :
+	Task(defaultPriority + 1, 10000)
+{
+	this->numberOfOperations = numberOfOperations;
+	seed = 1;
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	pHeap = (Heap_Descriptor *)heapArena;
+	useSlabs = false;
+}
+
+void *SlabBenchmarkTask::allocate(UInt size)
+{
+	// the same path as operator new in the runtime, but on the benchmark heap
+	if(useSlabs)
+	{
+		void *pMemory = slabAllocator.allocate(size);
+		if(pMemory != null)
+		{
+			return pMemory;
+		}
+	}
+	LockedSection heapLock(heapMutex);
+	return Heap_Alloc(pHeap, size);
+}
+
+void SlabBenchmarkTask::deallocate(void *pMemory)
+{
+	// the same path as operator delete in the runtime, but on the benchmark heap
+	if(useSlabs && slabAllocator.contains(pMemory))
+	{
+		slabAllocator.deallocate(pMemory);
+	}
+	else
+	{
+		LockedSection heapLock(heapMutex);
+		Heap_Free(pHeap, pMemory);
+	}
+}
+
+UInt SlabBenchmarkTask::findLargestFreeBlock()
+{
+	// narrow down the largest size that the heap can still allocate in one piece
+	UInt lowerSize = 0;
+	UInt upperSize = heapSize;
+	while(upperSize - lowerSize > 16)
+	{
+		const UInt size = (lowerSize + upperSize) / 2;
+		LockedSection heapLock(heapMutex);
+		void *pMemory = Heap_Alloc(pHeap, size);
+		if(pMemory != null)
+		{
+			Heap_Free(pHeap, pMemory);
+			lowerSize = size;
+		}
+		else
+		{
+			upperSize = size;
+		}
+	}
+	return lowerSize;
+}
+
+UInt SlabBenchmarkTask::getRandomSize()
+{
+	// mostly small objects, with a quarter of packet sized buffers
+	seed = seed * 1664525 + 1013904223;
+	const UInt random = seed >> 8;
+	return random % 4 != 0
+		? 8 + (random >> 2) % 249
+		: 257 + (random >> 2) % 1244;
+}
+
+void SlabBenchmarkTask::report(const char *pDescription, TimeValue elapsedTicks,
+	TimeValue worstTicks, UInt largestFreeBlock)
+{
+	#if defined(PRINT)
+		const UInt64 microseconds = (UInt64)elapsedTicks * 1000000 / pTimer->getFrequency();
+		const UInt64 worstMicroseconds = (UInt64)worstTicks * 1000000 / pTimer->getFrequency();
+		std::cout << pDescription << ": " << (UInt)microseconds << "us for "
+			<< numberOfOperations << " operations, worst " << (UInt)worstMicroseconds
+			<< "us, largest free block " << largestFreeBlock << " of "
+			<< (useSlabs ? heapSize - slabArenaSize : heapSize) << " heap bytes";
+		if(useSlabs)
+		{
+			std::cout << ", " << slabAllocator.getAllocatedSize() << " of "
+				<< slabAllocator.getUsedArenaSize() << " slab bytes allocated";
+		}
+		std::cout << "\n";
+	#endif
+}
+
+void SlabBenchmarkTask::runRound(Bool useSlabs)
+{
+	// start with an empty heap and reset the random sequence
+	this->useSlabs = useSlabs;
+	seed = 1;
+	const UInt heapLimit = useSlabs ? heapSize - slabArenaSize : heapSize;
+	Heap_Initialise(pHeap, null, null, null, null);
+	Heap_InitMemory(pHeap, pHeap + 1, heapLimit - sizeof(Heap_Descriptor));
+	slabAllocator.initialize(addToPointer(heapArena, heapLimit), slabArenaSize);
+	{
+		for(UInt slot = 0; slot < numberOfSlots; ++slot)
+		{
+			blocks[slot] = null;
+		}
+	}
+
+	// allocate and free blocks in random order
+	TimeValue worstTicks = 0;
+	const TimeValue startTime = pTimer->getTime();
+	{
+		for(UInt operation = 0; operation < numberOfOperations; ++operation)
+		{
+			const UInt slot = getRandomSize() % numberOfSlots;
+			const TimeValue operationStartTime = pTimer->getTime();
+			if(blocks[slot] != null)
+			{
+				deallocate(blocks[slot]);
+				blocks[slot] = null;
+			}
+			else
+			{
+				blocks[slot] = allocate(getRandomSize());
+			}
+			const TimeValue operationTicks = compareTimes(pTimer->getTime(), operationStartTime);
+			if(operationTicks > worstTicks)
+			{
+				worstTicks = operationTicks;
+			}
+		}
+	}
+	const TimeValue elapsedTicks = compareTimes(pTimer->getTime(), startTime);
+
+	// keep a few long lived blocks and see how fragmented the heap has become
+	{
+		for(UInt slot = 0; slot < numberOfSlots; ++slot)
+		{
+			if(blocks[slot] != null && slot % survivorSpacing != 0)
+			{
+				deallocate(blocks[slot]);
+				blocks[slot] = null;
+			}
+		}
+	}
+	report(useSlabs ? "Slab" : "Heap", elapsedTicks, worstTicks, findLargestFreeBlock());
+
+	// clean up the survivors
+	{
+		for(UInt slot = 0; slot < numberOfSlots; ++slot)
+		{
+			if(blocks[slot] != null)
+			{
+				deallocate(blocks[slot]);
+			}
+		}
+	}
+}
+
+void SlabBenchmarkTask::main()
+{
+	runRound(false);
+	runRound(true);
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * slabBenchmark
+//------------------------------------------------------------------------------------------------
+
+void slabBenchmark()
+{
+	const UInt numberOfOperations = 200000;
+
+	(new SlabBenchmarkTask(numberOfOperations))->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
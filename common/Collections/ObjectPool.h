@@ -0,0 +1,360 @@
+#ifndef _ObjectPool_h_
+#define _ObjectPool_h_
+
+#include "../cPrimitiveTypes.h"
+#include "../pointerArithmetic.h"
+#include "../multitasking/Semaphore.h"
+#include "../multitasking/UninterruptableSection.h"
+#include "../multitasking/TimeValue.h"
+
+//------------------------------------------------------------------------------------------------
+// * class BasicObjectPool
+//
+// Keeps objects of type <Object> for repeated use, so that they need not be allocated from the
+// heap. The storage for the objects is provided by the derived classes: ObjectPool has a fixed
+// number of objects that are part of the pool, DynamicObjectPool has a number of objects chosen
+// at construction.
+// Every object sits in a slot that links it into an intrusive free list while it is not in
+// use, so acquiring and releasing an object take constant time. The free list is only briefly
+// protected by an uninterruptable section, a semaphore counts the free objects so that a task
+// can block until one is released.
+// tryAcquire and release never block and can be used from interrupt handlers.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+class BasicObjectPool
+{
+public:
+	// testing
+	inline Bool contains(const Object *pObject) const;
+
+	// accessing
+	inline UInt getCapacity() const;
+	inline UInt getNumberOfFreeObjects() const;
+	inline UInt getNumberOfUsedObjects() const;
+	inline UInt getMaximumNumberOfUsedObjects() const;
+	inline UInt getNumberOfAcquires() const;
+
+	// acquiring and releasing
+	Object *acquire(TimeValue timeout = infiniteTime);
+	Object *tryAcquire();
+	void release(Object *pObject);
+
+protected:
+	// types
+	struct Slot
+	{
+		Object object;
+		Slot *pNextFreeSlot;
+	};
+
+	// constructor
+	BasicObjectPool(UInt capacity);
+
+	// initializing
+	void linkSlots(Slot *pSlots);
+
+private:
+	// acquiring
+	Object *removeFreeSlot();
+
+	// representation
+	Slot *pSlots;
+	UInt capacity;
+	Slot *pFirstFreeSlot;
+	Semaphore freeSlotSemaphore;
+	UInt numberOfUsedObjects;
+	UInt maximumNumberOfUsedObjects;
+	UInt numberOfAcquires;
+};
+
+//------------------------------------------------------------------------------------------------
+// * class ObjectPool
+//
+// An object pool of <size> objects. The objects are constructed with the pool and live as long
+// as the pool does, the storage for them is part of the pool, so a static pool has static
+// storage and a pool that is a member of another object is stored within that object.
+//------------------------------------------------------------------------------------------------
+
+template<class Object, UInt size>
+class ObjectPool : public BasicObjectPool<Object>
+{
+public:
+	// constructor
+	ObjectPool();
+
+private:
+	// representation
+	typename BasicObjectPool<Object>::Slot slots[size];
+};
+
+//------------------------------------------------------------------------------------------------
+// * class DynamicObjectPool
+//
+// An object pool whose number of objects is given at construction. The objects are allocated
+// from the heap in one block when the pool is constructed and are freed with the pool.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+class DynamicObjectPool : public BasicObjectPool<Object>
+{
+public:
+	// constructor and destructor
+	DynamicObjectPool(UInt capacity);
+	~DynamicObjectPool();
+
+private:
+	// representation
+	typename BasicObjectPool<Object>::Slot *pSlots;
+};
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::BasicObjectPool
+//
+// Constructs a pool of <capacity> objects, the derived class must link its slots.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+BasicObjectPool<Object>::BasicObjectPool(UInt capacity) :
+	freeSlotSemaphore(capacity)
+{
+	pSlots = null;
+	this->capacity = capacity;
+	pFirstFreeSlot = null;
+	numberOfUsedObjects = 0;
+	maximumNumberOfUsedObjects = 0;
+	numberOfAcquires = 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::linkSlots
+//
+// Links all of the <capacity> slots at <pSlots> into the free list.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+void BasicObjectPool<Object>::linkSlots(Slot *pSlots)
+{
+	this->pSlots = pSlots;
+	for(UInt i = capacity; i > 0; --i)
+	{
+		pSlots[i - 1].pNextFreeSlot = pFirstFreeSlot;
+		pFirstFreeSlot = &pSlots[i - 1];
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::contains
+//
+// Tests whether <pObject> is one of the objects of this pool.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+inline Bool BasicObjectPool<Object>::contains(const Object *pObject) const
+{
+	// the object is the first member of its slot, so it must start a slot
+	return (const void *)pObject >= (const void *)&pSlots[0]
+		&& (const void *)pObject < (const void *)&pSlots[capacity]
+		&& (UInt)subtractPointers(pObject, &pSlots[0]) % sizeof(Slot) == 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::getCapacity
+//
+// Returns the number of objects in the pool.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+inline UInt BasicObjectPool<Object>::getCapacity() const
+{
+	return capacity;
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::getNumberOfFreeObjects
+//
+// Returns the number of objects that can be acquired without blocking.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+inline UInt BasicObjectPool<Object>::getNumberOfFreeObjects() const
+{
+	return freeSlotSemaphore.getExcessSignalCount();
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::getNumberOfUsedObjects
+//
+// Returns the number of objects that have been acquired and not yet released.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+inline UInt BasicObjectPool<Object>::getNumberOfUsedObjects() const
+{
+	return numberOfUsedObjects;
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::getMaximumNumberOfUsedObjects
+//
+// Returns the largest number of objects that have been in use at the same time.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+inline UInt BasicObjectPool<Object>::getMaximumNumberOfUsedObjects() const
+{
+	return maximumNumberOfUsedObjects;
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::getNumberOfAcquires
+//
+// Returns the number of objects that have been acquired since the pool was constructed.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+inline UInt BasicObjectPool<Object>::getNumberOfAcquires() const
+{
+	return numberOfAcquires;
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::acquire
+//
+// Acquires a free object from the pool.
+// If there is no free object, the current task will block until another task releases one.
+// Returns null if a timeout occurred.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+Object *BasicObjectPool<Object>::acquire(TimeValue timeout)
+{
+	// wait for a free slot
+	if(freeSlotSemaphore.wait(timeout))
+	{
+		// timeout
+		return null;
+	}
+
+	return removeFreeSlot();
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::tryAcquire
+//
+// Acquires a free object from the pool, without blocking.
+// Returns null if there is no free object.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+Object *BasicObjectPool<Object>::tryAcquire()
+{
+	// take a free slot only if there is one
+	if(!freeSlotSemaphore.tryWait())
+	{
+		return null;
+	}
+
+	return removeFreeSlot();
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::release
+//
+// Gives <pObject> back to the pool and unblocks a task waiting for a free object (if any).
+// An object that is not one of the objects of this pool is ignored.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+void BasicObjectPool<Object>::release(Object *pObject)
+{
+	// linking a foreign object into the free list would hand it out, or the memory around it
+	if(!contains(pObject))
+	{
+		return;
+	}
+
+	// the object is the first member of its slot
+	Slot *pSlot = (Slot *)pObject;
+
+	// put the slot back into the free list
+	{
+		UninterruptableSection criticalSection;
+		pSlot->pNextFreeSlot = pFirstFreeSlot;
+		pFirstFreeSlot = pSlot;
+		--numberOfUsedObjects;
+	}
+
+	// wake a task waiting for a free slot
+	freeSlotSemaphore.signal();
+}
+
+//------------------------------------------------------------------------------------------------
+// * BasicObjectPool::removeFreeSlot
+//
+// Removes a slot from the free list, which has already been reserved through the semaphore.
+// Returns the object in the slot.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+Object *BasicObjectPool<Object>::removeFreeSlot()
+{
+	UninterruptableSection criticalSection;
+
+	// take the first free slot
+	Slot *pSlot = pFirstFreeSlot;
+	pFirstFreeSlot = pSlot->pNextFreeSlot;
+
+	// keep the usage counters
+	++numberOfUsedObjects;
+	if(numberOfUsedObjects > maximumNumberOfUsedObjects)
+	{
+		maximumNumberOfUsedObjects = numberOfUsedObjects;
+	}
+	++numberOfAcquires;
+
+	return &pSlot->object;
+}
+
+//------------------------------------------------------------------------------------------------
+// * ObjectPool::ObjectPool
+//
+// Constructs a pool with all of its objects free.
+//------------------------------------------------------------------------------------------------
+
+template<class Object, UInt size>
+ObjectPool<Object, size>::ObjectPool() :
+	BasicObjectPool<Object>(size)
+{
+	// the slots have been constructed with the pool
+	this->linkSlots(slots);
+}
+
+//------------------------------------------------------------------------------------------------
+// * DynamicObjectPool::DynamicObjectPool
+//
+// Constructs a pool of <capacity> objects with all of its objects free.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+DynamicObjectPool<Object>::DynamicObjectPool(UInt capacity) :
+	BasicObjectPool<Object>(capacity)
+{
+	// allocate and construct all slots at once
+	pSlots = new typename BasicObjectPool<Object>::Slot[capacity];
+	this->linkSlots(pSlots);
+}
+
+//------------------------------------------------------------------------------------------------
+// * DynamicObjectPool::~DynamicObjectPool
+//
+// Destructor.
+//------------------------------------------------------------------------------------------------
+
+template<class Object>
+DynamicObjectPool<Object>::~DynamicObjectPool()
+{
+	delete[] pSlots;
+}
+
+#endif // _ObjectPool_h_
@@ -0,0 +1,205 @@
+#include "ObjectPool.h"
+#include "../multitasking/Task.h"
+#include "../multitasking/TaskScheduler.h"
+#include "../multitasking/sleep.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+static const UInt poolSize = 4;
+static const UInt timeoutInMilliseconds = 10;
+static const UInt releaseDelayInMilliseconds = 5;
+
+// an object of more than one word, so that a pointer into its middle is not an object
+struct PooledObject
+{
+	UInt first;
+	UInt second;
+};
+
+//------------------------------------------------------------------------------------------------
+// * class ReleasingTask
+//------------------------------------------------------------------------------------------------
+
+class ReleasingTask : public Task
+{
+public:
+	// constructor
+	ReleasingTask(BasicObjectPool<PooledObject> &pool, PooledObject *pObject);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	BasicObjectPool<PooledObject> &pool;
+	PooledObject *pObject;
+};
+
+ReleasingTask::ReleasingTask(BasicObjectPool<PooledObject> &pool, PooledObject *pObject) :
+	Task(mediumPriority, 10000),
+	pool(pool),
+	pObject(pObject)
+{
+}
+
+void ReleasingTask::main()
+{
+	// release the object a while after the test task has started to wait for one
+	sleepForMilliseconds(releaseDelayInMilliseconds);
+	pool.release(pObject);
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ObjectPoolTestTask
+//------------------------------------------------------------------------------------------------
+
+class ObjectPoolTestTask : public Task
+{
+public:
+	// constructor
+	ObjectPoolTestTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// testing
+	Bool check(const char *pDescription, Bool passed);
+	Bool checkCounters(const char *pDescription, const BasicObjectPool<PooledObject> &pool,
+		UInt used, UInt maximumUsed, UInt acquires);
+	Bool checkPool(const char *pDescription, BasicObjectPool<PooledObject> &pool);
+
+	// representation
+	Timer *pTimer;
+};
+
+ObjectPoolTestTask::ObjectPoolTestTask() :
+	Task(highPriority, 20000)
+{
+	pTimer = null;
+}
+
+Bool ObjectPoolTestTask::check(const char *pDescription, Bool passed)
+{
+	#if defined(PRINT)
+		std::cout << "  " << pDescription << (passed ? "" : " FAILED") << "\n";
+	#endif
+	return passed;
+}
+
+Bool ObjectPoolTestTask::checkCounters(const char *pDescription,
+	const BasicObjectPool<PooledObject> &pool, UInt used, UInt maximumUsed, UInt acquires)
+{
+	const Bool passed = pool.getNumberOfUsedObjects() == used
+		&& pool.getNumberOfFreeObjects() == pool.getCapacity() - used
+		&& pool.getMaximumNumberOfUsedObjects() == maximumUsed
+		&& pool.getNumberOfAcquires() == acquires;
+	#if defined(PRINT)
+		std::cout << "  " << pDescription << ": " << pool.getNumberOfUsedObjects() << " used, "
+			<< pool.getNumberOfFreeObjects() << " free, " << pool.getMaximumNumberOfUsedObjects()
+			<< " at most, " << pool.getNumberOfAcquires() << " acquires"
+			<< (passed ? "" : " FAILED") << "\n";
+	#endif
+	return passed;
+}
+
+Bool ObjectPoolTestTask::checkPool(const char *pDescription, BasicObjectPool<PooledObject> &pool)
+{
+	#if defined(PRINT)
+		std::cout << pDescription << " of " << pool.getCapacity() << " objects\n";
+	#endif
+
+	// empty the pool without blocking, every object is a different one of the pool
+	PooledObject *objects[poolSize];
+	Bool distinct = true;
+	for(UInt i = 0; i < poolSize; ++i)
+	{
+		objects[i] = pool.tryAcquire();
+		distinct = distinct && objects[i] != null && pool.contains(objects[i]);
+		for(UInt j = 0; j < i; ++j)
+		{
+			distinct = distinct && objects[i] != objects[j];
+		}
+	}
+	Bool passed = check("tryAcquire takes every object once", distinct);
+	passed = checkCounters("empty", pool, poolSize, poolSize, poolSize) && passed;
+	passed = check("tryAcquire on an empty pool returns null", pool.tryAcquire() == null) && passed;
+
+	// acquiring from an empty pool blocks until the timeout
+	const TimeValue startTime = pTimer->getTime();
+	const Bool timedOut = pool.acquire(pTimer->convertMilliseconds(timeoutInMilliseconds)) == null;
+	const Bool waited = compareTimes(pTimer->getTime(), startTime)
+		>= pTimer->convertMilliseconds(timeoutInMilliseconds);
+	passed = check("acquire on an empty pool times out", timedOut && waited) && passed;
+	passed = checkCounters("after the timeout", pool, poolSize, poolSize, poolSize) && passed;
+
+	// objects that are not from the pool are not taken into it
+	PooledObject foreignObject;
+	PooledObject *pMiddleOfObject = (PooledObject *)&objects[0]->second;
+	pool.release(&foreignObject);
+	pool.release(pMiddleOfObject);
+	passed = check("foreign objects are not contained",
+		!pool.contains(&foreignObject) && !pool.contains(pMiddleOfObject)) && passed;
+	passed = checkCounters("after releasing foreign objects", pool, poolSize, poolSize, poolSize)
+		&& passed;
+
+	// an object released by another task unblocks the acquire
+	ReleasingTask releasingTask(pool, objects[0]);
+	releasingTask.resume();
+	objects[0] = pool.acquire(pTimer->convertMilliseconds(1000));
+	passed = check("acquire takes an object released while it waits", objects[0] != null)
+		&& passed;
+	passed = checkCounters("after the release", pool, poolSize, poolSize, poolSize + 1) && passed;
+
+	// the high-water mark stays when the objects are released
+	for(UInt i = 0; i < poolSize; ++i)
+	{
+		pool.release(objects[i]);
+	}
+	passed = checkCounters("all released", pool, 0, poolSize, poolSize + 1) && passed;
+	PooledObject *pObject = pool.acquire(pTimer->convertMilliseconds(timeoutInMilliseconds));
+	passed = check("acquire on a pool with free objects", pObject != null) && passed;
+	pool.release(pObject);
+	passed = checkCounters("one more", pool, 0, poolSize, poolSize + 2) && passed;
+	return passed;
+}
+
+void ObjectPoolTestTask::main()
+{
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	ObjectPool<PooledObject, poolSize> pool;
+	DynamicObjectPool<PooledObject> dynamicPool(poolSize);
+	Bool passed = checkPool("Object pool", pool);
+	passed = checkPool("Dynamic object pool", dynamicPool) && passed;
+
+	#if defined(PRINT)
+		exit(passed ? 0 : 1);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * objectPoolTest
+//------------------------------------------------------------------------------------------------
+
+void objectPoolTest()
+{
+	(new ObjectPoolTestTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
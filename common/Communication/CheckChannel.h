@@ -29,6 +29,17 @@ public:
 	inline UInt write(const void *pSource, UInt length, TimeValue timeout);
 	inline void flush();
 
+	// zero-copy streaming
+	inline void *reserve(UInt *pLength);
+	inline void *reserve(UInt *pLength, TimeValue timeout);
+	inline void commit(UInt length);
+	inline const void *borrow(UInt *pLength);
+	inline const void *borrow(UInt *pLength, TimeValue timeout);
+	inline void release(UInt length);
+
+	// accessing
+	inline void setPriority(UInt priorityClass, UInt weight = CheckPacketLayer::defaultWeight);
+
 	// error related
 	inline void forceError();
 	inline void reset();
@@ -107,6 +118,87 @@ inline void CheckChannel::flush()
 	writeChannel.flush();
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckChannel::reserve
+//
+// Reserves space in the stream for writing.
+//------------------------------------------------------------------------------------------------
+
+inline void *CheckChannel::reserve(UInt *pLength)
+{
+	return writeChannel.reserve(pLength);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckChannel::reserve
+//
+// Reserves space in the stream for writing.
+//------------------------------------------------------------------------------------------------
+
+inline void *CheckChannel::reserve(UInt *pLength, TimeValue timeout)
+{
+	return writeChannel.reserve(pLength, timeout);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckChannel::commit
+//
+// Writes the space reserved last.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckChannel::commit(UInt length)
+{
+	writeChannel.commit(length);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckChannel::borrow
+//
+// Borrows data from the stream for reading.
+//------------------------------------------------------------------------------------------------
+
+inline const void *CheckChannel::borrow(UInt *pLength)
+{
+	writeChannel.flush();
+	return readChannel.borrow(pLength);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckChannel::borrow
+//
+// Borrows data from the stream for reading.
+//------------------------------------------------------------------------------------------------
+
+inline const void *CheckChannel::borrow(UInt *pLength, TimeValue timeout)
+{
+	writeChannel.flush();
+	return readChannel.borrow(pLength, timeout);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckChannel::release
+//
+// Reads the data borrowed last.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckChannel::release(UInt length)
+{
+	readChannel.release(length);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckChannel::setPriority
+//
+// Sets the priority class and weight of both directions, the acknowledgments of the data read
+// are sent in the same class as the data written.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckChannel::setPriority(UInt priorityClass, UInt weight)
+{
+	readChannel.setPriority(priorityClass, weight);
+	writeChannel.setPriority(priorityClass, weight);
+}
+
 //------------------------------------------------------------------------------------------------
 // * CheckChannel::forceError
 //
@@ -1,5 +1,9 @@
 #include "CheckPacket.h"
 #include "../Crc/Crc16Calculator.h"
+#include "../memoryUtilities.h"
+#include "../pointerArithmetic.h"
+
+UInt CheckPacket::numberOfDataCrcWalks = 0;
 
 //------------------------------------------------------------------------------------------------
 // * CheckPacket::CheckPacket
@@ -9,19 +13,206 @@
 
 CheckPacket::CheckPacket()
 {
+	connectionNumber = 0;
+	headerFormat = originalHeaderFormat;
+	packetHeader.extension = 0;
 	packetHeader.crcValue = 0;
 	packetHeader.bitfields = 0;
+	appendedCrcValue = 0;
+	appendedHeaderCrcValue = 0;
+	appendedLength = 0;
 }
 
 //------------------------------------------------------------------------------------------------
 // * CheckPacket::calculateCrcValue
 //
 // Calculates the CRC value of the packet.
+// If all of the data has been appended, the CRC has already been calculated while the data was
+// copied, filled or read, only a header that has changed since then needs to be accounted for.
 //------------------------------------------------------------------------------------------------
 
 UInt CheckPacket::calculateCrcValue() const
 {
-	return crc16Calculator.calculateCrc(
-		&packetHeader.crcValue + 1,
-		sizeof(CheckPacketHeader) - sizeof(packetHeader.crcValue) + getDataSize());
+	const UInt headerCrcValue = calculateHeaderCrcValue(packetHeader.extension, packetHeader.bitfields);
+
+	// check if the CRC was calculated while appending all of the data
+	if(appendedLength != 0 && appendedLength == getDataSize())
+	{
+		if(headerCrcValue == appendedHeaderCrcValue)
+		{
+			return appendedCrcValue;
+		}
+
+		// the CRC is linear, so the header it was calculated with only differs from this one by
+		// their difference shifted through the data, which combineCrc does without the data once
+		// the initial value it takes off has been put back
+		return slicingCrc16Calculator.combineCrc(
+			(UInt16)(headerCrcValue ^ appendedHeaderCrcValue ^ maximumOfIntegerType(UInt16)),
+			appendedCrcValue,
+			appendedLength);
+	}
+
+	// walk the header behind the CRC value and the data
+	if(getDataSize() != 0)
+	{
+		++numberOfDataCrcWalks;
+	}
+	return slicingCrc16Calculator.calculateCrc(packetData, getDataSize(), (UInt16)headerCrcValue);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::calculateHeaderCrcValue
+//
+// Calculates the CRC value of a header with the given fields, which the CRC value of the data
+// continues. The CRC covers the header except for the CRC value, the extension word only if it
+// is transmitted.
+//------------------------------------------------------------------------------------------------
+
+UInt CheckPacket::calculateHeaderCrcValue(UInt32 extension, UInt16 bitfields) const
+{
+	// the extension word is transmitted first, if at all
+	const UInt16 crc = slicingCrc16Calculator.calculateCrc(
+		&extension,
+		headerFormat != originalHeaderFormat ? sizeof(extension) : 0);
+	return slicingCrc16Calculator.calculateCrc(&bitfields, sizeof(bitfields), crc);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::calculateHeaderCheck
+//
+// Returns <extension> with the check value of the checked header filled in. The check value is
+// a CRC of the rest of the extension word and the bitfields, so that the receiver can trust the
+// data size before it has read the data, and can find the next header after a damaged one.
+//------------------------------------------------------------------------------------------------
+
+UInt32 CheckPacket::calculateHeaderCheck(UInt32 extension, UInt16 bitfields)
+{
+	const UInt16 checkedFields[2] = {(UInt16)(extension & ~extensionHeaderCheckMask), bitfields};
+	const UInt16 check = slicingCrc16Calculator.calculateCrc(checkedFields, sizeof(checkedFields));
+	return extension & ~extensionHeaderCheckMask | ((UInt32)check << extensionHeaderCheckShift);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::appendData
+//
+// Copies <length> bytes from <pSource> to the data of the packet at <offset> and calculates
+// the CRC of the packet in the same pass. The data must be appended in order, starting at
+// offset 0, after the channel ID and sequence number have been set.
+// The CRC is calculated with the header of a full packet, if fewer bytes are sent or the header
+// is changed the CRC is corrected for the header actually sent, without walking the data again.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacket::appendData(UInt offset, const void *pSource, UInt length)
+{
+	// start a new CRC at the beginning of the data
+	if(offset == 0)
+	{
+		beginAppending();
+	}
+
+	// check if the data is appended in order
+	if(offset == appendedLength)
+	{
+		appendedCrcValue = slicingCrc16Calculator.copyAndCalculateCrc(
+			addToPointer(packetData, offset),
+			pSource,
+			length,
+			appendedCrcValue);
+		appendedLength += length;
+	}
+	else
+	{
+		// the CRC will be calculated from the data
+		memoryCopy(addToPointer(packetData, offset), pSource, length);
+		appendedLength = 0;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::appendFilledData
+//
+// Appends the <length> bytes that have been written into the data of the packet at <offset>,
+// calculating the CRC of the packet as appendData does, without a copy.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacket::appendFilledData(UInt offset, UInt length)
+{
+	// start a new CRC at the beginning of the data
+	if(offset == 0)
+	{
+		beginAppending();
+	}
+
+	continueAppending(offset, length);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::appendReceivedData
+//
+// Appends the <length> bytes that have been read into the data of the packet at <offset>, after
+// the header, calculating the CRC of the packet with the header as received. Reading the data
+// in pieces this way calculates the CRC while the data is still in the cache, and checking
+// the CRC needs no second walk of the data.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacket::appendReceivedData(UInt offset, UInt length)
+{
+	// start a new CRC at the beginning of the data
+	if(offset == 0)
+	{
+		appendedHeaderCrcValue = (UInt16)calculateHeaderCrcValue(
+			packetHeader.extension,
+			packetHeader.bitfields);
+		appendedCrcValue = appendedHeaderCrcValue;
+		appendedLength = 0;
+	}
+
+	continueAppending(offset, length);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::continueAppending
+//
+// Continues the CRC with the <length> bytes of data at <offset>, if they follow the data
+// appended so far. Otherwise the CRC will be calculated from the data.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacket::continueAppending(UInt offset, UInt length)
+{
+	// check if the data is appended in order
+	if(offset == appendedLength)
+	{
+		appendedCrcValue = slicingCrc16Calculator.calculateCrc(
+			addToPointer(packetData, offset),
+			length,
+			appendedCrcValue);
+		appendedLength += length;
+	}
+	else
+	{
+		// the CRC will be calculated from the data
+		appendedLength = 0;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::beginAppending
+//
+// Starts the CRC of data appended from offset 0, with the header of a full packet.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacket::beginAppending()
+{
+	const UInt16 savedBitfields = packetHeader.bitfields;
+	setDataSize(maximumPacketDataSize);
+	UInt32 extension = packetHeader.extension;
+	const UInt16 bitfields = packetHeader.bitfields;
+	if(headerFormat == checkedHeaderFormat)
+	{
+		extension = calculateHeaderCheck(extension, bitfields);
+	}
+	packetHeader.bitfields = savedBitfields;
+	appendedHeaderCrcValue = (UInt16)calculateHeaderCrcValue(extension, bitfields);
+	appendedCrcValue = appendedHeaderCrcValue;
+	appendedLength = 0;
 }
@@ -2,14 +2,16 @@
 #define _CheckPacket_h_
 
 #include "../cPrimitiveTypes.h"
+#include "../Collections/Link.h"
 
 //------------------------------------------------------------------------------------------------
 // * class CheckPacket
 //
 // Represents a piece of data trasmitted or received over a communication link.
+// The link queues the packet with the other packets of its channel while it waits to be sent.
 //------------------------------------------------------------------------------------------------
 
-class CheckPacket
+class CheckPacket : public Link
 {
 public:
 	CheckPacket();
@@ -17,27 +19,52 @@ public:
 	// types
 	struct CheckPacketHeader
 	{
+		UInt32 extension;
 		UInt16 crcValue;
 		UInt16 bitfields;
 	};
 	
+	enum HeaderFormat
+	{
+		originalHeaderFormat,
+		extendedHeaderFormat,
+		checkedHeaderFormat
+	};
+
 	enum { numberOfSequenceBits = 2 };
+	enum { numberOfExtendedSequenceBits = 8 };
+	enum { maximumPacketDataSize = 1016 };
 
 	// testing
 	inline Bool isCrcValid() const;
+	inline Bool isHeaderCheckValid() const;
+	inline Bool isNegativeAcknowledgment() const;
 
 	// querying
 	inline UInt getMaximumPacketDataSize() const;
+	static inline UInt getNumberOfDataCrcWalks();
 
 	// accessing
 	inline const CheckPacketHeader *getPacketHeader() const;
 	inline CheckPacketHeader *getPacketHeader();
 	inline const void *getPacketData() const;
 	inline void *getPacketData();
+	inline const void *getTransmittedHeader() const;
+	inline void *getTransmittedHeader();
+	inline UInt getTransmittedHeaderSize() const;
+
+	// filling
+	inline void *reserveData(UInt offset);
+	void appendData(UInt offset, const void *pSource, UInt length);
+	void appendFilledData(UInt offset, UInt length);
+	void appendReceivedData(UInt offset, UInt length);
 
 	// accessing header fields
 	inline UInt getConnectionNumber() const;
 	inline void setConnectionNumber(UInt connectionNumber);
+	inline HeaderFormat getHeaderFormat() const;
+	inline void setHeaderFormat(HeaderFormat headerFormat);
+	inline void setNegativeAcknowledgment(Bool negativeAcknowledgment);
 	inline UInt getChannelId() const;
 	inline void setChannelId(UInt channelId);
 	inline UInt getSequenceNumber() const;
@@ -53,9 +80,40 @@ public:
 
 private:
 	
+	// fields of the extension word
+	enum
+	{
+		extensionSequenceNumberMask = 0x0000003Fu,
+		extensionPacketTypeShift = 6,
+		extensionPacketTypeMask = 0x000000C0u,
+		extensionChannelIdShift = 8,
+		extensionChannelIdMask = 0x0000FF00u,
+		extensionHeaderCheckShift = 16,
+		extensionHeaderCheckMask = 0xFFFF0000u
+	};
+
+	// packet types of the checked header
+	enum
+	{
+		dataPacketType = 0,
+		negativeAcknowledgmentPacketType = 1
+	};
+
+	// CRC calculation
+	void beginAppending();
+	void continueAppending(UInt offset, UInt length);
+	UInt calculateHeaderCrcValue(UInt32 extension, UInt16 bitfields) const;
+	static UInt32 calculateHeaderCheck(UInt32 extension, UInt16 bitfields);
+
 	// representation
+	static UInt numberOfDataCrcWalks;
 	UInt connectionNumber;
-	enum { maximumPacketDataSize = 1016 };
+	HeaderFormat headerFormat;
+
+	// CRC of the header and the data appended so far, and of that header alone
+	UInt16 appendedCrcValue;
+	UInt16 appendedHeaderCrcValue;
+	UInt appendedLength;
 	
 	// packet contents
 	CheckPacketHeader packetHeader;
@@ -73,6 +131,34 @@ inline Bool CheckPacket::isCrcValid() const
 	return packetHeader.crcValue == calculateCrcValue();
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::isHeaderCheckValid
+//
+// Tests whether the header received contains no errors, so that its data size can be trusted
+// even if the data has errors. Only the checked header can be tested, any other header is
+// assumed to be valid.
+//------------------------------------------------------------------------------------------------
+
+inline Bool CheckPacket::isHeaderCheckValid() const
+{
+	return headerFormat != checkedHeaderFormat
+		|| packetHeader.extension == calculateHeaderCheck(packetHeader.extension, packetHeader.bitfields);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::isNegativeAcknowledgment
+//
+// Tests whether the packet asks the other end to send the packet with its sequence number
+// again. Only the checked header carries negative acknowledgments.
+//------------------------------------------------------------------------------------------------
+
+inline Bool CheckPacket::isNegativeAcknowledgment() const
+{
+	return headerFormat == checkedHeaderFormat
+		&& (packetHeader.extension & extensionPacketTypeMask)
+			== (negativeAcknowledgmentPacketType << extensionPacketTypeShift);
+}
+
 //------------------------------------------------------------------------------------------------
 // * CheckPacket::getMaximumPacketDataSize
 //
@@ -84,6 +170,18 @@ inline UInt CheckPacket::getMaximumPacketDataSize() const
 	return maximumPacketDataSize;
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::getNumberOfDataCrcWalks
+//
+// Returns the number of times the CRC of a packet has been calculated by walking its data,
+// rather than taken from the data appended, so that benchmarks can check how often that happens.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckPacket::getNumberOfDataCrcWalks()
+{
+	return numberOfDataCrcWalks;
+}
+
 //------------------------------------------------------------------------------------------------
 // * CheckPacket::getConnectionNumber
 //
@@ -106,15 +204,60 @@ inline void CheckPacket::setConnectionNumber(UInt connectionNumber)
 	this->connectionNumber = connectionNumber;
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::getHeaderFormat
+//
+// Returns the format of the header the packet is transmitted with, which depends on what both
+// ends of the connection support. The extended header carries wider sequence numbers, the
+// checked header also carries a packet type and a check value of the header alone. Both carry
+// the upper bits of extended channel IDs.
+//------------------------------------------------------------------------------------------------
+
+inline CheckPacket::HeaderFormat CheckPacket::getHeaderFormat() const
+{
+	return headerFormat;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::setHeaderFormat
+//
+// Accessor.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckPacket::setHeaderFormat(HeaderFormat headerFormat)
+{
+	this->headerFormat = headerFormat;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::setNegativeAcknowledgment
+//
+// Accessor.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckPacket::setNegativeAcknowledgment(Bool negativeAcknowledgment)
+{
+	packetHeader.extension = packetHeader.extension & ~extensionPacketTypeMask
+		| ((negativeAcknowledgment ? negativeAcknowledgmentPacketType : dataPacketType)
+			<< extensionPacketTypeShift);
+}
+
 //------------------------------------------------------------------------------------------------
 // * CheckPacket::getChannelId
 //
 // Accessor.
+// The extended header carries the upper bits of the channel ID in the extension word, an end
+// that does not support extended channel IDs leaves them zero.
 //------------------------------------------------------------------------------------------------
 
 inline UInt CheckPacket::getChannelId() const
 {
-	return packetHeader.bitfields & ((UInt16)0xfu);
+	UInt channelId = packetHeader.bitfields & ((UInt16)0xfu);
+	if(headerFormat != originalHeaderFormat)
+	{
+		channelId |= (packetHeader.extension & extensionChannelIdMask) >> (extensionChannelIdShift - 4);
+	}
+	return channelId;
 }
 
 //------------------------------------------------------------------------------------------------
@@ -125,18 +268,29 @@ inline UInt CheckPacket::getChannelId() const
 
 inline void CheckPacket::setChannelId(UInt channelId)
 {
-	packetHeader.bitfields = (packetHeader.bitfields & ~((UInt16)0xfu)) | channelId;
+	packetHeader.bitfields = (packetHeader.bitfields & ~((UInt16)0xfu)) | (channelId & 0xfu);
+	if(headerFormat != originalHeaderFormat)
+	{
+		packetHeader.extension = packetHeader.extension & ~extensionChannelIdMask
+			| ((channelId << (extensionChannelIdShift - 4)) & extensionChannelIdMask);
+	}
 }
 
 //------------------------------------------------------------------------------------------------
 // * CheckPacket::getSequenceNumber
 //
 // Accessor.
+// The extended header carries the upper bits of the sequence number in its lowest bits.
 //------------------------------------------------------------------------------------------------
 
 inline UInt CheckPacket::getSequenceNumber() const
 {
-	return (packetHeader.bitfields >> 4) & ((UInt16)0x03u);
+	UInt sequenceNumber = (packetHeader.bitfields >> 4) & ((UInt16)0x03u);
+	if(headerFormat != originalHeaderFormat)
+	{
+		sequenceNumber |= (packetHeader.extension & extensionSequenceNumberMask) << 2;
+	}
+	return sequenceNumber;
 }
 
 //------------------------------------------------------------------------------------------------
@@ -147,7 +301,12 @@ inline UInt CheckPacket::getSequenceNumber() const
 
 inline void CheckPacket::setSequenceNumber(UInt sequenceNumber)
 {
-	packetHeader.bitfields = (packetHeader.bitfields) & ~(((UInt16)0x03u) << 4) | (sequenceNumber << 4);
+	packetHeader.bitfields = (packetHeader.bitfields) & ~(((UInt16)0x03u) << 4) | ((sequenceNumber & 0x03u) << 4);
+	if(headerFormat != originalHeaderFormat)
+	{
+		packetHeader.extension = packetHeader.extension & ~extensionSequenceNumberMask
+			| ((sequenceNumber >> 2) & extensionSequenceNumberMask);
+	}
 }
 
 //------------------------------------------------------------------------------------------------
@@ -197,11 +356,16 @@ inline void CheckPacket::setCrcValue(UInt crc)
 //------------------------------------------------------------------------------------------------
 // * CheckPacket::setCrcValue
 //
-// Accessor.
+// Fills in the CRC value of the packet and, for the checked header, the check value of the
+// header, which the CRC value covers.
 //------------------------------------------------------------------------------------------------
 
 inline void CheckPacket::setCrcValue()
 {
+	if(headerFormat == checkedHeaderFormat)
+	{
+		packetHeader.extension = calculateHeaderCheck(packetHeader.extension, packetHeader.bitfields);
+	}
 	packetHeader.crcValue = calculateCrcValue();
 }
 
@@ -242,11 +406,72 @@ inline const void *CheckPacket::getPacketData() const
 // * CheckPacket::getPacketData
 //
 // Accessor.
+// The data may be changed through the pointer returned, so the CRC of the data appended so far
+// can no longer be used.
 //------------------------------------------------------------------------------------------------
 
 inline void *CheckPacket::getPacketData()
 {
+	appendedLength = 0;
 	return packetData;
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::reserveData
+//
+// Returns the data of the packet from <offset>, to be filled by the caller and then appended
+// with appendFilledData. Unlike getPacketData, this keeps the CRC of the data appended so far.
+//------------------------------------------------------------------------------------------------
+
+inline void *CheckPacket::reserveData(UInt offset)
+{
+	return packetData + offset;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::getTransmittedHeader
+//
+// Returns the part of the header that is transmitted, which is immediately followed by the
+// data. The extension word is not transmitted with the original header.
+//------------------------------------------------------------------------------------------------
+
+inline const void *CheckPacket::getTransmittedHeader() const
+{
+	if(headerFormat != originalHeaderFormat)
+	{
+		return &packetHeader.extension;
+	}
+	return &packetHeader.crcValue;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::getTransmittedHeader
+//
+// Accessor.
+//------------------------------------------------------------------------------------------------
+
+inline void *CheckPacket::getTransmittedHeader()
+{
+	if(headerFormat != originalHeaderFormat)
+	{
+		return &packetHeader.extension;
+	}
+	return &packetHeader.crcValue;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacket::getTransmittedHeaderSize
+//
+// Returns the size of the part of the header that is transmitted.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckPacket::getTransmittedHeaderSize() const
+{
+	if(headerFormat != originalHeaderFormat)
+	{
+		return sizeof(CheckPacketHeader);
+	}
+	return sizeof(CheckPacketHeader) - sizeof(packetHeader.extension);
+}
+
 #endif // _CheckPacket_h_
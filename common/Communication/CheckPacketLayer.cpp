@@ -11,37 +11,52 @@
 // * CheckPacketLayer::CheckPacketLayer
 //
 // Constructor.
+// Every channel takes up to twice the <packetPipelineDepth> packets, so the packet pool grows
+// with the depth. The depth is limited to the range from defaultPacketPipelineDepth to
+// maximumPacketPipelineDepth. The <capabilities> are those this end offers to use.
+// The packet pool has room for <maximumNumberOfOpenChannels> unidirectional channels, more
+// channels open at the same time wait for each other's packets.
 //------------------------------------------------------------------------------------------------
 
-CheckPacketLayer::CheckPacketLayer(Stream &stream, UInt basePriority) :
+CheckPacketLayer::CheckPacketLayer(
+	Stream &stream,
+	UInt basePriority,
+	UInt packetPipelineDepth,
+	UInt capabilities,
+	UInt maximumNumberOfOpenChannels) :
 	stream(stream),
-	freeQueue(maximumNumberOfChannels * packetPipelineDepth * 2 + 2),
-	sendQueue(maximumNumberOfChannels * packetPipelineDepth * 2 + 1),
+	requestedPacketPipelineDepth(
+		maximum(minimum(packetPipelineDepth, (UInt)maximumPacketPipelineDepth), (UInt)defaultPacketPipelineDepth)),
+	packetPool(maximumNumberOfOpenChannels * requestedPacketPipelineDepth * 2 + 2),
 	packetTransmitter(this, basePriority, 20000),
 	packetReceiver(this, basePriority + 1, 20000)
 {
+	// the original header is used until the other end has agreed to a depth
 	connectionNumber = 0;
+	this->packetPipelineDepth = defaultPacketPipelineDepth;
+	requestedCapabilities = capabilities & allCapabilities;
+	this->capabilities = 0;
+	headerFormat = CheckPacket::originalHeaderFormat;
+	numberOfDamagedPackets = 0;
+	numberOfResentPackets = 0;
+	coalescing = true;
+	coalescingDelay = 0;
+	numberOfWrites = 0;
+	stopping = false;
+
+	// packets are sent again after 200ms without an acknowledgment
 	#if defined(MSOS_MULTITASKING)
-		thisConnectionId = TaskScheduler::getCurrentTaskScheduler()->getTimer()->getTime() | 1;
+		retransmissionTimeout = TaskScheduler::getCurrentTaskScheduler()->getTimer()->getFrequency() / 5;
 	#endif
 	#if defined(WIN32_MULTITASKING)
-		thisConnectionId = GetTickCount() | 1;
+		retransmissionTimeout = 200;
 	#endif
+	retransmissionCheckTime = getCurrentTime();
+
+	thisConnectionId = getCurrentTime() | 1;
 	otherConnectionId = 1;
 	stream.forceError();
 
-	// no channels
-	for(UInt i = 0; i < maximumNumberOfChannels; ++i)
-	{
-		pChannels[i] = null;
-	}
-
-	// create working packets
-	for(UInt j = 0; j < maximumNumberOfChannels * packetPipelineDepth * 2 + 2; ++j)
-	{
-		freeQueue.addLast(new CheckPacket);
-	}
-
 	// start the transmitter and receiver tasks
 	packetTransmitter.resume();
 	packetReceiver.resume();
@@ -51,19 +66,38 @@ CheckPacketLayer::CheckPacketLayer(Stream &stream, UInt basePriority) :
 // * CheckPacketLayer::~CheckPacketLayer
 //
 // Destructor.
+// The transmitter and receiver tasks leave their loops before the layer is gone. Suspending them
+// wherever they are would leave the mutexes they hold locked, and the timeout of a wait they are
+// in running on a stack that is freed. The channels must have been deleted, the stream may be
+// deleted once the layer is.
 //------------------------------------------------------------------------------------------------
 
 CheckPacketLayer::~CheckPacketLayer()
 {
-	// stop the transmitter and receiver tasks
-	packetTransmitter.suspend();
-	packetReceiver.suspend();
-
-	// delete working packets
-	//for(UInt i = 0; i < maximumNumberOfChannels * packetPipelineDepth * 2 + 2; ++i)
-	//{
-	//	delete freeQueue.removeFirst();
-	//}
+	// wake the transmitter, and end the read the receiver is waiting for by forcing an error
+	stopping = true;
+	sendSemaphore.signal();
+	stream.forceError();
+
+	// wait for both tasks to stop
+	stoppedSemaphore.wait();
+	stoppedSemaphore.wait();
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::getCurrentTime
+//
+// Returns the time used for retransmission timeouts.
+//------------------------------------------------------------------------------------------------
+
+TimeValue CheckPacketLayer::getCurrentTime() const
+{
+	#if defined(MSOS_MULTITASKING)
+		return TaskScheduler::getCurrentTaskScheduler()->getTimer()->getTime();
+	#endif
+	#if defined(WIN32_MULTITASKING)
+		return GetTickCount();
+	#endif
 }
 
 //------------------------------------------------------------------------------------------------
@@ -81,43 +115,233 @@ Stream * CheckPacketLayer::createChannel(UInt readChannelId, UInt writeChannelId
 // * CheckPacketLayer::addChannel
 //
 // Adds a channel to the packet layer.
+// A channel whose ID the current connection cannot carry is forced into error, rather than
+// share its packets with the channel its ID would be cut down to.
 //------------------------------------------------------------------------------------------------
 
 void CheckPacketLayer::addChannel(UnidirectionalChannel *pChannel)
 {
-	// add the channel
+	// check if the connection can carry the channel ID
+	if(pChannel->getChannelId() >= getNumberOfChannelIds())
+	{
+		pChannel->forceError();
+		return;
+	}
+
+	LockedSection sendLock(sendMutex);
 	LockedSection channelsLock(channelsMutex);
-	pChannels[pChannel->getChannelId()] = (CheckUnidirectionalChannel *)pChannel;
+
+	// take the packets queued on the channel ID out of a channel it replaces
+	CheckUnidirectionalChannel *pQueuingChannel = (CheckUnidirectionalChannel *)getChannel(pChannel->getChannelId());
+	if(pQueuingChannel != null && pQueuingChannel != pChannel)
+	{
+		unscheduleChannel(pQueuingChannel);
+	}
+
+	// add the channel
+	setChannel(pChannel->getChannelId(), pChannel);
 }
 
 //------------------------------------------------------------------------------------------------
 // * CheckPacketLayer::removeChannel
 //
 // Removes a channel from the packet layer.
+// The packets the channel has queued are still sent, ahead of the packets of all channels.
 //------------------------------------------------------------------------------------------------
 
 void CheckPacketLayer::removeChannel(UnidirectionalChannel *pChannel)
 {
-	// remove the channel
+	LockedSection sendLock(sendMutex);
 	LockedSection channelsLock(channelsMutex);
-	pChannels[pChannel->getChannelId()] = null;
+
+	// take the packets queued on the channel ID out of the channel
+	CheckUnidirectionalChannel *pQueuingChannel = (CheckUnidirectionalChannel *)getChannel(pChannel->getChannelId());
+	if(pQueuingChannel != null)
+	{
+		unscheduleChannel(pQueuingChannel);
+	}
+
+	// remove the channel
+	setChannel(pChannel->getChannelId(), null);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::setChannelPriority
+//
+// Puts <pChannel> into <priorityClass>, up to highestPriorityClass, with <weight>, which is at
+// least one. A channel with packets queued waits for its next turn in the new class.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacketLayer::setChannelPriority(
+	CheckUnidirectionalChannel *pChannel,
+	UInt priorityClass,
+	UInt weight)
+{
+	LockedSection sendLock(sendMutex);
+	priorityClass = minimum(priorityClass, (UInt)highestPriorityClass);
+	weight = maximum(weight, (UInt)1);
+
+	// move the channel to the new class, if it is waiting for a turn
+	if(!pChannel->queuedPackets.isEmpty() && priorityClass != pChannel->priorityClass)
+	{
+		sendingChannels[pChannel->priorityClass].remove(pChannel);
+		sendingChannels[priorityClass].addLast(pChannel);
+	}
+	pChannel->priorityClass = priorityClass;
+	pChannel->weight = weight;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::queuePacket
+//
+// Queues <pPacket> to be sent after the other packets of its channel, or before them if
+// <first>. A channel that had no packets queued waits for a turn in its class. A packet whose
+// channel is not in the layer is sent ahead of the packets of all channels.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacketLayer::queuePacket(CheckPacket *pPacket, Bool first)
+{
+	{
+		LockedSection sendLock(sendMutex);
+		LockedSection channelsLock(channelsMutex);
+
+		// get the channel the packet belongs to
+		CheckUnidirectionalChannel *pChannel = (CheckUnidirectionalChannel *)getChannel(pPacket->getChannelId());
+		if(pChannel == null)
+		{
+			unscheduledPackets.addLast(pPacket);
+		}
+		else
+		{
+			// queue the packet on the channel
+			if(pChannel->queuedPackets.isEmpty())
+			{
+				sendingChannels[pChannel->priorityClass].addLast(pChannel);
+			}
+			if(first)
+			{
+				pChannel->queuedPackets.addFirst(pPacket);
+			}
+			else
+			{
+				pChannel->queuedPackets.addLast(pPacket);
+			}
+		}
+	}
+
+	// wake up the transmitter
+	sendSemaphore.signal();
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::removeNextPacket
+//
+// Removes the packet to be sent next from the queues and returns it, or returns null if no
+// packet is queued.
+// The channels in a class take turns in the order they started waiting. The channel whose turn
+// it is sends packets as long as its credit allows, and gets its weight in quanta of credit
+// when it runs out and goes to the back. A channel that has sent all its packets loses its
+// credit, so a channel cannot save up for a burst while it is idle.
+//------------------------------------------------------------------------------------------------
+
+CheckPacket *CheckPacketLayer::removeNextPacket()
+{
+	LockedSection sendLock(sendMutex);
+
+	// send the packets of removed channels first
+	if(!unscheduledPackets.isEmpty())
+	{
+		return (CheckPacket *)unscheduledPackets.removeFirst();
+	}
+
+	// serve the highest priority class that has packets queued
+	for(UInt priorityClass = numberOfPriorityClasses; priorityClass > 0; --priorityClass)
+	{
+		LinkedList &channels = sendingChannels[priorityClass - 1];
+		while(!channels.isEmpty())
+		{
+			// check if the channel whose turn it is has enough credit for its next packet
+			CheckUnidirectionalChannel *pChannel = (CheckUnidirectionalChannel *)channels.getFirst();
+			CheckPacket *pPacket = (CheckPacket *)pChannel->queuedPackets.getFirst();
+			const UInt packetSize = pPacket->getTransmittedHeaderSize() + pPacket->getDataSize();
+			if(pChannel->sendCredit >= packetSize)
+			{
+				// send the packet, the channel is done once it has nothing more to send
+				pChannel->sendCredit -= packetSize;
+				pChannel->queuedPackets.removeFirst();
+				if(pChannel->queuedPackets.isEmpty())
+				{
+					channels.removeFirst();
+					pChannel->sendCredit = 0;
+				}
+				return pPacket;
+			}
+
+			// give the channel credit for its next turn and let the next channel go
+			pChannel->sendCredit += pChannel->weight * schedulingQuantum;
+			channels.removeFirst();
+			channels.addLast(pChannel);
+		}
+	}
+	return null;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::unscheduleChannel
+//
+// Takes <pChannel> out of its class and moves the packets it has queued to the packets that
+// are sent first. The sendMutex must be locked.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacketLayer::unscheduleChannel(CheckUnidirectionalChannel *pChannel)
+{
+	if(pChannel->queuedPackets.isEmpty())
+	{
+		return;
+	}
+	sendingChannels[pChannel->priorityClass].remove(pChannel);
+	while(!pChannel->queuedPackets.isEmpty())
+	{
+		unscheduledPackets.addLast(pChannel->queuedPackets.removeFirst());
+	}
+	pChannel->sendCredit = 0;
 }
 
 //------------------------------------------------------------------------------------------------
 // * CheckPacketLayer::transmitPackets
 //
-// Transmits packets in an infinite loop.
+// Transmits packets in a loop, until the layer is stopping.
+// With selective retransmission the channels are checked for packets to send again in between.
 //------------------------------------------------------------------------------------------------
 
 void CheckPacketLayer::transmitPackets()
 {
-	// keep sending packets forever
-	while(true)
+	CheckPacket *pPackets[maximumNumberOfCoalescedPackets];
+
+	// keep sending packets until the layer is deleted
+	while(!stopping)
 	{
 		// get a packet from the send queue
-		sendQueue.reserveElementToRemoveFirst();
+		if(isRetransmissionSelective())
+		{
+			// wake up in time to check for packets to send again
+			checkRetransmissions();
+			if(sendSemaphore.wait(retransmissionTimeout / 2))
+			{
+				// timeout
+				continue;
+			}
+		}
+		else
+		{
+			sendSemaphore.wait();
+		}
 		LockedSection writeAndResetLock(writeAndResetMutex);
-		CheckPacket *pPacket = sendQueue.removeReservedElementFirst();
+		CheckPacket *pPacket = removeNextPacket();
+		if(pPacket == null)
+		{
+			continue;
+		}
 
 		// check that this packet belongs to the current connection
 		if(pPacket->getConnectionNumber() != connectionNumber)
@@ -127,24 +351,117 @@ void CheckPacketLayer::transmitPackets()
 			continue;
 		}
 
-		// write the packet (header and data)
+		// write the packet, together with the packets queued behind it
+		writePackets(pPackets, collectPackets(pPacket, pPackets));
+	}
+	stoppedSemaphore.signal();
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::collectPackets
+//
+// Collects <pFirstPacket> and the packets queued behind it into <ppPackets>, to be sent with a
+// single write. Packets are collected as long as a packet of any size still fits into the
+// coalescing buffer, so no packet has to be put back into the send queue, and no longer than
+// the coalescing delay after the first.
+// Returns the number of packets collected.
+//------------------------------------------------------------------------------------------------
+
+UInt CheckPacketLayer::collectPackets(CheckPacket *pFirstPacket, CheckPacket **ppPackets)
+{
+	ppPackets[0] = pFirstPacket;
+	UInt numberOfPackets = 1;
+	if(!coalescing)
+	{
+		return numberOfPackets;
+	}
+
+	// collect more packets
+	const UInt maximumPacketSize = sizeof(CheckPacket::CheckPacketHeader) + pFirstPacket->getMaximumPacketDataSize();
+	UInt coalescedSize = pFirstPacket->getTransmittedHeaderSize() + pFirstPacket->getDataSize();
+	const TimeValue endTime = getCurrentTime() + coalescingDelay;
+	while(numberOfPackets < maximumNumberOfCoalescedPackets
+		&& coalescedSize + maximumPacketSize <= coalescingBufferSize)
+	{
+		// wait for another packet until the coalescing delay is over
+		TimeValue timeout = 0;
+		if(coalescingDelay != 0)
+		{
+			const TimeValue currentTime = getCurrentTime();
+			if(compareTimes(endTime, currentTime) > 0)
+			{
+				timeout = endTime - currentTime;
+			}
+		}
+		if(sendSemaphore.wait(timeout))
+		{
+			// no more packets
+			break;
+		}
+		CheckPacket *pPacket = removeNextPacket();
+		if(pPacket == null)
+		{
+			break;
+		}
+
+		// check that this packet belongs to the current connection
+		if(pPacket->getConnectionNumber() != connectionNumber)
+		{
+			// ignore this packet
+			freePacket(pPacket);
+			continue;
+		}
+		ppPackets[numberOfPackets++] = pPacket;
+		coalescedSize += pPacket->getTransmittedHeaderSize() + pPacket->getDataSize();
+	}
+	return numberOfPackets;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::writePackets
+//
+// Writes the <numberOfPackets> packets in <ppPackets> (header and data) with a single write,
+// and gives them back to their channels. A single packet is written from where it is, several
+// are copied into the coalescing buffer first.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacketLayer::writePackets(CheckPacket **ppPackets, UInt numberOfPackets)
+{
+	// write the packets
+	if(numberOfPackets == 1)
+	{
 		stream.write(
-			pPacket->getPacketHeader(),
-			sizeof(CheckPacket::CheckPacketHeader) + pPacket->getDataSize());
+			ppPackets[0]->getTransmittedHeader(),
+			ppPackets[0]->getTransmittedHeaderSize() + ppPackets[0]->getDataSize());
+	}
+	else
+	{
+		UInt coalescedSize = 0;
+		for(UInt i = 0; i < numberOfPackets; ++i)
+		{
+			const UInt packetSize = ppPackets[i]->getTransmittedHeaderSize() + ppPackets[i]->getDataSize();
+			memoryCopy(&coalescingBuffer[coalescedSize], ppPackets[i]->getTransmittedHeader(), packetSize);
+			coalescedSize += packetSize;
+		}
+		stream.write(coalescingBuffer, coalescedSize);
+	}
+	++numberOfWrites;
 
-		// get the channel this packet belongs to
-		LockedSection channelsLock(channelsMutex);
-		CheckUnidirectionalChannel *pChannel;
-		if(pPacket->getChannelId() < getMaximumNumberOfChannels()
-			&& (pChannel = pChannels[pPacket->getChannelId()]) != null)
+	// get the channels the packets belong to
+	LockedSection channelsLock(channelsMutex);
+	for(UInt i = 0; i < numberOfPackets; ++i)
+	{
+		CheckPacket *pPacket = ppPackets[i];
+		CheckUnidirectionalChannel *pChannel = (CheckUnidirectionalChannel *)getChannel(pPacket->getChannelId());
+		if(pChannel != null)
 		{
 			// give the packet back to the channel
-			// the channel will record the packet in its history queue
+			// the channel will record the packet in its history
 			pChannel->recordPacket(pPacket);
 		}
 		else
 		{
-			// this packet belongs to an unknown channel, put it back in the free queue
+			// this packet belongs to an unknown channel, put it back in the packet pool
 			freePacket(pPacket);
 		}
 	}
@@ -153,58 +470,154 @@ void CheckPacketLayer::transmitPackets()
 //------------------------------------------------------------------------------------------------
 // * CheckPacketLayer::receivePackets
 //
-// Receives packets in an infinite loop.
+// Receives packets in a loop, until the layer is stopping.
 //------------------------------------------------------------------------------------------------
 
 void CheckPacketLayer::receivePackets()
 {
-	// keep receiving packets forever
-	while(true)
+	// keep receiving packets until the layer is deleted
+	while(!stopping)
 	{
-		// get a packet from the free queue
+		// get a packet from the packet pool
 		CheckPacket *pPacket = getFreePacket();
 		
 		// read the packet
-		stream.read(pPacket->getPacketHeader(), sizeof(CheckPacket::CheckPacketHeader));
-		if(pPacket->getDataSize() > 0)
+		const Bool crcValid = readPacket(pPacket);
+
+		// check if the read was ended to stop the layer, rather than resynchronize the link
+		if(stopping)
 		{
-			stream.read(pPacket->getPacketData(), pPacket->getDataSize());
+			freePacket(pPacket);
+			break;
 		}
 
 		// check for errors
-		if(stream.isInError() || !pPacket->isCrcValid())
+		if(stream.isInError() || (!crcValid && !isRetransmissionSelective()))
 		{
 			// ignore this packet, it may have errors
 			freePacket(pPacket);
 
-			// handle the error
+			// resynchronize the link, which makes the channels resend their packets
+			stream.forceError();
 			handleError();
 
 			// continue reading packets
 			continue;
 		}
 		
-		// dispatch the packet to a channel
+		// dispatch the packet to a channel, which may send packets in return
+		LockedSection sendLock(sendMutex);
 		LockedSection channelsLock(channelsMutex);
-		CheckUnidirectionalChannel *pChannel;
-		if(pPacket->getChannelId() < getMaximumNumberOfChannels()
-			&& (pChannel = pChannels[pPacket->getChannelId()]) != null)
+		CheckUnidirectionalChannel *pChannel = (CheckUnidirectionalChannel *)getChannel(pPacket->getChannelId());
+		if(pChannel != null)
 		{
-			// pass the packet on to the channel
-			pChannel->receivePacket(pPacket);
+			// pass the packet on to the channel, which asks for a damaged packet again
+			if(crcValid)
+			{
+				pChannel->receivePacket(pPacket);
+			}
+			else
+			{
+				pChannel->receiveDamagedPacket(pPacket);
+			}
 		}
 		else
 		{
-			// this packet belongs to an unknown channel, put it back in the free queue
+			// this packet belongs to an unknown channel, put it back in the packet pool
 			freePacket(pPacket);
 		}
 	}
+	stoppedSemaphore.signal();
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::readPacket
+//
+// Reads the next packet from the stream into <pPacket>, calculating its CRC while reading.
+// With the checked header a damaged header is skipped a byte at a time until a valid header is
+// found, so the data size read can be trusted even if the data is damaged. Otherwise a header
+// with an impossible data size puts the stream into error.
+// Returns true if the CRC of the packet is valid.
+//------------------------------------------------------------------------------------------------
+
+Bool CheckPacketLayer::readPacket(CheckPacket *pPacket)
+{
+	// read the header
+	UInt8 *pHeader = (UInt8 *)pPacket->getTransmittedHeader();
+	const UInt headerSize = pPacket->getTransmittedHeaderSize();
+	stream.read(pHeader, headerSize);
+	while(!stream.isInError()
+		&& (!pPacket->isHeaderCheckValid() || pPacket->getDataSize() > pPacket->getMaximumPacketDataSize()))
+	{
+		// check if the header can be found again
+		if(pPacket->getHeaderFormat() != CheckPacket::checkedHeaderFormat)
+		{
+			stream.forceError();
+			break;
+		}
+
+		// look for a header one byte further on
+		for(UInt i = 0; i + 1 < headerSize; ++i)
+		{
+			pHeader[i] = pHeader[i + 1];
+		}
+		stream.read(&pHeader[headerSize - 1], 1);
+	}
+
+	// read the data, calculating its CRC a piece at a time as it is read
+	const UInt dataSize = pPacket->getDataSize();
+	for(UInt offset = 0; offset < dataSize && !stream.isInError(); offset += receivedPieceSize)
+	{
+		const UInt pieceSize = minimum(dataSize - offset, (UInt)receivedPieceSize);
+		stream.read(pPacket->reserveData(offset), pieceSize);
+		pPacket->appendReceivedData(offset, pieceSize);
+	}
+
+	// check the data
+	if(stream.isInError() || pPacket->isCrcValid())
+	{
+		return true;
+	}
+	++numberOfDamagedPackets;
+	return false;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::checkRetransmissions
+//
+// Lets every channel send a packet again whose acknowledgment is overdue, no more often than
+// twice per retransmission timeout.
+//------------------------------------------------------------------------------------------------
+
+void CheckPacketLayer::checkRetransmissions()
+{
+	// check if it is time to check
+	const TimeValue currentTime = getCurrentTime();
+	if(compareTimes(currentTime, retransmissionCheckTime) < 0)
+	{
+		return;
+	}
+	retransmissionCheckTime = currentTime + retransmissionTimeout / 2;
+
+	// check all channels
+	LockedSection sendLock(sendMutex);
+	LockedSection channelsLock(channelsMutex);
+	for(UnidirectionalChannel *pChannel = getNextChannel(0);
+		pChannel != null;
+		pChannel = getNextChannel(pChannel->getChannelId() + 1))
+	{
+		((CheckUnidirectionalChannel *)pChannel)->checkRetransmission(currentTime);
+	}
 }
 
 //------------------------------------------------------------------------------------------------
 // * CheckPacketLayer::handleError
 //
 // Handle a communication error.
+// Both ends send synchronization bytes and their connection ID before reading those of the
+// other end, so that two ends that detect an error at the same time do not wait for each other.
+// The same holds for the negotiation words, which are only sent once the synchronization bytes
+// of the other end have shown that it negotiates as well.
 //------------------------------------------------------------------------------------------------
 
 void CheckPacketLayer::handleError()
@@ -222,14 +635,33 @@ void CheckPacketLayer::handleError()
 	UInt32 receiveId;
 	const UInt32 sendId = thisConnectionId;
 
-	// attempt resynchronization several times
-	for(UInt retryCount = 0; retryCount < 16; ++retryCount)
+	// negotiation words to be exchanged, the one received stays zero if the other end does
+	// not negotiate
+	UInt32 receiveNegotiation = 0;
+	UInt32 sendNegotiation = requestedPacketPipelineDepth
+		| (requestedCapabilities << negotiationCapabilitiesShift);
+	sendNegotiation |= (~sendNegotiation & negotiationValueMask) << negotiationCheckShift;
+
+	// attempt resynchronization several times, unless the layer is stopping
+	for(UInt retryCount = 0; retryCount < 16 && !stopping; ++retryCount)
 	{
 		// reset the stream
 		stream.reset();
+
+		// send synchronization bytes,
+		// this sequence works with both UART and USB ports, an end that does not negotiate
+		// takes any non-zero byte for the last one
+		UInt8 syncByte;
+		syncByte = 0;
+		stream.write(&syncByte, sizeof(syncByte));
+		stream.write(&syncByte, sizeof(syncByte));
+		syncByte = negotiationSyncByte;
+		stream.write(&syncByte, sizeof(syncByte));
+
+		// write this connection ID
+		stream.write(&sendId, sizeof(sendId));
 	
 		// read synchronization bytes
-		UInt8 syncByte;
 		do
 		{
 			syncByte = (UInt8)~0;
@@ -240,6 +672,19 @@ void CheckPacketLayer::handleError()
 		// read a connection ID from other end
 		stream.read(&receiveId, sizeof(receiveId));
 
+		// exchange negotiation words if the other end negotiates
+		receiveNegotiation = 0;
+		if(syncByte == negotiationSyncByte && !stream.isInError())
+		{
+			stream.write(&sendNegotiation, sizeof(sendNegotiation));
+			stream.read(&receiveNegotiation, sizeof(receiveNegotiation));
+			if((receiveNegotiation >> negotiationCheckShift) != (~receiveNegotiation & negotiationValueMask))
+			{
+				// not a negotiation word, synchronize again
+				stream.forceError();
+			}
+		}
+
 		// check if we were successfull
 		if(!stream.isInError())
 		{
@@ -264,6 +709,7 @@ void CheckPacketLayer::handleError()
 		// a new connection has been made, reset all channels
 		otherConnectionId = receiveId & ~(UInt32)1;
 		thisConnectionId &= ~(UInt32)1;
+		negotiateConnection(receiveNegotiation);
 		handleNewConnection();
 	}
 	else
@@ -271,18 +717,45 @@ void CheckPacketLayer::handleError()
 		// reestablish an existing connection
 		handleReestablishedConnection();
 	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::negotiateConnection
+//
+// Agrees on the packet pipeline depth, capabilities and header of a new connection, given the
+// negotiation word <receiveNegotiation> of the other end, which is zero if it does not
+// negotiate. Both ends come to the same result from the words they exchanged.
+//------------------------------------------------------------------------------------------------
 
-	// send synchronization bytes,
-	// this sequence works with both UART and USB ports
-	UInt8 syncByte;
-	syncByte = 0;
-	stream.write(&syncByte, sizeof(syncByte));
-	stream.write(&syncByte, sizeof(syncByte));
-	syncByte = (UInt8)~0;
-	stream.write(&syncByte, sizeof(syncByte));
-
-	// write this connection ID
-	stream.write(&sendId, sizeof(sendId));
+void CheckPacketLayer::negotiateConnection(UInt32 receiveNegotiation)
+{
+	// check if the other end requested a depth
+	if(receiveNegotiation != 0)
+	{
+		// use the smaller depth and the extended header for its sequence numbers
+		const UInt otherPacketPipelineDepth = receiveNegotiation & negotiationDepthMask;
+		packetPipelineDepth = maximum(
+			minimum(requestedPacketPipelineDepth, otherPacketPipelineDepth),
+			(UInt)defaultPacketPipelineDepth);
+
+		// use the capabilities both ends support, selective retransmission needs the checked header
+		capabilities = requestedCapabilities
+			& ((receiveNegotiation & negotiationCapabilitiesMask) >> negotiationCapabilitiesShift);
+		headerFormat = isRetransmissionSelective()
+			? CheckPacket::checkedHeaderFormat
+			: CheckPacket::extendedHeaderFormat;
+		numberOfChannelIds = areChannelIdsExtended()
+			? numberOfExtendedChannelIds
+			: numberOfOriginalChannelIds;
+	}
+	else
+	{
+		// the other end only knows the original header
+		packetPipelineDepth = defaultPacketPipelineDepth;
+		capabilities = 0;
+		headerFormat = CheckPacket::originalHeaderFormat;
+		numberOfChannelIds = numberOfOriginalChannelIds;
+	}
 }
 
 //------------------------------------------------------------------------------------------------
@@ -296,14 +769,13 @@ void CheckPacketLayer::handleNewConnection()
 	++connectionNumber;
 
 	// propagate error to all channels
+	LockedSection sendLock(sendMutex);
 	LockedSection channelsLock(channelsMutex);
-	for(UInt channelNumber = 0; channelNumber < maximumNumberOfChannels; ++channelNumber)
+	for(UnidirectionalChannel *pChannel = getNextChannel(0);
+		pChannel != null;
+		pChannel = getNextChannel(pChannel->getChannelId() + 1))
 	{
-		UnidirectionalChannel *pChannel = pChannels[channelNumber];
-		if(pChannel != null)
-		{
-			pChannel->forceError();
-		}
+		pChannel->forceError();
 	}
 }
 
@@ -311,21 +783,21 @@ void CheckPacketLayer::handleNewConnection()
 // * CheckPacketLayer::handleReestablishedConnection
 //
 // Attempt to recover from an error by resending historical packets.
+// With selective retransmission only the oldest unacknowledged packet of every channel is sent
+// again, the other end asks for any other packet it is missing.
 //------------------------------------------------------------------------------------------------
 
 void CheckPacketLayer::handleReestablishedConnection()
 {
-	LockedSection sendLock(sendQueue.getMutex());
+	LockedSection sendLock(sendMutex);
 
 	// resend historical packets of all channels
 	LockedSection channelsLock(channelsMutex);
-	for(UInt channelNumber = 0; channelNumber < maximumNumberOfChannels; ++channelNumber)
+	for(UnidirectionalChannel *pChannel = getNextChannel(0);
+		pChannel != null;
+		pChannel = getNextChannel(pChannel->getChannelId() + 1))
 	{
-		CheckUnidirectionalChannel *pChannel = pChannels[channelNumber];
-		if(pChannel != null)
-		{
-			// resend packets in the history queue of the channel
-			pChannel->resendAllPackets();
-		}
+		// resend packets in the history of the channel
+		((CheckUnidirectionalChannel *)pChannel)->resendPackets();
 	}
 }
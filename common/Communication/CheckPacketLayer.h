@@ -4,68 +4,251 @@
 #include "../cPrimitiveTypes.h"
 #include "../multitasking/Task.h"
 #include "../multitasking/MemberTask.h"
-#include "../multitasking/IntertaskQueue.h"
 #include "../multitasking/IntertaskEvent.h"
 #include "../multitasking/Mutex.h"
+#include "../multitasking/Semaphore.h"
+#include "../Collections/ObjectPool.h"
+#include "../Collections/LinkedList.h"
 #include "Stream.h"
 #include "PacketLayer.h"
-class CheckPacket;
+#include "CheckPacket.h"
 class CheckUnidirectionalChannel;
 
 //------------------------------------------------------------------------------------------------
 // * class CheckPacketLayer
 //
 // Multiplexes multiple logical channel over one physical connection.
+// Every channel may have up to <packetPipelineDepth> packets in flight before it waits for an
+// acknowledgment. The depth is given at construction and both ends of a connection agree on the
+// smaller of their depths when the connection is made. Only two ends that both negotiate
+// exchange their depths and capabilities, an end that does not negotiate sees the same
+// synchronization bytes and connection ID as ever. A connection to such an end uses the
+// default depth and the original header, whose sequence numbers allow no more than the
+// default depth.
+// If both ends support selective retransmission, every packet carries a checked header: a
+// packet whose data is damaged is asked for again by sequence number, and a packet that is
+// still not acknowledged after the retransmission timeout is sent again, so that a single
+// damaged packet neither stops the link nor makes every channel resend its whole history.
+// Without it any damaged packet resynchronizes the link, and all channels resend the packets
+// that are not yet acknowledged.
+// Packets of any channels that are queued back to back are sent with a single write, which
+// matters on links such as USB where every write is a transfer of its own. The packets keep
+// their headers, so the bytes on the link are the same and the other end needs no support for
+// it. The transmitter may wait up to the coalescing delay for more packets to send with the
+// first, the delay is zero by default.
+// If both ends support extended channel IDs, the extended and checked headers carry channel
+// IDs up to numberOfExtendedChannelIds. The packet pool is sized for the number of channels
+// that are open at the same time rather than for every channel ID.
+// Every channel queues its packets to be sent on its own. The transmitter sends the packets of
+// the channels in the highest priority class that has packets queued, so that the packets of a
+// lower class wait for as long as a higher class has any. Within a class the channels take
+// turns, each sending up to its weight in packets of the maximum size per turn, so that a
+// channel sending a lot does not hold up the others. A packet sent again goes before the other
+// packets of its channel.
 //------------------------------------------------------------------------------------------------
 
 class CheckPacketLayer : public PacketLayer
 {
 public:
+	// constants
+	enum
+	{
+		defaultPacketPipelineDepth = 2,
+		maximumPacketPipelineDepth = 64
+	};
+
+	// packets sent with a single write
+	enum
+	{
+		maximumNumberOfCoalescedPackets = 32,
+		coalescingBufferSize = 2048
+	};
+
+	// priority classes of channels, a higher class is sent first
+	enum
+	{
+		lowestPriorityClass = 0,
+		defaultPriorityClass = 1,
+		highestPriorityClass = 3,
+		numberOfPriorityClasses = 4
+	};
+
+	// weights of channels within their priority class
+	enum { defaultWeight = 1 };
+
+	// capabilities, which are used if both ends of a connection support them
+	enum
+	{
+		selectiveRetransmission = 0x1,
+		extendedChannelIds = 0x2,
+		allCapabilities = selectiveRetransmission | extendedChannelIds
+	};
+
 	// constructor and destructor
-	CheckPacketLayer(Stream &stream, UInt basePriority = Task::realtimePriority);
+	CheckPacketLayer(
+		Stream &stream,
+		UInt basePriority = Task::realtimePriority,
+		UInt packetPipelineDepth = defaultPacketPipelineDepth,
+		UInt capabilities = allCapabilities,
+		UInt maximumNumberOfOpenChannels = numberOfOriginalChannelIds);
 	virtual ~CheckPacketLayer();
 
+	// testing
+	inline Bool isRetransmissionSelective() const;
+	inline Bool areChannelIdsExtended() const;
+	inline Bool isCoalescing() const;
+
+	// querying
+	inline UInt getConnectionNumber() const;
+	inline UInt getPacketPipelineDepth() const;
+	inline UInt getRequestedPacketPipelineDepth() const;
+	inline UInt getSequenceNumberMask() const;
+	inline UInt getNumberOfDamagedPackets() const;
+	inline UInt getNumberOfResentPackets() const;
+	inline UInt getNumberOfWrites() const;
+	TimeValue getCurrentTime() const;
+
+	// accessing
+	inline TimeValue getRetransmissionTimeout() const;
+	inline void setRetransmissionTimeout(TimeValue retransmissionTimeout);
+	inline void setCoalescing(Bool coalescing);
+	inline TimeValue getCoalescingDelay() const;
+	inline void setCoalescingDelay(TimeValue coalescingDelay);
+
 	// modifying channels
 	void addChannel(UnidirectionalChannel *pChannel);
 	void removeChannel(UnidirectionalChannel *pChannel);
 	Stream * createChannel(UInt readChannelId, UInt writeChannelId);
 	
+	// scheduling channels
+	void setChannelPriority(CheckUnidirectionalChannel *pChannel, UInt priorityClass, UInt weight);
+
 	// packet operations
 	inline CheckPacket *getFreePacket();
+	inline CheckPacket *tryGetFreePacket();
 	inline void freePacket(CheckPacket *pPacket);
 	inline void sendPacket(CheckPacket *pPacket);
 	inline void sendPacketFirst(CheckPacket *pPacket);
+	inline void resendPacket(CheckPacket *pPacket);
 	
 private:
-	// querying
-	inline UInt getPacketPipelineDepth() const;
+	// an end that negotiates ends its synchronization bytes with negotiationSyncByte, which an
+	// end that does not negotiate never sends, two ends that both do so then exchange
+	// negotiation words with the requested packet pipeline depth and capabilities, whose upper
+	// half is the complement of the lower half
+	enum
+	{
+		negotiationSyncByte = 0xA5,
+		negotiationDepthMask = 0x000000FFu,
+		negotiationCapabilitiesShift = 8,
+		negotiationCapabilitiesMask = 0x0000FF00u,
+		negotiationValueMask = 0x0000FFFFu,
+		negotiationCheckShift = 16
+	};
+
+	// every turn of a channel allows its weight in packets of this size
+	enum { schedulingQuantum = sizeof(CheckPacket::CheckPacketHeader) + CheckPacket::maximumPacketDataSize };
+
+	// received data is read in pieces of this size, whose CRC is calculated while they are cached
+	enum { receivedPieceSize = 256 };
+
+	// synchronizers
+	Mutex sendMutex;
+	Semaphore sendSemaphore;
+	Semaphore stoppedSemaphore;
 
 	// representation
 	Stream &stream;
 	UInt connectionNumber;
-	enum { packetPipelineDepth = 2 };
-	IntertaskPointerQueue<CheckPacket> freeQueue;
-	IntertaskPointerQueue<CheckPacket> sendQueue;
-	CheckUnidirectionalChannel *pChannels[PacketLayer::maximumNumberOfChannels];
+	UInt requestedPacketPipelineDepth;
+	UInt packetPipelineDepth;
+	UInt requestedCapabilities;
+	UInt capabilities;
+	CheckPacket::HeaderFormat headerFormat;
+	TimeValue retransmissionTimeout;
+	TimeValue retransmissionCheckTime;
+	UInt numberOfDamagedPackets;
+	UInt numberOfResentPackets;
+	Bool coalescing;
+	TimeValue coalescingDelay;
+	UInt numberOfWrites;
+	volatile Bool stopping;
+	UInt8 coalescingBuffer[coalescingBufferSize];
+	DynamicObjectPool<CheckPacket> packetPool;
+	LinkedList sendingChannels[numberOfPriorityClasses];
+	LinkedList unscheduledPackets;
+
+	// scheduling packets
+	void queuePacket(CheckPacket *pPacket, Bool first);
+	CheckPacket *removeNextPacket();
+	void unscheduleChannel(CheckUnidirectionalChannel *pChannel);
 
 	// packet exchange tasks
 	void transmitPackets();
+	UInt collectPackets(CheckPacket *pFirstPacket, CheckPacket **ppPackets);
+	void writePackets(CheckPacket **ppPackets, UInt numberOfPackets);
 	void receivePackets();
+	Bool readPacket(CheckPacket *pPacket);
+	void checkRetransmissions();
 	MemberTask(TransmitterTask, CheckPacketLayer, transmitPackets) packetTransmitter;
 	MemberTask(ReceiverTask, CheckPacketLayer, receivePackets) packetReceiver;
 
 	// error handling
 	void handleError();
+	void negotiateConnection(UInt32 receiveNegotiation);
 	void handleNewConnection();
 	void handleReestablishedConnection();
 };
 
-#include "CheckPacket.h"
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::isRetransmissionSelective
+//
+// Tests whether both ends of the current connection retransmit single packets.
+//------------------------------------------------------------------------------------------------
+
+inline Bool CheckPacketLayer::isRetransmissionSelective() const
+{
+	return (capabilities & selectiveRetransmission) != 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::areChannelIdsExtended
+//
+// Tests whether both ends of the current connection carry extended channel IDs.
+//------------------------------------------------------------------------------------------------
+
+inline Bool CheckPacketLayer::areChannelIdsExtended() const
+{
+	return (capabilities & extendedChannelIds) != 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::isCoalescing
+//
+// Tests whether packets queued back to back are sent with a single write.
+//------------------------------------------------------------------------------------------------
+
+inline Bool CheckPacketLayer::isCoalescing() const
+{
+	return coalescing;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::getConnectionNumber
+//
+// Returns the number of connections made so far, the number changes whenever a new connection
+// is made and all channels are forced into error.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckPacketLayer::getConnectionNumber() const
+{
+	return connectionNumber;
+}
 
 //------------------------------------------------------------------------------------------------
 // * CheckPacketLayer::getPacketPipelineDepth
 //
-// Returns the packet pipeline depth per channel.
+// Returns the packet pipeline depth per channel agreed for the current connection.
 //------------------------------------------------------------------------------------------------
 
 inline UInt CheckPacketLayer::getPacketPipelineDepth() const
@@ -73,16 +256,156 @@ inline UInt CheckPacketLayer::getPacketPipelineDepth() const
 	return packetPipelineDepth;
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::getRequestedPacketPipelineDepth
+//
+// Returns the packet pipeline depth per channel given at construction, which no connection
+// exceeds.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckPacketLayer::getRequestedPacketPipelineDepth() const
+{
+	return requestedPacketPipelineDepth;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::getSequenceNumberMask
+//
+// Returns the mask for the sequence numbers of the current connection.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckPacketLayer::getSequenceNumberMask() const
+{
+	if(headerFormat != CheckPacket::originalHeaderFormat)
+	{
+		return (1u << CheckPacket::numberOfExtendedSequenceBits) - 1;
+	}
+	return (1u << CheckPacket::numberOfSequenceBits) - 1;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::getNumberOfDamagedPackets
+//
+// Returns the number of packets received with errors since the layer was constructed.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckPacketLayer::getNumberOfDamagedPackets() const
+{
+	return numberOfDamagedPackets;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::getNumberOfResentPackets
+//
+// Returns the number of packets sent again since the layer was constructed.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckPacketLayer::getNumberOfResentPackets() const
+{
+	return numberOfResentPackets;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::getNumberOfWrites
+//
+// Returns the number of writes of packets to the stream since the layer was constructed.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckPacketLayer::getNumberOfWrites() const
+{
+	return numberOfWrites;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::getRetransmissionTimeout
+//
+// Returns the time after which a packet that has not been acknowledged is sent again, in ticks
+// of getCurrentTime.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue CheckPacketLayer::getRetransmissionTimeout() const
+{
+	return retransmissionTimeout;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::setRetransmissionTimeout
+//
+// Accessor.
+// The timeout should allow for a full pipeline of packets in both directions, on a slow link.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckPacketLayer::setRetransmissionTimeout(TimeValue retransmissionTimeout)
+{
+	this->retransmissionTimeout = retransmissionTimeout;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::setCoalescing
+//
+// Accessor.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckPacketLayer::setCoalescing(Bool coalescing)
+{
+	this->coalescing = coalescing;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::getCoalescingDelay
+//
+// Returns the time the transmitter waits for more packets to send with the first packet of a
+// write, in ticks of getCurrentTime.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue CheckPacketLayer::getCoalescingDelay() const
+{
+	return coalescingDelay;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::setCoalescingDelay
+//
+// Accessor.
+// Every packet may be delayed by up to the <coalescingDelay>, in return for fewer writes when
+// packets are queued a little apart.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckPacketLayer::setCoalescingDelay(TimeValue coalescingDelay)
+{
+	this->coalescingDelay = coalescingDelay;
+}
+
 //------------------------------------------------------------------------------------------------
 // * CheckPacketLayer::getFreePacket
 //
-// Returns a packet from the free queue.
+// Returns a packet from the packet pool.
 //------------------------------------------------------------------------------------------------
 
 inline CheckPacket *CheckPacketLayer::getFreePacket()
 {
-	CheckPacket *pPacket = freeQueue.removeFirst();
+	CheckPacket *pPacket = packetPool.acquire();
 	pPacket->setConnectionNumber(connectionNumber);
+	pPacket->setHeaderFormat(headerFormat);
+	pPacket->setNegativeAcknowledgment(false);
+	return pPacket;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::tryGetFreePacket
+//
+// Returns a packet from the packet pool, or null if there is no free packet.
+//------------------------------------------------------------------------------------------------
+
+inline CheckPacket *CheckPacketLayer::tryGetFreePacket()
+{
+	CheckPacket *pPacket = packetPool.tryAcquire();
+	if(pPacket != null)
+	{
+		pPacket->setConnectionNumber(connectionNumber);
+		pPacket->setHeaderFormat(headerFormat);
+		pPacket->setNegativeAcknowledgment(false);
+	}
 	return pPacket;
 }
 
@@ -94,7 +417,7 @@ inline CheckPacket *CheckPacketLayer::getFreePacket()
 
 inline void CheckPacketLayer::freePacket(CheckPacket *pPacket)
 {
-	freeQueue.addLast(pPacket);
+	packetPool.release(pPacket);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -105,18 +428,30 @@ inline void CheckPacketLayer::freePacket(CheckPacket *pPacket)
 
 inline void CheckPacketLayer::sendPacket(CheckPacket *pPacket)
 {
-	sendQueue.addLast(pPacket);
+	queuePacket(pPacket, false);
 }
 
 //------------------------------------------------------------------------------------------------
 // * CheckPacketLayer::sendPacketFirst
 //
-// Sends the packet before all other packets.
+// Sends the packet before all other packets of its channel.
 //------------------------------------------------------------------------------------------------
 
 inline void CheckPacketLayer::sendPacketFirst(CheckPacket *pPacket)
 {
-	sendQueue.addFirst(pPacket);
+	queuePacket(pPacket, true);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckPacketLayer::resendPacket
+//
+// Sends a packet that has been sent before, before all other packets of its channel.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckPacketLayer::resendPacket(CheckPacket *pPacket)
+{
+	++numberOfResentPackets;
+	queuePacket(pPacket, true);
 }
 
 #endif // _CheckPacketLayer_h_
@@ -30,81 +30,131 @@ CheckReadChannel::~CheckReadChannel()
 // * CheckReadChannel::read
 //
 // Read data from the channel.
+// The data is copied from the data borrowed from the packet received.
 //------------------------------------------------------------------------------------------------
 
 UInt CheckReadChannel::read(void *pDestination, UInt length, TimeValue timeout)
 {
-	// do not continue if we are in an error state
-	if(isInError())
-	{
-		return 0;
-	}
-
 	// keep reading in pieces until the entire amount has been read
 	UInt remainingLength = length;
 	while(remainingLength > 0)
 	{
-		// check if a packet is available for reading
-		while(pWorkingPacket == null)
-		{
-			// get the next data packet from the queue
-			if(receiveQueue.removeFirst(&pWorkingPacket, timeout))
-			{
-				forceError();
-			}
-
-			// do not continue if we are in an error state
-			if(isInError())
-			{
-				return length - remainingLength;
-			}
-
-			workingPacketOffset = 0;
-			workingPacketDataSize = pWorkingPacket->getDataSize();
-		}
-
-		// do not continue if we are in an error state
-		if(isInError())
+		// borrow the data of the packet received
+		UInt borrowedLength;
+		const void *pBorrowedData = borrow(&borrowedLength, timeout);
+		if(pBorrowedData == null)
 		{
 			return length - remainingLength;
 		}
 
 		// read a piece of data
-		const UInt pieceLength = minimum(remainingLength, workingPacketDataSize);
-		memoryCopy(
-			pDestination,
-			addToPointer(pWorkingPacket->getPacketData(), workingPacketOffset),
-			pieceLength);
+		const UInt pieceLength = minimum(remainingLength, borrowedLength);
+		memoryCopy(pDestination, pBorrowedData, pieceLength);
 		
 		// advance to the next piece
 		pDestination = addToPointer(pDestination, pieceLength);
-		workingPacketOffset += pieceLength;
-		workingPacketDataSize -= pieceLength;
 		remainingLength -= pieceLength;
+		release(pieceLength);
+	}
 
-		// check if an entire packet has been read
-		if(workingPacketDataSize == 0)
+	return length;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckReadChannel::borrow
+//
+// Borrows the data of the packet received that has not been read yet, waiting for a packet if
+// there is none. The data is read in place and handed back with release, the packet is
+// acknowledged once all of its data has been released.
+// On return <pLength> points to the length borrowed.
+// Returns the data borrowed, or null if the channel is in error.
+//------------------------------------------------------------------------------------------------
+
+const void *CheckReadChannel::borrow(UInt *pLength, TimeValue timeout)
+{
+	*pLength = 0;
+
+	// check if a packet with data is available for reading
+	while(pWorkingPacket == null)
+	{
+		// do not continue if we are in an error state
+		if(isInError())
+		{
+			return null;
+		}
+
+		// get the next data packet from the queue
+		if(receiveQueue.removeFirst(&pWorkingPacket, timeout))
+		{
+			forceError();
+		}
+
+		// do not continue if we are in an error state
+		if(isInError())
 		{
-			// send an acknowledgement back
-			sendPacket(pWorkingPacket, 0);
+			return null;
+		}
+
+		workingPacketOffset = 0;
+		workingPacketDataSize = pWorkingPacket->getDataSize();
 
-			// no packet available for reading
-			pWorkingPacket = null;
+		// acknowledge a packet without data right away
+		if(workingPacketDataSize == 0)
+		{
+			release(0);
 		}
 	}
 
-	return length;
+	// do not continue if we are in an error state
+	if(isInError())
+	{
+		return null;
+	}
+
+	// lend the rest of the packet
+	*pLength = workingPacketDataSize;
+	return addToPointer(pWorkingPacket->getPacketData(), workingPacketOffset);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckReadChannel::release
+//
+// Reads the first <length> bytes of the data borrowed last.
+//------------------------------------------------------------------------------------------------
+
+void CheckReadChannel::release(UInt length)
+{
+	// check if there is a packet being read
+	if(pWorkingPacket == null)
+	{
+		return;
+	}
+
+	workingPacketOffset += length;
+	workingPacketDataSize -= length;
+
+	// check if an entire packet has been read
+	if(workingPacketDataSize == 0)
+	{
+		// send an acknowledgement back
+		sendPacket(pWorkingPacket, 0);
+
+		// no packet available for reading
+		pWorkingPacket = null;
+	}
 }
 
 //------------------------------------------------------------------------------------------------
 // * CheckReadChannel::reset
 //
 // Resets the stream and clears errors.
+// The history keeps every acknowledgment until the data packet that reuses it arrives.
 //------------------------------------------------------------------------------------------------
 
 void CheckReadChannel::reset()
 {
 	CheckUnidirectionalChannel::reset();
+	historyLag = packetPipelineDepth;
 
 	// initialize pipeline
 	for(UInt i = 0; i < packetPipelineDepth; ++i)
@@ -116,8 +166,8 @@ void CheckReadChannel::reset()
 		pDataPacket->setDataSize(0);
 		pDataPacket->setCrcValue();
 
-		// add the packet into the history queue
-		historyQueue.addLast(pDataPacket);
+		// add the packet into the history
+		recordPacket(pDataPacket);
 	}
 
 	// add the channel to the packet layer
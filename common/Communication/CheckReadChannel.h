@@ -10,6 +10,8 @@ class CheckPacketLayer;
 // * class CheckReadChannel
 //
 // Represents a read-only communication stream.
+// Data is read from the packet received, either copied by the channel with read or in place by
+// the reader itself with borrow and release.
 //------------------------------------------------------------------------------------------------
 
 class CheckReadChannel : public CheckUnidirectionalChannel
@@ -26,6 +28,11 @@ public:
 	inline UInt write(const void *pSource, UInt length, TimeValue timeout);
 	inline void flush();
 
+	// zero-copy streaming
+	inline const void *borrow(UInt *pLength);
+	const void *borrow(UInt *pLength, TimeValue timeout);
+	void release(UInt length);
+
 	// error related
 	void reset();
 
@@ -83,4 +90,15 @@ inline void CheckReadChannel::flush()
 {
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckReadChannel::borrow
+//
+// Borrows the data of the packet received with the default timeout.
+//------------------------------------------------------------------------------------------------
+
+inline const void *CheckReadChannel::borrow(UInt *pLength)
+{
+	return borrow(pLength, defaultTimeout);
+}
+
 #endif // _CheckReadChannel_h_
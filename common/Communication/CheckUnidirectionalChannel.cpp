@@ -6,18 +6,32 @@
 // * CheckUnidirectionalChannel::CheckUnidirectionalChannel
 //
 // Constructor.
+// The receive queue is sized for the depth requested from the packet layer, which no
+// connection exceeds.
 //------------------------------------------------------------------------------------------------
 
 CheckUnidirectionalChannel::CheckUnidirectionalChannel(CheckPacketLayer &packetLayer, UInt channelId) :
 	packetLayer(packetLayer),
-	receiveQueue(packetPipelineDepth + 1),
-	historyQueue(packetPipelineDepth * 2)
+	receiveQueue(packetLayer.getRequestedPacketPipelineDepth() + 1)
 {
 	inError = true;
 	pWorkingPacket = null;
 	this->channelId = channelId;
+	packetPipelineDepth = packetLayer.getPacketPipelineDepth();
+	sequenceNumberMask = packetLayer.getSequenceNumberMask();
 	sequenceNumber = packetPipelineDepth;
-	numberOfPacketsToFreeFromHistory = 0;
+	historyLag = 0;
+	retransmissionSelective = false;
+	progressTime = 0;
+	priorityClass = CheckPacketLayer::defaultPriorityClass;
+	weight = CheckPacketLayer::defaultWeight;
+	sendCredit = 0;
+	for(UInt slot = 0; slot < numberOfSlots; ++slot)
+	{
+		pHistoryPackets[slot] = null;
+		pReorderedPackets[slot] = null;
+		packetRequested[slot] = false;
+	}
 }
 
 //------------------------------------------------------------------------------------------------
@@ -62,13 +76,23 @@ void CheckUnidirectionalChannel::forceError()
 // * CheckUnidirectionalChannel::reset
 //
 // Resets the stream and clears errors.
+// The channel takes on the packet pipeline depth, sequence numbers and retransmission of the
+// current connection. The derived class sets the history lag and adds the channel to the
+// packet layer again.
 //------------------------------------------------------------------------------------------------
 
 void CheckUnidirectionalChannel::reset()
 {
+	// the packet layer must not pass packets on while the channel is reset
+	packetLayer.removeChannel(this);
+
 	inError = false;
+	packetPipelineDepth = packetLayer.getPacketPipelineDepth();
+	sequenceNumberMask = packetLayer.getSequenceNumberMask();
 	sequenceNumber = packetPipelineDepth;
-	numberOfPacketsToFreeFromHistory = 0;
+	historyLag = 0;
+	retransmissionSelective = packetLayer.isRetransmissionSelective();
+	progressTime = packetLayer.getCurrentTime();
 
 	// free all packets
 	freeAllPackets();
@@ -78,30 +102,141 @@ void CheckUnidirectionalChannel::reset()
 // * CheckUnidirectionalChannel::receivePacket
 //
 // Receives <pPacket> from the the packet layer.
+// Without selective retransmission only the packet expected next is accepted, the link is
+// resynchronized to recover any other. With it a packet ahead of the one expected is kept until
+// the packets before it have arrived, and the missing ones are asked for. A packet received
+// again means that its answer was lost, so the answer is sent again.
 //------------------------------------------------------------------------------------------------
 
 void CheckUnidirectionalChannel::receivePacket(CheckPacket *pPacket)
 {
-	// check if the sequence is correct
-	if(pPacket->getSequenceNumber() == sequenceNumber)
+	const UInt receivedSequenceNumber = pPacket->getSequenceNumber();
+
+	// check if the other end asks for a packet again
+	if(pPacket->isNegativeAcknowledgment())
 	{
-		// increment sequence number
-		++sequenceNumber;
+		resendPacket(receivedSequenceNumber);
+		freePacket(pPacket);
+		return;
+	}
 
-		// add the packet into the receive queue
-		receiveQueue.addLast(pPacket);
+	// check if the sequence is correct
+	if(receivedSequenceNumber == sequenceNumber)
+	{
+		deliverPacket(pPacket);
 
-		// remove a packet from the history queue
-		++numberOfPacketsToFreeFromHistory;
-		freePacketsInHistory();
+		// deliver the packets that were waiting for this one
+		while(retransmissionSelective
+			&& (pPacket = pReorderedPackets[getSlot(sequenceNumber)]) != null)
+		{
+			pReorderedPackets[getSlot(sequenceNumber)] = null;
+			deliverPacket(pPacket);
+		}
+		return;
 	}
-	else
+
+	// the packet is out of sequence
+	if(!retransmissionSelective)
 	{
-		// the packet is out of sequence, ignore it
+		// ignore it
 		freePacket(pPacket);
+		return;
+	}
+
+	// check if the packet is ahead of the one expected
+	const UInt distanceAhead = (receivedSequenceNumber - sequenceNumber) & sequenceNumberMask;
+	if(distanceAhead < packetPipelineDepth)
+	{
+		// keep the packet, unless it has already been received
+		CheckPacket *&pReorderedPacket = pReorderedPackets[getSlot(receivedSequenceNumber)];
+		if(pReorderedPacket == null)
+		{
+			pReorderedPacket = pPacket;
+		}
+		else
+		{
+			freePacket(pPacket);
+		}
+
+		// ask for the packets missing before it
+		for(UInt missingSequenceNumber = sequenceNumber;
+			missingSequenceNumber != receivedSequenceNumber;
+			missingSequenceNumber = (missingSequenceNumber + 1) & sequenceNumberMask)
+		{
+			if(pReorderedPackets[getSlot(missingSequenceNumber)] == null)
+			{
+				requestPacket(missingSequenceNumber);
+			}
+		}
+		return;
+	}
+
+	// the packet has been received before, send its answer again if there is one
+	const UInt distanceBehind = (sequenceNumber - receivedSequenceNumber) & sequenceNumberMask;
+	if(distanceBehind <= packetPipelineDepth)
+	{
+		resendPacket(receivedSequenceNumber);
+	}
+	freePacket(pPacket);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckUnidirectionalChannel::receiveDamagedPacket
+//
+// Receives <pPacket> from the packet layer, whose header is valid but whose CRC is not.
+// A packet without data has only its CRC value damaged, so it is received as it is. Any other
+// packet is asked for again if it is still missing, even if it has been asked for before, as
+// the damaged packet may be the one sent again.
+//------------------------------------------------------------------------------------------------
+
+void CheckUnidirectionalChannel::receiveDamagedPacket(CheckPacket *pPacket)
+{
+	// check if the header is all there is
+	if(pPacket->getDataSize() == 0)
+	{
+		receivePacket(pPacket);
+		return;
+	}
+	const UInt damagedSequenceNumber = pPacket->getSequenceNumber();
+	freePacket(pPacket);
+
+	// check if the packet is still missing
+	const UInt distanceAhead = (damagedSequenceNumber - sequenceNumber) & sequenceNumberMask;
+	if(distanceAhead < packetPipelineDepth
+		&& pReorderedPackets[getSlot(damagedSequenceNumber)] == null)
+	{
+		packetRequested[getSlot(damagedSequenceNumber)] = false;
+		requestPacket(damagedSequenceNumber);
 	}
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckUnidirectionalChannel::deliverPacket
+//
+// Passes <pPacket>, which is the packet expected next, on to the reading/writing task and frees
+// the packet in the history that it answers.
+//------------------------------------------------------------------------------------------------
+
+void CheckUnidirectionalChannel::deliverPacket(CheckPacket *pPacket)
+{
+	// free the packet that has been answered, unless it is being sent again
+	const UInt answeredSequenceNumber = getFirstHistorySequenceNumber();
+	CheckPacket *&pHistoryPacket = pHistoryPackets[getSlot(answeredSequenceNumber)];
+	if(pHistoryPacket != null && pHistoryPacket->getSequenceNumber() == answeredSequenceNumber)
+	{
+		freePacket(pHistoryPacket);
+		pHistoryPacket = null;
+	}
+
+	// increment sequence number
+	packetRequested[getSlot(sequenceNumber)] = false;
+	sequenceNumber = (sequenceNumber + 1) & sequenceNumberMask;
+	progressTime = packetLayer.getCurrentTime();
+
+	// add the packet into the receive queue
+	receiveQueue.addLast(pPacket);
+}
+
 //------------------------------------------------------------------------------------------------
 // * CheckUnidirectionalChannel::sendPacket
 //
@@ -123,50 +258,121 @@ void CheckUnidirectionalChannel::sendPacket(
 //------------------------------------------------------------------------------------------------
 // * CheckUnidirectionalChannel::recordPacket
 //
-// Records <pPacket> that has already been sent in the history queue.
+// Records <pPacket> that has already been sent in the history.
+// A packet that has been answered while it was being sent is freed, as is a request for a
+// packet, which is sent again when needed.
 //------------------------------------------------------------------------------------------------
 
 void CheckUnidirectionalChannel::recordPacket(CheckPacket *pPacket)
 {
-	// add the packet into the history queue
-	historyQueue.addLast(pPacket);
+	// check if the packet must be kept
+	const UInt recordedSequenceNumber = pPacket->getSequenceNumber();
+	const UInt firstHistorySequenceNumber = getFirstHistorySequenceNumber();
+	if(pPacket->isNegativeAcknowledgment()
+		|| ((recordedSequenceNumber - firstHistorySequenceNumber) & sequenceNumberMask) >= packetPipelineDepth)
+	{
+		freePacket(pPacket);
+		return;
+	}
+
+	// add the packet into the history
+	CheckPacket *&pHistoryPacket = pHistoryPackets[getSlot(recordedSequenceNumber)];
+	if(pHistoryPacket != null)
+	{
+		freePacket(pHistoryPacket);
+	}
+	pHistoryPacket = pPacket;
+
+	// the wait for an answer starts when the oldest packet is sent
+	if(recordedSequenceNumber == firstHistorySequenceNumber)
+	{
+		progressTime = packetLayer.getCurrentTime();
+	}
 }
 
 //------------------------------------------------------------------------------------------------
-// * CheckUnidirectionalChannel::freePacketsInHistory
+// * CheckUnidirectionalChannel::resendPacket
 //
-// Attempts to free <numberOfPacketsToFreeFromHistory> packets from the history queue.
+// Sends the packet with <resentSequenceNumber> in the history again, if it is in the history.
 //------------------------------------------------------------------------------------------------
 
-void CheckUnidirectionalChannel::freePacketsInHistory()
+void CheckUnidirectionalChannel::resendPacket(UInt resentSequenceNumber)
 {
-	// attempt to remove the required number of packets
-	while(numberOfPacketsToFreeFromHistory > 0)
+	CheckPacket *&pHistoryPacket = pHistoryPackets[getSlot(resentSequenceNumber)];
+	if(pHistoryPacket != null && pHistoryPacket->getSequenceNumber() == resentSequenceNumber)
 	{
-		// do nothing if the history queue is empty
-		if(historyQueue.isEmpty())
-		{
-			break;
-		}
+		// the packet is recorded again once it has been sent
+		packetLayer.resendPacket(pHistoryPacket);
+		pHistoryPacket = null;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckUnidirectionalChannel::requestPacket
+//
+// Asks the other end to send the packet with <missingSequenceNumber> again, once per packet.
+// If no packet is free the request is left to the retransmission timeout.
+//------------------------------------------------------------------------------------------------
 
-		// free one packet from the history
-		--numberOfPacketsToFreeFromHistory;
-		freePacket(historyQueue.removeFirst());
+void CheckUnidirectionalChannel::requestPacket(UInt missingSequenceNumber)
+{
+	// check if the packet has been asked for already
+	if(packetRequested[getSlot(missingSequenceNumber)])
+	{
+		return;
+	}
+
+	// send a negative acknowledgment
+	CheckPacket *pRequestPacket = packetLayer.tryGetFreePacket();
+	if(pRequestPacket != null)
+	{
+		packetRequested[getSlot(missingSequenceNumber)] = true;
+		pRequestPacket->setChannelId(channelId);
+		pRequestPacket->setSequenceNumber(missingSequenceNumber);
+		pRequestPacket->setNegativeAcknowledgment(true);
+		sendPacket(pRequestPacket, 0);
 	}
 }
 
 //------------------------------------------------------------------------------------------------
-// * CheckUnidirectionalChannel::resendAllPackets
+// * CheckUnidirectionalChannel::resendPackets
 //
-// Send all packets in the history queue.
+// Sends the packets in the history again after the link has been resynchronized.
+// Without selective retransmission all packets are sent again in order. With it only the packet
+// that the packet expected next answers is sent again, which is the oldest unacknowledged data
+// packet of a write channel. The other end asks for the others.
 //------------------------------------------------------------------------------------------------
 
-void CheckUnidirectionalChannel::resendAllPackets()
+void CheckUnidirectionalChannel::resendPackets()
 {
-	freePacketsInHistory();
-	while(!historyQueue.isEmpty())
+	if(retransmissionSelective)
 	{
-		packetLayer.sendPacketFirst(historyQueue.removeLast());
+		resendPacket(sequenceNumber);
+		return;
+	}
+
+	// put the newest packet at the front of the send queue first
+	const UInt firstHistorySequenceNumber = getFirstHistorySequenceNumber();
+	for(UInt i = packetPipelineDepth; i > 0; --i)
+	{
+		resendPacket((firstHistorySequenceNumber + i - 1) & sequenceNumberMask);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckUnidirectionalChannel::checkRetransmission
+//
+// Sends the packet that the packet expected next answers again, if nothing has been received
+// for the retransmission timeout since it was sent. This recovers a packet, or the request for
+// it, that was lost without a trace.
+//------------------------------------------------------------------------------------------------
+
+void CheckUnidirectionalChannel::checkRetransmission(TimeValue currentTime)
+{
+	if(compareTimes(currentTime, progressTime) >= packetLayer.getRetransmissionTimeout())
+	{
+		progressTime = currentTime;
+		resendPacket(sequenceNumber);
 	}
 }
 
@@ -191,8 +397,18 @@ void CheckUnidirectionalChannel::freeAllPackets()
 			freePacket(pPacket);
 		}
 	}
-	while(!historyQueue.isEmpty())
+	for(UInt slot = 0; slot < numberOfSlots; ++slot)
 	{
-		freePacket(historyQueue.removeFirst());
+		if(pHistoryPackets[slot] != null)
+		{
+			freePacket(pHistoryPackets[slot]);
+			pHistoryPackets[slot] = null;
+		}
+		if(pReorderedPackets[slot] != null)
+		{
+			freePacket(pReorderedPackets[slot]);
+			pReorderedPackets[slot] = null;
+		}
+		packetRequested[slot] = false;
 	}
 }
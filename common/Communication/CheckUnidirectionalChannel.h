@@ -3,6 +3,8 @@
 
 #include "../cPrimitiveTypes.h"
 #include "../multitasking/IntertaskQueue.h"
+#include "../Collections/Link.h"
+#include "../Collections/LinkedList.h"
 #include "UnidirectionalChannel.h"
 #include "CheckPacket.h"
 #include "CheckPacketLayer.h"
@@ -11,23 +13,38 @@
 // * class CheckUnidirectionalChannel
 //
 // Represents a unidirectional communication stream.
+// The packets sent are kept in a history until the packet that answers them has been received:
+// a write channel keeps its data packets until they are acknowledged, a read channel keeps its
+// acknowledgments until the data packet that reuses them arrives, which is the packet pipeline
+// depth later. The history is indexed by sequence number, so that a single packet can be sent
+// again when the other end asks for it. With selective retransmission, packets received ahead
+// of a missing packet are kept in order until the missing packet arrives.
+// The packets to be sent are queued in the channel, the packet layer links the channels that
+// have packets queued for their turn to send.
 //------------------------------------------------------------------------------------------------
 
-class CheckUnidirectionalChannel : public UnidirectionalChannel
+class CheckUnidirectionalChannel : public UnidirectionalChannel, public Link
 {
 public:
 	// constructor and destructor
-	CheckUnidirectionalChannel(CheckPacketLayer &packetLayer, UInt channelId);			
+	CheckUnidirectionalChannel(CheckPacketLayer &packetLayer, UInt channelId);
 	virtual ~CheckUnidirectionalChannel();
 
+	// accessing
+	inline UInt getPriorityClass() const;
+	inline UInt getWeight() const;
+	inline void setPriority(UInt priorityClass, UInt weight = CheckPacketLayer::defaultWeight);
+
 	// error related
 	void forceError();
 	void reset();
 
 	// packet operations
 	void receivePacket(CheckPacket *pPacket);
+	void receiveDamagedPacket(CheckPacket *pPacket);
 	void recordPacket(CheckPacket *pPacket);
-	void resendAllPackets();
+	void resendPackets();
+	void checkRetransmission(TimeValue currentTime);
 	void freeAllPackets();
 
 protected:
@@ -35,20 +52,80 @@ protected:
 	void sendPacket(
 		CheckPacket *pPacket,
 		UInt dataSize);
-	void freePacketsInHistory();
 	inline CheckPacket *getFreePacket();
 	inline void freePacket(CheckPacket *pPacket);
 
 	// representation
-	enum { packetPipelineDepth = 2 };
 	CheckPacketLayer &packetLayer;
 	IntertaskPointerQueue<CheckPacket> receiveQueue;
-	IntertaskPointerQueue<CheckPacket> historyQueue;
-	UInt sequenceNumber : CheckPacket::numberOfSequenceBits;
-	UInt numberOfPacketsToFreeFromHistory;
+	UInt packetPipelineDepth;
+	UInt sequenceNumberMask;
+	UInt sequenceNumber;
+	UInt historyLag;
 	CheckPacket *pWorkingPacket;
+
+private:
+	// the slots are indexed by the lower bits of the sequence number
+	enum { numberOfSlots = CheckPacketLayer::maximumPacketPipelineDepth };
+
+	// packet operations
+	void deliverPacket(CheckPacket *pPacket);
+	void resendPacket(UInt resentSequenceNumber);
+	void requestPacket(UInt missingSequenceNumber);
+	inline UInt getFirstHistorySequenceNumber() const;
+	static inline UInt getSlot(UInt sequenceNumber);
+
+	// representation
+	Bool retransmissionSelective;
+	TimeValue progressTime;
+	CheckPacket *pHistoryPackets[numberOfSlots];
+	CheckPacket *pReorderedPackets[numberOfSlots];
+	Bool packetRequested[numberOfSlots];
+
+	// sending, which the packet layer takes care of
+	UInt priorityClass;
+	UInt weight;
+	UInt sendCredit;
+	LinkedList queuedPackets;
+
+	// friends
+	friend class CheckPacketLayer;
 };
 
+//------------------------------------------------------------------------------------------------
+// * CheckUnidirectionalChannel::getPriorityClass
+//
+// Accessor.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckUnidirectionalChannel::getPriorityClass() const
+{
+	return priorityClass;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckUnidirectionalChannel::getWeight
+//
+// Accessor.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckUnidirectionalChannel::getWeight() const
+{
+	return weight;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckUnidirectionalChannel::setPriority
+//
+// Sets the priority class the packets of the channel are sent in, and the <weight> of the
+// channel within its class. The priority is kept when the channel is reset.
+//------------------------------------------------------------------------------------------------
+
+inline void CheckUnidirectionalChannel::setPriority(UInt priorityClass, UInt weight)
+{
+	packetLayer.setChannelPriority(this, priorityClass, weight);
+}
+
 //------------------------------------------------------------------------------------------------
 // * CheckUnidirectionalChannel::getFreePacket
 //
@@ -71,4 +148,28 @@ inline void CheckUnidirectionalChannel::freePacket(CheckPacket *pPacket)
 	packetLayer.freePacket(pPacket);
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckUnidirectionalChannel::getFirstHistorySequenceNumber
+//
+// Returns the sequence number of the oldest packet that the history may hold, the packets that
+// have been answered are no longer kept.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckUnidirectionalChannel::getFirstHistorySequenceNumber() const
+{
+	return (sequenceNumber - historyLag) & sequenceNumberMask;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckUnidirectionalChannel::getSlot
+//
+// Returns the index of the history and reorder slots for <sequenceNumber>. No two packets in
+// the pipeline share a slot.
+//------------------------------------------------------------------------------------------------
+
+inline UInt CheckUnidirectionalChannel::getSlot(UInt sequenceNumber)
+{
+	return sequenceNumber & (numberOfSlots - 1);
+}
+
 #endif // _UnidirectionalChannel_h_
@@ -1,5 +1,4 @@
 #include "CheckWriteChannel.h"
-#include "../memoryUtilities.h"
 #include "../pointerArithmetic.h"
 
 //------------------------------------------------------------------------------------------------
@@ -30,71 +29,137 @@ CheckWriteChannel::~CheckWriteChannel()
 // * CheckWriteChannel::write
 //
 // Write data to the channel.
+// The data is copied into the space reserved in the packet being filled, calculating its CRC
+// in the same pass.
 //------------------------------------------------------------------------------------------------
 
 UInt CheckWriteChannel::write(const void *pSource, UInt length, TimeValue timeout)
 {
-	// do not continue if we are in an error state
-	if(isInError())
-	{
-		return 0;
-	}
-
 	// keep writing in pieces until the entire amount has been written
 	UInt remainingLength = length;
 	while(remainingLength > 0)
 	{
-		// check if a packet is available for writing
-		while(pWorkingPacket == null)
-		{
-			// get the next acknowledgment packet from the queue
-			if(receiveQueue.removeFirst(&pWorkingPacket, timeout))
-			{
-				forceError();
-			}
-			workingPacketDataSize = 0;
-
-			// do not continue if we are in an error state
-			if(isInError())
-			{
-				return length - remainingLength;
-			}
-		}
-
-		// do not continue if we are in an error state
-		if(isInError())
+		// reserve space for any part of the data
+		UInt reservedLength = 1;
+		if(reserve(&reservedLength, timeout) == null)
 		{
 			return length - remainingLength;
 		}
 
-		// write a piece of data
-		const UInt pieceLength = minimum(
-			remainingLength,
-			pWorkingPacket->getMaximumPacketDataSize() - workingPacketDataSize);
-		memoryCopy(
-			addToPointer(pWorkingPacket->getPacketData(), workingPacketDataSize),
-			pSource,
-			pieceLength);
+		// write a piece of data, calculating its CRC while copying it
+		const UInt pieceLength = minimum(remainingLength, reservedLength);
+		pWorkingPacket->appendData(workingPacketDataSize, pSource, pieceLength);
 		
 		// advance to the next piece
 		pSource = addToPointer(pSource, pieceLength);
-		workingPacketDataSize += pieceLength;
 		remainingLength -= pieceLength;
-		
-		// check if an entire packet has been written
-		if(workingPacketDataSize == pWorkingPacket->getMaximumPacketDataSize())
+		advance(pieceLength);
+	}
+
+	return length;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckWriteChannel::reserve
+//
+// Reserves the space left in the packet being filled, to be filled by the writer and written
+// with commit. On entry <pLength> points to the least length needed, which must not be more
+// than the maximum packet data size. If the packet has less space left, it is sent first.
+// On return <pLength> points to the length reserved.
+// Returns the space reserved, or null if the channel is in error.
+//------------------------------------------------------------------------------------------------
+
+void *CheckWriteChannel::reserve(UInt *pLength, TimeValue timeout)
+{
+	const UInt minimumLength = *pLength;
+	*pLength = 0;
+	if(minimumLength > CheckPacket::maximumPacketDataSize)
+	{
+		return null;
+	}
+
+	// send the packet being filled if the space needed does not fit
+	if(pWorkingPacket != null
+		&& workingPacketDataSize + minimumLength > pWorkingPacket->getMaximumPacketDataSize())
+	{
+		flush();
+	}
+
+	// check if a packet is available for writing
+	while(pWorkingPacket == null)
+	{
+		// do not continue if we are in an error state
+		if(isInError())
 		{
-			// send the data packet
-			pWorkingPacket->setSequenceNumber(
-				pWorkingPacket->getSequenceNumber() + packetPipelineDepth);
-			sendPacket(pWorkingPacket, workingPacketDataSize);
+			return null;
+		}
 
-			// no packet available for writing
-			pWorkingPacket = null;
+		// get the next acknowledgment packet from the queue
+		if(receiveQueue.removeFirst(&pWorkingPacket, timeout))
+		{
+			forceError();
+		}
+		workingPacketDataSize = 0;
+
+		// do not continue if we are in an error state
+		if(isInError())
+		{
+			return null;
 		}
+
+		// number the data packet before it is filled, the CRC covers the sequence number
+		pWorkingPacket->setSequenceNumber(
+			pWorkingPacket->getSequenceNumber() + packetPipelineDepth);
 	}
 
-	return length;
+	// do not continue if we are in an error state
+	if(isInError())
+	{
+		return null;
+	}
+
+	// reserve the rest of the packet
+	*pLength = pWorkingPacket->getMaximumPacketDataSize() - workingPacketDataSize;
+	return pWorkingPacket->reserveData(workingPacketDataSize);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckWriteChannel::commit
+//
+// Writes the first <length> bytes of the space reserved last, calculating their CRC in place.
+//------------------------------------------------------------------------------------------------
+
+void CheckWriteChannel::commit(UInt length)
+{
+	// check if there is a packet being filled
+	if(pWorkingPacket == null || length == 0)
+	{
+		return;
+	}
+
+	pWorkingPacket->appendFilledData(workingPacketDataSize, length);
+	advance(length);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CheckWriteChannel::advance
+//
+// Advances the packet being filled past <length> bytes of data, and sends it when it is full.
+//------------------------------------------------------------------------------------------------
+
+void CheckWriteChannel::advance(UInt length)
+{
+	workingPacketDataSize += length;
+
+	// check if an entire packet has been written
+	if(workingPacketDataSize == pWorkingPacket->getMaximumPacketDataSize())
+	{
+		// send the data packet
+		sendPacket(pWorkingPacket, workingPacketDataSize);
+
+		// no packet available for writing
+		pWorkingPacket = null;
+	}
 }
 
 //------------------------------------------------------------------------------------------------
@@ -109,8 +174,6 @@ void CheckWriteChannel::flush()
 	if(pWorkingPacket != null)
 	{
 		// send the data packet
-		pWorkingPacket->setSequenceNumber(
-			pWorkingPacket->getSequenceNumber() + packetPipelineDepth);
 		sendPacket(pWorkingPacket, workingPacketDataSize);
 
 		// no packet available for writing
@@ -122,6 +185,7 @@ void CheckWriteChannel::flush()
 // * CheckWriteChannel::reset
 //
 // Resets the stream and clears errors.
+// The history keeps every data packet until it is acknowledged.
 //------------------------------------------------------------------------------------------------
 
 void CheckWriteChannel::reset()
@@ -10,6 +10,8 @@ class CheckPacketLayer;
 // * class CheckWriteChannel
 //
 // Represents a write-only communication stream.
+// Data is written into the packet being filled, either by the channel with write or by the
+// writer itself with reserve and commit.
 //------------------------------------------------------------------------------------------------
 
 class CheckWriteChannel : public CheckUnidirectionalChannel
@@ -26,10 +28,18 @@ public:
 	UInt write(const void *pSource, UInt length, TimeValue timeout);
 	void flush();
 
+	// zero-copy streaming
+	inline void *reserve(UInt *pLength);
+	void *reserve(UInt *pLength, TimeValue timeout);
+	void commit(UInt length);
+
 	// error related
 	void reset();
 
 private:
+	// writing
+	void advance(UInt length);
+
 	// state of current packet being written to
 	UInt workingPacketDataSize;
 };
@@ -72,4 +82,15 @@ inline UInt CheckWriteChannel::write(const void *pSource, UInt length)
 	return write(pSource, length, defaultTimeout);
 }
 
+//------------------------------------------------------------------------------------------------
+// * CheckWriteChannel::reserve
+//
+// Reserves space in the packet being filled with the default timeout.
+//------------------------------------------------------------------------------------------------
+
+inline void *CheckWriteChannel::reserve(UInt *pLength)
+{
+	return reserve(pLength, defaultTimeout);
+}
+
 #endif // _CheckWriteChannel_h_
@@ -8,5 +8,6 @@
 
 NocheckPacket::NocheckPacket()
 {
+	headerFormat = originalHeaderFormat;
 	packetHeader.bitfields = 0;
 }
@@ -7,6 +7,8 @@
 // * class NocheckPacket
 //
 // Represents a piece of data trasmitted or received over a communication link.
+// The extended header carries the upper bits of extended channel IDs in the upper bits of the
+// header, in place of the upper bits of the data size.
 //------------------------------------------------------------------------------------------------
 
 class NocheckPacket
@@ -19,9 +21,18 @@ public:
 	{
 		UInt32 bitfields;
 	};
+
+	enum HeaderFormat
+	{
+		originalHeaderFormat,
+		extendedHeaderFormat
+	};
 	
 	enum { numberOfSequenceBits = 2 };
 
+	// querying
+	inline UInt getMaximumDataSize() const;
+
 	// accessing
 	inline const NocheckPacketHeader *getPacketHeader() const;
 	inline NocheckPacketHeader *getPacketHeader();
@@ -30,6 +41,8 @@ public:
 	inline void *getPacketData();
 
 	// accessing header fields
+	inline HeaderFormat getHeaderFormat() const;
+	inline void setHeaderFormat(HeaderFormat headerFormat);
 	inline UInt getChannelId() const;
 	inline void setChannelId(UInt channelId);
 	inline UInt getSequenceNumber() const;
@@ -38,12 +51,60 @@ public:
 	inline void setDataSize(UInt dataSize);
 
 private:
+
+	// fields of the extended header
+	enum
+	{
+		extendedDataSizeMask = 0x00FFFFC0u,
+		extendedChannelIdShift = 24,
+		extendedChannelIdMask = 0xFF000000u
+	};
+
+	// representation
+	HeaderFormat headerFormat;
 	
 	// packet contents
 	NocheckPacketHeader packetHeader;
 	UInt8 *packetData;
 };
 
+//------------------------------------------------------------------------------------------------
+// * NocheckPacket::getMaximumDataSize
+//
+// Returns the largest data size the header can carry.
+//------------------------------------------------------------------------------------------------
+
+inline UInt NocheckPacket::getMaximumDataSize() const
+{
+	if(headerFormat != originalHeaderFormat)
+	{
+		return extendedDataSizeMask >> 6;
+	}
+	return 0x3FFFFFFu;
+}
+
+//------------------------------------------------------------------------------------------------
+// * NocheckPacket::getHeaderFormat
+//
+// Returns the format of the header, which depends on what both ends of the connection support.
+//------------------------------------------------------------------------------------------------
+
+inline NocheckPacket::HeaderFormat NocheckPacket::getHeaderFormat() const
+{
+	return headerFormat;
+}
+
+//------------------------------------------------------------------------------------------------
+// * NocheckPacket::setHeaderFormat
+//
+// Accessor.
+//------------------------------------------------------------------------------------------------
+
+inline void NocheckPacket::setHeaderFormat(HeaderFormat headerFormat)
+{
+	this->headerFormat = headerFormat;
+}
+
 //------------------------------------------------------------------------------------------------
 // * NocheckPacket::getChannelId
 //
@@ -52,7 +113,12 @@ private:
 
 inline UInt NocheckPacket::getChannelId() const
 {
-	return packetHeader.bitfields & ((UInt32)0xfu);
+	UInt channelId = packetHeader.bitfields & ((UInt32)0xfu);
+	if(headerFormat != originalHeaderFormat)
+	{
+		channelId |= (packetHeader.bitfields & extendedChannelIdMask) >> (extendedChannelIdShift - 4);
+	}
+	return channelId;
 }
 
 //------------------------------------------------------------------------------------------------
@@ -63,7 +129,12 @@ inline UInt NocheckPacket::getChannelId() const
 
 inline void NocheckPacket::setChannelId(UInt channelId)
 {
-	packetHeader.bitfields = (packetHeader.bitfields & ~((UInt32)0xfu)) | channelId;
+	packetHeader.bitfields = (packetHeader.bitfields & ~((UInt32)0xfu)) | (channelId & 0xfu);
+	if(headerFormat != originalHeaderFormat)
+	{
+		packetHeader.bitfields = packetHeader.bitfields & ~extendedChannelIdMask
+			| ((channelId << (extendedChannelIdShift - 4)) & extendedChannelIdMask);
+	}
 }
 
 //------------------------------------------------------------------------------------------------
@@ -96,6 +167,10 @@ inline void NocheckPacket::setSequenceNumber(UInt sequenceNumber)
 
 inline UInt NocheckPacket::getDataSize() const
 {
+	if(headerFormat != originalHeaderFormat)
+	{
+		return (packetHeader.bitfields & extendedDataSizeMask) >> 6;
+	}
 	return (packetHeader.bitfields) >> 6;
 }
 
@@ -107,6 +182,12 @@ inline UInt NocheckPacket::getDataSize() const
 
 inline void NocheckPacket::setDataSize(UInt dataSize)
 {
+	if(headerFormat != originalHeaderFormat)
+	{
+		packetHeader.bitfields = packetHeader.bitfields & ~extendedDataSizeMask
+			| ((dataSize << 6) & extendedDataSizeMask);
+		return;
+	}
 	packetHeader.bitfields = (packetHeader.bitfields) & ~(((UInt32)0x3FFFFFFu) << 6) | (dataSize << 6);
 }
 
@@ -1,29 +1,30 @@
 #include "NocheckPacketLayer.h"
 #include "NocheckUnidirectionalChannel.h"
 #include "NocheckChannel.h"
-#include "../../memoryUtilities.h"
-#include "../../multitasking/LockedSection.h"
+#include "../memoryUtilities.h"
+#include "../multitasking/LockedSection.h"
 
 //------------------------------------------------------------------------------------------------
 // * NocheckPacketLayer::NocheckPacketLayer
 //
 // Constructor.
+// The <capabilities> are those this end offers to use.
 //------------------------------------------------------------------------------------------------
 
-NocheckPacketLayer::NocheckPacketLayer(Stream &stream, UInt basePriority) :
+NocheckPacketLayer::NocheckPacketLayer(Stream &stream, UInt basePriority, UInt capabilities) :
 	stream(stream),
 	packetReceiver(this, basePriority + 1, 20000)
 {
+	// the original header is used until the other end has agreed to more
+	requestedCapabilities = capabilities & allCapabilities;
+	this->capabilities = 0;
+	headerFormat = NocheckPacket::originalHeaderFormat;
+	stopping = false;
+
 	thisConnectionId = TaskScheduler::getCurrentTaskScheduler()->getTimer()->getTime() | 1;
 	otherConnectionId = 1;
 	stream.forceError();
 
-	// no channels
-	for(UInt i = 0; i < maximumNumberOfChannels; ++i)
-	{
-		pChannels[i] = null;
-	}
-
 	// start the receiver tasks
 	packetReceiver.resume();
 }
@@ -32,12 +33,17 @@ NocheckPacketLayer::NocheckPacketLayer(Stream &stream, UInt basePriority) :
 // * NocheckPacketLayer::~NocheckPacketLayer
 //
 // Destructor.
+// The receiver task leaves its loop before the layer is gone, as the receiver of a
+// CheckPacketLayer does. The channels must have been deleted, the stream may be deleted once the
+// layer is.
 //------------------------------------------------------------------------------------------------
 
 NocheckPacketLayer::~NocheckPacketLayer()
 {
-	// stop the transmitter and receiver tasks
-	packetReceiver.suspend();
+	// end the read the receiver is waiting for by forcing an error, and wait for it to stop
+	stopping = true;
+	stream.forceError();
+	stoppedEvent.wait();
 }
 
 //------------------------------------------------------------------------------------------------
@@ -55,13 +61,22 @@ Stream * NocheckPacketLayer::createChannel(UInt readChannelId, UInt writeChannel
 // * NocheckPacketLayer::addChannel
 //
 // Adds a channel to the packet layer.
+// A channel whose ID the current connection cannot carry is forced into error, rather than
+// share its packets with the channel its ID would be cut down to.
 //------------------------------------------------------------------------------------------------
 
 void NocheckPacketLayer::addChannel(UnidirectionalChannel *pChannel)
 {
+	// check if the connection can carry the channel ID
+	if(pChannel->getChannelId() >= getNumberOfChannelIds())
+	{
+		pChannel->forceError();
+		return;
+	}
+
 	// add the channel
 	LockedSection channelsLock(channelsMutex);
-	pChannels[pChannel->getChannelId()] = (NocheckUnidirectionalChannel *)pChannel;
+	setChannel(pChannel->getChannelId(), pChannel);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -74,7 +89,7 @@ void NocheckPacketLayer::removeChannel(UnidirectionalChannel *pChannel)
 {
 	// remove the channel
 	LockedSection channelsLock(channelsMutex);
-	pChannels[pChannel->getChannelId()] = null;
+	setChannel(pChannel->getChannelId(), null);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -93,18 +108,25 @@ void NocheckPacketLayer::sendPacket(NocheckPacket *pPacket)
 //------------------------------------------------------------------------------------------------
 // * NocheckPacketLayer::receivePackets
 //
-// Receives packets in an infinite loop.
+// Receives packets in a loop, until the layer is stopping.
 //------------------------------------------------------------------------------------------------
 
 void NocheckPacketLayer::receivePackets()
 {
-	// keep receiving packets forever
-	while(true)
+	// keep receiving packets until the layer is deleted
+	while(!stopping)
 	{
 		// read the packet header
 		NocheckPacket packet;
+		packet.setHeaderFormat(headerFormat);
 		stream.read(packet.getPacketHeader(), sizeof(NocheckPacket::NocheckPacketHeader));
 
+		// check if the read was ended to stop the layer, rather than resynchronize the link
+		if(stopping)
+		{
+			break;
+		}
+
 		// check for errors
 		if(stream.isInError())
 		{
@@ -120,9 +142,8 @@ void NocheckPacketLayer::receivePackets()
 			continue;
 		}
 		
-		NocheckUnidirectionalChannel *pChannel = null;
-		if (packet.getChannelId() < getMaximumNumberOfChannels() &&
-			(pChannel = pChannels[packet.getChannelId()]) != null)
+		NocheckUnidirectionalChannel *pChannel = (NocheckUnidirectionalChannel *)getChannel(packet.getChannelId());
+		if (pChannel != null)
 		{
 
 			while (true)
@@ -158,12 +179,17 @@ void NocheckPacketLayer::receivePackets()
 			stream.forceError();
 		}
 	}
+	stoppedEvent.signal();
 }
 
 //------------------------------------------------------------------------------------------------
 // * NocheckPacketLayer::handleError
 //
 // Handle a communication error.
+// Both ends send synchronization bytes and their connection ID before reading those of the
+// other end, so that two ends that detect an error at the same time do not wait for each other.
+// The same holds for the negotiation words, which are only sent once the synchronization bytes
+// of the other end have shown that it negotiates as well.
 //------------------------------------------------------------------------------------------------
 
 void NocheckPacketLayer::handleError()
@@ -181,14 +207,32 @@ void NocheckPacketLayer::handleError()
 	UInt32 receiveId = 0;
 	const UInt32 sendId = thisConnectionId;
 
-	// attempt resynchronization several times
-	for(UInt retryCount = 0; retryCount < 16; ++retryCount)
+	// negotiation words to be exchanged, the one received stays zero if the other end does
+	// not negotiate
+	UInt32 receiveNegotiation = 0;
+	const UInt32 sendNegotiation = requestedCapabilities
+		| ((~requestedCapabilities & negotiationCapabilitiesMask) << negotiationCheckShift);
+
+	// attempt resynchronization several times, unless the layer is stopping
+	for(UInt retryCount = 0; retryCount < 16 && !stopping; ++retryCount)
 	{
 		// reset the stream
 		stream.reset();
+
+		// send synchronization bytes,
+		// this sequence works with both UART and USB ports, an end that does not negotiate
+		// takes any non-zero byte for the last one
+		UInt8 syncByte;
+		syncByte = 0;
+		stream.write(&syncByte, sizeof(syncByte));
+		stream.write(&syncByte, sizeof(syncByte));
+		syncByte = negotiationSyncByte;
+		stream.write(&syncByte, sizeof(syncByte));
+
+		// write this connection ID
+		stream.write(&sendId, sizeof(sendId));
 	
 		// read synchronization bytes
-		UInt8 syncByte;
 		do
 		{
 			syncByte = (UInt8)~0;
@@ -199,6 +243,19 @@ void NocheckPacketLayer::handleError()
 		// read a connection ID from other end
 		stream.read(&receiveId, sizeof(receiveId));
 
+		// exchange negotiation words if the other end negotiates
+		receiveNegotiation = 0;
+		if(syncByte == negotiationSyncByte && !stream.isInError())
+		{
+			stream.write(&sendNegotiation, sizeof(sendNegotiation));
+			stream.read(&receiveNegotiation, sizeof(receiveNegotiation));
+			if((receiveNegotiation >> negotiationCheckShift) != (~receiveNegotiation & negotiationCapabilitiesMask))
+			{
+				// not a negotiation word, synchronize again
+				stream.forceError();
+			}
+		}
+
 		// check if we were successfull
 		if(!stream.isInError())
 		{
@@ -223,6 +280,7 @@ void NocheckPacketLayer::handleError()
 		// a new connection has been made, reset all channels
 		otherConnectionId = receiveId & ~(UInt32)1;
 		thisConnectionId &= ~(UInt32)1;
+		negotiateConnection(receiveNegotiation);
 		handleNewConnection();
 	}
 	else
@@ -230,18 +288,35 @@ void NocheckPacketLayer::handleError()
 		// reestablish an existing connection
 		handleReestablishedConnection();
 	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * NocheckPacketLayer::negotiateConnection
+//
+// Agrees on the capabilities and header of a new connection, given the negotiation word
+// <receiveNegotiation> of the other end, which is zero if it does not negotiate. Both ends come
+// to the same result from the words they exchanged.
+//------------------------------------------------------------------------------------------------
 
-	// send synchronization bytes,
-	// this sequence works with both UART and USB ports
-	UInt8 syncByte;
-	syncByte = 0;
-	stream.write(&syncByte, sizeof(syncByte));
-	stream.write(&syncByte, sizeof(syncByte));
-	syncByte = (UInt8)~0;
-	stream.write(&syncByte, sizeof(syncByte));
-
-	// write this connection ID
-	stream.write(&sendId, sizeof(sendId));
+void NocheckPacketLayer::negotiateConnection(UInt32 receiveNegotiation)
+{
+	// check if the other end requested capabilities
+	if(receiveNegotiation != 0)
+	{
+		// use the capabilities both ends support
+		capabilities = requestedCapabilities & receiveNegotiation & negotiationCapabilitiesMask;
+	}
+	else
+	{
+		// the other end only knows the original header
+		capabilities = 0;
+	}
+	headerFormat = areChannelIdsExtended()
+		? NocheckPacket::extendedHeaderFormat
+		: NocheckPacket::originalHeaderFormat;
+	numberOfChannelIds = areChannelIdsExtended()
+		? numberOfExtendedChannelIds
+		: numberOfOriginalChannelIds;
 }
 
 //------------------------------------------------------------------------------------------------
@@ -254,13 +329,11 @@ void NocheckPacketLayer::handleNewConnection()
 {
 	// propagate error to all channels
 	LockedSection channelsLock(channelsMutex);
-	for(UInt channelNumber = 0; channelNumber < maximumNumberOfChannels; ++channelNumber)
+	for(UnidirectionalChannel *pChannel = getNextChannel(0);
+		pChannel != null;
+		pChannel = getNextChannel(pChannel->getChannelId() + 1))
 	{
-		NocheckUnidirectionalChannel *pChannel = pChannels[channelNumber];
-		if(pChannel != null)
-		{
-			pChannel->forceError();
-		}
+		pChannel->forceError();
 	}
 }
 
@@ -1,31 +1,49 @@
 #ifndef _NocheckPacketLayer_h_
 #define _NocheckPacketLayer_h_
 
-#include "../../cPrimitiveTypes.h"
-#include "../../multitasking/Task.h"
-#include "../../multitasking/MemberTask.h"
-#include "../../multitasking/IntertaskQueue.h"
-#include "../../multitasking/IntertaskEvent.h"
-#include "../../multitasking/Mutex.h"
+#include "../cPrimitiveTypes.h"
+#include "../multitasking/Task.h"
+#include "../multitasking/MemberTask.h"
+#include "../multitasking/IntertaskQueue.h"
+#include "../multitasking/IntertaskEvent.h"
+#include "../multitasking/Mutex.h"
 #include "Stream.h"
 #include "PacketLayer.h"
+#include "NocheckPacket.h"
 
-class NocheckPacket;
 class NocheckUnidirectionalChannel;
 
 //------------------------------------------------------------------------------------------------
 // * class NocheckPacketLayer
 //
 // Multiplexes multiple logical channel over one physical connection.
+// If both ends support extended channel IDs, the headers carry channel IDs up to
+// numberOfExtendedChannelIds and no more than NocheckPacket::getMaximumDataSize of data each.
 //------------------------------------------------------------------------------------------------
 
 class NocheckPacketLayer : public PacketLayer
 {
 public:
+	// capabilities, which are used if both ends of a connection support them
+	enum
+	{
+		extendedChannelIds = 0x2,
+		allCapabilities = extendedChannelIds
+	};
+
 	// constructor and destructor
-	NocheckPacketLayer(Stream &stream, UInt basePriority = Task::realtimePriority);
+	NocheckPacketLayer(
+		Stream &stream,
+		UInt basePriority = Task::realtimePriority,
+		UInt capabilities = allCapabilities);
 	virtual ~NocheckPacketLayer();
 
+	// testing
+	inline Bool areChannelIdsExtended() const;
+
+	// querying
+	inline NocheckPacket::HeaderFormat getHeaderFormat() const;
+
 	// modifying channels
 	void addChannel(UnidirectionalChannel *pChannel);
 	void removeChannel(UnidirectionalChannel *pChannel);
@@ -35,9 +53,26 @@ public:
 	void sendPacket(NocheckPacket *pPacket);
 	
 private:
+	// an end that negotiates ends its synchronization bytes with negotiationSyncByte, which an
+	// end that does not negotiate never sends, two ends that both do so then exchange
+	// negotiation words with the requested capabilities, whose upper half is the complement of
+	// the lower half
+	enum
+	{
+		negotiationSyncByte = 0xA5,
+		negotiationCapabilitiesMask = 0x0000FFFFu,
+		negotiationCheckShift = 16
+	};
+
+	// synchronizers
+	IntertaskEvent stoppedEvent;
+
 	// representation
 	Stream &stream;
-	NocheckUnidirectionalChannel *pChannels[PacketLayer::maximumNumberOfChannels];
+	UInt requestedCapabilities;
+	UInt capabilities;
+	NocheckPacket::HeaderFormat headerFormat;
+	volatile Bool stopping;
 	
 	// packet exchange tasks
 	void receivePackets();
@@ -45,8 +80,31 @@ private:
 
 	// error handling
 	void handleError();
+	void negotiateConnection(UInt32 receiveNegotiation);
 	void handleNewConnection();
 	void handleReestablishedConnection();
 };
 
+//------------------------------------------------------------------------------------------------
+// * NocheckPacketLayer::areChannelIdsExtended
+//
+// Tests whether both ends of the current connection carry extended channel IDs.
+//------------------------------------------------------------------------------------------------
+
+inline Bool NocheckPacketLayer::areChannelIdsExtended() const
+{
+	return (capabilities & extendedChannelIds) != 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * NocheckPacketLayer::getHeaderFormat
+//
+// Returns the format of the packet headers of the current connection.
+//------------------------------------------------------------------------------------------------
+
+inline NocheckPacket::HeaderFormat NocheckPacketLayer::getHeaderFormat() const
+{
+	return headerFormat;
+}
+
 #endif // _NocheckPacketLayer_h_
@@ -40,12 +40,14 @@ UInt NocheckReadChannel::read(void *pDestination, UInt length, TimeValue timeout
 		return 0;
 	}
 
-	// keep reading in pieces until the entire amount has been read
+	// keep reading in pieces until the entire amount has been read, each no larger than the
+	// header of the connection can carry
+	workingPacket.setHeaderFormat(packetLayer.getHeaderFormat());
 	UInt remainingLength = length;
 	while(remainingLength > 0)
 	{
 		workingPacket.setPacketData(pDestination);
-		workingPacket.setDataSize(remainingLength);
+		workingPacket.setDataSize(minimum(remainingLength, workingPacket.getMaximumDataSize()));
 
 		// wait for data to transfer
 		receivePacket(&workingPacket, timeout);
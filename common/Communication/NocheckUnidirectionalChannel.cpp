@@ -6,12 +6,14 @@
 // * NocheckUnidirectionalChannel::NocheckUnidirectionalChannel
 //
 // Constructor.
+// The queues have room for the packet being transferred and the dummy entry of forceError, so
+// that neither the reading task nor the receiver of the packet layer blocks on the dummy entry.
 //------------------------------------------------------------------------------------------------
 
 NocheckUnidirectionalChannel::NocheckUnidirectionalChannel(NocheckPacketLayer &packetLayer, UInt channelId) :
 	packetLayer(packetLayer),
-	releaseQueue(1),
-	waitQueue(1)
+	releaseQueue(2),
+	waitQueue(2)
 {
 	inError = true;
 	this->channelId = channelId;
@@ -30,10 +30,14 @@ NocheckWriteChannel::~NocheckWriteChannel()
 // * NocheckWriteChannel::write
 //
 // Write data to the channel.
+// The data is sent in pieces as large as the header of the connection can carry.
 //------------------------------------------------------------------------------------------------
 
 UInt NocheckWriteChannel::write(const void *pSource, UInt length, TimeValue timeout)
 {
+	// unused argument
+	timeout = timeout;
+
 	// do not continue if we are in an error state
 	if(isInError())
 	{
@@ -45,12 +49,23 @@ UInt NocheckWriteChannel::write(const void *pSource, UInt length, TimeValue time
 		return 0;
 	}
 	
-	// write all data at once
-	workingPacket.setDataSize(length);
-	workingPacket.setPacketData(pSource);
-	
-	// send data 
-	sendPacket(&workingPacket);
+	// use the header of the connection
+	workingPacket.setHeaderFormat(packetLayer.getHeaderFormat());
+	workingPacket.setChannelId(channelId);
+
+	// keep writing in pieces until the entire amount has been written
+	UInt remainingLength = length;
+	while(remainingLength > 0)
+	{
+		const UInt dataSize = minimum(remainingLength, workingPacket.getMaximumDataSize());
+		workingPacket.setDataSize(dataSize);
+		workingPacket.setPacketData(pSource);
+
+		// send data
+		sendPacket(&workingPacket);
+		pSource = addToPointer(pSource, dataSize);
+		remainingLength -= dataSize;
+	}
 
 	return length;
 }
@@ -0,0 +1,96 @@
+#include "PacketLayer.h"
+#include "UnidirectionalChannel.h"
+
+//------------------------------------------------------------------------------------------------
+// * PacketLayer::PacketLayer
+//
+// Constructor.
+// The original channel IDs are used until a connection agrees on more.
+//------------------------------------------------------------------------------------------------
+
+PacketLayer::PacketLayer()
+{
+	numberOfChannelIds = numberOfOriginalChannelIds;
+
+	// no channel pages
+	for(UInt pageNumber = 0; pageNumber < numberOfChannelPages; ++pageNumber)
+	{
+		ppChannelPages[pageNumber] = null;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * PacketLayer::~PacketLayer
+//
+// Destructor.
+//------------------------------------------------------------------------------------------------
+
+PacketLayer::~PacketLayer()
+{
+	// free the channel pages
+	for(UInt pageNumber = 0; pageNumber < numberOfChannelPages; ++pageNumber)
+	{
+		delete [] ppChannelPages[pageNumber];
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * PacketLayer::setChannel
+//
+// Makes <pChannel> the channel with <channelId>, or removes the channel if <pChannel> is null.
+// The page of the channel is allocated when the first channel is added to it, and is kept for
+// the channels added later.
+//------------------------------------------------------------------------------------------------
+
+void PacketLayer::setChannel(UInt channelId, UnidirectionalChannel *pChannel)
+{
+	// check if the ID is in the table
+	if(channelId >= maximumNumberOfChannels)
+	{
+		return;
+	}
+
+	// get the page of the channel
+	UnidirectionalChannel **&ppChannelPage = ppChannelPages[channelId >> channelPageShift];
+	if(ppChannelPage == null)
+	{
+		// there is no channel to remove from a page that does not exist
+		if(pChannel == null)
+		{
+			return;
+		}
+		ppChannelPage = new UnidirectionalChannel *[channelPageSize];
+		for(UInt i = 0; i < channelPageSize; ++i)
+		{
+			ppChannelPage[i] = null;
+		}
+	}
+	ppChannelPage[channelId & (channelPageSize - 1)] = pChannel;
+}
+
+//------------------------------------------------------------------------------------------------
+// * PacketLayer::getNextChannel
+//
+// Returns the channel with the lowest ID from <channelId> on, or null if there is none. Pages
+// that have not been allocated are skipped as a whole.
+//------------------------------------------------------------------------------------------------
+
+UnidirectionalChannel *PacketLayer::getNextChannel(UInt channelId) const
+{
+	while(channelId < maximumNumberOfChannels)
+	{
+		UnidirectionalChannel **ppChannelPage = ppChannelPages[channelId >> channelPageShift];
+		if(ppChannelPage == null)
+		{
+			// go on with the next page
+			channelId = (channelId | (channelPageSize - 1)) + 1;
+			continue;
+		}
+		if(ppChannelPage[channelId & (channelPageSize - 1)] != null)
+		{
+			return ppChannelPage[channelId & (channelPageSize - 1)];
+		}
+		++channelId;
+	}
+	return null;
+}
@@ -10,35 +10,80 @@ class UnidirectionalChannel;
 // * class PacketLayer
 //
 // Multiplexes multiple logical channel over one physical connection.
+// The original headers carry channel IDs below numberOfOriginalChannelIds, a connection whose
+// ends both support extended channel IDs carries IDs below numberOfExtendedChannelIds. The
+// channels are found by ID through a table of pages of channels, a page is only allocated once
+// a channel with an ID in it is added, so a layer with few channels stays small.
 //------------------------------------------------------------------------------------------------
 
 class PacketLayer
 {
 public:
-	virtual ~PacketLayer() {};
+	// constants
+	enum
+	{
+		numberOfOriginalChannelIds = 16,
+		numberOfExtendedChannelIds = 4096
+	};
+
+	virtual ~PacketLayer();
+
+	// querying
+	inline UInt getNumberOfChannelIds() const;
 
 	// modifying channels
 	virtual void addChannel(UnidirectionalChannel *pChannel) = 0;
 	virtual void removeChannel(UnidirectionalChannel *pChannel) = 0;
 	virtual Stream * createChannel(UInt readChannelId, UInt writeChannelId) = 0;
-	
+
 	// friends
 	friend class UnidirectionalChannel;
-	
+
 protected:
+	// constructor
+	PacketLayer();
+
 	// synchronizers
 	Mutex channelsMutex;
 	Mutex writeAndResetMutex;
-	
+
 	// representation
 	UInt32 thisConnectionId;
 	UInt32 otherConnectionId;
+	UInt numberOfChannelIds;
 
 	// querying
 	inline UInt getMaximumNumberOfChannels() const;
-	enum { maximumNumberOfChannels = 16 };
+	enum { maximumNumberOfChannels = numberOfExtendedChannelIds };
+
+	// accessing channels, the channelsMutex must be locked
+	inline UnidirectionalChannel *getChannel(UInt channelId) const;
+	void setChannel(UInt channelId, UnidirectionalChannel *pChannel);
+	UnidirectionalChannel *getNextChannel(UInt channelId) const;
+
+private:
+	// channel table
+	enum
+	{
+		channelPageShift = 6,
+		channelPageSize = 1 << channelPageShift,
+		numberOfChannelPages = maximumNumberOfChannels / channelPageSize
+	};
+	UnidirectionalChannel **ppChannelPages[numberOfChannelPages];
 };
 
+//------------------------------------------------------------------------------------------------
+// * PacketLayer::getNumberOfChannelIds
+//
+// Returns the number of channel IDs the current connection can carry, channels with a higher
+// ID stay in error.
+//------------------------------------------------------------------------------------------------
+
+inline UInt PacketLayer::getNumberOfChannelIds() const
+{
+	return numberOfChannelIds;
+}
+
 //------------------------------------------------------------------------------------------------
 // * PacketLayer::getMaximumNumberOfChannels
 //
@@ -50,4 +95,24 @@ inline UInt PacketLayer::getMaximumNumberOfChannels() const
 	return maximumNumberOfChannels;
 }
 
+//------------------------------------------------------------------------------------------------
+// * PacketLayer::getChannel
+//
+// Returns the channel with <channelId>, or null if there is none.
+//------------------------------------------------------------------------------------------------
+
+inline UnidirectionalChannel *PacketLayer::getChannel(UInt channelId) const
+{
+	if(channelId >= maximumNumberOfChannels)
+	{
+		return null;
+	}
+	UnidirectionalChannel **ppChannelPage = ppChannelPages[channelId >> channelPageShift];
+	if(ppChannelPage == null)
+	{
+		return null;
+	}
+	return ppChannelPage[channelId & (channelPageSize - 1)];
+}
+
 #endif // _PacketLayer_h_
@@ -0,0 +1,125 @@
+#include "SimulatedLink.h"
+#include "../multitasking/Timer.h"
+#include "../multitasking/sleep.h"
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::SimulatedLink
+//
+// Constructor.
+// The ends are connected to each other, the layers are connected by one of the connect methods.
+//------------------------------------------------------------------------------------------------
+
+SimulatedLink::SimulatedLink(UInt lineRateInBytesPerSecond) :
+	endA(lineRateInBytesPerSecond),
+	endB(lineRateInBytesPerSecond)
+{
+	endA.connect(endB);
+	pLayerA = null;
+	pLayerB = null;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::~SimulatedLink
+//
+// Destructor.
+// The channels of the layers must have been deleted. Both layers stop their tasks before either
+// end is deleted, a layer whose other end stops first is left waiting for its bytes.
+//------------------------------------------------------------------------------------------------
+
+SimulatedLink::~SimulatedLink()
+{
+	delete pLayerA;
+	delete pLayerB;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::connectCheckPacketLayers
+//
+// Connects a CheckPacketLayer to each end, and waits until both have agreed on the depth and
+// capabilities of the connection.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLink::connectCheckPacketLayers(
+	UInt packetPipelineDepth,
+	UInt capabilities,
+	UInt maximumNumberOfOpenChannels)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	CheckPacketLayer *pCheckLayerA = new CheckPacketLayer(
+		endA,
+		Task::realtimePriority,
+		packetPipelineDepth,
+		capabilities,
+		maximumNumberOfOpenChannels);
+	CheckPacketLayer *pCheckLayerB = new CheckPacketLayer(
+		endB,
+		Task::realtimePriority,
+		packetPipelineDepth,
+		capabilities,
+		maximumNumberOfOpenChannels);
+	pLayerA = pCheckLayerA;
+	pLayerB = pCheckLayerB;
+	while(pCheckLayerA->getConnectionNumber() == 0 || pCheckLayerB->getConnectionNumber() == 0)
+	{
+		sleepForTicks(pTimer->getFrequency() / 1000, pTimer);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::connectNocheckPacketLayers
+//
+// Connects a NocheckPacketLayer to each end, and waits until both carry extended channel IDs.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLink::connectNocheckPacketLayers()
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	NocheckPacketLayer *pNocheckLayerA = new NocheckPacketLayer(endA);
+	NocheckPacketLayer *pNocheckLayerB = new NocheckPacketLayer(endB);
+	pLayerA = pNocheckLayerA;
+	pLayerB = pNocheckLayerB;
+	while(!pNocheckLayerA->areChannelIdsExtended() || !pNocheckLayerB->areChannelIdsExtended())
+	{
+		sleepForTicks(pTimer->getFrequency() / 1000, pTimer);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::setRoundTripTime
+//
+// Sets the time the bytes take to reach the other end and an answer to come back.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLink::setRoundTripTime(UInt roundTripTimeInMicroseconds)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	const TimeValue delay = (TimeValue)((UInt64)roundTripTimeInMicroseconds * pTimer->getFrequency() / 2000000);
+	endA.setDelay(delay);
+	endB.setDelay(delay);
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::setWriteOverhead
+//
+// Sets the time the line is busy with every write at either end besides sending its bytes.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLink::setWriteOverhead(UInt writeOverheadInMicroseconds)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	const TimeValue writeOverhead = (TimeValue)((UInt64)writeOverheadInMicroseconds * pTimer->getFrequency() / 1000000);
+	endA.setWriteOverhead(writeOverhead);
+	endB.setWriteOverhead(writeOverhead);
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::setBitErrorRate
+//
+// Sets the probability that a bit is flipped in either direction, in bits per billion.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLink::setBitErrorRate(UInt bitErrorsPerBillion)
+{
+	endA.setBitErrorRate(bitErrorsPerBillion);
+	endB.setBitErrorRate(bitErrorsPerBillion);
+}
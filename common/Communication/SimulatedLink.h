@@ -0,0 +1,128 @@
+#ifndef _SimulatedLink_h_
+#define _SimulatedLink_h_
+
+#include "../cPrimitiveTypes.h"
+#include "SimulatedLinkStream.h"
+#include "CheckPacketLayer.h"
+#include "NocheckPacketLayer.h"
+
+//------------------------------------------------------------------------------------------------
+// * class SimulatedLink
+//
+// Two packet layers connected over a simulated link, for measuring the packet layers on the
+// host. The link owns both ends and the layers that are connected over them. It deletes the
+// layers before the ends, so that no task of a layer is left using an end that is gone.
+//------------------------------------------------------------------------------------------------
+
+class SimulatedLink
+{
+public:
+	// constructor and destructor
+	SimulatedLink(UInt lineRateInBytesPerSecond);
+	~SimulatedLink();
+
+	// connecting packet layers
+	void connectCheckPacketLayers(
+		UInt packetPipelineDepth,
+		UInt capabilities = CheckPacketLayer::allCapabilities,
+		UInt maximumNumberOfOpenChannels = PacketLayer::numberOfOriginalChannelIds);
+	void connectNocheckPacketLayers();
+
+	// accessing
+	inline SimulatedLinkStream &getEndA();
+	inline SimulatedLinkStream &getEndB();
+	inline CheckPacketLayer &getCheckPacketLayerA();
+	inline CheckPacketLayer &getCheckPacketLayerB();
+	inline NocheckPacketLayer &getNocheckPacketLayerA();
+	inline NocheckPacketLayer &getNocheckPacketLayerB();
+	void setRoundTripTime(UInt roundTripTimeInMicroseconds);
+	void setWriteOverhead(UInt writeOverheadInMicroseconds);
+	void setBitErrorRate(UInt bitErrorsPerBillion);
+	inline UInt getNumberOfBitErrors() const;
+
+private:
+	// representation
+	SimulatedLinkStream endA;
+	SimulatedLinkStream endB;
+	PacketLayer *pLayerA;
+	PacketLayer *pLayerB;
+};
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::getEndA
+//
+// Returns the end of the link that layer A is connected to.
+//------------------------------------------------------------------------------------------------
+
+inline SimulatedLinkStream &SimulatedLink::getEndA()
+{
+	return endA;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::getEndB
+//
+// Returns the end of the link that layer B is connected to.
+//------------------------------------------------------------------------------------------------
+
+inline SimulatedLinkStream &SimulatedLink::getEndB()
+{
+	return endB;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::getCheckPacketLayerA
+//
+// Returns layer A, the link must have connected Check packet layers.
+//------------------------------------------------------------------------------------------------
+
+inline CheckPacketLayer &SimulatedLink::getCheckPacketLayerA()
+{
+	return *(CheckPacketLayer *)pLayerA;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::getCheckPacketLayerB
+//
+// Returns layer B, the link must have connected Check packet layers.
+//------------------------------------------------------------------------------------------------
+
+inline CheckPacketLayer &SimulatedLink::getCheckPacketLayerB()
+{
+	return *(CheckPacketLayer *)pLayerB;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::getNocheckPacketLayerA
+//
+// Returns layer A, the link must have connected Nocheck packet layers.
+//------------------------------------------------------------------------------------------------
+
+inline NocheckPacketLayer &SimulatedLink::getNocheckPacketLayerA()
+{
+	return *(NocheckPacketLayer *)pLayerA;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::getNocheckPacketLayerB
+//
+// Returns layer B, the link must have connected Nocheck packet layers.
+//------------------------------------------------------------------------------------------------
+
+inline NocheckPacketLayer &SimulatedLink::getNocheckPacketLayerB()
+{
+	return *(NocheckPacketLayer *)pLayerB;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLink::getNumberOfBitErrors
+//
+// Returns the number of bits flipped in both directions.
+//------------------------------------------------------------------------------------------------
+
+inline UInt SimulatedLink::getNumberOfBitErrors() const
+{
+	return endA.getNumberOfBitErrors() + endB.getNumberOfBitErrors();
+}
+
+#endif // _SimulatedLink_h_
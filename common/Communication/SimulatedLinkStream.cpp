@@ -0,0 +1,279 @@
+#include "SimulatedLinkStream.h"
+#include "../multitasking/Timer.h"
+#include "../multitasking/sleep.h"
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::SimulatedLinkStream
+//
+// Constructor.
+// The end must be connected to another end before it is used.
+//------------------------------------------------------------------------------------------------
+
+SimulatedLinkStream::SimulatedLinkStream(UInt lineRateInBytesPerSecond) :
+	receivedBytes(1024 * 1024),
+	receivedSegments(16 * 1024)
+{
+	pOtherEnd = null;
+	this->lineRateInBytesPerSecond = lineRateInBytesPerSecond;
+	lineFreeTime = TaskScheduler::getCurrentTaskScheduler()->getTimer()->getTime();
+	delay = 0;
+	writeOverhead = 0;
+	byteErrorThreshold = 0;
+	randomValue = (UInt32)lineFreeTime ^ 0x2545F491u;
+	numberOfBitErrors = 0;
+	remainingSegmentLength = 0;
+	breakCount = 0;
+	inError = false;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::connect
+//
+// Connects this end and <otherEnd> to each other.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLinkStream::connect(SimulatedLinkStream &otherEnd)
+{
+	pOtherEnd = &otherEnd;
+	otherEnd.pOtherEnd = this;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::isInError
+//
+// Tests whether an error condition has occurred.
+//------------------------------------------------------------------------------------------------
+
+Bool SimulatedLinkStream::isInError() const
+{
+	return inError;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::setBitErrorRate
+//
+// Sets the probability that a bit written at this end is flipped, in bits per billion.
+// At most one bit per byte is flipped, which is accurate for the low rates of real links.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLinkStream::setBitErrorRate(UInt bitErrorsPerBillion)
+{
+	// a byte is damaged with eight times the probability of a bit
+	byteErrorThreshold = (UInt)(((UInt64)bitErrorsPerBillion * 8 << 32) / 1000000000);
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::read
+//
+// Read data from the stream.
+//------------------------------------------------------------------------------------------------
+
+UInt SimulatedLinkStream::read(void *pDestination, UInt length, TimeValue timeout)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	UInt8 *pBytes = (UInt8 *)pDestination;
+	UInt remainingLength = length;
+	while(remainingLength > 0 && !inError)
+	{
+		// wait for the next segment to arrive
+		if(remainingSegmentLength == 0)
+		{
+			Segment segment;
+			if(receivedSegments.removeFirst(&segment, timeout))
+			{
+				inError = true;
+				break;
+			}
+			if(compareTimes(segment.arrivalTime, pTimer->getTime()) > 0)
+			{
+				sleepUntil(segment.arrivalTime, pTimer);
+			}
+			remainingSegmentLength = segment.length;
+
+			// discard the bytes written before a break of the other end
+			if(segment.breakCount != pOtherEnd->breakCount)
+			{
+				discardSegment();
+			}
+			continue;
+		}
+
+		// take the bytes that have arrived
+		const UInt pieceLength = minimum(remainingLength, remainingSegmentLength);
+		receivedBytes.removeFirstMany(pBytes, pieceLength, pieceLength);
+		pBytes += pieceLength;
+		remainingSegmentLength -= pieceLength;
+		remainingLength -= pieceLength;
+	}
+	return length - remainingLength;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::write
+//
+// Write data to the stream.
+//------------------------------------------------------------------------------------------------
+
+UInt SimulatedLinkStream::write(const void *pSource, UInt length, TimeValue timeout)
+{
+	// unused argument, the simulated line never refuses bytes
+	timeout = timeout;
+
+	if(inError)
+	{
+		return 0;
+	}
+
+	// wait for the line to send the earlier bytes
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	if(compareTimes(lineFreeTime, pTimer->getTime()) > 0)
+	{
+		sleepUntil(lineFreeTime, pTimer);
+	}
+	else
+	{
+		lineFreeTime = pTimer->getTime();
+	}
+	lineFreeTime += writeOverhead
+		+ (TimeValue)((UInt64)length * pTimer->getFrequency() / lineRateInBytesPerSecond);
+
+	// send the bytes in pieces, damaging some of them on the way
+	const UInt8 *pBytes = (const UInt8 *)pSource;
+	UInt remainingLength = length;
+	while(remainingLength > 0)
+	{
+		UInt8 piece[256];
+		const UInt pieceLength = minimum(remainingLength, (UInt)sizeof(piece));
+		for(UInt i = 0; i < pieceLength; ++i)
+		{
+			piece[i] = pBytes[i];
+			randomValue = randomValue * 1664525 + 1013904223;
+			if(randomValue < byteErrorThreshold)
+			{
+				// flip the bit chosen by the next random value
+				randomValue = randomValue * 1664525 + 1013904223;
+				piece[i] ^= (UInt8)(1 << (randomValue >> 29));
+				++numberOfBitErrors;
+			}
+		}
+
+		// the bytes arrive once they have been sent and have travelled over the link
+		pOtherEnd->receiveSegment(piece, pieceLength, lineFreeTime + delay, breakCount);
+		pBytes += pieceLength;
+		remainingLength -= pieceLength;
+	}
+	return length;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::flush
+//
+// Sends any buffered data.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLinkStream::flush()
+{
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::forceError
+//
+// Force an error condition, which ends a pending read.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLinkStream::forceError()
+{
+	inError = true;
+	endPendingRead();
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::reset
+//
+// Resets the stream and clears errors, once the other end has been reset as well.
+// Must be called by the task that reads from the stream.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLinkStream::reset()
+{
+	// the rest of a segment being read is no longer wanted
+	inError = true;
+	discardSegment();
+
+	// signal a break, so that the other end discards what this end has written so far
+	++breakCount;
+	pOtherEnd->receiveBreak();
+
+	// wait for the break from the other end, which may have come first
+	if(!breakEvent.waitForSeconds(1))
+	{
+		// synchronization completed, clear error
+		inError = false;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::receiveSegment
+//
+// Receives <length> bytes from the other end, which are to be read at <arrivalTime>. The
+// <breakCount> of the other end tells whether they have been written before its last break.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLinkStream::receiveSegment(
+	const UInt8 *pBytes,
+	UInt length,
+	TimeValue arrivalTime,
+	UInt breakCount)
+{
+	Segment segment;
+	segment.arrivalTime = arrivalTime;
+	segment.length = length;
+	segment.breakCount = breakCount;
+	receivedBytes.addLastMany(pBytes, length, length);
+	receivedSegments.addLast(segment);
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::receiveBreak
+//
+// Receives a break from the other end, which forces an error and completes a synchronization.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLinkStream::receiveBreak()
+{
+	inError = true;
+	breakEvent.signal();
+	endPendingRead();
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::endPendingRead
+//
+// Ends a pending read with an empty segment, which the read finds the stream in error after.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLinkStream::endPendingRead()
+{
+	Segment segment;
+	segment.arrivalTime = TaskScheduler::getCurrentTaskScheduler()->getTimer()->getTime();
+	segment.length = 0;
+	segment.breakCount = pOtherEnd->breakCount;
+	receivedSegments.addLast(segment);
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::discardSegment
+//
+// Discards the bytes of the segment being read.
+//------------------------------------------------------------------------------------------------
+
+void SimulatedLinkStream::discardSegment()
+{
+	while(remainingSegmentLength > 0)
+	{
+		UInt8 piece[256];
+		const UInt pieceLength = minimum(remainingSegmentLength, (UInt)sizeof(piece));
+		receivedBytes.removeFirstMany(piece, pieceLength, pieceLength);
+		remainingSegmentLength -= pieceLength;
+	}
+}
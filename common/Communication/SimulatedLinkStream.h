@@ -0,0 +1,114 @@
+#ifndef _SimulatedLinkStream_h_
+#define _SimulatedLinkStream_h_
+
+#include "../cPrimitiveTypes.h"
+#include "../multitasking/IntertaskQueue.h"
+#include "../multitasking/IntertaskEvent.h"
+#include "Stream.h"
+
+//------------------------------------------------------------------------------------------------
+// * class SimulatedLinkStream
+//
+// One end of a simulated serial link, for measuring the packet layers on the host. Bytes leave
+// at the line rate, arrive after a delay and may have bits flipped at random on the way. A
+// write blocks while the line is busy with earlier bytes, as the driver of a real port does, a
+// read blocks until the bytes have arrived.
+// A reset synchronizes both ends as a UART port does: this end signals a break, which forces
+// the other end into error, and waits for the break of the other end. Bytes written before the
+// last break of the end that wrote them are discarded.
+//------------------------------------------------------------------------------------------------
+
+class SimulatedLinkStream : public Stream
+{
+public:
+	// constructor
+	SimulatedLinkStream(UInt lineRateInBytesPerSecond);
+
+	// connecting
+	void connect(SimulatedLinkStream &otherEnd);
+
+	// testing
+	Bool isInError() const;
+
+	// accessing
+	inline void setDelay(TimeValue delay);
+	inline void setWriteOverhead(TimeValue writeOverhead);
+	void setBitErrorRate(UInt bitErrorsPerBillion);
+	inline UInt getNumberOfBitErrors() const;
+
+	// streaming
+	UInt read(void *pDestination, UInt length, TimeValue timeout);
+	UInt write(const void *pSource, UInt length, TimeValue timeout);
+	void flush();
+
+	// error related
+	void forceError();
+	void reset();
+
+private:
+	// types
+	struct Segment
+	{
+		TimeValue arrivalTime;
+		UInt length;
+		UInt breakCount;
+	};
+
+	// receiving
+	void receiveSegment(const UInt8 *pBytes, UInt length, TimeValue arrivalTime, UInt breakCount);
+	void receiveBreak();
+	void discardSegment();
+	void endPendingRead();
+
+	// representation
+	SimulatedLinkStream *pOtherEnd;
+	UInt lineRateInBytesPerSecond;
+	TimeValue lineFreeTime;
+	TimeValue delay;
+	TimeValue writeOverhead;
+	UInt byteErrorThreshold;
+	UInt32 randomValue;
+	UInt numberOfBitErrors;
+	IntertaskValueQueue<UInt8> receivedBytes;
+	IntertaskValueQueue<Segment> receivedSegments;
+	UInt remainingSegmentLength;
+	UInt breakCount;
+	IntertaskEvent breakEvent;
+	Bool inError;
+};
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::setDelay
+//
+// Sets the time the bytes written at this end take to reach the other end, in timer ticks.
+//------------------------------------------------------------------------------------------------
+
+inline void SimulatedLinkStream::setDelay(TimeValue delay)
+{
+	this->delay = delay;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::setWriteOverhead
+//
+// Sets the time the line is busy with every write besides sending its bytes, in timer ticks,
+// such as the frame a USB port waits for to start a transfer.
+//------------------------------------------------------------------------------------------------
+
+inline void SimulatedLinkStream::setWriteOverhead(TimeValue writeOverhead)
+{
+	this->writeOverhead = writeOverhead;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SimulatedLinkStream::getNumberOfBitErrors
+//
+// Returns the number of bits flipped in the bytes written at this end.
+//------------------------------------------------------------------------------------------------
+
+inline UInt SimulatedLinkStream::getNumberOfBitErrors() const
+{
+	return numberOfBitErrors;
+}
+
+#endif // _SimulatedLinkStream_h_
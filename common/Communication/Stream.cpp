@@ -21,3 +21,55 @@ UInt Stream::write(const void *pSource, UInt length)
 {
 	return write(pSource, length, defaultTimeout);
 }
+
+//------------------------------------------------------------------------------------------------
+// * Stream::reserve
+//
+// Reserves space in the stream to be filled and then written with commit. On entry <pLength>
+// points to the least length needed, on return to the length reserved.
+// Returns the space reserved, or null if the stream does not support it or is in error.
+//------------------------------------------------------------------------------------------------
+
+void *Stream::reserve(UInt *pLength, TimeValue timeout)
+{
+	timeout = timeout;
+	*pLength = 0;
+	return null;
+}
+
+//------------------------------------------------------------------------------------------------
+// * Stream::commit
+//
+// Writes the first <length> bytes of the space reserved last.
+//------------------------------------------------------------------------------------------------
+
+void Stream::commit(UInt length)
+{
+	length = length;
+}
+
+//------------------------------------------------------------------------------------------------
+// * Stream::borrow
+//
+// Borrows the data the stream has received, to be read in place and then handed back with
+// release. On return <pLength> points to the length borrowed.
+// Returns the data borrowed, or null if the stream does not support it or is in error.
+//------------------------------------------------------------------------------------------------
+
+const void *Stream::borrow(UInt *pLength, TimeValue timeout)
+{
+	timeout = timeout;
+	*pLength = 0;
+	return null;
+}
+
+//------------------------------------------------------------------------------------------------
+// * Stream::release
+//
+// Reads the first <length> bytes of the data borrowed last.
+//------------------------------------------------------------------------------------------------
+
+void Stream::release(UInt length)
+{
+	length = length;
+}
@@ -8,6 +8,10 @@
 // * Stream
 //
 // Abstract base class for byte streams.
+// A stream with buffers of its own may also let a writer fill its buffers directly, with reserve
+// and commit, and a reader use the data where it has been received, with borrow and release.
+// Other streams return null from reserve and borrow, the data is then copied with read and
+// write.
 //------------------------------------------------------------------------------------------------
 
 class Stream
@@ -26,6 +30,14 @@ public:
 	virtual UInt write(const void *pSource, UInt length, TimeValue timeout) = 0;
 	virtual void flush() = 0;
 
+	// zero-copy streaming
+	inline void *reserve(UInt *pLength);
+	virtual void *reserve(UInt *pLength, TimeValue timeout);
+	virtual void commit(UInt length);
+	inline const void *borrow(UInt *pLength);
+	virtual const void *borrow(UInt *pLength, TimeValue timeout);
+	virtual void release(UInt length);
+
 	// timeout
 	inline TimeValue getDefaultTimeout() const;
 	inline void setDefaultTimeout(TimeValue timeout);
@@ -50,6 +62,28 @@ inline Stream::Stream()
 	defaultTimeout = infiniteTime;
 }
 
+//------------------------------------------------------------------------------------------------
+// * Stream::reserve
+//
+// Reserves space in the stream for writing with the default timeout.
+//------------------------------------------------------------------------------------------------
+
+inline void *Stream::reserve(UInt *pLength)
+{
+	return reserve(pLength, defaultTimeout);
+}
+
+//------------------------------------------------------------------------------------------------
+// * Stream::borrow
+//
+// Borrows data from the stream for reading with the default timeout.
+//------------------------------------------------------------------------------------------------
+
+inline const void *Stream::borrow(UInt *pLength)
+{
+	return borrow(pLength, defaultTimeout);
+}
+
 //------------------------------------------------------------------------------------------------
 // * Stream::getDefaultTimeout
 //
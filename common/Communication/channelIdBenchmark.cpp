@@ -0,0 +1,396 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Timer.h"
+#include "../multitasking/sleep.h"
+#include "../memoryUtilities.h"
+#include "Stream.h"
+#include "SimulatedLink.h"
+#include "CheckReadChannel.h"
+#include "CheckWriteChannel.h"
+#include "NocheckReadChannel.h"
+#include "NocheckWriteChannel.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the numbers of channels open at the same time, their IDs are spread over all extended IDs
+static const UInt numbersOfChannels[] = {16, 256, 1024};
+static const UInt numberOfWorkloads = arrayDimension(numbersOfChannels);
+
+// the simulated link is fast enough for the packet layers to be the bottleneck
+static const UInt lineRateInBytesPerSecond = 400000000;
+static const UInt packetPipelineDepth = 2;
+static const UInt messageSize = 32;
+static const UInt measurementTimeInMilliseconds = 1000;
+
+// a single write larger than the extended Nocheck header can carry, so it is split
+static const UInt largeWriteSize = 1000000;
+
+//------------------------------------------------------------------------------------------------
+// * class ChannelWriterTask
+//------------------------------------------------------------------------------------------------
+
+class ChannelWriterTask : public Task
+{
+public:
+	// constructor
+	ChannelWriterTask(
+		Stream &stream,
+		UInt channelId,
+		volatile Bool &stopping,
+		volatile UInt &numberOfTasksDone);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	UInt channelId;
+	volatile Bool &stopping;
+	volatile UInt &numberOfTasksDone;
+};
+
+ChannelWriterTask::ChannelWriterTask(
+	Stream &stream,
+	UInt channelId,
+	volatile Bool &stopping,
+	volatile UInt &numberOfTasksDone) :
+	Task(defaultPriority, 10000),
+	stream(stream),
+	stopping(stopping),
+	numberOfTasksDone(numberOfTasksDone)
+{
+	this->channelId = channelId;
+}
+
+void ChannelWriterTask::main()
+{
+	// every message carries the ID of its channel, so that the reader can check it
+	UInt8 message[messageSize] = {0};
+	message[0] = (UInt8)channelId;
+	message[1] = (UInt8)(channelId >> 8);
+	while(!stopping && stream.write(message, messageSize) == messageSize)
+	{
+		stream.flush();
+	}
+	++numberOfTasksDone;
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ChannelReaderTask
+//------------------------------------------------------------------------------------------------
+
+class ChannelReaderTask : public Task
+{
+public:
+	// constructor
+	ChannelReaderTask(
+		Stream &stream,
+		UInt channelId,
+		volatile UInt &numberOfMessagesRead,
+		volatile UInt &numberOfMisroutedMessages,
+		volatile UInt &numberOfTasksDone);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	UInt channelId;
+	volatile UInt &numberOfMessagesRead;
+	volatile UInt &numberOfMisroutedMessages;
+	volatile UInt &numberOfTasksDone;
+};
+
+ChannelReaderTask::ChannelReaderTask(
+	Stream &stream,
+	UInt channelId,
+	volatile UInt &numberOfMessagesRead,
+	volatile UInt &numberOfMisroutedMessages,
+	volatile UInt &numberOfTasksDone) :
+	Task(defaultPriority, 10000),
+	stream(stream),
+	numberOfMessagesRead(numberOfMessagesRead),
+	numberOfMisroutedMessages(numberOfMisroutedMessages),
+	numberOfTasksDone(numberOfTasksDone)
+{
+	this->channelId = channelId;
+}
+
+void ChannelReaderTask::main()
+{
+	// stop when the channel is removed
+	UInt8 message[messageSize];
+	while(stream.read(message, messageSize) == messageSize)
+	{
+		if(message[0] != (UInt8)channelId || message[1] != (UInt8)(channelId >> 8))
+		{
+			++numberOfMisroutedMessages;
+		}
+		++numberOfMessagesRead;
+	}
+	++numberOfTasksDone;
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class LargeWriterTask
+//------------------------------------------------------------------------------------------------
+
+class LargeWriterTask : public Task
+{
+public:
+	// constructor
+	LargeWriterTask(Stream &stream, const UInt8 *pData, UInt length);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	const UInt8 *pData;
+	UInt length;
+};
+
+LargeWriterTask::LargeWriterTask(Stream &stream, const UInt8 *pData, UInt length) :
+	Task(defaultPriority, 10000),
+	stream(stream)
+{
+	this->pData = pData;
+	this->length = length;
+}
+
+void LargeWriterTask::main()
+{
+	// write all data at once, the channel splits it into packets
+	stream.write(pData, length);
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ChannelIdBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class ChannelIdBenchmarkTask : public Task
+{
+public:
+	// constructor
+	ChannelIdBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	void measureCheckMessageRate(UInt numberOfChannels);
+	void measureNocheckMessageRate(UInt numberOfChannels);
+	void measureNocheckLargeWrite();
+	void measureMessageRate(
+		const char *pLayerName,
+		UInt numberOfChannelIds,
+		Stream **ppReadChannels,
+		Stream **ppWriteChannels,
+		UInt numberOfChannels);
+	static UInt getChannelId(UInt channelNumber, UInt numberOfChannelIds, UInt numberOfChannels);
+};
+
+ChannelIdBenchmarkTask::ChannelIdBenchmarkTask() :
+	Task(defaultPriority + 1, 10000)
+{
+}
+
+UInt ChannelIdBenchmarkTask::getChannelId(UInt channelNumber, UInt numberOfChannelIds, UInt numberOfChannels)
+{
+	// spread the channels over all IDs, not only on page boundaries
+	const UInt channelIdStep = numberOfChannelIds / numberOfChannels;
+	return channelNumber * channelIdStep + channelNumber % channelIdStep;
+}
+
+void ChannelIdBenchmarkTask::measureCheckMessageRate(UInt numberOfChannels)
+{
+	// connect two packet layers over a new simulated link, each with room for its channels only
+	SimulatedLink link(lineRateInBytesPerSecond);
+	link.connectCheckPacketLayers(packetPipelineDepth, CheckPacketLayer::allCapabilities, numberOfChannels);
+
+	// the layer reads on one end and writes on the other
+	Stream **ppReadChannels = new Stream *[numberOfChannels];
+	Stream **ppWriteChannels = new Stream *[numberOfChannels];
+	const UInt numberOfChannelIds = link.getCheckPacketLayerA().getNumberOfChannelIds();
+	for(UInt channelNumber = 0; channelNumber < numberOfChannels; ++channelNumber)
+	{
+		const UInt channelId = getChannelId(channelNumber, numberOfChannelIds, numberOfChannels);
+		ppReadChannels[channelNumber] = new CheckReadChannel(link.getCheckPacketLayerB(), channelId);
+		ppWriteChannels[channelNumber] = new CheckWriteChannel(link.getCheckPacketLayerA(), channelId);
+	}
+	measureMessageRate("Check", numberOfChannelIds, ppReadChannels, ppWriteChannels, numberOfChannels);
+}
+
+void ChannelIdBenchmarkTask::measureNocheckMessageRate(UInt numberOfChannels)
+{
+	// connect two packet layers over a new simulated link
+	SimulatedLink link(lineRateInBytesPerSecond);
+	link.connectNocheckPacketLayers();
+
+	// the layer reads on one end and writes on the other
+	Stream **ppReadChannels = new Stream *[numberOfChannels];
+	Stream **ppWriteChannels = new Stream *[numberOfChannels];
+	const UInt numberOfChannelIds = link.getNocheckPacketLayerA().getNumberOfChannelIds();
+	for(UInt channelNumber = 0; channelNumber < numberOfChannels; ++channelNumber)
+	{
+		const UInt channelId = getChannelId(channelNumber, numberOfChannelIds, numberOfChannels);
+		ppReadChannels[channelNumber] = new NocheckReadChannel(link.getNocheckPacketLayerB(), channelId);
+		ppWriteChannels[channelNumber] = new NocheckWriteChannel(link.getNocheckPacketLayerA(), channelId);
+	}
+	measureMessageRate("Nocheck", numberOfChannelIds, ppReadChannels, ppWriteChannels, numberOfChannels);
+}
+
+void ChannelIdBenchmarkTask::measureNocheckLargeWrite()
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	// connect two packet layers over a new simulated link
+	SimulatedLink link(lineRateInBytesPerSecond);
+	link.connectNocheckPacketLayers();
+	NocheckPacketLayer &layerA = link.getNocheckPacketLayerA();
+	NocheckPacketLayer &layerB = link.getNocheckPacketLayerB();
+
+	// write more data at once than a packet can carry on the highest channel ID
+	const UInt channelId = layerA.getNumberOfChannelIds() - 1;
+	NocheckReadChannel *pReadChannel = new NocheckReadChannel(layerB, channelId);
+	NocheckWriteChannel *pWriteChannel = new NocheckWriteChannel(layerA, channelId);
+	UInt8 *pWrittenData = new UInt8[largeWriteSize];
+	UInt8 *pReadData = new UInt8[largeWriteSize];
+	for(UInt index = 0; index < largeWriteSize; ++index)
+	{
+		pWrittenData[index] = (UInt8)(index * 7 + (index >> 16));
+	}
+	memoryZero(pReadData, largeWriteSize);
+	const TimeValue startTime = pTimer->getTime();
+	(new LargeWriterTask(*pWriteChannel, pWrittenData, largeWriteSize))->resume();
+	const UInt numberOfBytesRead = pReadChannel->read(pReadData, largeWriteSize);
+	const TimeValue elapsedTicks = compareTimes(pTimer->getTime(), startTime);
+	const Bool intact = numberOfBytesRead == largeWriteSize
+		&& arrayCompare(pWrittenData, pReadData, largeWriteSize) == 0;
+	NocheckPacket packet;
+	packet.setHeaderFormat(layerA.getHeaderFormat());
+
+	#if defined(PRINT)
+		std::cout << "Nocheck, one write of " << largeWriteSize << " bytes in packets of up to "
+			<< packet.getMaximumDataSize() << " bytes on channel " << channelId << ": "
+			<< (UInt)((UInt64)numberOfBytesRead * pTimer->getFrequency() / maximum(elapsedTicks, (TimeValue)1) / 1024)
+			<< "KB/s, data " << (intact ? "intact" : "corrupted") << std::endl;
+	#endif
+
+	// the writer is done once everything has been read
+	delete pWriteChannel;
+	delete pReadChannel;
+	delete [] pReadData;
+	delete [] pWrittenData;
+}
+
+void ChannelIdBenchmarkTask::measureMessageRate(
+	const char *pLayerName,
+	UInt numberOfChannelIds,
+	Stream **ppReadChannels,
+	Stream **ppWriteChannels,
+	UInt numberOfChannels)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	// send messages on all channels at once
+	volatile Bool stopping = false;
+	volatile UInt numberOfMessagesRead = 0;
+	volatile UInt numberOfMisroutedMessages = 0;
+	volatile UInt numberOfTasksDone = 0;
+	for(UInt channelNumber = 0; channelNumber < numberOfChannels; ++channelNumber)
+	{
+		const UInt channelId = getChannelId(channelNumber, numberOfChannelIds, numberOfChannels);
+		(new ChannelReaderTask(
+			*ppReadChannels[channelNumber],
+			channelId,
+			numberOfMessagesRead,
+			numberOfMisroutedMessages,
+			numberOfTasksDone))->resume();
+		(new ChannelWriterTask(*ppWriteChannels[channelNumber], channelId, stopping, numberOfTasksDone))->resume();
+	}
+
+	// count the messages read once the channels are busy
+	sleepForTicks(pTimer->getFrequency() / 10, pTimer);
+	const UInt startCount = numberOfMessagesRead;
+	const TimeValue startTime = pTimer->getTime();
+	sleepForTicks((TimeValue)((UInt64)measurementTimeInMilliseconds * pTimer->getFrequency() / 1000), pTimer);
+	const UInt messageCount = numberOfMessagesRead - startCount;
+	const TimeValue elapsedTicks = compareTimes(pTimer->getTime(), startTime);
+
+	// stop the writers and readers, the channels are removed once no task uses them
+	stopping = true;
+	for(UInt channelNumber = 0; channelNumber < numberOfChannels; ++channelNumber)
+	{
+		ppWriteChannels[channelNumber]->forceError();
+		ppReadChannels[channelNumber]->forceError();
+	}
+	while(numberOfTasksDone < numberOfChannels * 2)
+	{
+		sleepForTicks(pTimer->getFrequency() / 1000, pTimer);
+	}
+	for(UInt channelNumber = 0; channelNumber < numberOfChannels; ++channelNumber)
+	{
+		delete ppWriteChannels[channelNumber];
+		delete ppReadChannels[channelNumber];
+	}
+	delete [] ppWriteChannels;
+	delete [] ppReadChannels;
+
+	#if defined(PRINT)
+		std::cout << pLayerName << ", " << numberOfChannels << " channels, IDs up to " << numberOfChannelIds - 1 << ": "
+			<< (UInt)((UInt64)messageCount * pTimer->getFrequency() / elapsedTicks) << " messages/s, "
+			<< numberOfMisroutedMessages << " messages on the wrong channel" << std::endl;
+	#endif
+}
+
+void ChannelIdBenchmarkTask::main()
+{
+	// the message rate should not depend on the number of channels or the size of their IDs
+	for(UInt workloadNumber = 0; workloadNumber < numberOfWorkloads; ++workloadNumber)
+	{
+		measureCheckMessageRate(numbersOfChannels[workloadNumber]);
+	}
+	for(UInt workloadNumber = 0; workloadNumber < numberOfWorkloads; ++workloadNumber)
+	{
+		measureNocheckMessageRate(numbersOfChannels[workloadNumber]);
+	}
+	measureNocheckLargeWrite();
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * channelIdBenchmark
+//------------------------------------------------------------------------------------------------
+
+void channelIdBenchmark()
+{
+	(new ChannelIdBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
@@ -0,0 +1,220 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Timer.h"
+#include "../multitasking/sleep.h"
+#include "Stream.h"
+#include "SimulatedLink.h"
+#include "CheckReadChannel.h"
+#include "CheckWriteChannel.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the numbers of channels sending messages at the same time
+static const UInt numbersOfChannels[] = {1, 4, 16};
+static const UInt numberOfWorkloads = arrayDimension(numbersOfChannels);
+static const UInt maximumNumberOfChannels = 16;
+
+// the simulated link runs at about the rate of a full speed USB port, where every write waits
+// for a frame of its own
+static const UInt lineRateInBytesPerSecond = 1000000;
+static const UInt roundTripTimeInMicroseconds = 2000;
+static const UInt writeOverheadInMicroseconds = 1000;
+static const UInt packetPipelineDepth = 16;
+static const UInt messageSize = 32;
+static const UInt measurementTimeInMilliseconds = 1000;
+
+//------------------------------------------------------------------------------------------------
+// * class MessageWriterTask
+//------------------------------------------------------------------------------------------------
+
+class MessageWriterTask : public Task
+{
+public:
+	// constructor
+	MessageWriterTask(Stream &stream, volatile Bool &stopping);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	volatile Bool &stopping;
+};
+
+MessageWriterTask::MessageWriterTask(Stream &stream, volatile Bool &stopping) :
+	Task(defaultPriority, 10000),
+	stream(stream),
+	stopping(stopping)
+{
+}
+
+void MessageWriterTask::main()
+{
+	// send every message on its own, as debug output and control traffic do
+	UInt8 message[messageSize] = {0};
+	while(!stopping && stream.write(message, messageSize) == messageSize)
+	{
+		stream.flush();
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class MessageReaderTask
+//------------------------------------------------------------------------------------------------
+
+class MessageReaderTask : public Task
+{
+public:
+	// constructor
+	MessageReaderTask(Stream &stream, volatile UInt &numberOfMessagesRead);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	volatile UInt &numberOfMessagesRead;
+};
+
+MessageReaderTask::MessageReaderTask(Stream &stream, volatile UInt &numberOfMessagesRead) :
+	Task(defaultPriority, 10000),
+	stream(stream),
+	numberOfMessagesRead(numberOfMessagesRead)
+{
+}
+
+void MessageReaderTask::main()
+{
+	// stop when the channel is removed
+	UInt8 message[messageSize];
+	while(stream.read(message, messageSize) == messageSize)
+	{
+		++numberOfMessagesRead;
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class CoalescingBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class CoalescingBenchmarkTask : public Task
+{
+public:
+	// constructor
+	CoalescingBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	void measureMessageRate(UInt numberOfChannels, Bool coalescing);
+};
+
+CoalescingBenchmarkTask::CoalescingBenchmarkTask() :
+	Task(defaultPriority + 1, 10000)
+{
+}
+
+void CoalescingBenchmarkTask::measureMessageRate(UInt numberOfChannels, Bool coalescing)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	// connect two packet layers over a new simulated link
+	SimulatedLink link(lineRateInBytesPerSecond);
+	link.setRoundTripTime(roundTripTimeInMicroseconds);
+	link.setWriteOverhead(writeOverheadInMicroseconds);
+	link.connectCheckPacketLayers(packetPipelineDepth);
+	CheckPacketLayer &layerA = link.getCheckPacketLayerA();
+	CheckPacketLayer &layerB = link.getCheckPacketLayerB();
+	layerA.setCoalescing(coalescing);
+	layerB.setCoalescing(coalescing);
+
+	// send messages on all channels at once
+	volatile Bool stopping = false;
+	volatile UInt numberOfMessagesRead = 0;
+	CheckReadChannel *pReadChannels[maximumNumberOfChannels];
+	CheckWriteChannel *pWriteChannels[maximumNumberOfChannels];
+	for(UInt channelId = 0; channelId < numberOfChannels; ++channelId)
+	{
+		pReadChannels[channelId] = new CheckReadChannel(layerB, channelId);
+		pWriteChannels[channelId] = new CheckWriteChannel(layerA, channelId);
+		(new MessageReaderTask(*pReadChannels[channelId], numberOfMessagesRead))->resume();
+		(new MessageWriterTask(*pWriteChannels[channelId], stopping))->resume();
+	}
+
+	// count the messages read once the channels are busy
+	sleepForTicks(pTimer->getFrequency() / 10, pTimer);
+	const UInt startCount = numberOfMessagesRead;
+	const UInt startWrites = layerA.getNumberOfWrites();
+	const TimeValue startTime = pTimer->getTime();
+	sleepForTicks((TimeValue)((UInt64)measurementTimeInMilliseconds * pTimer->getFrequency() / 1000), pTimer);
+	const UInt messageCount = numberOfMessagesRead - startCount;
+	const UInt writeCount = layerA.getNumberOfWrites() - startWrites;
+	const TimeValue elapsedTicks = compareTimes(pTimer->getTime(), startTime);
+
+	// stop the writers and readers before the channels are removed
+	stopping = true;
+	for(UInt channelId = 0; channelId < numberOfChannels; ++channelId)
+	{
+		pWriteChannels[channelId]->forceError();
+		pReadChannels[channelId]->forceError();
+	}
+	sleepForTicks(pTimer->getFrequency() / 10, pTimer);
+	for(UInt channelId = 0; channelId < numberOfChannels; ++channelId)
+	{
+		delete pWriteChannels[channelId];
+		delete pReadChannels[channelId];
+	}
+
+	#if defined(PRINT)
+		std::cout << numberOfChannels << (numberOfChannels == 1 ? " channel" : " channels")
+			<< (coalescing ? ", coalescing: " : ", one packet per write: ")
+			<< (UInt)((UInt64)messageCount * pTimer->getFrequency() / elapsedTicks) << " messages/s, "
+			<< (messageCount != 0 ? (UInt)((UInt64)writeCount * 100 / messageCount) : 0)
+			<< " writes per 100 messages\n";
+	#endif
+}
+
+void CoalescingBenchmarkTask::main()
+{
+	// compare one write per packet with coalescing the packets queued back to back
+	for(UInt workloadNumber = 0; workloadNumber < numberOfWorkloads; ++workloadNumber)
+	{
+		measureMessageRate(numbersOfChannels[workloadNumber], false);
+		measureMessageRate(numbersOfChannels[workloadNumber], true);
+	}
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * coalescingBenchmark
+//------------------------------------------------------------------------------------------------
+
+void coalescingBenchmark()
+{
+	(new CoalescingBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
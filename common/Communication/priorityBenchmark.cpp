@@ -0,0 +1,358 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Timer.h"
+#include "../multitasking/IntertaskEvent.h"
+#include "../multitasking/sleep.h"
+#include "../memoryUtilities.h"
+#include "Stream.h"
+#include "SimulatedLink.h"
+#include "CheckReadChannel.h"
+#include "CheckWriteChannel.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the priority classes of the control channel, the bulk channels are in the default class
+struct ControlPriority
+{
+	UInt priorityClass;
+	const char *pName;
+};
+static const ControlPriority controlPriorities[] =
+{
+	{CheckPacketLayer::defaultPriorityClass, "same class as the bulk channels"},
+	{CheckPacketLayer::highestPriorityClass, "highest class"}
+};
+static const UInt numberOfControlPriorities = arrayDimension(controlPriorities);
+
+// the simulated link runs at about the rate of a full speed USB port
+static const UInt lineRateInBytesPerSecond = 1000000;
+static const UInt roundTripTimeInMicroseconds = 2000;
+static const UInt packetPipelineDepth = 16;
+static const UInt bulkChunkSize = 4096;
+static const UInt controlMessageSize = 32;
+static const UInt controlIntervalInMilliseconds = 10;
+static const UInt numberOfControlMessages = 200;
+static const UInt numberOfBulkChannels = 4;
+static const UInt controlChannelId = numberOfBulkChannels;
+
+//------------------------------------------------------------------------------------------------
+// * class BulkWriterTask
+//------------------------------------------------------------------------------------------------
+
+class BulkWriterTask : public Task
+{
+public:
+	// constructor
+	BulkWriterTask(Stream &stream, volatile Bool &stopping);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	volatile Bool &stopping;
+};
+
+BulkWriterTask::BulkWriterTask(Stream &stream, volatile Bool &stopping) :
+	Task(defaultPriority, 10000),
+	stream(stream),
+	stopping(stopping)
+{
+}
+
+void BulkWriterTask::main()
+{
+	// keep the link busy, as a firmware or log transfer does
+	static UInt8 chunk[bulkChunkSize];
+	while(!stopping && stream.write(chunk, bulkChunkSize) == bulkChunkSize)
+	{
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class BulkReaderTask
+//------------------------------------------------------------------------------------------------
+
+class BulkReaderTask : public Task
+{
+public:
+	// constructor
+	BulkReaderTask(Stream &stream, volatile UInt &numberOfBytesRead);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	volatile UInt &numberOfBytesRead;
+};
+
+BulkReaderTask::BulkReaderTask(Stream &stream, volatile UInt &numberOfBytesRead) :
+	Task(defaultPriority, 10000),
+	stream(stream),
+	numberOfBytesRead(numberOfBytesRead)
+{
+}
+
+void BulkReaderTask::main()
+{
+	// stop when the channel is removed
+	static UInt8 chunk[bulkChunkSize];
+	while(stream.read(chunk, bulkChunkSize) == bulkChunkSize)
+	{
+		numberOfBytesRead += bulkChunkSize;
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ControlWriterTask
+//------------------------------------------------------------------------------------------------
+
+class ControlWriterTask : public Task
+{
+public:
+	// constructor
+	ControlWriterTask(Stream &stream);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+};
+
+ControlWriterTask::ControlWriterTask(Stream &stream) :
+	Task(defaultPriority + 1, 10000),
+	stream(stream)
+{
+}
+
+void ControlWriterTask::main()
+{
+	// send small messages now and then, each with the time it was sent
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	UInt8 message[controlMessageSize] = {0};
+	for(UInt messageNumber = 0; messageNumber < numberOfControlMessages; ++messageNumber)
+	{
+		sleepForTicks(pTimer->getFrequency() * controlIntervalInMilliseconds / 1000, pTimer);
+		const TimeValue sendTime = pTimer->getTime();
+		memoryCopy(message, &sendTime, sizeof(sendTime));
+		if(stream.write(message, controlMessageSize) != controlMessageSize)
+		{
+			return;
+		}
+		stream.flush();
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ControlReaderTask
+//------------------------------------------------------------------------------------------------
+
+class ControlReaderTask : public Task
+{
+public:
+	// constructor
+	ControlReaderTask(Stream &stream, IntertaskEvent &completeEvent);
+
+	// accessing
+	inline TimeValue getTotalLatency() const;
+	inline TimeValue getMaximumLatency() const;
+	inline UInt getNumberOfMessagesRead() const;
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	IntertaskEvent &completeEvent;
+	TimeValue totalLatency;
+	TimeValue maximumLatency;
+	UInt numberOfMessagesRead;
+};
+
+ControlReaderTask::ControlReaderTask(Stream &stream, IntertaskEvent &completeEvent) :
+	Task(defaultPriority + 1, 10000),
+	stream(stream),
+	completeEvent(completeEvent)
+{
+	totalLatency = 0;
+	maximumLatency = 0;
+	numberOfMessagesRead = 0;
+}
+
+inline TimeValue ControlReaderTask::getTotalLatency() const
+{
+	return totalLatency;
+}
+
+inline TimeValue ControlReaderTask::getMaximumLatency() const
+{
+	return maximumLatency;
+}
+
+inline UInt ControlReaderTask::getNumberOfMessagesRead() const
+{
+	return numberOfMessagesRead;
+}
+
+void ControlReaderTask::main()
+{
+	// measure the time from writing every message to reading it
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	UInt8 message[controlMessageSize];
+	while(numberOfMessagesRead < numberOfControlMessages
+		&& stream.read(message, controlMessageSize) == controlMessageSize)
+	{
+		TimeValue sendTime;
+		memoryCopy(&sendTime, message, sizeof(sendTime));
+		const TimeValue latency = compareTimes(pTimer->getTime(), sendTime);
+		totalLatency += latency;
+		maximumLatency = maximum(maximumLatency, latency);
+		++numberOfMessagesRead;
+	}
+	completeEvent.signal();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class PriorityBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class PriorityBenchmarkTask : public Task
+{
+public:
+	// constructor
+	PriorityBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	void measureLatency(const ControlPriority &controlPriority);
+
+	// representation
+	IntertaskEvent completeEvent;
+};
+
+PriorityBenchmarkTask::PriorityBenchmarkTask() :
+	Task(defaultPriority + 2, 10000)
+{
+}
+
+void PriorityBenchmarkTask::measureLatency(const ControlPriority &controlPriority)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	// connect two packet layers over a new simulated link
+	SimulatedLink link(lineRateInBytesPerSecond);
+	link.setRoundTripTime(roundTripTimeInMicroseconds);
+	link.connectCheckPacketLayers(packetPipelineDepth);
+	CheckPacketLayer &layerA = link.getCheckPacketLayerA();
+	CheckPacketLayer &layerB = link.getCheckPacketLayerB();
+
+	// saturate the link with the bulk channels
+	volatile Bool stopping = false;
+	volatile UInt numberOfBulkBytesRead = 0;
+	CheckReadChannel **ppBulkReadChannels = new CheckReadChannel *[numberOfBulkChannels];
+	CheckWriteChannel **ppBulkWriteChannels = new CheckWriteChannel *[numberOfBulkChannels];
+	for(UInt channelId = 0; channelId < numberOfBulkChannels; ++channelId)
+	{
+		ppBulkReadChannels[channelId] = new CheckReadChannel(layerB, channelId);
+		ppBulkWriteChannels[channelId] = new CheckWriteChannel(layerA, channelId);
+		(new BulkReaderTask(*ppBulkReadChannels[channelId], numberOfBulkBytesRead))->resume();
+		(new BulkWriterTask(*ppBulkWriteChannels[channelId], stopping))->resume();
+	}
+	sleepForTicks(pTimer->getFrequency() / 10, pTimer);
+
+	// send the control messages alongside
+	CheckReadChannel *pControlReadChannel = new CheckReadChannel(layerB, controlChannelId);
+	CheckWriteChannel *pControlWriteChannel = new CheckWriteChannel(layerA, controlChannelId);
+	pControlReadChannel->setPriority(controlPriority.priorityClass);
+	pControlWriteChannel->setPriority(controlPriority.priorityClass);
+	ControlReaderTask *pControlReaderTask = new ControlReaderTask(*pControlReadChannel, completeEvent);
+	const UInt startBulkBytes = numberOfBulkBytesRead;
+	const TimeValue startTime = pTimer->getTime();
+	pControlReaderTask->resume();
+	(new ControlWriterTask(*pControlWriteChannel))->resume();
+	completeEvent.wait();
+	const UInt bulkBytes = numberOfBulkBytesRead - startBulkBytes;
+	const TimeValue elapsedTicks = compareTimes(pTimer->getTime(), startTime);
+
+	// stop the bulk transfer before the channels are removed
+	stopping = true;
+	for(UInt channelId = 0; channelId < numberOfBulkChannels; ++channelId)
+	{
+		ppBulkWriteChannels[channelId]->forceError();
+		ppBulkReadChannels[channelId]->forceError();
+	}
+	sleepForTicks(pTimer->getFrequency() / 10, pTimer);
+	delete pControlWriteChannel;
+	delete pControlReadChannel;
+	for(UInt channelId = 0; channelId < numberOfBulkChannels; ++channelId)
+	{
+		delete ppBulkWriteChannels[channelId];
+		delete ppBulkReadChannels[channelId];
+	}
+	delete [] ppBulkWriteChannels;
+	delete [] ppBulkReadChannels;
+
+	#if defined(PRINT)
+		const UInt numberOfMessages = maximum(pControlReaderTask->getNumberOfMessagesRead(), (UInt)1);
+		std::cout << "Control channel in the " << controlPriority.pName << ": "
+			<< (UInt)((UInt64)pControlReaderTask->getTotalLatency() * 1000000 / pTimer->getFrequency() / numberOfMessages)
+			<< "us average latency, "
+			<< (UInt)((UInt64)pControlReaderTask->getMaximumLatency() * 1000000 / pTimer->getFrequency())
+			<< "us maximum, bulk channels "
+			<< (UInt)((UInt64)bulkBytes * pTimer->getFrequency() / elapsedTicks / 1024) << "KB/s\n";
+	#endif
+}
+
+void PriorityBenchmarkTask::main()
+{
+	// compare the latency of a control channel that takes turns with the bulk channels with one
+	// that goes first
+	for(UInt priorityNumber = 0; priorityNumber < numberOfControlPriorities; ++priorityNumber)
+	{
+		measureLatency(controlPriorities[priorityNumber]);
+	}
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * priorityBenchmark
+//------------------------------------------------------------------------------------------------
+
+void priorityBenchmark()
+{
+	(new PriorityBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
@@ -0,0 +1,273 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Timer.h"
+#include "../multitasking/IntertaskEvent.h"
+#include "../multitasking/sleep.h"
+#include "Stream.h"
+#include "SimulatedLink.h"
+#include "CheckReadChannel.h"
+#include "CheckWriteChannel.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the bit error rates of the simulated link
+struct BitErrorRate
+{
+	UInt bitErrorsPerBillion;
+	const char *pName;
+};
+static const BitErrorRate bitErrorRates[] =
+{
+	{0, "0"},
+	{100, "1e-7"},
+	{1000, "1e-6"},
+	{10000, "1e-5"},
+	{30000, "3e-5"},
+	{100000, "1e-4"}
+};
+static const UInt numberOfBitErrorRates = arrayDimension(bitErrorRates);
+
+// the simulated link runs at about the rate of a full speed USB port, with the round trip time
+// of a USB to serial converter
+static const UInt lineRateInBytesPerSecond = 1000000;
+static const UInt roundTripTimeInMicroseconds = 8000;
+static const UInt packetPipelineDepth = 16;
+static const UInt bytesPerMeasurement = 512 * 1024;
+static const UInt chunkSize = 4096;
+static const UInt timeoutInSeconds = 60;
+
+// the data written is a function of its position, so that the reader can check it
+static inline UInt8 getDataByte(UInt position)
+{
+	return (UInt8)(position * 7 + (position >> 9));
+}
+
+//------------------------------------------------------------------------------------------------
+// * class RetransmissionWriterTask
+//------------------------------------------------------------------------------------------------
+
+class RetransmissionWriterTask : public Task
+{
+public:
+	// constructor
+	RetransmissionWriterTask(Stream &stream);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+};
+
+RetransmissionWriterTask::RetransmissionWriterTask(Stream &stream) :
+	Task(defaultPriority, 10000),
+	stream(stream)
+{
+}
+
+void RetransmissionWriterTask::main()
+{
+	static UInt8 chunk[chunkSize];
+	for(UInt offset = 0; offset < bytesPerMeasurement; offset += chunkSize)
+	{
+		for(UInt i = 0; i < chunkSize; ++i)
+		{
+			chunk[i] = getDataByte(offset + i);
+		}
+		if(stream.write(chunk, chunkSize) != chunkSize)
+		{
+			return;
+		}
+	}
+	stream.flush();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class RetransmissionReaderTask
+//------------------------------------------------------------------------------------------------
+
+class RetransmissionReaderTask : public Task
+{
+public:
+	// constructor
+	RetransmissionReaderTask(Stream &stream, IntertaskEvent &completeEvent);
+
+	// accessing
+	inline UInt getNumberOfBytesRead() const;
+	inline Bool isDataCorrect() const;
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	IntertaskEvent &completeEvent;
+	UInt numberOfBytesRead;
+	Bool dataCorrect;
+};
+
+RetransmissionReaderTask::RetransmissionReaderTask(Stream &stream, IntertaskEvent &completeEvent) :
+	Task(defaultPriority, 10000),
+	stream(stream),
+	completeEvent(completeEvent)
+{
+	numberOfBytesRead = 0;
+	dataCorrect = true;
+}
+
+inline UInt RetransmissionReaderTask::getNumberOfBytesRead() const
+{
+	return numberOfBytesRead;
+}
+
+inline Bool RetransmissionReaderTask::isDataCorrect() const
+{
+	return dataCorrect;
+}
+
+void RetransmissionReaderTask::main()
+{
+	static UInt8 chunk[chunkSize];
+	while(numberOfBytesRead < bytesPerMeasurement)
+	{
+		// stop if the channel fails
+		const UInt length = stream.read(chunk, chunkSize);
+		for(UInt i = 0; i < length; ++i)
+		{
+			if(chunk[i] != getDataByte(numberOfBytesRead + i))
+			{
+				dataCorrect = false;
+			}
+		}
+		numberOfBytesRead += length;
+		if(length != chunkSize)
+		{
+			break;
+		}
+	}
+	completeEvent.signal();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class RetransmissionBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class RetransmissionBenchmarkTask : public Task
+{
+public:
+	// constructor
+	RetransmissionBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	void measureGoodput(UInt capabilities, const BitErrorRate &bitErrorRate);
+
+	// representation
+	IntertaskEvent completeEvent;
+};
+
+RetransmissionBenchmarkTask::RetransmissionBenchmarkTask() :
+	Task(defaultPriority + 1, 10000)
+{
+}
+
+void RetransmissionBenchmarkTask::measureGoodput(UInt capabilities, const BitErrorRate &bitErrorRate)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	// connect two packet layers over a new simulated link, without errors until they agree
+	SimulatedLink link(lineRateInBytesPerSecond);
+	link.setRoundTripTime(roundTripTimeInMicroseconds);
+	link.connectCheckPacketLayers(packetPipelineDepth, capabilities);
+	link.setBitErrorRate(bitErrorRate.bitErrorsPerBillion);
+	CheckPacketLayer &layerA = link.getCheckPacketLayerA();
+	CheckPacketLayer &layerB = link.getCheckPacketLayerB();
+
+	// move the data from one end to the other, giving up if it takes too long
+	CheckReadChannel *pReadChannel = new CheckReadChannel(layerB, 0);
+	CheckWriteChannel *pWriteChannel = new CheckWriteChannel(layerA, 0);
+	RetransmissionReaderTask *pReaderTask = new RetransmissionReaderTask(*pReadChannel, completeEvent);
+	const TimeValue startTime = pTimer->getTime();
+	pReaderTask->resume();
+	(new RetransmissionWriterTask(*pWriteChannel))->resume();
+	if(completeEvent.waitForSeconds(timeoutInSeconds))
+	{
+		pReadChannel->forceError();
+		completeEvent.wait();
+	}
+	const TimeValue elapsedTicks = compareTimes(pTimer->getTime(), startTime);
+
+	// let the writer finish before the channels are removed
+	pWriteChannel->forceError();
+	sleepForTicks(pTimer->getFrequency() / 10, pTimer);
+	delete pWriteChannel;
+	delete pReadChannel;
+
+	#if defined(PRINT)
+		std::cout << (capabilities != 0 ? "Selective retransmission" : "Resynchronization")
+			<< ", bit error rate " << bitErrorRate.pName << ": ";
+		if(pReaderTask->getNumberOfBytesRead() < bytesPerMeasurement)
+		{
+			std::cout << "failed after " << pReaderTask->getNumberOfBytesRead() / 1024 << "KB, ";
+		}
+		else
+		{
+			const UInt bytesPerSecond
+				= (UInt)((UInt64)bytesPerMeasurement * pTimer->getFrequency() / elapsedTicks);
+			std::cout << bytesPerSecond / 1024 << "KB/s ("
+				<< (UInt)((UInt64)bytesPerSecond * 100 / lineRateInBytesPerSecond) << "% of line rate), ";
+		}
+		std::cout << link.getNumberOfBitErrors() << " bit errors, "
+			<< layerA.getNumberOfDamagedPackets() + layerB.getNumberOfDamagedPackets()
+			<< " damaged packets, "
+			<< layerA.getNumberOfResentPackets() + layerB.getNumberOfResentPackets()
+			<< " packets resent"
+			<< (pReaderTask->isDataCorrect() ? "" : ", DATA CORRUPTED") << "\n";
+	#endif
+}
+
+void RetransmissionBenchmarkTask::main()
+{
+	// compare selective retransmission with resynchronizing the link on every damaged packet
+	for(UInt rateNumber = 0; rateNumber < numberOfBitErrorRates; ++rateNumber)
+	{
+		measureGoodput(CheckPacketLayer::selectiveRetransmission, bitErrorRates[rateNumber]);
+		measureGoodput(0, bitErrorRates[rateNumber]);
+	}
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * retransmissionBenchmark
+//------------------------------------------------------------------------------------------------
+
+void retransmissionBenchmark()
+{
+	(new RetransmissionBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
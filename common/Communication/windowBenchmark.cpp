@@ -0,0 +1,206 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Timer.h"
+#include "../multitasking/IntertaskEvent.h"
+#include "../multitasking/sleep.h"
+#include "Stream.h"
+#include "SimulatedLink.h"
+#include "CheckReadChannel.h"
+#include "CheckWriteChannel.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the packet pipeline depths compared and the round trip times of the simulated link
+static const UInt packetPipelineDepths[] = {2, 4, 16, 64};
+static const UInt numberOfDepths = arrayDimension(packetPipelineDepths);
+static const UInt roundTripTimesInMicroseconds[] = {0, 2000, 8000, 32000};
+static const UInt numberOfRoundTripTimes = arrayDimension(roundTripTimesInMicroseconds);
+
+// the simulated link runs at about the rate of a full speed USB port
+static const UInt lineRateInBytesPerSecond = 1000000;
+static const UInt bytesPerMeasurement = 256 * 1024;
+static const UInt chunkSize = 4096;
+
+//------------------------------------------------------------------------------------------------
+// * class WindowWriterTask
+//------------------------------------------------------------------------------------------------
+
+class WindowWriterTask : public Task
+{
+public:
+	// constructor
+	WindowWriterTask(Stream &stream);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+};
+
+WindowWriterTask::WindowWriterTask(Stream &stream) :
+	Task(defaultPriority, 10000),
+	stream(stream)
+{
+}
+
+void WindowWriterTask::main()
+{
+	static UInt8 chunk[chunkSize];
+	for(UInt offset = 0; offset < bytesPerMeasurement; offset += chunkSize)
+	{
+		stream.write(chunk, chunkSize);
+	}
+	stream.flush();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class WindowReaderTask
+//------------------------------------------------------------------------------------------------
+
+class WindowReaderTask : public Task
+{
+public:
+	// constructor
+	WindowReaderTask(Stream &stream, IntertaskEvent &completeEvent);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	IntertaskEvent &completeEvent;
+};
+
+WindowReaderTask::WindowReaderTask(Stream &stream, IntertaskEvent &completeEvent) :
+	Task(defaultPriority, 10000),
+	stream(stream),
+	completeEvent(completeEvent)
+{
+}
+
+void WindowReaderTask::main()
+{
+	static UInt8 chunk[chunkSize];
+	for(UInt offset = 0; offset < bytesPerMeasurement; offset += chunkSize)
+	{
+		stream.read(chunk, chunkSize);
+	}
+	completeEvent.signal();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class WindowBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class WindowBenchmarkTask : public Task
+{
+public:
+	// constructor
+	WindowBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	UInt measureThroughput(CheckPacketLayer &writingLayer, CheckPacketLayer &readingLayer, UInt channelId);
+	void report(UInt packetPipelineDepth, UInt roundTripTime, UInt bytesPerSecond);
+
+	// representation
+	IntertaskEvent completeEvent;
+};
+
+WindowBenchmarkTask::WindowBenchmarkTask() :
+	Task(defaultPriority + 1, 10000)
+{
+}
+
+UInt WindowBenchmarkTask::measureThroughput(
+	CheckPacketLayer &writingLayer,
+	CheckPacketLayer &readingLayer,
+	UInt channelId)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	// the reading channel must exist before the first data packet arrives
+	CheckReadChannel *pReadChannel = new CheckReadChannel(readingLayer, channelId);
+	CheckWriteChannel *pWriteChannel = new CheckWriteChannel(writingLayer, channelId);
+
+	// move the data from one end to the other
+	const TimeValue startTime = pTimer->getTime();
+	(new WindowReaderTask(*pReadChannel, completeEvent))->resume();
+	(new WindowWriterTask(*pWriteChannel))->resume();
+	completeEvent.wait();
+	const TimeValue elapsedTicks = compareTimes(pTimer->getTime(), startTime);
+
+	// let the last acknowledgments arrive before the channels are removed
+	sleepForTicks(pTimer->getFrequency() / 10, pTimer);
+	delete pWriteChannel;
+	delete pReadChannel;
+
+	return (UInt)((UInt64)bytesPerMeasurement * pTimer->getFrequency() / elapsedTicks);
+}
+
+void WindowBenchmarkTask::report(UInt packetPipelineDepth, UInt roundTripTime, UInt bytesPerSecond)
+{
+	#if defined(PRINT)
+		std::cout << "Depth " << packetPipelineDepth << ", round trip " << roundTripTime / 1000
+			<< "ms: " << bytesPerSecond / 1024 << "KB/s ("
+			<< (UInt)((UInt64)bytesPerSecond * 100 / lineRateInBytesPerSecond) << "% of line rate)\n";
+	#endif
+}
+
+void WindowBenchmarkTask::main()
+{
+	for(UInt depthNumber = 0; depthNumber < numberOfDepths; ++depthNumber)
+	{
+		// connect two packet layers over a simulated link, once both ends have agreed on the depth
+		SimulatedLink link(lineRateInBytesPerSecond);
+		link.connectCheckPacketLayers(packetPipelineDepths[depthNumber]);
+
+		// measure the throughput for every round trip time, on a new channel each time
+		for(UInt timeNumber = 0; timeNumber < numberOfRoundTripTimes; ++timeNumber)
+		{
+			const UInt roundTripTime = roundTripTimesInMicroseconds[timeNumber];
+			link.setRoundTripTime(roundTripTime);
+			report(
+				link.getCheckPacketLayerA().getPacketPipelineDepth(),
+				roundTripTime,
+				measureThroughput(link.getCheckPacketLayerA(), link.getCheckPacketLayerB(), timeNumber));
+		}
+	}
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * windowBenchmark
+//------------------------------------------------------------------------------------------------
+
+void windowBenchmark()
+{
+	(new WindowBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
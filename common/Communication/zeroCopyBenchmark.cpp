@@ -0,0 +1,308 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Timer.h"
+#include "../multitasking/IntertaskEvent.h"
+#include "../multitasking/sleep.h"
+#include "Stream.h"
+#include "SimulatedLink.h"
+#include "CheckReadChannel.h"
+#include "CheckWriteChannel.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the simulated link is fast enough for the channels to be the bottleneck
+static const UInt lineRateInBytesPerSecond = 400000000;
+static const UInt packetPipelineDepth = 16;
+static const UInt bytesPerMeasurement = 8 * 1024 * 1024;
+static const UInt chunkSize = 4096;
+
+// the data written is a function of its position, so that the reader can check it
+static inline UInt8 getDataByte(UInt position)
+{
+	return (UInt8)(position * 7 + (position >> 9));
+}
+
+//------------------------------------------------------------------------------------------------
+// * class ProducerTask
+//------------------------------------------------------------------------------------------------
+
+class ProducerTask : public Task
+{
+public:
+	// constructor
+	ProducerTask(Stream &stream, Bool zeroCopy);
+
+	// accessing
+	inline UInt getNumberOfBytesCopied() const;
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	Bool zeroCopy;
+	UInt numberOfBytesCopied;
+};
+
+ProducerTask::ProducerTask(Stream &stream, Bool zeroCopy) :
+	Task(defaultPriority, 10000),
+	stream(stream)
+{
+	this->zeroCopy = zeroCopy;
+	numberOfBytesCopied = 0;
+}
+
+inline UInt ProducerTask::getNumberOfBytesCopied() const
+{
+	return numberOfBytesCopied;
+}
+
+void ProducerTask::main()
+{
+	static UInt8 chunk[chunkSize];
+	UInt position = 0;
+	while(position < bytesPerMeasurement)
+	{
+		if(zeroCopy)
+		{
+			// produce the data in the packet
+			UInt length = 1;
+			UInt8 *pData = (UInt8 *)stream.reserve(&length);
+			if(pData == null)
+			{
+				return;
+			}
+			length = minimum(length, bytesPerMeasurement - position);
+			for(UInt i = 0; i < length; ++i)
+			{
+				pData[i] = getDataByte(position + i);
+			}
+			stream.commit(length);
+			position += length;
+		}
+		else
+		{
+			// produce the data in a buffer, as a flash read would, and write it
+			for(UInt i = 0; i < chunkSize; ++i)
+			{
+				chunk[i] = getDataByte(position + i);
+			}
+			if(stream.write(chunk, chunkSize) != chunkSize)
+			{
+				return;
+			}
+			numberOfBytesCopied += chunkSize;
+			position += chunkSize;
+		}
+	}
+	stream.flush();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ConsumerTask
+//------------------------------------------------------------------------------------------------
+
+class ConsumerTask : public Task
+{
+public:
+	// constructor
+	ConsumerTask(Stream &stream, Bool zeroCopy, IntertaskEvent &completeEvent);
+
+	// accessing
+	inline UInt getNumberOfBytesCopied() const;
+	inline Bool isDataCorrect() const;
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	Stream &stream;
+	Bool zeroCopy;
+	IntertaskEvent &completeEvent;
+	UInt numberOfBytesCopied;
+	Bool dataCorrect;
+};
+
+ConsumerTask::ConsumerTask(Stream &stream, Bool zeroCopy, IntertaskEvent &completeEvent) :
+	Task(defaultPriority, 10000),
+	stream(stream),
+	completeEvent(completeEvent)
+{
+	this->zeroCopy = zeroCopy;
+	numberOfBytesCopied = 0;
+	dataCorrect = true;
+}
+
+inline UInt ConsumerTask::getNumberOfBytesCopied() const
+{
+	return numberOfBytesCopied;
+}
+
+inline Bool ConsumerTask::isDataCorrect() const
+{
+	return dataCorrect;
+}
+
+void ConsumerTask::main()
+{
+	static UInt8 chunk[chunkSize];
+	UInt position = 0;
+	while(position < bytesPerMeasurement)
+	{
+		// get the data in the packet, or a copy of it
+		const UInt8 *pData;
+		UInt length;
+		if(zeroCopy)
+		{
+			pData = (const UInt8 *)stream.borrow(&length);
+		}
+		else
+		{
+			length = stream.read(chunk, chunkSize);
+			numberOfBytesCopied += length;
+			pData = length == chunkSize ? chunk : null;
+		}
+		if(pData == null)
+		{
+			dataCorrect = false;
+			break;
+		}
+
+		// check the data
+		for(UInt i = 0; i < length; ++i)
+		{
+			if(pData[i] != getDataByte(position + i))
+			{
+				dataCorrect = false;
+			}
+		}
+		if(zeroCopy)
+		{
+			stream.release(length);
+		}
+		position += length;
+	}
+	completeEvent.signal();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ZeroCopyBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class ZeroCopyBenchmarkTask : public Task
+{
+public:
+	// constructor
+	ZeroCopyBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	void measureCopies(CheckPacketLayer &writingLayer, CheckPacketLayer &readingLayer, UInt channelId, Bool zeroCopy);
+
+	// representation
+	IntertaskEvent completeEvent;
+	UInt numberOfFailures;
+};
+
+ZeroCopyBenchmarkTask::ZeroCopyBenchmarkTask() :
+	Task(defaultPriority + 1, 10000)
+{
+	numberOfFailures = 0;
+}
+
+void ZeroCopyBenchmarkTask::measureCopies(
+	CheckPacketLayer &writingLayer,
+	CheckPacketLayer &readingLayer,
+	UInt channelId,
+	Bool zeroCopy)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	// the reading channel must exist before the first data packet arrives
+	CheckReadChannel *pReadChannel = new CheckReadChannel(readingLayer, channelId);
+	CheckWriteChannel *pWriteChannel = new CheckWriteChannel(writingLayer, channelId);
+
+	// move the data from one end to the other
+	ConsumerTask *pConsumerTask = new ConsumerTask(*pReadChannel, zeroCopy, completeEvent);
+	ProducerTask *pProducerTask = new ProducerTask(*pWriteChannel, zeroCopy);
+	const UInt startCrcWalks = CheckPacket::getNumberOfDataCrcWalks();
+	const TimeValue startTime = pTimer->getTime();
+	pConsumerTask->resume();
+	pProducerTask->resume();
+	completeEvent.wait();
+	const TimeValue elapsedTicks = compareTimes(pTimer->getTime(), startTime);
+
+	// the CRC of every packet is calculated while it is filled or read, even the last partial
+	// packet, so neither end should walk the data of a packet again
+	const UInt numberOfPackets = (bytesPerMeasurement + CheckPacket::maximumPacketDataSize - 1)
+		/ CheckPacket::maximumPacketDataSize;
+	const UInt numberOfCrcWalks = CheckPacket::getNumberOfDataCrcWalks() - startCrcWalks;
+	const Bool crcCarried = numberOfCrcWalks == 0;
+	if(!crcCarried || !pConsumerTask->isDataCorrect())
+	{
+		++numberOfFailures;
+	}
+
+	// let the last acknowledgments arrive before the channels are removed
+	sleepForTicks(pTimer->getFrequency() / 10, pTimer);
+	delete pWriteChannel;
+	delete pReadChannel;
+
+	#if defined(PRINT)
+		const UInt megabytes = bytesPerMeasurement / (1024 * 1024);
+		std::cout << (zeroCopy ? "Reserve/commit and borrow/release: " : "Write and read: ")
+			<< (UInt)((UInt64)bytesPerMeasurement * pTimer->getFrequency() / elapsedTicks / 1024) << "KB/s, "
+			<< (pProducerTask->getNumberOfBytesCopied() + pConsumerTask->getNumberOfBytesCopied()) / megabytes / 1024
+			<< "KB copied by the channels per MB, "
+			<< numberOfCrcWalks << " CRC walks for " << numberOfPackets << " packets"
+			<< (crcCarried ? "" : ", CRC WALKED AGAIN")
+			<< (pConsumerTask->isDataCorrect() ? "" : ", DATA CORRUPTED") << "\n";
+	#endif
+}
+
+void ZeroCopyBenchmarkTask::main()
+{
+	// connect two packet layers over a simulated link
+	SimulatedLink link(lineRateInBytesPerSecond);
+	link.connectCheckPacketLayers(packetPipelineDepth);
+
+	// compare copying the data through the channels with producing and consuming it in place
+	measureCopies(link.getCheckPacketLayerA(), link.getCheckPacketLayerB(), 0, false);
+	measureCopies(link.getCheckPacketLayerA(), link.getCheckPacketLayerB(), 1, true);
+
+	#if defined(PRINT)
+		exit(numberOfFailures == 0 ? 0 : 1);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * zeroCopyBenchmark
+//------------------------------------------------------------------------------------------------
+
+void zeroCopyBenchmark()
+{
+	(new ZeroCopyBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
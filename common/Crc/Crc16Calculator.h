@@ -3,8 +3,14 @@
 
 #include "../cPrimitiveTypes.h"
 #include "CrcCalculator.h"
+#include "SlicingCrcCalculator.h"
 
 typedef CrcCalculator<UInt16, 0x1021, maximumOfIntegerType(UInt16), 4> Crc16Calculator;
 extern Crc16Calculator crc16Calculator;
 
+// the same CRC with larger constant tables, for code that checks a lot of data
+typedef SlicingCrcCalculator<UInt16, 0x1021, maximumOfIntegerType(UInt16), 4> SlicingCrc16Calculator;
+extern SlicingCrc16Calculator slicingCrc16Calculator;
+DECLARE_CRC_TABLES(UInt16, 0x1021, false);
+
 #endif // _Crc16Calculator_h_
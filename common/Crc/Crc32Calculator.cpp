@@ -1,3 +1,5 @@
 #include "Crc32Calculator.h"
 
 Crc32Calculator crc32Calculator;
+SlicingCrc32Calculator slicingCrc32Calculator;
+DEFINE_CRC_TABLES(UInt32, 0x04C11DB7, false);
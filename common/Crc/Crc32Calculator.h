@@ -3,8 +3,14 @@
 
 #include "../cPrimitiveTypes.h"
 #include "CrcCalculator.h"
+#include "SlicingCrcCalculator.h"
 
 typedef CrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32), 8> Crc32Calculator;
 extern Crc32Calculator crc32Calculator;
 
+// the same CRC with larger constant tables, for code that checks a lot of data
+typedef SlicingCrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32), 4> SlicingCrc32Calculator;
+extern SlicingCrc32Calculator slicingCrc32Calculator;
+DECLARE_CRC_TABLES(UInt32, 0x04C11DB7, false);
+
 #endif // _Crc32Calculator_h_
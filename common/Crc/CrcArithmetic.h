@@ -0,0 +1,149 @@
+#ifndef _CrcArithmetic_h_
+#define _CrcArithmetic_h_
+
+#include "../cPrimitiveTypes.h"
+
+//------------------------------------------------------------------------------------------------
+// * class CrcArithmetic
+//
+// Polynomial arithmetic modulo the CRC <polynomial>, which is given in normal (most significant
+// bit first) form. If <reflected> is true, CRC values are taken and returned in reflected (least
+// significant bit first) form, as a reflected CRC calculator produces them.
+// This is used to combine the CRC values of buffers without walking the data again.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Bool reflected>
+class CrcArithmetic
+{
+public:
+	// bit order
+	static Value reflect(Value value);
+
+	// combining
+	static Value combineCrc(Value crc1, Value crc2, UInt length2, Value initialValue);
+
+private:
+	// arithmetic
+	static inline Value multiplyByX(Value value);
+	static Value multiply(Value value1, Value value2);
+	static Value shiftByZeroBytes(Value value, UInt length);
+};
+
+//------------------------------------------------------------------------------------------------
+// * CrcArithmetic::reflect
+//
+// Returns <value> with the order of its bits reversed.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Bool reflected>
+Value CrcArithmetic<Value, polynomial, reflected>::reflect(Value value)
+{
+	Value reflectedValue = 0;
+	for(UInt i = 0; i < 8 * sizeof(Value); ++i)
+	{
+		reflectedValue = (Value)((reflectedValue << 1) | (value & 1));
+		value >>= 1;
+	}
+	return reflectedValue;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CrcArithmetic::combineCrc
+//
+// Returns the CRC value of two concatenated buffers, given the CRC value <crc1> of the first
+// buffer, the CRC value <crc2> of the second buffer and the <length2> of the second buffer.
+// Both CRC values must have been calculated starting from <initialValue>.
+// Only the length of the second buffer is needed, the time taken grows with its logarithm.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Bool reflected>
+Value CrcArithmetic<Value, polynomial, reflected>::combineCrc(
+	Value crc1, Value crc2, UInt length2, Value initialValue)
+{
+	// the CRC is linear, so the second CRC only misses the first CRC shifted through the second
+	// buffer, minus what the initial value contributed while being shifted through it
+	Value shiftedValue = (Value)(crc1 ^ initialValue);
+
+	// the arithmetic works on polynomials in normal form
+	if(reflected)
+	{
+		shiftedValue = reflect(shiftedValue);
+	}
+	shiftedValue = shiftByZeroBytes(shiftedValue, length2);
+	if(reflected)
+	{
+		shiftedValue = reflect(shiftedValue);
+	}
+
+	return (Value)(shiftedValue ^ crc2);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CrcArithmetic::multiplyByX
+//
+// Returns <value> multiplied by x, modulo the polynomial.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Bool reflected>
+inline Value CrcArithmetic<Value, polynomial, reflected>::multiplyByX(Value value)
+{
+	if((value & ((Value)1 << (8 * sizeof(Value) - 1))) != 0)
+	{
+		return (Value)((value << 1) ^ polynomial);
+	}
+	return (Value)(value << 1);
+}
+
+//------------------------------------------------------------------------------------------------
+// * CrcArithmetic::multiply
+//
+// Returns <value1> multiplied by <value2>, modulo the polynomial.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Bool reflected>
+Value CrcArithmetic<Value, polynomial, reflected>::multiply(Value value1, Value value2)
+{
+	// add <value1> for every bit of <value2>, most significant bit first
+	Value product = 0;
+	for(SInt bit = 8 * sizeof(Value) - 1; bit >= 0; --bit)
+	{
+		product = multiplyByX(product);
+		if(((value2 >> bit) & 1) != 0)
+		{
+			product ^= value1;
+		}
+	}
+	return product;
+}
+
+//------------------------------------------------------------------------------------------------
+// * CrcArithmetic::shiftByZeroBytes
+//
+// Returns the CRC value that results from feeding <length> zero bytes to the CRC value <value>,
+// which is <value> multiplied by x to the power of 8 * <length>, modulo the polynomial.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Bool reflected>
+Value CrcArithmetic<Value, polynomial, reflected>::shiftByZeroBytes(Value value, UInt length)
+{
+	// start with x to the power of 8, the factor for one zero byte
+	Value factor = 1;
+	for(UInt i = 0; i < 8; ++i)
+	{
+		factor = multiplyByX(factor);
+	}
+
+	// multiply by the factor for every bit of the length, squaring it from bit to bit
+	while(length != 0)
+	{
+		if((length & 1) != 0)
+		{
+			value = multiply(value, factor);
+		}
+		factor = multiply(factor, factor);
+		length >>= 1;
+	}
+	return value;
+}
+
+#endif // _CrcArithmetic_h_
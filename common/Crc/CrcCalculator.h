@@ -2,6 +2,8 @@
 #define _CrcCalculator_h_
 
 #include "../cPrimitiveTypes.h"
+#include "CrcArithmetic.h"
+#include "CrcTable.h"
 
 #if defined(_MSC_VER) && (_MSC_VER >= 1400) // if Visual Studio 2005
 	#pragma warning(disable: 4333) // warning C4333: '>>' : right shift by too large amount, data loss
@@ -18,54 +20,28 @@
 // CrcCalculator<UInt16, 0x8021, maximumOfIntegerType(UInt16)>
 // CrcCalculator<UInt16, 0x8408, maximumOfIntegerType(UInt16)>
 // CrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32)>
+// The table is computed by the compiler and is constant, so the calculator needs no construction.
+// See SlicingCrcCalculator for a faster algorithm with larger tables.
 //------------------------------------------------------------------------------------------------
 
-template<class CrcValue, CrcValue polynomial, CrcValue initialValue, UInt log2TableSize = 4>
+template<class Value, Value polynomial, Value initialValue, UInt log2TableSize = 4>
 class CrcCalculator
 {
 public:
 	// types
-	typedef CrcValue CrcValue;
+	typedef Value CrcValue;
 
-	// constructor
-	CrcCalculator();
+	// geometry
+	enum
+	{
+		tableSize = (1 << log2TableSize) * sizeof(CrcValue)
+	};
 
 	// CRC calculation
 	CrcValue calculateCrc(const void *pData, UInt length, CrcValue crc = initialValue) const;
-
-private:
-	// representation
-	CrcValue crcTable[(1 << log2TableSize)];
+	CrcValue combineCrc(CrcValue crc1, CrcValue crc2, UInt length2) const;
 };
 
-//------------------------------------------------------------------------------------------------
-// * CrcCalculator::CrcCalculator
-//
-// Constructor.
-//------------------------------------------------------------------------------------------------
-
-template<class CrcValue, CrcValue polynomial, CrcValue initialValue, UInt log2TableSize>
-CrcCalculator<CrcValue, polynomial, initialValue, log2TableSize>::CrcCalculator()
-{
-	// initialize the table
-	for(UInt i = 0; i < arrayDimension(crcTable); ++i)
-	{
-		CrcValue tableEntry = i << (8 * sizeof(CrcValue) - log2TableSize);
-		for(UInt j = 0; j < log2TableSize; ++j)
-		{
-			if((tableEntry & (1 << (8 * sizeof(CrcValue) - 1))) != 0)
-			{
-				tableEntry = (tableEntry << 1) ^ polynomial;
-			}
-			else
-			{
-				tableEntry <<= 1;
-			}
-		}
-		crcTable[i] = tableEntry;
-	}
-}
-
 //------------------------------------------------------------------------------------------------
 // * CrcCalculator::calculateCrc
 //
@@ -75,10 +51,12 @@ CrcCalculator<CrcValue, polynomial, initialValue, log2TableSize>::CrcCalculator(
 // CRC calculated from a previous buffer as the <crc> argument of the next buffer.
 //------------------------------------------------------------------------------------------------
 
-template<class CrcValue, CrcValue polynomial, CrcValue initialValue, UInt log2TableSize>
-CrcValue CrcCalculator<CrcValue, polynomial, initialValue, log2TableSize>::calculateCrc(
+template<class Value, Value polynomial, Value initialValue, UInt log2TableSize>
+Value CrcCalculator<Value, polynomial, initialValue, log2TableSize>::calculateCrc(
 	const void *pData, UInt length, CrcValue crc) const
 {
+	const CrcValue *pCrcTable = CrcLeadingTable<Value, polynomial, (1 << log2TableSize)>::entries;
+
 	// iterate over the data one byte at a time
 	while((SInt)length-- > 0)
 	{
@@ -92,19 +70,19 @@ CrcValue CrcCalculator<CrcValue, polynomial, initialValue, log2TableSize>::calcu
 		// this constant condition will be resolved at compile time
 		if(log2TableSize == 8)
 		{
-			crc = crcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ byte] ^ crc << log2TableSize;
+			crc = pCrcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ byte] ^ crc << log2TableSize;
 		}
 		else if(log2TableSize == 4)
 		{
-			crc = crcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> log2TableSize)] ^ crc << log2TableSize;
-			crc = crcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte & ((1 << log2TableSize) - 1))] ^ crc << log2TableSize;
+			crc = pCrcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> log2TableSize)] ^ crc << log2TableSize;
+			crc = pCrcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte & ((1 << log2TableSize) - 1))] ^ crc << log2TableSize;
 		}
 		else if(log2TableSize == 2)
 		{
-			crc = crcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> (3 * log2TableSize))] ^ crc << log2TableSize;
-			crc = crcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> (2 * log2TableSize)) & ((1 << log2TableSize) - 1)] ^ crc << log2TableSize;
-			crc = crcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> (1 * log2TableSize)) & ((1 << log2TableSize) - 1)] ^ crc << log2TableSize;
-			crc = crcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ byte & ((1 << log2TableSize) - 1)] ^ crc << log2TableSize;
+			crc = pCrcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> (3 * log2TableSize))] ^ crc << log2TableSize;
+			crc = pCrcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> (2 * log2TableSize)) & ((1 << log2TableSize) - 1)] ^ crc << log2TableSize;
+			crc = pCrcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> (1 * log2TableSize)) & ((1 << log2TableSize) - 1)] ^ crc << log2TableSize;
+			crc = pCrcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ byte & ((1 << log2TableSize) - 1)] ^ crc << log2TableSize;
 		}
 		else
 		{
@@ -112,7 +90,7 @@ CrcValue CrcCalculator<CrcValue, polynomial, initialValue, log2TableSize>::calcu
 			SInt shift = 8 * sizeof(byte);
 			while((shift -= log2TableSize) >= 0)
 			{
-				crc = crcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> shift) & ((1 << log2TableSize) - 1)] ^ crc << log2TableSize;
+				crc = pCrcTable[(crc >> (8 * sizeof(CrcValue) - log2TableSize)) ^ (byte >> shift) & ((1 << log2TableSize) - 1)] ^ crc << log2TableSize;
 			}
 		}
 	}
@@ -120,4 +98,19 @@ CrcValue CrcCalculator<CrcValue, polynomial, initialValue, log2TableSize>::calcu
 	return crc;
 }
 
+//------------------------------------------------------------------------------------------------
+// * CrcCalculator::combineCrc
+//
+// Returns the CRC value of two concatenated buffers, given the CRC value <crc1> of the first
+// buffer, the CRC value <crc2> of the second buffer and the <length2> of the second buffer.
+// Both CRC values must have been calculated with the initial value.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Value initialValue, UInt log2TableSize>
+Value CrcCalculator<Value, polynomial, initialValue, log2TableSize>::combineCrc(
+	CrcValue crc1, CrcValue crc2, UInt length2) const
+{
+	return CrcArithmetic<Value, polynomial, false>::combineCrc(crc1, crc2, length2, initialValue);
+}
+
 #endif // _CrcCalculator_h_
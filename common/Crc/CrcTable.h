@@ -0,0 +1,232 @@
+#ifndef _CrcTable_h_
+#define _CrcTable_h_
+
+#include "../cPrimitiveTypes.h"
+
+//------------------------------------------------------------------------------------------------
+// * struct CrcReflection
+//
+// Computes the lowest <numberOfBits> bits of <value> in reverse order at compile time.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value value, UInt numberOfBits>
+struct CrcReflection
+{
+	static const Value reflectedValue = (Value)(((value & 1) << (numberOfBits - 1))
+		| CrcReflection<Value, (Value)(value >> 1), numberOfBits - 1>::reflectedValue);
+};
+
+template<class Value, Value value>
+struct CrcReflection<Value, value, 0>
+{
+	static const Value reflectedValue = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// * struct CrcBitShift
+//
+// Computes the CRC register that results from shifting <numberOfBits> zero bits into the CRC
+// register <value> at compile time, most significant bit first or, if <reflected> is true,
+// least significant bit first.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Bool reflected, Value value, UInt numberOfBits>
+struct CrcBitShift
+{
+	static const Value shiftedValue = CrcBitShift<
+		Value,
+		polynomial,
+		reflected,
+		reflected
+			? (Value)((value & 1) != 0
+				? (value >> 1) ^ CrcReflection<Value, polynomial, 8 * sizeof(Value)>::reflectedValue
+				: value >> 1)
+			: (Value)((value & ((Value)1 << (8 * sizeof(Value) - 1))) != 0
+				? (value << 1) ^ polynomial
+				: value << 1),
+		numberOfBits - 1>::shiftedValue;
+};
+
+template<class Value, Value polynomial, Bool reflected, Value value>
+struct CrcBitShift<Value, polynomial, reflected, value, 0>
+{
+	static const Value shiftedValue = value;
+};
+
+//------------------------------------------------------------------------------------------------
+// * struct CrcTableEntry
+//
+// Computes the entry at <index> of a CRC table at compile time: the CRC register that results
+// from the byte <index> followed by <numberOfFollowingBytes> zero bytes, starting from zero.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Bool reflected, UInt numberOfFollowingBytes, UInt index>
+struct CrcTableEntry
+{
+	// shift one more zero byte into the entry for one following byte less
+	static const Value value = (Value)((reflected
+			? CrcTableEntry<Value, polynomial, reflected, numberOfFollowingBytes - 1, index>::value >> 8
+			: CrcTableEntry<Value, polynomial, reflected, numberOfFollowingBytes - 1, index>::value << 8)
+		^ CrcTableEntry<
+			Value,
+			polynomial,
+			reflected,
+			0,
+			(reflected
+				? CrcTableEntry<Value, polynomial, reflected, numberOfFollowingBytes - 1, index>::value
+				: CrcTableEntry<Value, polynomial, reflected, numberOfFollowingBytes - 1, index>::value
+					>> (8 * sizeof(Value) - 8))
+			& 0xFF>::value);
+};
+
+template<class Value, Value polynomial, Bool reflected, UInt index>
+struct CrcTableEntry<Value, polynomial, reflected, 0, index>
+{
+	// shift the byte through the CRC register
+	static const Value value = CrcBitShift<
+		Value,
+		polynomial,
+		reflected,
+		(Value)(reflected ? index : index << (8 * sizeof(Value) - 8)),
+		8>::shiftedValue;
+};
+
+//------------------------------------------------------------------------------------------------
+// * struct CrcTable
+//
+// A table of the CRC registers that result from every byte followed by <numberOfFollowingBytes>
+// zero bytes, for the CRC <polynomial> in normal form, processed least significant bit first
+// if <reflected> is true.
+// The table is computed by the compiler and is constant, so that it takes no time at startup
+// and can be placed in ROM. Every combination of template arguments has one table, however
+// many calculators use it.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Bool reflected, UInt numberOfFollowingBytes>
+struct CrcTable
+{
+	// the entry at <index>, named the same in every specialization of the table
+	template<UInt index>
+	struct Entry : CrcTableEntry<Value, polynomial, reflected, numberOfFollowingBytes, index>
+	{
+	};
+
+	static const Value entries[256];
+};
+
+#define CRC_TABLE_ENTRIES_4(index) \
+	Entry<(index) + 0>::value, Entry<(index) + 1>::value, \
+	Entry<(index) + 2>::value, Entry<(index) + 3>::value
+#define CRC_TABLE_ENTRIES_16(index) \
+	CRC_TABLE_ENTRIES_4((index) + 0), CRC_TABLE_ENTRIES_4((index) + 4), \
+	CRC_TABLE_ENTRIES_4((index) + 8), CRC_TABLE_ENTRIES_4((index) + 12)
+#define CRC_TABLE_ENTRIES_64(index) \
+	CRC_TABLE_ENTRIES_16((index) + 0), CRC_TABLE_ENTRIES_16((index) + 16), \
+	CRC_TABLE_ENTRIES_16((index) + 32), CRC_TABLE_ENTRIES_16((index) + 48)
+#define CRC_TABLE_ENTRIES \
+	{ \
+		CRC_TABLE_ENTRIES_64(0), \
+		CRC_TABLE_ENTRIES_64(64), \
+		CRC_TABLE_ENTRIES_64(128), \
+		CRC_TABLE_ENTRIES_64(192) \
+	}
+
+template<class Value, Value polynomial, Bool reflected, UInt numberOfFollowingBytes>
+const Value CrcTable<Value, polynomial, reflected, numberOfFollowingBytes>::entries[256] =
+	CRC_TABLE_ENTRIES;
+
+//------------------------------------------------------------------------------------------------
+// * struct CrcLeadingTable
+//
+// The first <numberOfEntries> entries of the table for the CRC <polynomial> with no following
+// bytes, which are the table for processing log2(<numberOfEntries>) bits at a time, most
+// significant bit first. Like CrcTable, it is computed by the compiler and is constant.
+// The table of 256 entries is the CrcTable itself, so that it is shared with slicing calculators.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, UInt numberOfEntries>
+struct CrcLeadingTable;
+
+template<class Value, Value polynomial>
+struct CrcLeadingTable<Value, polynomial, 256> : CrcTable<Value, polynomial, false, 0>
+{
+};
+
+template<class Value, Value polynomial>
+struct CrcLeadingTable<Value, polynomial, 16>
+{
+	template<UInt index>
+	struct Entry : CrcTableEntry<Value, polynomial, false, 0, index>
+	{
+	};
+
+	static const Value entries[16];
+};
+
+template<class Value, Value polynomial>
+const Value CrcLeadingTable<Value, polynomial, 16>::entries[16] = {CRC_TABLE_ENTRIES_16(0)};
+
+template<class Value, Value polynomial>
+struct CrcLeadingTable<Value, polynomial, 4>
+{
+	template<UInt index>
+	struct Entry : CrcTableEntry<Value, polynomial, false, 0, index>
+	{
+	};
+
+	static const Value entries[4];
+};
+
+template<class Value, Value polynomial>
+const Value CrcLeadingTable<Value, polynomial, 4>::entries[4] = {CRC_TABLE_ENTRIES_4(0)};
+
+template<class Value, Value polynomial>
+struct CrcLeadingTable<Value, polynomial, 2>
+{
+	template<UInt index>
+	struct Entry : CrcTableEntry<Value, polynomial, false, 0, index>
+	{
+	};
+
+	static const Value entries[2];
+};
+
+template<class Value, Value polynomial>
+const Value CrcLeadingTable<Value, polynomial, 2>::entries[2] = {Entry<0>::value, Entry<1>::value};
+
+//------------------------------------------------------------------------------------------------
+// * DECLARE_CRC_TABLES, DEFINE_CRC_TABLES
+//
+// The tables of a template are instantiated in every object file that uses them, and a linker
+// scatter file cannot tell them apart from the rest of the read only data of that object.
+// DECLARE_CRC_TABLES declares the tables of a CRC for slicing by up to four bytes as explicit
+// specializations instead, so that DEFINE_CRC_TABLES can define them once, in one object file,
+// in the CrcTables section. Images that copy their read only data to RAM, such as the boot
+// block, list that section in a region that stays in flash memory.
+// The declaration must be seen by every use of the tables, so it goes in the header of the
+// calculator and the definition in its source file.
+//------------------------------------------------------------------------------------------------
+
+#if defined(__ARMCC_VERSION) || defined(__GNUC__)
+	#define CRC_TABLE_SECTION __attribute__((section("CrcTables")))
+#else
+	#define CRC_TABLE_SECTION
+#endif
+
+#define DECLARE_CRC_TABLES(Value, polynomial, reflected) \
+	template<> const Value CrcTable<Value, polynomial, reflected, 0>::entries[256]; \
+	template<> const Value CrcTable<Value, polynomial, reflected, 1>::entries[256]; \
+	template<> const Value CrcTable<Value, polynomial, reflected, 2>::entries[256]; \
+	template<> const Value CrcTable<Value, polynomial, reflected, 3>::entries[256]
+
+#define DEFINE_CRC_TABLES(Value, polynomial, reflected) \
+	template<> const Value CrcTable<Value, polynomial, reflected, 0>::entries[256] CRC_TABLE_SECTION = \
+		CRC_TABLE_ENTRIES; \
+	template<> const Value CrcTable<Value, polynomial, reflected, 1>::entries[256] CRC_TABLE_SECTION = \
+		CRC_TABLE_ENTRIES; \
+	template<> const Value CrcTable<Value, polynomial, reflected, 2>::entries[256] CRC_TABLE_SECTION = \
+		CRC_TABLE_ENTRIES; \
+	template<> const Value CrcTable<Value, polynomial, reflected, 3>::entries[256] CRC_TABLE_SECTION = \
+		CRC_TABLE_ENTRIES
+
+#endif // _CrcTable_h_
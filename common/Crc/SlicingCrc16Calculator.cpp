@@ -0,0 +1,6 @@
+#include "Crc16Calculator.h"
+
+// kept apart from crc16Calculator, whose table is its own, so that images which only use that
+// leave these tables out
+SlicingCrc16Calculator slicingCrc16Calculator;
+DEFINE_CRC_TABLES(UInt16, 0x1021, false);
@@ -0,0 +1,229 @@
+#ifndef _SlicingCrcCalculator_h_
+#define _SlicingCrcCalculator_h_
+
+#include "../cPrimitiveTypes.h"
+#include "CrcArithmetic.h"
+#include "CrcTable.h"
+
+//------------------------------------------------------------------------------------------------
+// * class SlicingCrcCalculator
+//
+// This class implements a Cyclic Redundancy Code algorithm that processes <numberOfSlices>
+// bytes per step ("slicing by N"), using one table of 256 entries per byte of a step.
+// The <numberOfSlices> template argument must be one of 1, 2, 4, 8: 4 or 8 are fastest, 1 is
+// the classic byte-wise algorithm. The tables take numberOfSlices * 256 CRC values, they are
+// computed by the compiler and are constant, so the calculator needs no construction and can
+// be used before static construction.
+// The <polynomial> is always given in normal (most significant bit first) form. If <reflected>
+// is true, the data bits are processed least significant bit first and CRC values are in
+// reflected form, as in Ethernet, zip and PNG. The values calculated are the CRC register, any
+// final exclusive or must be applied by the caller.
+// SlicingCrcCalculator<UInt16, 0x1021, maximumOfIntegerType(UInt16), 1> calculates the same
+// CRC values as CrcCalculator<UInt16, 0x1021, maximumOfIntegerType(UInt16)>.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Value initialValue, UInt numberOfSlices = 4,
+	Bool reflected = false>
+class SlicingCrcCalculator
+{
+public:
+	// types
+	typedef Value CrcValue;
+
+	// geometry
+	enum
+	{
+		tableSize = numberOfSlices * 256 * sizeof(CrcValue)
+	};
+
+	// CRC calculation
+	CrcValue calculateCrc(const void *pData, UInt length, CrcValue crc = initialValue) const;
+	CrcValue copyAndCalculateCrc(void *pDestination, const void *pSource, UInt length,
+		CrcValue crc = initialValue) const;
+	CrcValue combineCrc(CrcValue crc1, CrcValue crc2, UInt length2) const;
+
+private:
+	// geometry
+	enum
+	{
+		widthInBits = 8 * sizeof(CrcValue),
+		remainderShift = numberOfSlices < sizeof(CrcValue) ? 8 * numberOfSlices : 0
+	};
+
+	// CRC calculation
+	template<Bool copying>
+	static CrcValue processData(UInt8 *pDestination, const UInt8 *pSource, UInt length, CrcValue crc);
+	template<UInt slice>
+	static inline CrcValue lookUpSlice(const UInt8 *pBytes, CrcValue crc);
+	static inline CrcValue updateCrc(CrcValue crc, UInt8 byte);
+};
+
+//------------------------------------------------------------------------------------------------
+// * SlicingCrcCalculator::calculateCrc
+//
+// Calculates a CRC value given some data.
+// The <crc> arguments is the initial value if a new CRC calculation is intended.
+// The CRC calculation of a sequence of data items can be chained together by specifying the
+// CRC calculated from a previous buffer as the <crc> argument of the next buffer.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Value initialValue, UInt numberOfSlices, Bool reflected>
+Value SlicingCrcCalculator<Value, polynomial, initialValue, numberOfSlices, reflected>::calculateCrc(
+	const void *pData, UInt length, CrcValue crc) const
+{
+	return processData<false>(null, (const UInt8 *)pData, length, crc);
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlicingCrcCalculator::copyAndCalculateCrc
+//
+// Copies <length> bytes from <pSource> to <pDestination> and calculates their CRC value in the
+// same pass, so that every byte is read only once. The buffers must not overlap.
+// The <crc> argument is used as in calculateCrc.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Value initialValue, UInt numberOfSlices, Bool reflected>
+Value SlicingCrcCalculator<Value, polynomial, initialValue, numberOfSlices, reflected>::copyAndCalculateCrc(
+	void *pDestination, const void *pSource, UInt length, CrcValue crc) const
+{
+	return processData<true>((UInt8 *)pDestination, (const UInt8 *)pSource, length, crc);
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlicingCrcCalculator::combineCrc
+//
+// Returns the CRC value of two concatenated buffers, given the CRC value <crc1> of the first
+// buffer, the CRC value <crc2> of the second buffer and the <length2> of the second buffer.
+// Both CRC values must have been calculated with the initial value.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Value initialValue, UInt numberOfSlices, Bool reflected>
+Value SlicingCrcCalculator<Value, polynomial, initialValue, numberOfSlices, reflected>::combineCrc(
+	CrcValue crc1, CrcValue crc2, UInt length2) const
+{
+	return CrcArithmetic<Value, polynomial, reflected>::combineCrc(crc1, crc2, length2, initialValue);
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlicingCrcCalculator::processData
+//
+// Returns <crc> updated with <length> bytes at <pSource>, which are also copied to
+// <pDestination> if <copying> is true.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Value initialValue, UInt numberOfSlices, Bool reflected>
+template<Bool copying>
+Value SlicingCrcCalculator<Value, polynomial, initialValue, numberOfSlices, reflected>::processData(
+	UInt8 *pDestination, const UInt8 *pSource, UInt length, CrcValue crc)
+{
+	// iterate over the data <numberOfSlices> bytes at a time
+	// the constant conditions and loops below will be resolved at compile time
+	while(length >= numberOfSlices)
+	{
+		// read the bytes of the step once, before any of them is written
+		UInt8 bytes[numberOfSlices];
+		for(UInt slice = 0; slice < numberOfSlices; ++slice)
+		{
+			bytes[slice] = pSource[slice];
+		}
+
+		// keep the part of the CRC that is not shifted out by this step
+		CrcValue nextCrc = 0;
+		if(remainderShift != 0)
+		{
+			nextCrc = (CrcValue)(reflected ? crc >> remainderShift : crc << remainderShift);
+		}
+
+		// look up every byte of the step, unrolled for up to 8 slices
+		nextCrc ^= lookUpSlice<0>(bytes, crc);
+		if(numberOfSlices > 1)
+		{
+			nextCrc ^= lookUpSlice<1>(bytes, crc);
+		}
+		if(numberOfSlices > 2)
+		{
+			nextCrc ^= lookUpSlice<2>(bytes, crc) ^ lookUpSlice<3>(bytes, crc);
+		}
+		if(numberOfSlices > 4)
+		{
+			nextCrc ^= lookUpSlice<4>(bytes, crc) ^ lookUpSlice<5>(bytes, crc)
+				^ lookUpSlice<6>(bytes, crc) ^ lookUpSlice<7>(bytes, crc);
+		}
+		crc = nextCrc;
+
+		// copy the step
+		if(copying)
+		{
+			for(UInt slice = 0; slice < numberOfSlices; ++slice)
+			{
+				pDestination[slice] = bytes[slice];
+			}
+			pDestination += numberOfSlices;
+		}
+
+		pSource += numberOfSlices;
+		length -= numberOfSlices;
+	}
+
+	// process the rest one byte at a time
+	while(length > 0)
+	{
+		const UInt8 byte = *(pSource++);
+		crc = updateCrc(crc, byte);
+		if(copying)
+		{
+			*(pDestination++) = byte;
+		}
+		--length;
+	}
+
+	return crc;
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlicingCrcCalculator::lookUpSlice
+//
+// Returns the table entry for the byte at <slice> of the step in <pBytes>. The leading bytes of
+// a step are combined with the bytes of <crc> they line up with.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Value initialValue, UInt numberOfSlices, Bool reflected>
+template<UInt slice>
+inline Value SlicingCrcCalculator<Value, polynomial, initialValue, numberOfSlices, reflected>::lookUpSlice(
+	const UInt8 *pBytes, CrcValue crc)
+{
+	// the byte is followed by the rest of the step, slices beyond the step are never reached
+	enum
+	{
+		numberOfFollowingBytes = slice < numberOfSlices ? numberOfSlices - 1 - slice : 0
+	};
+
+	UInt index = pBytes[slice];
+	if(slice < sizeof(CrcValue))
+	{
+		index ^= reflected
+			? (crc >> (8 * slice)) & 0xFF
+			: (crc >> (widthInBits - 8 - 8 * slice)) & 0xFF;
+	}
+	return CrcTable<Value, polynomial, reflected, numberOfFollowingBytes>::entries[index];
+}
+
+//------------------------------------------------------------------------------------------------
+// * SlicingCrcCalculator::updateCrc
+//
+// Returns <crc> updated with one <byte> of data, using the table for a single byte.
+//------------------------------------------------------------------------------------------------
+
+template<class Value, Value polynomial, Value initialValue, UInt numberOfSlices, Bool reflected>
+inline Value SlicingCrcCalculator<Value, polynomial, initialValue, numberOfSlices, reflected>::updateCrc(
+	CrcValue crc, UInt8 byte)
+{
+	const CrcValue *pTable = CrcTable<Value, polynomial, reflected, 0>::entries;
+	if(reflected)
+	{
+		return (CrcValue)(pTable[(crc ^ byte) & 0xFF] ^ (crc >> 8));
+	}
+	return (CrcValue)(pTable[((crc >> (widthInBits - 8)) ^ byte) & 0xFF] ^ (crc << 8));
+}
+
+#endif // _SlicingCrcCalculator_h_
@@ -0,0 +1,356 @@
+#include "../multitasking/Task.h"
+#include "../multitasking/Timer.h"
+#include "Crc16Calculator.h"
+#include "Crc32Calculator.h"
+#include "../Communication/CheckPacket.h"
+#include "../memoryUtilities.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// buffer sizes of a boot command, a check packet and a firmware image chunk
+static const UInt sizes[] = {16, 1016, 65536};
+static const UInt numberOfSizes = arrayDimension(sizes);
+static const UInt maximumSize = 65536;
+static const UInt bytesPerMeasurement = 1024 * 1024;
+
+// the data to calculate CRC values of
+static UInt32 dataBuffer[maximumSize / sizeof(UInt32)];
+
+// the calculators, one per table strategy
+typedef CrcCalculator<UInt16, 0x1021, maximumOfIntegerType(UInt16), 4> Crc16NibbleCalculator;
+typedef CrcCalculator<UInt16, 0x1021, maximumOfIntegerType(UInt16), 8> Crc16ByteCalculator;
+typedef SlicingCrcCalculator<UInt16, 0x1021, maximumOfIntegerType(UInt16), 1> Crc16Slicing1Calculator;
+typedef SlicingCrcCalculator<UInt16, 0x1021, maximumOfIntegerType(UInt16), 4> Crc16Slicing4Calculator;
+typedef SlicingCrcCalculator<UInt16, 0x1021, maximumOfIntegerType(UInt16), 8> Crc16Slicing8Calculator;
+typedef CrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32), 4> Crc32NibbleCalculator;
+typedef CrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32), 8> Crc32ByteCalculator;
+typedef SlicingCrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32), 1> Crc32Slicing1Calculator;
+typedef SlicingCrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32), 4> Crc32Slicing4Calculator;
+typedef SlicingCrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32), 8> Crc32Slicing8Calculator;
+typedef SlicingCrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32), 1, true> Crc32ReflectedSlicing1Calculator;
+typedef SlicingCrcCalculator<UInt32, 0x04C11DB7, maximumOfIntegerType(UInt32), 8, true> Crc32ReflectedSlicing8Calculator;
+Crc16NibbleCalculator crc16NibbleCalculator;
+Crc16ByteCalculator crc16ByteCalculator;
+Crc16Slicing1Calculator crc16Slicing1Calculator;
+Crc16Slicing4Calculator crc16Slicing4Calculator;
+Crc16Slicing8Calculator crc16Slicing8Calculator;
+Crc32NibbleCalculator crc32NibbleCalculator;
+Crc32ByteCalculator crc32ByteCalculator;
+Crc32Slicing1Calculator crc32Slicing1Calculator;
+Crc32Slicing4Calculator crc32Slicing4Calculator;
+Crc32Slicing8Calculator crc32Slicing8Calculator;
+Crc32ReflectedSlicing1Calculator crc32ReflectedSlicing1Calculator;
+Crc32ReflectedSlicing8Calculator crc32ReflectedSlicing8Calculator;
+
+//------------------------------------------------------------------------------------------------
+// * calculator adapters
+//------------------------------------------------------------------------------------------------
+
+template<class Calculator, Calculator &calculator>
+static UInt32 calculateCrc(const void *pData, UInt length)
+{
+	return calculator.calculateCrc(pData, length);
+}
+
+template<class Calculator, Calculator &calculator>
+static UInt32 combineCrc(UInt32 crc1, UInt32 crc2, UInt length2)
+{
+	return calculator.combineCrc(
+		(typename Calculator::CrcValue)crc1,
+		(typename Calculator::CrcValue)crc2,
+		length2);
+}
+
+// a table strategy, with the CRC of "123456789" (before any final exclusive or)
+struct CrcStrategy
+{
+	const char *pName;
+	UInt tableSize;
+	UInt32 checkValue;
+	UInt32 (*calculateCrc)(const void *pData, UInt length);
+	UInt32 (*combineCrc)(UInt32 crc1, UInt32 crc2, UInt length2);
+};
+
+#define CRC_STRATEGY(name, Calculator, calculator, checkValue) \
+	{name, Calculator::tableSize, checkValue, calculateCrc<Calculator, calculator>, combineCrc<Calculator, calculator>}
+
+static const CrcStrategy strategies[] =
+{
+	CRC_STRATEGY("CRC16 nibble table", Crc16NibbleCalculator, crc16NibbleCalculator, 0x29B1),
+	CRC_STRATEGY("CRC16 byte table", Crc16ByteCalculator, crc16ByteCalculator, 0x29B1),
+	CRC_STRATEGY("CRC16 slicing by 1", Crc16Slicing1Calculator, crc16Slicing1Calculator, 0x29B1),
+	CRC_STRATEGY("CRC16 slicing by 4", Crc16Slicing4Calculator, crc16Slicing4Calculator, 0x29B1),
+	CRC_STRATEGY("CRC16 slicing by 8", Crc16Slicing8Calculator, crc16Slicing8Calculator, 0x29B1),
+	CRC_STRATEGY("CRC32 nibble table", Crc32NibbleCalculator, crc32NibbleCalculator, 0x0376E6E7),
+	CRC_STRATEGY("CRC32 byte table", Crc32ByteCalculator, crc32ByteCalculator, 0x0376E6E7),
+	CRC_STRATEGY("CRC32 slicing by 1", Crc32Slicing1Calculator, crc32Slicing1Calculator, 0x0376E6E7),
+	CRC_STRATEGY("CRC32 slicing by 4", Crc32Slicing4Calculator, crc32Slicing4Calculator, 0x0376E6E7),
+	CRC_STRATEGY("CRC32 slicing by 8", Crc32Slicing8Calculator, crc32Slicing8Calculator, 0x0376E6E7),
+	CRC_STRATEGY("CRC32 reflected slicing by 1", Crc32ReflectedSlicing1Calculator,
+		crc32ReflectedSlicing1Calculator, 0x340BC6D9),
+	CRC_STRATEGY("CRC32 reflected slicing by 8", Crc32ReflectedSlicing8Calculator,
+		crc32ReflectedSlicing8Calculator, 0x340BC6D9)
+};
+static const UInt numberOfStrategies = arrayDimension(strategies);
+
+//------------------------------------------------------------------------------------------------
+// * class CrcBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class CrcBenchmarkTask : public Task
+{
+public:
+	// constructor
+	CrcBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// measuring
+	void fillBuffer();
+	Bool check(const CrcStrategy &strategy, const CrcStrategy &reference);
+	UInt measure(const CrcStrategy &strategy, UInt size);
+	UInt measurePacketFill(Bool fused);
+	Bool checkPartialPacket(UInt dataSize);
+
+	// representation
+	Timer *pTimer;
+	CheckPacket packet;
+	UInt numberOfMismatches;
+	volatile UInt32 crcResult;
+};
+
+CrcBenchmarkTask::CrcBenchmarkTask() :
+	Task(defaultPriority + 1, 10000)
+{
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	numberOfMismatches = 0;
+	crcResult = 0;
+}
+
+void CrcBenchmarkTask::fillBuffer()
+{
+	UInt seed = 1;
+	UInt8 *pData = (UInt8 *)dataBuffer;
+	for(UInt i = 0; i < sizeof(dataBuffer); ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		pData[i] = (UInt8)(seed >> 24);
+	}
+}
+
+Bool CrcBenchmarkTask::check(const CrcStrategy &strategy, const CrcStrategy &reference)
+{
+	// the check value of the CRC
+	if(strategy.calculateCrc("123456789", 9) != strategy.checkValue)
+	{
+		return false;
+	}
+
+	// every length and alignment gives the same CRC as the reference strategy
+	for(UInt offset = 0; offset < 8; ++offset)
+	{
+		for(UInt length = 0; length < 64; ++length)
+		{
+			const UInt8 *pData = (const UInt8 *)dataBuffer + offset;
+			if(strategy.calculateCrc(pData, length) != reference.calculateCrc(pData, length))
+			{
+				return false;
+			}
+		}
+	}
+
+	// combining the CRC values of two parts gives the CRC of the whole buffer
+	const UInt splits[] = {0, 1, 7, 1016, 4095, maximumSize - 1, maximumSize};
+	const UInt32 wholeCrc = strategy.calculateCrc(dataBuffer, maximumSize);
+	for(UInt i = 0; i < arrayDimension(splits); ++i)
+	{
+		const UInt8 *pData = (const UInt8 *)dataBuffer;
+		const UInt32 crc1 = strategy.calculateCrc(pData, splits[i]);
+		const UInt32 crc2 = strategy.calculateCrc(pData + splits[i], maximumSize - splits[i]);
+		if(strategy.combineCrc(crc1, crc2, maximumSize - splits[i]) != wholeCrc)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+UInt CrcBenchmarkTask::measure(const CrcStrategy &strategy, UInt size)
+{
+	const UInt count = maximum(bytesPerMeasurement / size, (UInt)16);
+	const TimeValue startTime = pTimer->getTime();
+	for(UInt i = 0; i < count; ++i)
+	{
+		crcResult = strategy.calculateCrc(dataBuffer, size);
+	}
+	TimeValue ticks = compareTimes(pTimer->getTime(), startTime);
+	if(ticks <= 0)
+	{
+		ticks = 1;
+	}
+	return (UInt)((UInt64)size * count * pTimer->getFrequency() / ((UInt64)ticks * 1000000));
+}
+
+UInt CrcBenchmarkTask::measurePacketFill(Bool fused)
+{
+	// fill and seal 1 MB worth of packets from the data buffer, in pieces of 256 bytes
+	const UInt packetSize = packet.getMaximumPacketDataSize();
+	const UInt pieceSize = 256;
+	const UInt count = bytesPerMeasurement / packetSize;
+	const TimeValue startTime = pTimer->getTime();
+	for(UInt i = 0; i < count; ++i)
+	{
+		for(UInt offset = 0; offset < packetSize; offset += pieceSize)
+		{
+			const UInt8 *pSource = (const UInt8 *)dataBuffer + i * 8 + offset;
+			if(fused)
+			{
+				packet.appendData(offset, pSource, minimum(pieceSize, packetSize - offset));
+			}
+			else
+			{
+				memoryCopy(
+					(UInt8 *)packet.getPacketData() + offset,
+					pSource,
+					minimum(pieceSize, packetSize - offset));
+			}
+		}
+		packet.setDataSize(packetSize);
+		packet.setCrcValue();
+	}
+	const TimeValue ticks = compareTimes(pTimer->getTime(), startTime);
+
+	// return microseconds per MB
+	return (UInt)((UInt64)ticks * 1000000 * 1024 * 1024
+		/ ((UInt64)pTimer->getFrequency() * count * packetSize));
+}
+
+Bool CrcBenchmarkTask::checkPartialPacket(UInt dataSize)
+{
+	// fill a packet with fewer bytes than the full packet its CRC was started for, and a packet
+	// whose CRC is walked from its data
+	CheckPacket copiedPacket;
+	memoryCopy(copiedPacket.getPacketData(), dataBuffer, dataSize);
+	copiedPacket.setDataSize(dataSize);
+	copiedPacket.setCrcValue();
+	packet.appendData(0, dataBuffer, dataSize);
+	packet.setDataSize(dataSize);
+
+	// the header is corrected for without walking the data
+	const UInt startCrcWalks = CheckPacket::getNumberOfDataCrcWalks();
+	packet.setCrcValue();
+	return packet.getCrcValue() == copiedPacket.getCrcValue()
+		&& CheckPacket::getNumberOfDataCrcWalks() == startCrcWalks;
+}
+
+void CrcBenchmarkTask::main()
+{
+	fillBuffer();
+
+	#if defined(PRINT)
+		std::cout << "MB/s per table strategy\n";
+		std::cout << "strategy\t\t\ttable";
+		for(UInt sizeIndex = 0; sizeIndex < numberOfSizes; ++sizeIndex)
+		{
+			std::cout << "\t" << sizes[sizeIndex];
+		}
+		std::cout << "\n";
+	#endif
+
+	for(UInt strategyIndex = 0; strategyIndex < numberOfStrategies; ++strategyIndex)
+	{
+		// compare with the first strategy that calculates the same CRC
+		const CrcStrategy &strategy = strategies[strategyIndex];
+		UInt referenceIndex = 0;
+		while(strategies[referenceIndex].checkValue != strategy.checkValue)
+		{
+			++referenceIndex;
+		}
+		if(!check(strategy, strategies[referenceIndex]))
+		{
+			++numberOfMismatches;
+			#if defined(PRINT)
+				std::cout << strategy.pName << " differs from " << strategies[referenceIndex].pName << "\n";
+			#endif
+		}
+
+		#if defined(PRINT)
+			std::cout << strategy.pName << (strategyIndex < numberOfStrategies - 2 ? "\t\t" : "\t")
+				<< strategy.tableSize;
+		#endif
+		for(UInt sizeIndex = 0; sizeIndex < numberOfSizes; ++sizeIndex)
+		{
+			const UInt rate = measure(strategy, sizes[sizeIndex]);
+			#if defined(PRINT)
+				std::cout << "\t" << rate;
+			#endif
+		}
+		#if defined(PRINT)
+			std::cout << "\n";
+		#endif
+	}
+
+	// time filling check packets, copying the data and calculating the CRC separately or fused
+	const UInt separateTime = measurePacketFill(false);
+	const UInt separateCrc = packet.getCrcValue();
+	const UInt startCrcWalks = CheckPacket::getNumberOfDataCrcWalks();
+	const UInt fusedTime = measurePacketFill(true);
+	if(CheckPacket::getNumberOfDataCrcWalks() != startCrcWalks)
+	{
+		++numberOfMismatches;
+		#if defined(PRINT)
+			std::cout << "fused packet CRC walked again\n";
+		#endif
+	}
+	if(packet.getCrcValue() != separateCrc || !packet.isCrcValid())
+	{
+		++numberOfMismatches;
+		#if defined(PRINT)
+			std::cout << "fused packet CRC differs\n";
+		#endif
+	}
+
+	const UInt partialSizes[] = {1, 255, 512, 1015};
+	for(UInt i = 0; i < arrayDimension(partialSizes); ++i)
+	{
+		if(!checkPartialPacket(partialSizes[i]))
+		{
+			++numberOfMismatches;
+			#if defined(PRINT)
+				std::cout << "partial packet CRC of " << partialSizes[i] << " bytes differs\n";
+			#endif
+		}
+	}
+
+	#if defined(PRINT)
+		std::cout << "check packet fill, us per MB: separate copy and CRC " << separateTime
+			<< ", fused " << fusedTime << "\n";
+		std::cout << numberOfMismatches << " mismatches\n";
+		exit(numberOfMismatches == 0 ? 0 : 1);
+	#endif
+}
+
+//------------------------------------------------------------------------------------------------
+// * crcBenchmark
+//------------------------------------------------------------------------------------------------
+
+void crcBenchmark()
+{
+	(new CrcBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
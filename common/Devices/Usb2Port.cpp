@@ -21,7 +21,8 @@ Usb2Port::Usb2Port() :
 	flagAInterruptPin(10),//19
 	flagBInterruptPin(23),//17
 	flagCInterruptPin(27),//18
-	intFlagInterruptPin(14)//24
+	intFlagInterruptPin(14),//24
+	intFlagWork(this)
 {
 	// disable the interrupts
 	Sa1110InterruptController::getCurrentInterruptController()->disable(11);
@@ -756,8 +757,9 @@ Bool Usb2Port::handleInterrupt()
 	// determine if this interrupt is for us
 	if(intFlagInterruptPin.isInterruptPending())
 	{
-		// INT interrupt
-		handleIntFlagInterrupt();
+		// INT interrupt, the controller won't interrupt again until its status has been read
+		intFlagInterruptPin.clearInterrupt();
+		intFlagWork.defer();
 		return true;
 	}
 
@@ -808,7 +810,8 @@ void Usb2Port::handleFlagBInterrupt()
 //------------------------------------------------------------------------------------------------
 // * Usb2Port::handleIntFlagInterrupt
 //
-// Interrupt handler.
+// Deferred interrupt handler.
+// Reads the controller's status and services it with interrupts enabled.
 //------------------------------------------------------------------------------------------------
 
 void Usb2Port::handleIntFlagInterrupt()
@@ -925,8 +928,6 @@ void Usb2Port::handleIntFlagInterrupt()
 				break;
 		};
 	}
-	
-	intFlagInterruptPin.clearInterrupt();
 }
 
 //------------------------------------------------------------------------------------------------
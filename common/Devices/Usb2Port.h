@@ -7,6 +7,7 @@
 #include "../multitasking/IntertaskEvent.h"
 #include "../multitasking/Mutex.h"
 #include "../multitasking/MemberTask.h"
+#include "../multitasking/MemberDeferredWork.h"
 #include "../Sa1110Devices/Sa1110GpioPin.h"
 
 #define	DSCR_DEVICE			1   /* Descriptor type: Device */
@@ -28,6 +29,8 @@
 // * class Usb2Port
 //
 // Provides an interface to a CY7C68001 USB II controller.
+// The controller's INT interrupts are handled by deferred work, the interrupt handler only clears
+// the edge.
 //------------------------------------------------------------------------------------------------
 
 class Usb2Port :
@@ -59,12 +62,14 @@ private:
 	void handleFlagAInterrupt();
 	void handleFlagBInterrupt();
 	void handleIntFlagInterrupt();
+	MemberDeferredWork(IntFlagWork, Usb2Port, handleIntFlagInterrupt);
 	
 	Sa1110GpioPin wakeUpPin;
 	Sa1110GpioPin flagAInterruptPin;
 	Sa1110GpioPin flagBInterruptPin;
 	Sa1110GpioPin flagCInterruptPin;
 	Sa1110GpioPin intFlagInterruptPin;
+	IntFlagWork intFlagWork;
 	
 	// device configuration
 	void configureRegisters();
@@ -102,7 +102,7 @@ UInt32 FirmwareLoaderTask::checkLoadFirmware()
 			
 			if ((startAddress + firmwareLength) < flashLimit)
 			{
-				if (firmwareCrc == crc32Calculator.calculateCrc((void *)runAddress, firmwareLength))
+				if (firmwareCrc == slicingCrc32Calculator.calculateCrc((void *)runAddress, firmwareLength))
 				{	
 					// check processor type
 					UInt32 firmwareTag;
@@ -42,7 +42,7 @@ void Mx1GpioBuzzer::generateTone(UInt duration, UInt period)
 {
 	// switch to a higher priority so that the frequency will be accurate
 	Task *pCurrentTask = TaskScheduler::getCurrentTaskScheduler()->getCurrentTask();
-	const UInt savedPriority = pCurrentTask->getPriority();
+	const UInt savedPriority = pCurrentTask->getBasePriority();
 	pCurrentTask->setPriority(maximum(savedPriority, Task::realtimePriority + 1000));
 
 	// oscillate the output pin
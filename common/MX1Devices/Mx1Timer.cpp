@@ -89,16 +89,15 @@ Mx1Timer::~Mx1Timer()
 void Mx1Timer::updateIntervals()
 {
 	// check if there are any time intervals
-	const TimeInterval *pFirstInterval = getFirstInterval();
-	if(pFirstInterval == null)
+	if(!hasIntervals())
 	{
 		// there are no time intervals, disable matching
 		getTimerRegisters()->tctl &= ~0x10;
 	}
 	else
 	{
-		// match for the expiry time of the first interval
-		getTimerRegisters()->tcmp = pFirstInterval->getExpiryTime();
+		// match for the expiry time of the first interval (or the next wheel slot)
+		getTimerRegisters()->tcmp = getNextMatchTime();
 		getTimerRegisters()->tctl |= 0x10;
 	}
 }
@@ -11,6 +11,9 @@
 #endif
 #include "exceptionHandlers.h"
 #include "../LockedSection.h"
+#if defined(USE_HEAP_PROFILING)
+	#include "../../ArmRuntime/runtime.h"
+#endif
 
 //------------------------------------------------------------------------------------------------
 // * RemoteDebuggerAgent::RemoteDebuggerAgent
@@ -190,6 +193,21 @@ void RemoteDebuggerAgent::processCommand()
 			processSetStoppedTaskCommand();
 			break;
 		}
+		case getTaskStatisticsCommand:
+		{
+			processGetTaskStatisticsCommand();
+			break;
+		}
+		case getHeapStatisticsCommand:
+		{
+			processGetHeapStatisticsCommand();
+			break;
+		}
+		case getTaskStackUsageCommand:
+		{
+			processGetTaskStackUsageCommand();
+			break;
+		}
 		default:
 		{
 			commandReceivingStream.forceError();
@@ -764,6 +782,168 @@ void RemoteDebuggerAgent::processSetStoppedTaskCommand()
 	pStoppedTask = (Task *)(taskHandle & ~1u);
 }
 
+//------------------------------------------------------------------------------------------------
+// * RemoteDebuggerAgent::processGetTaskStatisticsCommand
+//
+// Processes a single command from the host.
+// Writes the handle and statistics of every task, the list is empty unless the tasks keep
+// statistics (USE_TASK_STATISTICS).
+//------------------------------------------------------------------------------------------------
+
+void RemoteDebuggerAgent::processGetTaskStatisticsCommand()
+{
+	#if defined(USE_TASK_STATISTICS)
+		// iterate over all tasks
+		LockedSection allTasksLock(allTasksMutex);
+		for(UInt i = 0; i < maximumNumberOfTasks; ++i)
+		{
+			if(pAllTasks[i].pTask != null)
+			{
+				// write the task handle
+				const UInt taskHandle = (UInt)pAllTasks[i].pTask;
+				commandReceivingStream.write(&taskHandle, sizeof(taskHandle));
+
+				// write the statistics field by field so that the layout does not depend on padding
+				const TaskStatistics statistics = pAllTasks[i].pTask->getStatistics();
+				commandReceivingStream.write(&statistics.runTickCount, sizeof(statistics.runTickCount));
+				commandReceivingStream.write(&statistics.switchInCount, sizeof(statistics.switchInCount));
+				commandReceivingStream.write(
+					&statistics.voluntarySwitchCount,
+					sizeof(statistics.voluntarySwitchCount));
+				commandReceivingStream.write(
+					&statistics.preemptiveSwitchCount,
+					sizeof(statistics.preemptiveSwitchCount));
+				commandReceivingStream.write(
+					&statistics.maximumReadyLatency,
+					sizeof(statistics.maximumReadyLatency));
+				commandReceivingStream.write(
+					&statistics.totalReadyLatency,
+					sizeof(statistics.totalReadyLatency));
+			}
+		}
+	#endif
+
+	// write 0 to indicate the end of the list
+	const UInt zero = 0;
+	commandReceivingStream.write(&zero, sizeof(zero));
+}
+
+//------------------------------------------------------------------------------------------------
+// * RemoteDebuggerAgent::processGetTaskStackUsageCommand
+//
+// Processes a single command from the host.
+// Writes the handle, stack size and peak stack usage of every task, the list is empty unless
+// the stacks are painted (USE_STACK_PAINTING).
+//------------------------------------------------------------------------------------------------
+
+void RemoteDebuggerAgent::processGetTaskStackUsageCommand()
+{
+	#if defined(USE_STACK_PAINTING)
+		// iterate over all tasks
+		LockedSection allTasksLock(allTasksMutex);
+		for(UInt i = 0; i < maximumNumberOfTasks; ++i)
+		{
+			if(pAllTasks[i].pTask != null)
+			{
+				// write the task handle
+				const UInt taskHandle = (UInt)pAllTasks[i].pTask;
+				commandReceivingStream.write(&taskHandle, sizeof(taskHandle));
+
+				// write the stack size and the bytes of it used so far
+				const UInt stackSize = pAllTasks[i].pTask->getStackSize();
+				commandReceivingStream.write(&stackSize, sizeof(stackSize));
+				const UInt peakStackUsage = pAllTasks[i].pTask->getPeakStackUsage();
+				commandReceivingStream.write(&peakStackUsage, sizeof(peakStackUsage));
+			}
+		}
+	#endif
+
+	// write 0 to indicate the end of the list
+	const UInt zero = 0;
+	commandReceivingStream.write(&zero, sizeof(zero));
+}
+
+//------------------------------------------------------------------------------------------------
+// * RemoteDebuggerAgent::processGetHeapStatisticsCommand
+//
+// Processes a single command from the host.
+// Writes whether the heap is profiled (USE_HEAP_PROFILING), followed by the totals, the size
+// histogram, the owners and the call sites of the heap profile. The largest free block is only
+// measured when the host asks for it, because measuring walks the free blocks with the heap locked.
+//------------------------------------------------------------------------------------------------
+
+void RemoteDebuggerAgent::processGetHeapStatisticsCommand()
+{
+	// get command parameters
+	UInt8 measureLargestFreeBlock;
+	commandReceivingStream.read(&measureLargestFreeBlock, sizeof(measureLargestFreeBlock));
+	if(commandReceivingStream.isInError())
+	{
+		return;
+	}
+
+	#if defined(USE_HEAP_PROFILING)
+		// write that the heap is profiled
+		const UInt8 profiled = true;
+		commandReceivingStream.write(&profiled, sizeof(profiled));
+
+		// write the totals field by field so that the layout does not depend on padding
+		if(measureLargestFreeBlock != 0)
+		{
+			measureLargestFreeHeapBlock();
+		}
+		HeapProfile::Totals totals;
+		heapProfile.getTotals(totals);
+		commandReceivingStream.write(&totals.liveBytes, sizeof(totals.liveBytes));
+		commandReceivingStream.write(&totals.peakLiveBytes, sizeof(totals.peakLiveBytes));
+		commandReceivingStream.write(&totals.liveBlocks, sizeof(totals.liveBlocks));
+		commandReceivingStream.write(&totals.numberOfAllocations, sizeof(totals.numberOfAllocations));
+		commandReceivingStream.write(&totals.numberOfFrees, sizeof(totals.numberOfFrees));
+		commandReceivingStream.write(&totals.largestFreeBlock, sizeof(totals.largestFreeBlock));
+		commandReceivingStream.write(
+			&totals.smallestLargestFreeBlock,
+			sizeof(totals.smallestLargestFreeBlock));
+
+		// write the size histogram
+		UInt32 sizeHistogram[HeapProfile::numberOfSizeBuckets];
+		heapProfile.getSizeHistogram(sizeHistogram);
+		commandReceivingStream.write(sizeHistogram, sizeof(sizeHistogram));
+
+		// write the owners, then the call sites, each preceded by their number
+		for(UInt list = 0; list < 2; ++list)
+		{
+			HeapProfile::Entry entries[HeapProfile::maximumNumberOfCallSites];
+			UInt32 numberOfEntries = 0;
+			while(numberOfEntries < arrayDimension(entries)
+				&& (list == 0
+					? heapProfile.getOwner(numberOfEntries, entries[numberOfEntries])
+					: heapProfile.getCallSite(numberOfEntries, entries[numberOfEntries])))
+			{
+				++numberOfEntries;
+			}
+
+			commandReceivingStream.write(&numberOfEntries, sizeof(numberOfEntries));
+			for(UInt i = 0; i < numberOfEntries; ++i)
+			{
+				const HeapProfile::Entry &entry = entries[i];
+				commandReceivingStream.write(&entry.handle, sizeof(entry.handle));
+				commandReceivingStream.write(&entry.liveBytes, sizeof(entry.liveBytes));
+				commandReceivingStream.write(&entry.peakLiveBytes, sizeof(entry.peakLiveBytes));
+				commandReceivingStream.write(&entry.liveBlocks, sizeof(entry.liveBlocks));
+				commandReceivingStream.write(
+					&entry.numberOfAllocations,
+					sizeof(entry.numberOfAllocations));
+			}
+		}
+	#else
+		// write that the heap is not profiled
+		const UInt8 profiled = false;
+		commandReceivingStream.write(&profiled, sizeof(profiled));
+	#endif
+
+	commandReceivingStream.flush();
+}
+
 //------------------------------------------------------------------------------------------------
 // * RemoteDebuggerAgent::stopTask
 //
@@ -44,7 +44,10 @@ private:
 		goCommand,
 		stopCommand,
 		getAllTasksCommand,
-		setStoppedTaskCommand
+		setStoppedTaskCommand,
+		getTaskStatisticsCommand,
+		getHeapStatisticsCommand,
+		getTaskStackUsageCommand
 	};
 	enum StopReason
 	{
@@ -75,6 +78,9 @@ private:
 	void processStopCommand();
 	void processGetAllTasksCommand();
 	void processSetStoppedTaskCommand();
+	void processGetTaskStatisticsCommand();
+	void processGetHeapStatisticsCommand();
+	void processGetTaskStackUsageCommand();
 
 	// task stop handling
 	void handleStop();
@@ -0,0 +1,96 @@
+#include "BandedTaskGroup.h"
+#include "../arithmetic/countLeadingZeros.h"
+
+//------------------------------------------------------------------------------------------------
+// * BandedTaskGroup::BandedTaskGroup
+//
+// Constructor.
+//------------------------------------------------------------------------------------------------
+
+BandedTaskGroup::BandedTaskGroup()
+{
+	usedBands = 0;
+	for(UInt band = 0; band < numberOfBands; ++band)
+	{
+		pLastTaskInBand[band] = null;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * BandedTaskGroup::addTask
+//
+// Adds the specified <pTask> to the queue in priority order.
+// The <pTask> will be added after any tasks of equal priority.
+//------------------------------------------------------------------------------------------------
+
+void BandedTaskGroup::addTask(Task *pTask)
+{
+	const UInt priority = pTask->getPriority();
+	const UInt band = getBand(priority);
+	Task *pTaskBefore;
+
+	// check if there are other tasks in this band
+	if((usedBands & (1u << band)) != 0)
+	{
+		// start at the end of the band and skip back over any lower priority tasks,
+		// this will not move at all when every task in the band has the same priority
+		pTaskBefore = pLastTaskInBand[band];
+		while(pTaskBefore != null && pTaskBefore->getPriority() < priority)
+		{
+			pTaskBefore = pTaskBefore->getPreviousTask();
+		}
+		if(pTaskBefore == pLastTaskInBand[band])
+		{
+			// the task becomes the end of the band
+			pLastTaskInBand[band] = pTask;
+		}
+	}
+	else
+	{
+		// the band is empty, the task goes after the end of the nearest higher band (if any)
+		const UInt higherBands = usedBands & ~((2u << band) - 1);
+		pTaskBefore = higherBands == 0 ? null : pLastTaskInBand[indexOfLowestSetBit(higherBands)];
+		usedBands |= 1u << band;
+		pLastTaskInBand[band] = pTask;
+	}
+
+	// insert the task into the list
+	if(pTaskBefore == null)
+	{
+		LinkedList::addFirst(pTask);
+	}
+	else
+	{
+		LinkedList::addAfter(pTask, pTaskBefore);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * BandedTaskGroup::removeTask
+//
+// Removes the specified <pTask> from the queue.
+//------------------------------------------------------------------------------------------------
+
+void BandedTaskGroup::removeTask(Task *pTask)
+{
+	// check if the task is at the end of its band
+	const UInt band = getBand(pTask->getPriority());
+	if(pLastTaskInBand[band] == pTask)
+	{
+		Task *pPreviousTask = pTask->getPreviousTask();
+		if(pPreviousTask != null && getBand(pPreviousTask->getPriority()) == band)
+		{
+			// the previous task becomes the end of the band
+			pLastTaskInBand[band] = pPreviousTask;
+		}
+		else
+		{
+			// this was the only task in the band
+			pLastTaskInBand[band] = null;
+			usedBands &= ~(1u << band);
+		}
+	}
+
+	// remove the task from the list
+	LinkedList::remove(pTask);
+}
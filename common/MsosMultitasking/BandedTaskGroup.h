@@ -0,0 +1,57 @@
+#include "TaskGroup.h"
+
+#ifndef _BandedTaskGroup_h_
+#define _BandedTaskGroup_h_
+
+#include "../cPrimitiveTypes.h"
+class Task;
+
+//------------------------------------------------------------------------------------------------
+// * class BandedTaskGroup
+//
+// Keeps a list of tasks sorted in order of priority like TaskGroup, but divides the priority
+// range into a fixed number of bands so that tasks can be added and removed in constant time.
+// Each band is a FIFO run of tasks within the list and a bitmap records which bands are in use.
+// Tasks of different priorities that share a band are still kept in priority order.
+//------------------------------------------------------------------------------------------------
+
+class BandedTaskGroup : public TaskGroup
+{
+public:
+	// constructor
+	BandedTaskGroup();
+
+	// modifying task priority queue
+	void addTask(Task *pTask);
+	void removeTask(Task *pTask);
+
+private:
+	// priority bands
+	enum
+	{
+		numberOfBands = 32,
+		bandWidth = 5 * 1000000
+	};
+	static inline UInt getBand(UInt priority);
+
+	// representation
+	UInt usedBands;
+	Task *pLastTaskInBand[numberOfBands];
+};
+
+#include "Task.h"
+
+//------------------------------------------------------------------------------------------------
+// * BandedTaskGroup::getBand
+//
+// Returns the band that tasks of the given <priority> belong to.
+// Every predefined Task priority level falls into a band of its own.
+//------------------------------------------------------------------------------------------------
+
+inline UInt BandedTaskGroup::getBand(UInt priority)
+{
+	const UInt band = priority / bandWidth;
+	return band < numberOfBands ? band : numberOfBands - 1;
+}
+
+#endif // _BandedTaskGroup_h_
@@ -0,0 +1,63 @@
+#include "DeferredWork.h"
+#include "DeferredWorkQueue.h"
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWork::DeferredWork
+//
+// Constructor.
+// The work will be handled by the default queue, which is created now if this is the first work
+// to use it, so the work must be constructed by a task rather than by an interrupt handler.
+//------------------------------------------------------------------------------------------------
+
+DeferredWork::DeferredWork() :
+	pQueue(DeferredWorkQueue::getDefaultQueue()),
+	queued(false)
+{
+}
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWork::DeferredWork
+//
+// Constructor.
+// The work will be handled by the given <pQueue>.
+//------------------------------------------------------------------------------------------------
+
+DeferredWork::DeferredWork(DeferredWorkQueue *pQueue) :
+	pQueue(pQueue),
+	queued(false)
+{
+}
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWork::~DeferredWork
+//
+// Destructor.
+//------------------------------------------------------------------------------------------------
+
+DeferredWork::~DeferredWork()
+{
+	cancel();
+}
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWork::defer
+//
+// Queues this work to be handled by a task.
+// This may be called from an interrupt handler.
+//------------------------------------------------------------------------------------------------
+
+void DeferredWork::defer()
+{
+	pQueue->addWork(this);
+}
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWork::cancel
+//
+// Removes this work from its queue if it has not been handled yet.
+//------------------------------------------------------------------------------------------------
+
+void DeferredWork::cancel()
+{
+	pQueue->removeWork(this);
+}
@@ -0,0 +1,56 @@
+#ifndef _DeferredWork_h_
+#define _DeferredWork_h_
+
+#include "../cPrimitiveTypes.h"
+#include "../Collections/Link.h"
+class DeferredWorkQueue;
+
+//------------------------------------------------------------------------------------------------
+// * class DeferredWork
+//
+// A piece of work that an interrupt handler hands over to a task.
+// The interrupt handler should only do the register accesses that can't wait, and then defer
+// this work, which a DeferredWorkQueue task will handle with interrupts enabled. Deferring work
+// that is already queued does nothing, so the work runs once for any number of interrupts.
+//------------------------------------------------------------------------------------------------
+
+class DeferredWork : public Link
+{
+public:
+	// constructors and destructor
+	DeferredWork();
+	DeferredWork(DeferredWorkQueue *pQueue);
+	virtual ~DeferredWork();
+
+	// testing
+	inline Bool isQueued() const;
+
+	// queueing
+	void defer();
+	void cancel();
+
+protected:
+	// behaviour
+	virtual void handleWork() = 0;
+
+private:
+	// representation
+	DeferredWorkQueue *pQueue;
+	Bool queued;
+
+	// friends
+	friend class DeferredWorkQueue;
+};
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWork::isQueued
+//
+// Tests whether this work is waiting to be handled.
+//------------------------------------------------------------------------------------------------
+
+inline Bool DeferredWork::isQueued() const
+{
+	return queued;
+}
+
+#endif // _DeferredWork_h_
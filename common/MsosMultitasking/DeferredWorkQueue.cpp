@@ -0,0 +1,80 @@
+#include "DeferredWorkQueue.h"
+#include "DeferredWork.h"
+#include "UninterruptableSection.h"
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWorkQueue::DeferredWorkQueue
+//
+// Constructor.
+// The task is created suspended, it must be resumed before any work will be handled.
+//------------------------------------------------------------------------------------------------
+
+DeferredWorkQueue::DeferredWorkQueue(UInt priority, UInt stackSize) :
+	Task(priority, stackSize)
+{
+}
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWorkQueue::addWork
+//
+// Queues <pWork> to be handled, unless it is already queued.
+// This may be called from an interrupt handler.
+//------------------------------------------------------------------------------------------------
+
+void DeferredWorkQueue::addWork(DeferredWork *pWork)
+{
+	UninterruptableSection criticalSection;
+	if(!pWork->queued)
+	{
+		pWork->queued = true;
+		workList.addLast(pWork);
+		workEvent.signal();
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWorkQueue::removeWork
+//
+// Removes <pWork> from the queue if it has not been handled yet.
+//------------------------------------------------------------------------------------------------
+
+void DeferredWorkQueue::removeWork(DeferredWork *pWork)
+{
+	UninterruptableSection criticalSection;
+	if(pWork->queued)
+	{
+		pWork->queued = false;
+		workList.remove(pWork);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWorkQueue::main
+//
+// Handles deferred work forever.
+//------------------------------------------------------------------------------------------------
+
+void DeferredWorkQueue::main()
+{
+	while(true)
+	{
+		// wait for some work to be deferred
+		workEvent.wait();
+
+		// handle all of the queued work, work may be deferred again while it is being handled
+		while(true)
+		{
+			DeferredWork *pWork;
+			{
+				UninterruptableSection criticalSection;
+				if(workList.isEmpty())
+				{
+					break;
+				}
+				pWork = (DeferredWork *)workList.removeFirst();
+				pWork->queued = false;
+			}
+			pWork->handleWork();
+		}
+	}
+}
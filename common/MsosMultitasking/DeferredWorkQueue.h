@@ -0,0 +1,88 @@
+#ifndef _DeferredWorkQueue_h_
+#define _DeferredWorkQueue_h_
+
+#include "../cPrimitiveTypes.h"
+#include "../Collections/LinkedList.h"
+#include "Task.h"
+#include "IntertaskEvent.h"
+class DeferredWork;
+
+//------------------------------------------------------------------------------------------------
+// * class DeferredWorkQueue
+//
+// A task which handles the work deferred by interrupt handlers, in the order it was deferred.
+// It runs above the realtime priority so that deferred work is handled before any task that is
+// waiting for it, but with interrupts enabled so that other interrupts are not held up.
+// The default queue is created by the task scheduler when the first work that uses it is created.
+//------------------------------------------------------------------------------------------------
+
+class DeferredWorkQueue : public Task
+{
+public:
+	// constructor
+	DeferredWorkQueue(UInt priority = deferredWorkPriority, UInt stackSize = getDefaultStackSize());
+
+	// querying
+	static inline DeferredWorkQueue *getDefaultQueue();
+
+	// modifying
+	void addWork(DeferredWork *pWork);
+	void removeWork(DeferredWork *pWork);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	static inline UInt getDefaultStackSize();
+
+	// representation
+	LinkedList workList;
+	IntertaskEvent workEvent;
+};
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWorkQueue::getDefaultQueue
+//
+// Returns the queue shared by all deferred work, creating it if this is the first time.
+// This must be called from a task rather than from an interrupt handler.
+//------------------------------------------------------------------------------------------------
+
+inline DeferredWorkQueue *DeferredWorkQueue::getDefaultQueue()
+{
+	return TaskScheduler::getCurrentTaskScheduler()->getDeferredWorkQueue();
+}
+
+//------------------------------------------------------------------------------------------------
+// * DeferredWorkQueue::getDefaultStackSize
+//
+// Returns the default stack size for this task.
+// The task only waits for work and calls the handlers, so this covers the deepest handler.
+//------------------------------------------------------------------------------------------------
+
+inline UInt DeferredWorkQueue::getDefaultStackSize()
+{
+	// the stack space used is dependent on the compiler settings and processor
+	#if defined(_MSC_VER) && defined(_M_IX86)
+		return 2048;
+	#elif defined(_MSC_VER) && defined(_M_ARM)
+		return 2048;
+	#elif defined(__ARMCC_VERSION)
+		return 2048;
+	#elif defined(__i386__)
+		return 4096;
+	#elif defined(__x86_64__) && defined(__linux__)
+		// signal handlers run on the task's stack and the kernel's signal frame is large
+		return 16384;
+	#elif defined(__x86_64__)
+		return 4096;
+	#elif defined(__ppc__)
+		return 2048;
+	#elif defined(__ppc64__)
+		return 4096;
+	#else
+		#error "unknown platform"
+	#endif
+}
+
+#endif // _DeferredWorkQueue_h_
@@ -6,6 +6,9 @@
 #if defined(__TARGET_CPU_ARM920T)
 	#include "../Mx1Devices/Mx1DeviceAddresses.h"
 #endif
+#if defined(__x86_64__) && defined(__linux__)
+	#include "Posix/posixInterrupts.h"
+#endif
 #include "IdleTask.h"
 
 //------------------------------------------------------------------------------------------------
@@ -46,6 +49,11 @@ void IdleTask::main()
 			// speed-up external bus, HCLK = BCLK = System PLL / 1
 			*(volatile UInt *)(mx1RegistersBase + 0x1B000) &= ~0x00003C00;
 		#endif
+		#if defined(__x86_64__) && defined(__linux__)
+			// sleep until an interrupt signal occurs,
+			// the signal handler will switch to any task which it has made ready
+			waitForInterrupt();
+		#endif
 	}
 }
 
@@ -53,6 +61,8 @@ void IdleTask::main()
 // * IdleTask static variables
 //------------------------------------------------------------------------------------------------
 
+UInt64 IdleTask::stack[defaultStackSize / sizeof(UInt64)];
+
 #if defined(__TARGET_CPU_ARM920T)
 	UInt IdleTask::busClockDividerRegisterValue = (5 - 1) << 10;
 #endif
@@ -28,7 +28,32 @@ protected:
 	void main();
 
 private:
-	static inline UInt getDefaultStackSize();
+	// the stack space used is dependent on the compiler settings and processor
+	// to do: calculate the smallest stack size possible, these are conservative estimates
+	#if defined(_MSC_VER) && defined(_M_IX86)
+		static const UInt defaultStackSize = 1024;
+	#elif defined(_MSC_VER) && defined(_M_ARM)
+		static const UInt defaultStackSize = 1024;
+	#elif defined(__ARMCC_VERSION)
+		static const UInt defaultStackSize = 1024;
+	#elif defined(__i386__)
+		static const UInt defaultStackSize = 2048;
+	#elif defined(__x86_64__) && defined(__linux__)
+		// signal handlers run on the task's stack and the kernel's signal frame is large
+		static const UInt defaultStackSize = 16384;
+	#elif defined(__x86_64__)
+		static const UInt defaultStackSize = 3072;
+	#elif defined(__ppc__)
+		static const UInt defaultStackSize = 1024;
+	#elif defined(__ppc64__)
+		static const UInt defaultStackSize = 2048;
+	#else
+		#error "unknown platform"
+	#endif
+
+	// the stack is not allocated from the heap, because the scheduler and with it this task
+	// are constructed before main() is called
+	static UInt64 stack[defaultStackSize / sizeof(UInt64)];
 	static UInt busClockDividerRegisterValue;
 };
 
@@ -39,7 +64,7 @@ private:
 //------------------------------------------------------------------------------------------------
 
 inline IdleTask::IdleTask() :
-	Task(0, getDefaultStackSize())
+	Task(0, stack, sizeof(stack))
 {
 }
 
@@ -57,35 +82,4 @@ inline void IdleTask::setBusClockDivider(UInt denominator)
 }
 #endif
 
-//------------------------------------------------------------------------------------------------
-// * IdleTask::getDefaultStackSize
-//
-// Returns the default stack size for this task.
-// This value will be relatively small because the task does make any function calls.
-//------------------------------------------------------------------------------------------------
-
-inline UInt IdleTask::getDefaultStackSize()
-{
-	// to do: calculate the smallest stack size possible, these are conservative estimates
-
-	// the stack space used is dependent on the compiler settings and processor
-	#if defined(_MSC_VER) && defined(_M_IX86)
-		return 1024;
-	#elif defined(_MSC_VER) && defined(_M_ARM)
-		return 1024;
-	#elif defined(__ARMCC_VERSION)
-		return 1024;
-	#elif defined(__i386__)
-		return 2048;
-	#elif defined(__x86_64__)
-		return 3072;
-	#elif defined(__ppc__)
-		return 1024;
-	#elif defined(__ppc64__)
-		return 2048;
-	#else
-		#error "unknown platform"
-	#endif
-}
-
 #endif // _IdleTask_h_
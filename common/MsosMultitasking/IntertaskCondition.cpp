@@ -12,7 +12,7 @@ void IntertaskCondition::waitTask(Task *pTask)
 {
 	// increase to maximum priority so that the remaining code will be atomic
 	// with respect to any signaling task, and no change in condition will be missed
-	const UInt savedPriority = pTask->getPriority();
+	const UInt savedPriority = pTask->getBasePriority();
 	pTask->setPriority(Task::maximumPriority);
 
 	// keep the mutex unlocked while waiting for the condition to change
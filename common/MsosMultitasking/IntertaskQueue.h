@@ -5,6 +5,7 @@
 #include "Semaphore.h"
 #include "LockedSection.h"
 #include "TimeValue.h"
+#include "Timer.h"
 
 //------------------------------------------------------------------------------------------------
 // * class IntertaskQueue
@@ -16,6 +17,8 @@
 // the task will be blocked until an element is added to the queue.
 // If a task attempts to add an element when the queue is full,
 // the task will be blocked until an element is removed from the queue.
+// Elements can also be added and removed in batches, which reserves space for (or elements from)
+// the whole batch at once, moves it under a single lock and wakes the other side only once.
 // This is an abstract class, instanciate IntertaskPointerQueue or IntertaskValueQueue instead.
 //------------------------------------------------------------------------------------------------
 
@@ -51,6 +54,18 @@ protected:
 	Bool basicRemoveFirst(Element *pItem, TimeValue timeout = infiniteTime);
 	Bool basicRemoveLast(Element *pItem, TimeValue timeout = infiniteTime);
 
+	// batch modifying
+	UInt basicAddLastMany(
+		const Element *pItems,
+		UInt minimumCount,
+		UInt maximumCount,
+		TimeValue timeout = infiniteTime);
+	UInt basicRemoveFirstMany(
+		Element *pItems,
+		UInt minimumCount,
+		UInt maximumCount,
+		TimeValue timeout = infiniteTime);
+
 	// low-level modifying
 	inline Bool basicReserveElementToAdd(TimeValue timeout = infiniteTime);
 	inline Bool basicReserveElementToRemove(TimeValue timeout = infiniteTime);
@@ -58,8 +73,17 @@ protected:
 	void basicAddReservedElementLast(Element item);
 	Element basicRemoveReservedElementFirst();
 	Element basicRemoveReservedElementLast();
+	void basicAddReservedElementsLast(const Element *pItems, UInt count);
+	void basicRemoveReservedElementsFirst(Element *pItems, UInt count);
 
 private:
+	// batch reserving
+	static UInt reserveSlots(
+		Semaphore &slotSemaphore,
+		UInt minimumCount,
+		UInt maximumCount,
+		TimeValue timeout);
+
 	// representation
 	UInt capacity;
 	Element *pSlots;
@@ -419,6 +443,160 @@ Element IntertaskQueue<Element>::basicRemoveReservedElementLast()
 	return pSlots[lastIndex];
 }
 
+//------------------------------------------------------------------------------------------------
+// * IntertaskQueue::basicAddLastMany
+//
+// Adds between <minimumCount> and <maximumCount> elements from <pItems> to the queue,
+// as many as there is space for.
+// If there is space for less than <minimumCount> elements, the current task will block until
+// other tasks remove enough elements.
+// Returns the number of elements added, which is less than <minimumCount> only if a timeout
+// occurred.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+UInt IntertaskQueue<Element>::basicAddLastMany(
+	const Element *pItems,
+	UInt minimumCount,
+	UInt maximumCount,
+	TimeValue timeout)
+{
+	// wait for enough free slots in the queue
+	const UInt count = reserveSlots(freeSlotSemaphore, minimumCount, maximumCount, timeout);
+
+	// add the items to the queue
+	if(count != 0)
+	{
+		basicAddReservedElementsLast(pItems, count);
+	}
+
+	return count;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskQueue::basicRemoveFirstMany
+//
+// Removes between <minimumCount> and <maximumCount> elements from the queue into <pItems>,
+// as many as there are.
+// If there are less than <minimumCount> elements, the current task will block until other tasks
+// add enough elements.
+// Returns the number of elements removed, which is less than <minimumCount> only if a timeout
+// occurred.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+UInt IntertaskQueue<Element>::basicRemoveFirstMany(
+	Element *pItems,
+	UInt minimumCount,
+	UInt maximumCount,
+	TimeValue timeout)
+{
+	// wait for enough used slots in the queue
+	const UInt count = reserveSlots(usedSlotSemaphore, minimumCount, maximumCount, timeout);
+
+	// remove the items from the queue
+	if(count != 0)
+	{
+		basicRemoveReservedElementsFirst(pItems, count);
+	}
+
+	return count;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskQueue::basicAddReservedElementsLast
+//
+// Adds <count> elements that have previously been reserved to the queue.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+void IntertaskQueue<Element>::basicAddReservedElementsLast(const Element *pItems, UInt count)
+{
+	// add the items to the queue
+	LockedSection slotLock(slotMutex);
+	for(UInt itemNumber = 0; itemNumber < count; ++itemNumber)
+	{
+		pSlots[lastIndex] = pItems[itemNumber];
+		if(++lastIndex >= (SInt)capacity)
+		{
+			lastIndex = 0;
+		}
+	}
+
+	// signal that there are more items in the queue
+	usedSlotSemaphore.signalMany(count);
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskQueue::basicRemoveReservedElementsFirst
+//
+// Removes <count> elements that have previously been reserved from the queue.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+void IntertaskQueue<Element>::basicRemoveReservedElementsFirst(Element *pItems, UInt count)
+{
+	// remove the items from the queue
+	LockedSection slotLock(slotMutex);
+	for(UInt itemNumber = 0; itemNumber < count; ++itemNumber)
+	{
+		pItems[itemNumber] = pSlots[firstIndex];
+		if(++firstIndex >= (SInt)capacity)
+		{
+			firstIndex = 0;
+		}
+	}
+
+	// signal that there are more free slots in the queue
+	freeSlotSemaphore.signalMany(count);
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskQueue::reserveSlots
+//
+// Waits on <slotSemaphore> between <minimumCount> and <maximumCount> times.
+// Every slot that is available straight away is taken, and the current task only blocks until
+// <minimumCount> slots have been taken.
+// Returns the number of slots taken, which is less than <minimumCount> only if a timeout occurred.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+UInt IntertaskQueue<Element>::reserveSlots(
+	Semaphore &slotSemaphore,
+	UInt minimumCount,
+	UInt maximumCount,
+	TimeValue timeout)
+{
+	// take the slots that are available now
+	UInt count = slotSemaphore.tryWaitMany(maximumCount);
+	if(count >= minimumCount)
+	{
+		return count;
+	}
+
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	const TimeValue endTime = timeout == infiniteTime ? 0 : pTimer->getTime() + timeout;
+	while(count < minimumCount)
+	{
+		// wait for one more slot
+		if(timeout == infiniteTime)
+		{
+			slotSemaphore.wait();
+		}
+		else if(slotSemaphore.waitUntil(endTime, pTimer))
+		{
+			// timeout
+			break;
+		}
+		++count;
+
+		// take any other slots that were made available at the same time
+		count += slotSemaphore.tryWaitMany(maximumCount - count);
+	}
+
+	return count;
+}
+
 
 
 
@@ -444,6 +622,18 @@ public:
 	inline Element *removeFirst();
 	inline Element *removeLast();
 
+	// batch modifying
+	inline UInt addLastMany(
+		Element *const *ppItems,
+		UInt minimumCount,
+		UInt maximumCount,
+		TimeValue timeout = infiniteTime);
+	inline UInt removeFirstMany(
+		Element **ppItems,
+		UInt minimumCount,
+		UInt maximumCount,
+		TimeValue timeout = infiniteTime);
+
 	// low-level modifying
 	inline void addReservedElementFirst(Element *pItem);
 	inline void addReservedElementLast(Element *pItem);
@@ -516,7 +706,7 @@ inline Bool IntertaskPointerQueue<Element>::removeFirst(Element **ppItem, TimeVa
 template<class Element>
 inline Bool IntertaskPointerQueue<Element>::removeLast(Element **ppItem, TimeValue timeout)
 {
-	return basicRemoveLast((void **)ppItem, null, timeout);
+	return basicRemoveLast((void **)ppItem, timeout);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -529,7 +719,7 @@ inline Bool IntertaskPointerQueue<Element>::removeLast(Element **ppItem, TimeVal
 template<class Element>
 inline Element *IntertaskPointerQueue<Element>::removeFirst()
 {
-	Element *pItem;
+	Element *pItem = null;
 	basicRemoveFirst((void **)&pItem);
 	return pItem;
 }
@@ -544,11 +734,49 @@ inline Element *IntertaskPointerQueue<Element>::removeFirst()
 template<class Element>
 inline Element *IntertaskPointerQueue<Element>::removeLast()
 {
-	Element *pItem;
+	Element *pItem = null;
 	basicRemoveLast((void **)&pItem);
 	return pItem;
 }
 
+//------------------------------------------------------------------------------------------------
+// * IntertaskPointerQueue::addLastMany
+//
+// Adds between <minimumCount> and <maximumCount> elements from <ppItems> to the queue,
+// possibly blocking the current task until there is space for <minimumCount> elements.
+// Returns the number of elements added, which is less than <minimumCount> only if a timeout
+// occurred.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline UInt IntertaskPointerQueue<Element>::addLastMany(
+	Element *const *ppItems,
+	UInt minimumCount,
+	UInt maximumCount,
+	TimeValue timeout)
+{
+	return basicAddLastMany((void *const *)ppItems, minimumCount, maximumCount, timeout);
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskPointerQueue::removeFirstMany
+//
+// Removes between <minimumCount> and <maximumCount> elements from the queue into <ppItems>,
+// possibly blocking the current task until there are <minimumCount> elements.
+// Returns the number of elements removed, which is less than <minimumCount> only if a timeout
+// occurred.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline UInt IntertaskPointerQueue<Element>::removeFirstMany(
+	Element **ppItems,
+	UInt minimumCount,
+	UInt maximumCount,
+	TimeValue timeout)
+{
+	return basicRemoveFirstMany((void **)ppItems, minimumCount, maximumCount, timeout);
+}
+
 //------------------------------------------------------------------------------------------------
 // * IntertaskPointerQueue::addReservedElementFirst
 //
@@ -622,6 +850,18 @@ public:
 	inline Element removeFirst();
 	inline Element removeLast();
 
+	// batch modifying
+	inline UInt addLastMany(
+		const Element *pItems,
+		UInt minimumCount,
+		UInt maximumCount,
+		TimeValue timeout = infiniteTime);
+	inline UInt removeFirstMany(
+		Element *pItems,
+		UInt minimumCount,
+		UInt maximumCount,
+		TimeValue timeout = infiniteTime);
+
 	// low-level modifying
 	inline void addReservedElementFirst(Element item);
 	inline void addReservedElementLast(Element item);
@@ -651,7 +891,7 @@ inline IntertaskValueQueue<Element>::IntertaskValueQueue(UInt capacity) :
 template<class Element>
 inline Bool IntertaskValueQueue<Element>::addFirst(Element item, TimeValue timeout)
 {
-	return basicAddFirst(item, timeout);
+	return this->basicAddFirst(item, timeout);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -678,7 +918,7 @@ inline Bool IntertaskValueQueue<Element>::addLast(Element item, TimeValue timeou
 template<class Element>
 inline Bool IntertaskValueQueue<Element>::removeFirst(Element *pItem, TimeValue timeout)
 {
-	return basicRemoveFirst(pItem, timeout);
+	return this->basicRemoveFirst(pItem, timeout);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -692,7 +932,7 @@ inline Bool IntertaskValueQueue<Element>::removeFirst(Element *pItem, TimeValue
 template<class Element>
 inline Bool IntertaskValueQueue<Element>::removeLast(Element *pItem, TimeValue timeout)
 {
-	return basicRemoveLast(pItem, timeout);
+	return this->basicRemoveLast(pItem, timeout);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -705,7 +945,7 @@ inline Bool IntertaskValueQueue<Element>::removeLast(Element *pItem, TimeValue t
 template<class Element>
 inline Element IntertaskValueQueue<Element>::removeFirst()
 {
-	Element item;
+	Element item = Element();
 	this->basicRemoveFirst(&item);
 	return item;
 }
@@ -720,11 +960,49 @@ inline Element IntertaskValueQueue<Element>::removeFirst()
 template<class Element>
 inline Element IntertaskValueQueue<Element>::removeLast()
 {
-	Element item;
-	basicRemoveLast(&item);
+	Element item = Element();
+	this->basicRemoveLast(&item);
 	return item;
 }
 
+//------------------------------------------------------------------------------------------------
+// * IntertaskValueQueue::addLastMany
+//
+// Adds between <minimumCount> and <maximumCount> elements from <pItems> to the queue,
+// possibly blocking the current task until there is space for <minimumCount> elements.
+// Returns the number of elements added, which is less than <minimumCount> only if a timeout
+// occurred.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline UInt IntertaskValueQueue<Element>::addLastMany(
+	const Element *pItems,
+	UInt minimumCount,
+	UInt maximumCount,
+	TimeValue timeout)
+{
+	return this->basicAddLastMany(pItems, minimumCount, maximumCount, timeout);
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskValueQueue::removeFirstMany
+//
+// Removes between <minimumCount> and <maximumCount> elements from the queue into <pItems>,
+// possibly blocking the current task until there are <minimumCount> elements.
+// Returns the number of elements removed, which is less than <minimumCount> only if a timeout
+// occurred.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline UInt IntertaskValueQueue<Element>::removeFirstMany(
+	Element *pItems,
+	UInt minimumCount,
+	UInt maximumCount,
+	TimeValue timeout)
+{
+	return this->basicRemoveFirstMany(pItems, minimumCount, maximumCount, timeout);
+}
+
 //------------------------------------------------------------------------------------------------
 // * IntertaskValueQueue::addReservedElementFirst
 //
@@ -734,7 +1012,7 @@ inline Element IntertaskValueQueue<Element>::removeLast()
 template<class Element>
 inline void IntertaskValueQueue<Element>::addReservedElementFirst(Element item)
 {
-	basicAddReservedElementFirst(item);
+	this->basicAddReservedElementFirst(item);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -746,7 +1024,7 @@ inline void IntertaskValueQueue<Element>::addReservedElementFirst(Element item)
 template<class Element>
 inline void IntertaskValueQueue<Element>::addReservedElementLast(Element item)
 {
-	basicAddReservedElementLast(item);
+	this->basicAddReservedElementLast(item);
 }
 
 //------------------------------------------------------------------------------------------------
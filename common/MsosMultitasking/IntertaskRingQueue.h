@@ -0,0 +1,342 @@
+#ifndef _IntertaskRingQueue_h_
+#define _IntertaskRingQueue_h_
+
+#include "../cPrimitiveTypes.h"
+#include "../arithmetic/countLeadingZeros.h"
+#include "IntertaskEvent.h"
+#include "UninterruptableSection.h"
+#include "TimeValue.h"
+#include "Timer.h"
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * class IntertaskRingQueue
+//
+// This class provides a mechanism for passing <Element>s from a single producer to a single
+// consumer, either of which may be an interrupt handler.
+// Unlike IntertaskQueue, adding and removing elements takes no locks, the producer only writes
+// the last index and the consumer only writes the first index, and these are kept in separate
+// cache lines. An IntertaskEvent is only used when the consumer (or producer) has to sleep
+// because the queue is empty (or full).
+// The tryAddLast() and tryRemoveFirst() functions never block and may be called from
+// InterruptHandler::handleInterrupt().
+// The capacity is rounded up to a power of two.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+class IntertaskRingQueue
+{
+public:
+	// constructor and destructor
+	IntertaskRingQueue(UInt capacity);
+	~IntertaskRingQueue();
+
+	// testing
+	inline Bool isFull() const;
+	inline Bool isEmpty() const;
+
+	// accessing
+	inline UInt getSize() const;
+	inline UInt getCapacity() const;
+
+	// producing
+	inline Bool tryAddLast(Element item);
+	Bool addLast(Element item, TimeValue timeout = infiniteTime);
+
+	// consuming
+	inline Bool tryRemoveFirst(Element *pItem);
+	Bool removeFirst(Element *pItem, TimeValue timeout = infiniteTime);
+	inline Element removeFirst();
+
+private:
+	// types
+	enum
+	{
+		#if defined(__x86_64__) || defined(__i386__) || defined(_M_IX86)
+			cacheLineSize = 64
+		#else
+			cacheLineSize = 32
+		#endif
+	};
+
+	// ordering
+	static inline void orderMemoryAccesses();
+
+	// representation
+	UInt indexMask;
+	Element *pSlots;
+
+	// consumer state
+	volatile UInt firstIndex;
+	volatile Bool consumerWaiting;
+	IntertaskEvent usedSlotEvent;
+	UInt8 consumerPadding[cacheLineSize];
+
+	// producer state
+	volatile UInt lastIndex;
+	volatile Bool producerWaiting;
+	IntertaskEvent freeSlotEvent;
+	UInt8 producerPadding[cacheLineSize];
+};
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::IntertaskRingQueue
+//
+// Constructs an IntertaskRingQueue capable of holding at least <capacity> elements.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+IntertaskRingQueue<Element>::IntertaskRingQueue(UInt capacity)
+{
+	const UInt roundedCapacity = capacity <= 1 ? 1 : 1 << (32 - countLeadingZeros(capacity - 1));
+	indexMask = roundedCapacity - 1;
+	pSlots = new Element[roundedCapacity];
+	firstIndex = 0;
+	consumerWaiting = false;
+	lastIndex = 0;
+	producerWaiting = false;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::~IntertaskRingQueue
+//
+// Destructor.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+IntertaskRingQueue<Element>::~IntertaskRingQueue()
+{
+	delete[] pSlots;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::isFull
+//
+// Tests whether there is no free space in the queue.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline Bool IntertaskRingQueue<Element>::isFull() const
+{
+	return getSize() == getCapacity();
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::isEmpty
+//
+// Tests whether there are no elements in the queue.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline Bool IntertaskRingQueue<Element>::isEmpty() const
+{
+	return lastIndex == firstIndex;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::getSize
+//
+// Returns the number of items in the queue.
+// The indices run freely and wrap around together, so their difference is always the size.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline UInt IntertaskRingQueue<Element>::getSize() const
+{
+	return lastIndex - firstIndex;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::getCapacity
+//
+// Returns the maximum number of items that can simultaneously be held in the queue.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline UInt IntertaskRingQueue<Element>::getCapacity() const
+{
+	return indexMask + 1;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::tryAddLast
+//
+// Adds an element to the queue if there is space for it.
+// Returns true if the <item> has been added, false if the queue is full.
+// This must only be called by the producer, it never blocks.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline Bool IntertaskRingQueue<Element>::tryAddLast(Element item)
+{
+	const UInt index = lastIndex;
+	if(index - firstIndex > indexMask)
+	{
+		return false;
+	}
+
+	// the element must be in its slot before the consumer can see it
+	pSlots[index & indexMask] = item;
+	orderMemoryAccesses();
+	lastIndex = index + 1;
+
+	// wake up the consumer if it is waiting for this element
+	if(consumerWaiting)
+	{
+		consumerWaiting = false;
+		usedSlotEvent.signal();
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::addLast
+//
+// Adds an element to the queue.
+// If the queue is full, the producer task will block until the consumer removes an element.
+// Returns true if a timeout occurred, false if the <item> has been added.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+Bool IntertaskRingQueue<Element>::addLast(Element item, TimeValue timeout)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	const TimeValue endTime = timeout == infiniteTime ? 0 : pTimer->getTime() + timeout;
+	while(!tryAddLast(item))
+	{
+		// ask the consumer for a wake up, unless it removed an element in the meantime
+		{
+			UninterruptableSection criticalSection;
+			freeSlotEvent.clear();
+			producerWaiting = true;
+			if(!isFull())
+			{
+				producerWaiting = false;
+				continue;
+			}
+		}
+
+		// sleep until an element has been removed
+		if(timeout == infiniteTime)
+		{
+			freeSlotEvent.wait();
+		}
+		else if(freeSlotEvent.waitUntil(endTime, pTimer))
+		{
+			producerWaiting = false;
+			return true;
+		}
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::tryRemoveFirst
+//
+// Removes an element from the queue if there is one.  <pItem> will point to the element removed.
+// Returns true if an item has been removed, false if the queue is empty.
+// This must only be called by the consumer, it never blocks.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline Bool IntertaskRingQueue<Element>::tryRemoveFirst(Element *pItem)
+{
+	const UInt index = firstIndex;
+	if(index == lastIndex)
+	{
+		return false;
+	}
+
+	// the element must be out of its slot before the producer can reuse it
+	orderMemoryAccesses();
+	*pItem = pSlots[index & indexMask];
+	orderMemoryAccesses();
+	firstIndex = index + 1;
+
+	// wake up the producer if it is waiting for this slot
+	if(producerWaiting)
+	{
+		producerWaiting = false;
+		freeSlotEvent.signal();
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::removeFirst
+//
+// Removes an element from the queue.  <pItem> will point to the element removed.
+// If the queue is empty, the consumer task will block until the producer adds an element.
+// Returns true if a timeout occurred, false if an item has been removed.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+Bool IntertaskRingQueue<Element>::removeFirst(Element *pItem, TimeValue timeout)
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	const TimeValue endTime = timeout == infiniteTime ? 0 : pTimer->getTime() + timeout;
+	while(!tryRemoveFirst(pItem))
+	{
+		// ask the producer for a wake up, unless it added an element in the meantime
+		{
+			UninterruptableSection criticalSection;
+			usedSlotEvent.clear();
+			consumerWaiting = true;
+			if(!isEmpty())
+			{
+				consumerWaiting = false;
+				continue;
+			}
+		}
+
+		// sleep until an element has been added
+		if(timeout == infiniteTime)
+		{
+			usedSlotEvent.wait();
+		}
+		else if(usedSlotEvent.waitUntil(endTime, pTimer))
+		{
+			consumerWaiting = false;
+			return true;
+		}
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::removeFirst
+//
+// Removes an element from the queue.
+// If the queue is empty, the consumer task will block until the producer adds an element.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline Element IntertaskRingQueue<Element>::removeFirst()
+{
+	Element item;
+	removeFirst(&item);
+	return item;
+}
+
+//------------------------------------------------------------------------------------------------
+// * IntertaskRingQueue::orderMemoryAccesses
+//
+// Stops the compiler from moving memory accesses across this point.
+// The producer and consumer run on the same processor, so no hardware barrier is needed.
+//------------------------------------------------------------------------------------------------
+
+template<class Element>
+inline void IntertaskRingQueue<Element>::orderMemoryAccesses()
+{
+	#if defined(__ARMCC_VERSION)
+		__schedule_barrier();
+	#elif defined(__GNUC__)
+		__asm__ __volatile__("" : : : "memory");
+	#elif defined(_MSC_VER)
+		_ReadWriteBarrier();
+	#endif
+}
+
+#endif // _IntertaskRingQueue_h_
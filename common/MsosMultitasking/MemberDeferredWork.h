@@ -0,0 +1,46 @@
+#ifndef _MemberDeferredWork_h_
+#define _MemberDeferredWork_h_
+
+#include "DeferredWork.h"
+
+//------------------------------------------------------------------------------------------------
+// * class MemberDeferredWork
+//
+// Used to define deferred work within a class which invokes a single member function.
+//------------------------------------------------------------------------------------------------
+
+#define MemberDeferredWork(WorkName, OuterClass, memberFunction) \
+class WorkName; \
+friend class WorkName; \
+class WorkName : public DeferredWork \
+{ \
+public: \
+	inline WorkName(OuterClass &owner) : \
+		pOwner(&owner) \
+	{ \
+	}; \
+	inline WorkName(OuterClass &owner, DeferredWorkQueue *pQueue) : \
+		DeferredWork(pQueue), \
+		pOwner(&owner) \
+	{ \
+	}; \
+	inline WorkName(OuterClass *pOwner) : \
+		pOwner(pOwner) \
+	{ \
+	}; \
+	inline WorkName(OuterClass *pOwner, DeferredWorkQueue *pQueue) : \
+		DeferredWork(pQueue), \
+		pOwner(pOwner) \
+	{ \
+	}; \
+\
+private:\
+	inline void handleWork() \
+	{ \
+			pOwner->memberFunction(); \
+	}; \
+\
+	OuterClass *pOwner; \
+}
+
+#endif // _MemberDeferredWork_h_
@@ -20,14 +20,24 @@ public: \
 		pOwner(&owner) \
 	{ \
 	}; \
+	inline TaskName(OuterClass &owner, UInt priority, void *pStack, UInt stackSize) : \
+		Task(priority, pStack, stackSize), \
+		pOwner(&owner) \
+	{ \
+	}; \
 	inline TaskName(OuterClass *pOwner, UInt priority, UInt stackSize) : \
 		Task(priority, stackSize), \
 		pOwner(pOwner) \
 	{ \
 	}; \
+	inline TaskName(OuterClass *pOwner, UInt priority, void *pStack, UInt stackSize) : \
+		Task(priority, pStack, stackSize), \
+		pOwner(pOwner) \
+	{ \
+	}; \
 \
 private:\
-	inline void TaskName::main() \
+	inline void main() \
 	{ \
 			pOwner->memberFunction(); \
 	}; \
@@ -53,15 +63,27 @@ public: \
 		parameter(parameter) \
 	{ \
 	}; \
+	inline TaskName(OuterClass &owner, ParameterType parameter, UInt priority, void *pStack, UInt stackSize) : \
+		Task(priority, pStack, stackSize), \
+		pOwner(&owner), \
+		parameter(parameter) \
+	{ \
+	}; \
 	inline TaskName(OuterClass *pOwner, ParameterType parameter, UInt priority, UInt stackSize) : \
 		Task(priority, stackSize), \
 		pOwner(pOwner), \
 		parameter(parameter) \
 	{ \
 	}; \
+	inline TaskName(OuterClass *pOwner, ParameterType parameter, UInt priority, void *pStack, UInt stackSize) : \
+		Task(priority, pStack, stackSize), \
+		pOwner(pOwner), \
+		parameter(parameter) \
+	{ \
+	}; \
 \
 private:\
-	inline void TaskName::main() \
+	inline void main() \
 	{ \
 			pOwner->memberFunction(parameter); \
 	}; \
@@ -0,0 +1,83 @@
+#include "posixInterrupts.h"
+#include "../interrupts.h"
+
+//------------------------------------------------------------------------------------------------
+// * getInterruptSignals
+//
+// Returns the set of signals that are treated as interrupts.
+//------------------------------------------------------------------------------------------------
+
+const sigset_t &getInterruptSignals()
+{
+	// the set is built on first use because interrupts may be disabled during static construction
+	static sigset_t interruptSignals;
+	static Bool initialized = false;
+	if(!initialized)
+	{
+		sigemptyset(&interruptSignals);
+		sigaddset(&interruptSignals, SIGALRM);
+		sigaddset(&interruptSignals, SIGIO);
+		initialized = true;
+	}
+	return interruptSignals;
+}
+
+//------------------------------------------------------------------------------------------------
+// * waitForInterrupt
+//
+// Waits until an interrupt occurs.
+// Interrupts are enabled while waiting, the interrupt state is restored when the
+// interrupt has been handled.
+//------------------------------------------------------------------------------------------------
+
+void waitForInterrupt()
+{
+	// suspend with all the current signals except for interrupts blocked
+	sigset_t waitingSignals;
+	sigprocmask(SIG_BLOCK, null, &waitingSignals);
+	sigdelset(&waitingSignals, SIGALRM);
+	sigdelset(&waitingSignals, SIGIO);
+	sigsuspend(&waitingSignals);
+}
+
+//------------------------------------------------------------------------------------------------
+// * disableInterrupts
+//------------------------------------------------------------------------------------------------
+
+void disableInterrupts()
+{
+	sigprocmask(SIG_BLOCK, &getInterruptSignals(), null);
+}
+
+//------------------------------------------------------------------------------------------------
+// * enableInterrupts
+//------------------------------------------------------------------------------------------------
+
+void enableInterrupts()
+{
+	sigprocmask(SIG_UNBLOCK, &getInterruptSignals(), null);
+}
+
+//------------------------------------------------------------------------------------------------
+// * getInterruptState
+//
+// Returns non-zero if interrupts are disabled.
+//------------------------------------------------------------------------------------------------
+
+UInt getInterruptState()
+{
+	sigset_t blockedSignals;
+	sigprocmask(SIG_BLOCK, null, &blockedSignals);
+	return sigismember(&blockedSignals, SIGALRM);
+}
+
+//------------------------------------------------------------------------------------------------
+// * setInterruptState
+//
+// Disables interrupts if <state> is non-zero, enables them otherwise.
+//------------------------------------------------------------------------------------------------
+
+void setInterruptState(UInt state)
+{
+	sigprocmask(state != 0 ? SIG_BLOCK : SIG_UNBLOCK, &getInterruptSignals(), null);
+}
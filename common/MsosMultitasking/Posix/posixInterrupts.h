@@ -0,0 +1,18 @@
+#ifndef _posixInterrupts_h_
+#define _posixInterrupts_h_
+
+#include "../../cPrimitiveTypes.h"
+#include <signal.h>
+
+//------------------------------------------------------------------------------------------------
+// POSIX interrupt emulation
+//
+// Signals are used in place of hardware interrupts.
+// Interrupts are disabled by blocking the signals and enabled by unblocking them.
+// The interrupt state is non-zero while interrupts are disabled.
+//------------------------------------------------------------------------------------------------
+
+const sigset_t &getInterruptSignals();
+void waitForInterrupt();
+
+#endif // _posixInterrupts_h_
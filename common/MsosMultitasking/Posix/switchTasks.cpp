@@ -0,0 +1,71 @@
+#include "switchTasks.h"
+
+//------------------------------------------------------------------------------------------------
+// * switchTasks
+//
+// Switches tasks.
+// The current task's stack pointer is saved in <*ppFromStack>.
+// The new task's stack pointer is taken from <*ppToStack>.
+// Only the registers preserved across calls by the System V x86-64 ABI need to be saved,
+// the caller has already saved all others.
+//------------------------------------------------------------------------------------------------
+
+asm
+(
+	"	.text\n"
+	"	.globl	switchTasks\n"
+	"	.type	switchTasks, @function\n"
+	"switchTasks:\n"
+
+	// save all registers of the current task
+	"	pushq	%rbp\n"
+	"	pushq	%rbx\n"
+	"	pushq	%r12\n"
+	"	pushq	%r13\n"
+	"	pushq	%r14\n"
+	"	pushq	%r15\n"
+	"	subq	$8, %rsp\n"
+	"	stmxcsr	(%rsp)\n"
+	"	fnstcw	4(%rsp)\n"
+
+	// save the current task's stack pointer
+	"	movq	%rsp, (%rdi)\n"
+
+	// get the new task's stack pointer
+	"	movq	(%rsi), %rsp\n"
+
+	// restore all registers of the new task and return
+	"	ldmxcsr	(%rsp)\n"
+	"	fldcw	4(%rsp)\n"
+	"	addq	$8, %rsp\n"
+	"	popq	%r15\n"
+	"	popq	%r14\n"
+	"	popq	%r13\n"
+	"	popq	%r12\n"
+	"	popq	%rbx\n"
+	"	popq	%rbp\n"
+	"	ret\n"
+	"	.size	switchTasks, .-switchTasks\n"
+);
+
+//------------------------------------------------------------------------------------------------
+// * beginTask
+//
+// The first code executed by a new task, switchTasks() returns here.
+// The new task's stack is setup with its receiver (this pointer) in r12 and
+// its entry function in r13.
+// Interrupts are enabled before calling the entry function.
+//------------------------------------------------------------------------------------------------
+
+asm
+(
+	"	.text\n"
+	"	.globl	beginTask\n"
+	"	.type	beginTask, @function\n"
+	"beginTask:\n"
+	"	call	enableInterrupts\n"
+	"	movq	%r12, %rdi\n"
+	"	call	*%r13\n"
+	"	ud2\n"
+	"	.size	beginTask, .-beginTask\n"
+);
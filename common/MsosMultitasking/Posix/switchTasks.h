@@ -0,0 +1,10 @@
+#ifndef _switchTasks_h_
+#define _switchTasks_h_
+
+extern "C"
+{
+	void switchTasks(void **ppFromStack, void *const *ppToStack);
+	void beginTask();
+}
+
+#endif // _switchTasks_h_
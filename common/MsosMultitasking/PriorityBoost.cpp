@@ -12,7 +12,7 @@
 void PriorityBoost::waitTask(Task *pTask)
 {
 	// increase the current task's priority
-	const UInt currentPriority = pTask->getPriority();
+	const UInt currentPriority = pTask->getBasePriority();
 	pTask->setPriority(lockingPriority);
 	savedPriority = currentPriority;
 }
@@ -18,8 +18,7 @@ void PriorityMutex::waitTask(Task *pTask)
 	if(pLockingTask == null)
 	{
 		// this mutex is not locked, the current task can lock it
-		pLockingTask = pTask;
-		lockingTaskOriginalPriority = pTask->getPriority();
+		setLockingTask(pTask);
 		++lockCount;
 	}
 	else if(pLockingTask == pTask)
@@ -28,16 +27,11 @@ void PriorityMutex::waitTask(Task *pTask)
 		++lockCount;
 	}
 	else
-	{		
-		// this mutex has already been locked by another task, block the current task
+	{
+		// this mutex has already been locked by another task, block the current task,
+		// the locking task will inherit its priority as it is added to the waiting tasks
+		pTask->pBlockingMutex = this;
 		blockTask(pTask);
-
-		// check if current task has a higher priority than the locking task
-		if (pTask->getPriority() > lockingTaskOriginalPriority)
-		{
-			// bump up the priority of the locking task
-			pLockingTask->setPriority(pTask->getPriority());
-		}
 	}
 }
 
@@ -47,7 +41,8 @@ void PriorityMutex::waitTask(Task *pTask)
 // Unlocks this mutex and unblocks an awaiting task (if any).
 // If this mutex had been locked recursively by a single task, the mutex will not become unlocked
 // until the task calls unlock() as many times as it had called lock().
-// The original priority of the locking task is restored (if it was bumped up).
+// The locking task loses any priority it inherited through this mutex, but keeps any it has
+// inherited through other mutexes that it still holds.
 //------------------------------------------------------------------------------------------------
 
 void PriorityMutex::signal()
@@ -55,23 +50,181 @@ void PriorityMutex::signal()
 	UninterruptableSection criticalSection;
 	if(--lockCount == 0)
 	{
-		// restore the locking task's original priority
-		if (pLockingTask->getPriority() != lockingTaskOriginalPriority)
+		// the last recursive lock has been undone
+		Task *pUnlockingTask = pLockingTask;
+		clearLockingTask();
+
+		// check if there are any other tasks blocked
+		if(!isEmpty())
 		{
-			pLockingTask->setPriority(lockingTaskOriginalPriority);
+			// lock the mutex by the highest priority waiting task,
+			// it inherits the priority of any tasks that are left waiting as it is unblocked
+			Task *pTask = getFirstTask();
+			pTask->pBlockingMutex = null;
+			setLockingTask(pTask);
+			++lockCount;
+			unblockTask();
 		}
-		
-		// the last recursive lock has been undone, check if there are any other tasks blocked
-		if(isEmpty())
+
+		// restore the unlocking task's priority
+		updatePriority(pUnlockingTask);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * PriorityMutex::addTask
+//
+// Adds the specified <pTask> to the waiting tasks in priority order.
+// The locking task's priority is updated as it may have to inherit the priority of <pTask>.
+//------------------------------------------------------------------------------------------------
+
+void PriorityMutex::addTask(Task *pTask)
+{
+	TaskBlocker::addTask(pTask);
+	updatePriority(pLockingTask);
+}
+
+//------------------------------------------------------------------------------------------------
+// * PriorityMutex::removeTask
+//
+// Removes the specified <pTask> from the waiting tasks.
+// The locking task's priority is updated as it may have inherited the priority of <pTask>,
+// which happens when <pTask> times-out or is suspended.
+//------------------------------------------------------------------------------------------------
+
+void PriorityMutex::removeTask(Task *pTask)
+{
+	TaskBlocker::removeTask(pTask);
+	updatePriority(pLockingTask);
+}
+
+//------------------------------------------------------------------------------------------------
+// * PriorityMutex::setLockingTask
+//
+// Makes <pTask> the locking task and adds this mutex to the mutexes that it holds.
+//------------------------------------------------------------------------------------------------
+
+void PriorityMutex::setLockingTask(Task *pTask)
+{
+	pLockingTask = pTask;
+	pNextHeldMutex = pTask->pFirstHeldMutex;
+	pTask->pFirstHeldMutex = this;
+}
+
+//------------------------------------------------------------------------------------------------
+// * PriorityMutex::clearLockingTask
+//
+// Removes this mutex from the mutexes held by the locking task, leaving it with no locking task.
+//------------------------------------------------------------------------------------------------
+
+void PriorityMutex::clearLockingTask()
+{
+	PriorityMutex **ppMutex = &pLockingTask->pFirstHeldMutex;
+	while(*ppMutex != this)
+	{
+		ppMutex = &(*ppMutex)->pNextHeldMutex;
+	}
+	*ppMutex = pNextHeldMutex;
+	pNextHeldMutex = null;
+	pLockingTask = null;
+}
+
+//------------------------------------------------------------------------------------------------
+// * PriorityMutex::updatePriority
+//
+// Recalculates the priority of <pTask> from its base priority and the highest priority task
+// waiting for each of the priority mutexes that it holds.
+// If the priority changes and <pTask> is waiting for a priority mutex itself, the change is
+// passed along to that mutex's locking task, and so on along the chain of blocked tasks.
+//------------------------------------------------------------------------------------------------
+
+void PriorityMutex::updatePriority(Task *pTask)
+{
+	UninterruptableSection criticalSection;
+	if(pTask == null)
+	{
+		return;
+	}
+
+	// the waiting tasks are reordered while walking a chain, and the timer may time out a task
+	// waiting for another priority mutex meanwhile, which must not start another walk, the
+	// update is left for the walk in progress to finish instead
+	if(updatingPriorities)
+	{
+		if(!pTask->priorityUpdatePending)
 		{
-			// the mutex remains unlocked
-			pLockingTask = null;
+			pTask->priorityUpdatePending = true;
+			pTask->pNextPendingPriorityUpdate = pFirstPendingPriorityUpdate;
+			pFirstPendingPriorityUpdate = pTask;
+		}
+		return;
+	}
+	updatingPriorities = true;
+
+	// walk the chain, and then the chains of any updates left pending by that walk
+	while(pTask != null)
+	{
+		updateChainPriorities(pTask);
+
+		pTask = pFirstPendingPriorityUpdate;
+		if(pTask != null)
+		{
+			pFirstPendingPriorityUpdate = pTask->pNextPendingPriorityUpdate;
+			pTask->pNextPendingPriorityUpdate = null;
+			pTask->priorityUpdatePending = false;
+		}
+	}
+
+	updatingPriorities = false;
+}
+
+//------------------------------------------------------------------------------------------------
+// * PriorityMutex::updateChainPriorities
+//
+// Updates the priority of <pTask>, and of the tasks along the chain of blocked tasks after it,
+// as long as they change.
+//------------------------------------------------------------------------------------------------
+
+void PriorityMutex::updateChainPriorities(Task *pTask)
+{
+	for(UInt depth = 0; pTask != null && depth < maximumInheritanceDepth; ++depth)
+	{
+		// find the highest priority that the task should run at
+		UInt priority = pTask->getBasePriority();
+		for(const PriorityMutex *pMutex = pTask->pFirstHeldMutex;
+			pMutex != null;
+			pMutex = pMutex->pNextHeldMutex)
+		{
+			if(!pMutex->isEmpty() && pMutex->getFirstTask()->getPriority() > priority)
+			{
+				priority = pMutex->getFirstTask()->getPriority();
+			}
+		}
+
+		// the rest of the chain is up to date if the priority has not changed
+		if(priority == pTask->getPriority())
+		{
+			break;
+		}
+		pTask->changePriority(priority);
+
+		// check if the task is waiting for a priority mutex
+		PriorityMutex *pBlockingMutex = pTask->pBlockingMutex;
+		if(pBlockingMutex != null && pTask->pGroup == pBlockingMutex)
+		{
+			// pass the change along to the task that holds it
+			pTask = pBlockingMutex->pLockingTask;
 		}
 		else
 		{
-			// lock the mutex by the next waiting task
-			pLockingTask = unblockTask();
-			++lockCount;
+			pTask = null;
 		}
 	}
 }
+
+//------------------------------------------------------------------------------------------------
+// * PriorityMutex static variables
+//------------------------------------------------------------------------------------------------
+
+Bool PriorityMutex::updatingPriorities = false;
+Task *PriorityMutex::pFirstPendingPriorityUpdate = null;
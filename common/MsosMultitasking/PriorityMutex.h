@@ -12,6 +12,10 @@ class Task;
 // A mutex allows only a single task to recursively lock it.
 // This type of mutex handles priority inversion by temporarily bumping up the locking task's
 // priority to that of the highest waiting task's priority.
+// The priority is inherited transitively, if the locking task is itself waiting for another
+// priority mutex then that mutex's locking task is bumped up too. A task that holds several
+// priority mutexes runs at the highest priority of all of their waiting tasks.
+// When unlocked, the mutex is handed to the highest priority waiting task.
 //------------------------------------------------------------------------------------------------
 
 class PriorityMutex : public TaskBlocker
@@ -27,13 +31,36 @@ public:
 	void signal();
 
 private:
+	// limits
+	enum
+	{
+		// the longest chain of blocked tasks that a priority change is passed along,
+		// this also stops a deadlocked cycle of tasks from being walked forever
+		maximumInheritanceDepth = 16
+	};
+
 	// synchronizing
 	void waitTask(Task *pTask);
 
+	// modifying the waiting tasks
+	void addTask(Task *pTask);
+	void removeTask(Task *pTask);
+
+	// modifying the locking task
+	void setLockingTask(Task *pTask);
+	void clearLockingTask();
+
+	// priority inheritance
+	static void updatePriority(Task *pTask);
+	static void updateChainPriorities(Task *pTask);
+	friend class Task;
+
 	// represenation
 	UInt lockCount;
 	Task *pLockingTask;
-	UInt lockingTaskOriginalPriority;
+	PriorityMutex *pNextHeldMutex;
+	static Bool updatingPriorities;
+	static Task *pFirstPendingPriorityUpdate;
 };
 
 //------------------------------------------------------------------------------------------------
@@ -46,6 +73,7 @@ inline PriorityMutex::PriorityMutex()
 {
 	lockCount = 0;
 	pLockingTask = null;
+	pNextHeldMutex = null;
 }
 
 //------------------------------------------------------------------------------------------------
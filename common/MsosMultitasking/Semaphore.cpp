@@ -38,3 +38,37 @@ void Semaphore::signal()
 		unblockTask();
 	}
 }
+
+//------------------------------------------------------------------------------------------------
+// * Semaphore::signalMany
+//
+// Signals this semaphore <count> times.
+// Each signal unblocks an awaiting task (if any), but any task switch happens only once.
+//------------------------------------------------------------------------------------------------
+
+void Semaphore::signalMany(UInt count)
+{
+	UninterruptableSection criticalSection;
+	while(count != 0 && !isEmpty())
+	{
+		unblockTask();
+		--count;
+	}
+	excessSignalCount += count;
+}
+
+//------------------------------------------------------------------------------------------------
+// * Semaphore::tryWaitMany
+//
+// Waits on this semaphore up to <maximumCount> times, but only as many times as it has been
+// signalled, so this never blocks.
+// Returns the number of waits done.
+//------------------------------------------------------------------------------------------------
+
+UInt Semaphore::tryWaitMany(UInt maximumCount)
+{
+	UninterruptableSection criticalSection;
+	const UInt count = minimum(excessSignalCount, maximumCount);
+	excessSignalCount -= count;
+	return count;
+}
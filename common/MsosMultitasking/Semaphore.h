@@ -24,6 +24,8 @@ public:
 
 	// synchronizing
 	void signal();
+	void signalMany(UInt count);
+	UInt tryWaitMany(UInt maximumCount);
 
 private:
 	// synchronizing
@@ -1,28 +1,78 @@
 #include "Task.h"
 #include "TaskBlocker.h"
 #include "IntertaskEvent.h"
+#include "PriorityMutex.h"
 #include "UninterruptableSection.h"
 #include "interrupts.h"
 #include "../pointerArithmetic.h"
 #include "../memoryUtilities.h"
+#if defined(__x86_64__) && defined(__linux__)
+	#include "Posix/switchTasks.h"
+#endif
 #if defined(INCLUDE_DEBUGGER)
 	#include "arm/RemoteDebuggerAgent.h"
 #endif
+#if defined(USE_HEAP_PROFILING)
+	#include "../ArmRuntime/runtime.h"
+#endif
 
 //------------------------------------------------------------------------------------------------
 // * Task::Task
 //
 // Constructs a new task given its <priority> level and <stackSize> in bytes.
+// The stack is allocated on the heap.
 //------------------------------------------------------------------------------------------------
 
 Task::Task(UInt priority, UInt stackSize)
+{
+	initialize(priority, new UInt8[stackSize], stackSize, true);
+}
+
+//------------------------------------------------------------------------------------------------
+// * Task::Task
+//
+// Constructs a new task given its <priority> level and a stack of <stackSize> bytes at <pStack>.
+// The stack must be aligned to 8 bytes and must remain valid until the task is destroyed,
+// it is not freed by the task.
+//------------------------------------------------------------------------------------------------
+
+Task::Task(UInt priority, void *pStack, UInt stackSize)
+{
+	initialize(priority, pStack, stackSize, false);
+}
+
+//------------------------------------------------------------------------------------------------
+// * Task::initialize
+//
+// Sets up a new task to run on the given stack.
+//------------------------------------------------------------------------------------------------
+
+void Task::initialize(UInt priority, void *pStack, UInt stackSize, Bool ownsStack)
 {
 	// initialize instance variables
 	this->priority = priority;
-	pStack = new UInt8[stackSize];
+	basePriority = priority;
+	this->pStack = pStack;
+	this->stackSize = stackSize;
+	this->ownsStack = ownsStack;
 	pStackTop = addToPointer(pStack, stackSize);
 	suspendCount = 1;
 	pGroup = getScheduler();
+	pFirstHeldMutex = null;
+	pBlockingMutex = null;
+	pNextPendingPriorityUpdate = null;
+	priorityUpdatePending = false;
+	#if defined(USE_TASK_STATISTICS)
+		memoryZero(&statistics, sizeof(statistics));
+		readyTime = 0;
+		switchInTime = 0;
+		yielding = false;
+	#endif
+
+	#if defined(USE_STACK_PAINTING)
+		// fill the stack so that the parts that have been used can be found later
+		memorySet(pStack, stackPaintValue, stackSize);
+	#endif
 
 	// define the task entry point
 	typedef void (Task::*EntryFunction)();
@@ -104,6 +154,39 @@ Task::Task(UInt priority, UInt stackSize)
 		((InitialStackLayout *)pStackTop)->status = getInterruptState();
 		((InitialStackLayout *)pStackTop)->eip = *(UInt *)&entryFunction;
 	
+	#elif defined(__x86_64__) && defined(__linux__)
+		// Intel 80x86 64-bit processor under Linux
+		struct InitialStackLayout
+		{
+			// processor state restored by switchTasks()
+			UInt32 mxcsr;
+			UInt16 fpuControlWord;
+			UInt16 unused;
+			UInt64 r15;
+			UInt64 r14;
+			UInt64 r13; // entry function
+			UInt64 r12; // receiver (this pointer)
+			UInt64 rbx;
+			UInt64 rbp;
+			void *returnAddress; // beginTask() function
+
+			// keep the stack aligned to 16 bytes for calls made by beginTask()
+			UInt64 callAlignment[2];
+		};
+
+		// align the top of the stack to 16 bytes and push all zeros on the stack
+		pStackTop = subtractFromPointer(pStackTop, (UInt64)pStackTop & 15);
+		pStackTop = subtractFromPointer(pStackTop, sizeof(InitialStackLayout));
+		memorySet(pStackTop, 0, sizeof(InitialStackLayout));
+
+		// set all other values, switching to this task will call beginTask()
+		// which enables interrupts and then calls entry()
+		((InitialStackLayout *)pStackTop)->mxcsr = 0x1F80;
+		((InitialStackLayout *)pStackTop)->fpuControlWord = 0x037F;
+		((InitialStackLayout *)pStackTop)->r13 = *(UInt64 *)&entryFunction;
+		((InitialStackLayout *)pStackTop)->r12 = (UInt64)this;
+		((InitialStackLayout *)pStackTop)->returnAddress = (void *)&beginTask;
+
 	#elif defined(_MSC_VER) && defined(_M_ARM) || defined(__ARMCC_VERSION)
 		// ARM processor
 
@@ -160,16 +243,39 @@ Task::~Task()
 	// make sure this task is not running
 	suspend();
 
-	delete[] (UInt8 *)pStack;
+	#if defined(USE_HEAP_PROFILING)
+		// let another task have the heap profile entry of this one
+		heapProfile.releaseOwner(this);
+	#endif
+
+	// a stack supplied by the creator of this task belongs to them
+	if(ownsStack)
+	{
+		delete[] (UInt8 *)pStack;
+	}
 }
 
 //------------------------------------------------------------------------------------------------
 // * Task::setPriority
 //
-// Changes the <priority> level of this task.
+// Changes the base <priority> level of this task.
+// The task keeps running at any higher priority that it has inherited through a PriorityMutex.
 //------------------------------------------------------------------------------------------------
 
 void Task::setPriority(UInt priority)
+{
+	UninterruptableSection criticalSection;
+	basePriority = priority;
+	PriorityMutex::updatePriority(this);
+}
+
+//------------------------------------------------------------------------------------------------
+// * Task::changePriority
+//
+// Changes the <priority> level that this task is scheduled at.
+//------------------------------------------------------------------------------------------------
+
+void Task::changePriority(UInt priority)
 {
 	UninterruptableSection criticalSection;
 	const Bool wasSuspended = isSuspended();
@@ -184,6 +290,47 @@ void Task::setPriority(UInt priority)
 	}
 }
 
+//------------------------------------------------------------------------------------------------
+// * Task::getStatistics
+//
+// Returns the processor time accounting of this task.
+// The time the task has been running for since it was last switched to is included.
+//------------------------------------------------------------------------------------------------
+
+#if defined(USE_TASK_STATISTICS)
+	TaskStatistics Task::getStatistics() const
+	{
+		UninterruptableSection criticalSection;
+		TaskStatistics currentStatistics = statistics;
+		if(getScheduler()->getCurrentTask() == this)
+		{
+			currentStatistics.runTickCount +=
+				compareTimes(getScheduler()->getStatisticsTime(), switchInTime);
+		}
+		return currentStatistics;
+	}
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * Task::getPeakStackUsage
+//
+// Returns the largest number of bytes of this task's stack that have been used so far.
+// The stack grows down, so this is found from the lowest byte that has been written to.
+//------------------------------------------------------------------------------------------------
+
+#if defined(USE_STACK_PAINTING)
+	UInt Task::getPeakStackUsage() const
+	{
+		const UInt8 *pStackBytes = (const UInt8 *)pStack;
+		UInt unusedSize = 0;
+		while(unusedSize < stackSize && pStackBytes[unusedSize] == stackPaintValue)
+		{
+			++unusedSize;
+		}
+		return stackSize - unusedSize;
+	}
+#endif
+
 //------------------------------------------------------------------------------------------------
 // * Task::suspend
 //
@@ -235,11 +382,22 @@ void Task::resume()
 
 void Task::yield()
 {
-	UninterruptableSection criticalSection;
-	if(!isSuspended())
+	#if defined(USE_TASK_STATISTICS)
+		// a switch away from this task while yielding is voluntary
+		yielding = true;
+	#endif
+
 	{
-		pGroup->yieldTask(this);
+		UninterruptableSection criticalSection;
+		if(!isSuspended())
+		{
+			pGroup->yieldTask(this);
+		}
 	}
+
+	#if defined(USE_TASK_STATISTICS)
+		yielding = false;
+	#endif
 }
 
 //------------------------------------------------------------------------------------------------
@@ -3,14 +3,20 @@
 
 #include "../cPrimitiveTypes.h"
 #include "../Collections/Link.h"
+#if defined(USE_TASK_STATISTICS)
+	#include "TaskStatistics.h"
+#endif
 class TaskGroup;
 class TaskScheduler;
 class TaskBlocker;
+class PriorityMutex;
 
 //------------------------------------------------------------------------------------------------
 // * class Task
 //
 // An instance of this class represents an asynchronous task executed by the processor.
+// Define USE_TASK_STATISTICS to account for the processor time used by each task.
+// Define USE_STACK_PAINTING to fill stacks with a known value so that their peak usage can be found.
 //------------------------------------------------------------------------------------------------
 
 class Task : public Link
@@ -27,11 +33,13 @@ public:
 
 		defaultPriority = mediumPriority,
 		normalPriority = mediumPriority,
-		debuggerPriority = realtimePriority - 1
+		debuggerPriority = realtimePriority - 1,
+		deferredWorkPriority = realtimePriority + 10 * 1000000
 	};
 
 	// constructors and destructors
 	Task(UInt priority, UInt stackSize);
+	Task(UInt priority, void *pStack, UInt stackSize);
 	virtual ~Task();
 
 	// testing
@@ -41,7 +49,15 @@ public:
 	// accessing
 	inline TaskScheduler *getScheduler() const;
 	inline UInt getPriority() const;
+	inline UInt getBasePriority() const;
 	void setPriority(UInt priority);
+	#if defined(USE_TASK_STATISTICS)
+		TaskStatistics getStatistics() const;
+	#endif
+	inline UInt getStackSize() const;
+	#if defined(USE_STACK_PAINTING)
+		UInt getPeakStackUsage() const;
+	#endif
 
 	// behaviour
 	void suspend();
@@ -61,18 +77,43 @@ protected:
 	virtual void main() = 0;
 
 private:
+	// types
+	#if defined(USE_STACK_PAINTING)
+		static const UInt8 stackPaintValue = 0xA5;
+	#endif
+
+	// initialization
+	void initialize(UInt priority, void *pStack, UInt stackSize, Bool ownsStack);
+
 	// hidden entry point
 	void entry();
 
+	// priority inheritance
+	void changePriority(UInt priority);
+
 	// representation
 	void *pStack;
 	void *pStackTop;
+	UInt stackSize;
+	Bool ownsStack;
 	UInt priority;
+	UInt basePriority;
 	UInt suspendCount;
 	TaskGroup *pGroup;
+	PriorityMutex *pFirstHeldMutex;
+	PriorityMutex *pBlockingMutex;
+	Task *pNextPendingPriorityUpdate;
+	Bool priorityUpdatePending;
+	#if defined(USE_TASK_STATISTICS)
+		TaskStatistics statistics;
+		TimeValue readyTime;
+		TimeValue switchInTime;
+		Bool yielding;
+	#endif
 
 	// friends
 	friend class TaskScheduler;
+	friend class PriorityMutex;
 	friend class RemoteDebuggerAgent;
 };
 
@@ -104,6 +145,8 @@ inline Bool Task::isBlocked() const
 // * Task::getPriority
 //
 // Returns the priority level of this task.
+// This may be higher than the base priority while the task holds a PriorityMutex that a higher
+// priority task is waiting for.
 //------------------------------------------------------------------------------------------------
 
 inline UInt Task::getPriority() const
@@ -111,6 +154,17 @@ inline UInt Task::getPriority() const
 	return priority;
 }
 
+//------------------------------------------------------------------------------------------------
+// * Task::getBasePriority
+//
+// Returns the priority level that was given to this task, ignoring any inherited priority.
+//------------------------------------------------------------------------------------------------
+
+inline UInt Task::getBasePriority() const
+{
+	return basePriority;
+}
+
 //------------------------------------------------------------------------------------------------
 // * Task::getScheduler
 //
@@ -133,6 +187,17 @@ inline Task *Task::getPreviousTask() const
 	return (Task *)Link::getPrevious();
 }
 
+//------------------------------------------------------------------------------------------------
+// * Task::getStackSize
+//
+// Returns the size of this task's stack in bytes.
+//------------------------------------------------------------------------------------------------
+
+inline UInt Task::getStackSize() const
+{
+	return stackSize;
+}
+
 //------------------------------------------------------------------------------------------------
 // * Task::getNextTask
 //
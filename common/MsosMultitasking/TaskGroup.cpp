@@ -11,6 +11,29 @@ TaskGroup::~TaskGroup()
 {
 }
 
+//------------------------------------------------------------------------------------------------
+// * TaskGroup::addTask
+//
+// Adds the specified <pTask> to the queue in priority order.
+// The <pTask> will be added after any tasks of equal priority.
+//------------------------------------------------------------------------------------------------
+
+void TaskGroup::addTask(Task *pTask)
+{
+	LinkedList::addSorted(pTask, &TaskGroup::compareTasks);
+}
+
+//------------------------------------------------------------------------------------------------
+// * TaskGroup::removeTask
+//
+// Removes the specified <pTask> from the queue.
+//------------------------------------------------------------------------------------------------
+
+void TaskGroup::removeTask(Task *pTask)
+{
+	LinkedList::remove(pTask);
+}
+
 //------------------------------------------------------------------------------------------------
 // * TaskGroup::compareTasks
 //
@@ -30,6 +53,8 @@ SInt TaskGroup::compareTasks(const Link *pTask1, const Link *pTask2)
 
 void TaskGroup::suspendTask(Task *pTask)
 {
+	// unused argument
+	pTask = pTask;
 }
 
 //------------------------------------------------------------------------------------------------
@@ -40,6 +65,8 @@ void TaskGroup::suspendTask(Task *pTask)
 
 void TaskGroup::resumeTask(Task *pTask)
 {
+	// unused argument
+	pTask = pTask;
 }
 
 //------------------------------------------------------------------------------------------------
@@ -25,8 +25,8 @@ public:
 	inline Task *getFirstTask() const;
 
 	// modifying task priority queue
-	inline void addTask(Task *pTask);
-	inline void removeTask(Task *pTask);
+	virtual void addTask(Task *pTask);
+	virtual void removeTask(Task *pTask);
 	inline Task *removeFirstTask();
 
 	// controlling tasks
@@ -73,38 +73,22 @@ inline Task *TaskGroup::getFirstTask() const
 	return (Task *)LinkedList::getFirst();
 }
 
-//------------------------------------------------------------------------------------------------
-// * TaskGroup::addTask
-//
-// Adds the specified <pTask> to the queue in priority order.
-// The <pTask> will be added after any tasks of equal priority.
-//------------------------------------------------------------------------------------------------
-
-inline void TaskGroup::addTask(Task *pTask)
-{
-	LinkedList::addSorted(pTask, &TaskGroup::compareTasks);
-}
-
-//------------------------------------------------------------------------------------------------
-// * TaskGroup::removeTask
-//
-// Removes the specified <pTask> from the queue.
-//------------------------------------------------------------------------------------------------
-
-inline void TaskGroup::removeTask(Task *pTask)
-{
-	LinkedList::remove(pTask);
-}
-
 //------------------------------------------------------------------------------------------------
 // * TaskGroup::removeFirstTask
 //
 // Removes the highest priority task from the queue.
+// Returns null if the queue is empty.
 //------------------------------------------------------------------------------------------------
 
 inline Task *TaskGroup::removeFirstTask()
 {
-	return (Task *)LinkedList::removeFirst();
+	// the removeTask of a derived group may look at the task, so never pass it null
+	Task *pTask = getFirstTask();
+	if(pTask != null)
+	{
+		removeTask(pTask);
+	}
+	return pTask;
 }
 
 #endif // _TaskGroup_h_
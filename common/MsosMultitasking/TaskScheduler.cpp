@@ -1,5 +1,8 @@
 #include "TaskScheduler.h"
 #include "IdleTask.h"
+#include "DeferredWorkQueue.h"
+#include "TimeSliceInterval.h"
+#include "Timer.h"
 #include "interrupts.h"
 
 #if (defined(_MSC_VER) && defined(_M_IX86)) || defined(__i386__)
@@ -12,6 +15,12 @@
 	#define SWITCH_TASKS_USING_SWI
 	//#define SWITCH_TASKS_USING_IRQ
 	//#define SWITCH_TASKS_USING_FIQ
+#elif defined(__x86_64__) && defined(__linux__)
+	// Intel 80x86 64-bit processor under Linux, signals are used as interrupts
+	#include "Posix/posixInterrupts.h"
+	#include "Posix/switchTasks.h"
+	#include "../memoryUtilities.h"
+	#include <errno.h>
 #else
 	#error "unknown platform"
 #endif
@@ -28,6 +37,10 @@ TaskScheduler::TaskScheduler()
 {
 	// initialize instance variables
 	pCurrentTask = null;
+	pDeferredWorkQueue = null;
+	pTimeSliceInterval = null;
+	timeSlice = 0;
+	pTimeSlicedTask = null;
 	unpreemptableSectionEntryCount = 1;
 	uninterruptableSectionEntryCount = 0;
 
@@ -53,6 +66,17 @@ TaskScheduler::TaskScheduler()
 			oldSoftwareInterruptHandler = getExceptionHandler(softwareInterruptVectorIndex);
 			setExceptionHandler(softwareInterruptVectorIndex, &handleSoftwareInterrupt);
 		#endif
+	#elif defined(__x86_64__) && defined(__linux__)
+		// Intel 80x86 64-bit processor under Linux
+
+		// handle interrupt signals, all interrupts are disabled while one is being handled
+		struct sigaction action;
+		memoryZero(&action, sizeof(action));
+		action.sa_handler = &handleSignal;
+		action.sa_mask = getInterruptSignals();
+		action.sa_flags = SA_RESTART;
+		sigaction(SIGALRM, &action, null);
+		sigaction(SIGIO, &action, null);
 	#else
 		#error "unknown platform"
 	#endif
@@ -78,9 +102,17 @@ TaskScheduler::~TaskScheduler()
 		#if defined(SWITCH_TASKS_USING_SWI)
 			setExceptionHandler(softwareInterruptVectorIndex, oldSoftwareInterruptHandler);
 		#endif
+	#elif defined(__x86_64__) && defined(__linux__)
+		// Intel 80x86 64-bit processor under Linux
+
+		// stop handling interrupt signals
+		signal(SIGALRM, SIG_DFL);
+		signal(SIGIO, SIG_DFL);
 	#else
 		#error "unknown platform"
 	#endif
+
+	delete pDeferredWorkQueue;
 }
 
 //------------------------------------------------------------------------------------------------
@@ -144,6 +176,10 @@ void TaskScheduler::schedule()
 		// check if the currently running task is not the highest priority task
 		if(getCurrentTask() != getFirstTask())
 		{
+			#if defined(USE_TASK_STATISTICS)
+				recordTaskSwitch(getCurrentTask(), getFirstTask());
+			#endif
+
 			if(getCurrentTask() == null)
 			{
 				// start the very first task
@@ -160,6 +196,263 @@ void TaskScheduler::schedule()
 	#endif
 }
 
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::getDeferredWorkQueue
+//
+// Returns the queue that handles the work deferred by interrupt handlers, unless the work names
+// a queue of its own. The queue is created the first time it is asked for, so images without
+// deferred work don't pay for its task, this must be called from a task rather than from an
+// interrupt handler.
+//------------------------------------------------------------------------------------------------
+
+DeferredWorkQueue *TaskScheduler::getDeferredWorkQueue()
+{
+	if(pDeferredWorkQueue == null)
+	{
+		// allocate the queue before disabling interrupts, the heap may block on its mutex
+		DeferredWorkQueue *pNewDeferredWorkQueue = new DeferredWorkQueue();
+		{
+			UninterruptableSection criticalSection;
+
+			// another task may have created the queue in the meantime
+			if(pDeferredWorkQueue == null)
+			{
+				pDeferredWorkQueue = pNewDeferredWorkQueue;
+				pNewDeferredWorkQueue = null;
+			}
+		}
+
+		if(pNewDeferredWorkQueue == null)
+		{
+			pDeferredWorkQueue->resume();
+		}
+		else
+		{
+			// free a queue that was not needed
+			delete pNewDeferredWorkQueue;
+		}
+	}
+	return pDeferredWorkQueue;
+}
+
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::setTimeSlice
+//
+// Changes the number of timer ticks a task may run for before the next ready task of equal
+// priority is run. Zero disables time slicing, which is the default.
+// The time slice is only timed while more than one task is ready at the top priority.
+//------------------------------------------------------------------------------------------------
+
+void TaskScheduler::setTimeSlice(TimeValue tickCount)
+{
+	// time slicing needs a timer
+	Timer *pTimer = getTimer();
+	if(pTimer == null)
+	{
+		return;
+	}
+
+	// allocate the interval before disabling interrupts, the heap may block on its mutex
+	TimeSliceInterval *pNewTimeSliceInterval = null;
+	if(pTimeSliceInterval == null)
+	{
+		pNewTimeSliceInterval = new TimeSliceInterval(*pTimer);
+	}
+
+	{
+		UninterruptableSection criticalSection;
+
+		// another task may have started time slicing in the meantime
+		if(pTimeSliceInterval == null)
+		{
+			pTimeSliceInterval = pNewTimeSliceInterval;
+			pNewTimeSliceInterval = null;
+		}
+
+		// start a new time slice
+		timeSlice = tickCount;
+		pTimeSlicedTask = null;
+		updateTimeSlice();
+	}
+
+	// free an interval that was not needed
+	delete pNewTimeSliceInterval;
+}
+
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::isTimingTimeSlice
+//
+// Tests whether the time slice of the first ready task is being timed, which only happens
+// while it shares the top priority with another ready task.
+//------------------------------------------------------------------------------------------------
+
+Bool TaskScheduler::isTimingTimeSlice() const
+{
+	return pTimeSliceInterval != null && !pTimeSliceInterval->isExpired();
+}
+
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::addTask
+//
+// Adds the specified <pTask> to the ready tasks.
+//------------------------------------------------------------------------------------------------
+
+void TaskScheduler::addTask(Task *pTask)
+{
+	#if defined(USE_TASK_STATISTICS)
+		// the task is ready from now on, unless it is already running
+		if(isInitialized() && pTask != getCurrentTask())
+		{
+			pTask->readyTime = getStatisticsTime();
+		}
+	#endif
+
+	ReadyTaskGroup::addTask(pTask);
+	updateTimeSlice();
+}
+
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::removeTask
+//
+// Removes the specified <pTask> from the ready tasks.
+//------------------------------------------------------------------------------------------------
+
+void TaskScheduler::removeTask(Task *pTask)
+{
+	ReadyTaskGroup::removeTask(pTask);
+	updateTimeSlice();
+}
+
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::updateTimeSlice
+//
+// Starts timing a time slice when the first ready task has to share the top priority with
+// another task, and stops timing when it does not.
+//------------------------------------------------------------------------------------------------
+
+void TaskScheduler::updateTimeSlice()
+{
+	// check if time slicing has never been used
+	if(pTimeSliceInterval == null)
+	{
+		return;
+	}
+
+	// check if more than one task is ready at the top priority
+	Task *pFirstTask = getFirstTask();
+	Task *pNextTask = pFirstTask == null ? null : pFirstTask->getNextTask();
+	if(timeSlice != 0
+		&& pNextTask != null
+		&& pNextTask->getPriority() == pFirstTask->getPriority())
+	{
+		// give a task a full time slice when it becomes the first task
+		if(pFirstTask != pTimeSlicedTask)
+		{
+			pTimeSlicedTask = pFirstTask;
+			pTimeSliceInterval->beginTimingFor(timeSlice);
+		}
+	}
+	else
+	{
+		// the first task can run for as long as it likes
+		pTimeSlicedTask = null;
+		pTimeSliceInterval->stopTiming();
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::expireTimeSlice
+//
+// Moves the first ready task behind the other ready tasks of equal priority once it has
+// used up its time slice.
+//------------------------------------------------------------------------------------------------
+
+void TaskScheduler::expireTimeSlice()
+{
+	UninterruptableSection criticalSection;
+
+	// rotating the tasks starts the time slice of the next task
+	Task *pFirstTask = getFirstTask();
+	if(pFirstTask != null && pFirstTask == pTimeSlicedTask)
+	{
+		yieldTask(pFirstTask);
+	}
+	else
+	{
+		pTimeSlicedTask = null;
+		updateTimeSlice();
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::getStatisticsTime
+//
+// Returns the time used to account for the processor time used by tasks.
+//------------------------------------------------------------------------------------------------
+
+#if defined(USE_TASK_STATISTICS)
+	TimeValue TaskScheduler::getStatisticsTime()
+	{
+		Timer *pTimer = getTimer();
+		return pTimer == null ? 0 : pTimer->getTime();
+	}
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::recordTaskSwitch
+//
+// Accounts for a switch from <pFromTask> (which may be null) to <pToTask>.
+// Must be called with interrupts disabled, just before the switch.
+//------------------------------------------------------------------------------------------------
+
+#if defined(USE_TASK_STATISTICS)
+	void TaskScheduler::recordTaskSwitch(Task *pFromTask, Task *pToTask)
+	{
+		const TimeValue currentTime = getStatisticsTime();
+
+		if(pFromTask == null)
+		{
+			// the scheduler is starting, all ready tasks have been waiting since now
+			for(Task *pTask = getFirstTask(); pTask != null; pTask = pTask->getNextTask())
+			{
+				pTask->readyTime = currentTime;
+			}
+		}
+		else
+		{
+			// account for the time the task has been running
+			pFromTask->statistics.runTickCount += compareTimes(currentTime, pFromTask->switchInTime);
+
+			// the task is preempted if it is still ready to run and did not yield
+			const Bool stillReady = !pFromTask->isSuspended() && !pFromTask->isBlocked();
+			if(stillReady && !pFromTask->yielding)
+			{
+				++pFromTask->statistics.preemptiveSwitchCount;
+			}
+			else
+			{
+				++pFromTask->statistics.voluntarySwitchCount;
+			}
+
+			// a task that is still ready is waiting to run again from now on
+			if(stillReady)
+			{
+				pFromTask->readyTime = currentTime;
+			}
+		}
+
+		// account for the time the task has been waiting to run
+		const TimeValue readyLatency = compareTimes(currentTime, pToTask->readyTime);
+		pToTask->statistics.totalReadyLatency += readyLatency;
+		if(readyLatency > pToTask->statistics.maximumReadyLatency)
+		{
+			pToTask->statistics.maximumReadyLatency = readyLatency;
+		}
+		++pToTask->statistics.switchInCount;
+		pToTask->switchInTime = currentTime;
+	}
+#endif
+
 //------------------------------------------------------------------------------------------------
 // * TaskScheduler::handleInterrupt
 //
@@ -250,6 +543,10 @@ SInt TaskScheduler::compareInterruptHandlers(
 			// indicate stack of task being switched to
 			info.ppSwitchToTaskStackTop = &getFirstTask()->pStackTop;
 
+			#if defined(USE_TASK_STATISTICS)
+				recordTaskSwitch(getCurrentTask(), getFirstTask());
+			#endif
+
 			// change the current task
 			pCurrentTask = getFirstTask();
 		}
@@ -264,6 +561,60 @@ SInt TaskScheduler::compareInterruptHandlers(
 	}
 #endif
 
+//------------------------------------------------------------------------------------------------
+// * TaskScheduler::handleSignal
+//
+// Handles an interrupt signal.
+// This plays the part of the IRQ exception handler, if a higher priority task has become ready
+// the interrupted task is switched out from within the signal handler and will return from the
+// signal handler (restoring its signal mask) when it is switched back in.
+//------------------------------------------------------------------------------------------------
+
+#if defined(__x86_64__) && defined(__linux__)
+	void TaskScheduler::handleSignal(int signalNumber)
+	{
+		// unused argument
+		signalNumber = signalNumber;
+
+		// the interrupted code must not see a change in errno
+		const int savedErrorNumber = errno;
+
+		currentTaskScheduler.handleInterrupt(InterruptHandler::defaultInterruptLevel);
+
+		// check if preemption is enabled and
+		// check if the currently running task is not the highest priority task
+		if(currentTaskScheduler.unpreemptableSectionEntryCount == 0
+			&& currentTaskScheduler.getCurrentTask() != currentTaskScheduler.getFirstTask())
+		{
+			// indicate stack of task being switched from
+			void **ppCurrentTaskStackTop;
+			if(currentTaskScheduler.getCurrentTask() == null)
+			{
+				// no current task
+				static void *pDummy;
+				ppCurrentTaskStackTop = &pDummy;
+			}
+			else
+			{
+				// stack of current task
+				ppCurrentTaskStackTop = &currentTaskScheduler.getCurrentTask()->pStackTop;
+			}
+
+			#if defined(USE_TASK_STATISTICS)
+				currentTaskScheduler.recordTaskSwitch(
+					currentTaskScheduler.getCurrentTask(),
+					currentTaskScheduler.getFirstTask());
+			#endif
+
+			// switch to the highest priority task
+			currentTaskScheduler.pCurrentTask = currentTaskScheduler.getFirstTask();
+			switchTasks(ppCurrentTaskStackTop, &currentTaskScheduler.pCurrentTask->pStackTop);
+		}
+
+		errno = savedErrorNumber;
+	}
+#endif
+
 //------------------------------------------------------------------------------------------------
 // * TaskScheduler static variables
 //------------------------------------------------------------------------------------------------
@@ -281,3 +632,6 @@ TaskScheduler TaskScheduler::currentTaskScheduler;
 #if defined(__TARGET_CPU_SA_1100)
 	Sa1110Timer TaskScheduler::timer;
 #endif
+#if defined(__x86_64__) && defined(__linux__)
+	PosixTimer TaskScheduler::timer;
+#endif
@@ -1,4 +1,7 @@
 #include "TaskGroup.h"
+#if defined(USE_BANDED_READY_QUEUE)
+	#include "BandedTaskGroup.h"
+#endif
 
 #ifndef _TaskScheduler_h_
 #define _TaskScheduler_h_
@@ -6,21 +9,36 @@
 class Task;
 #include "IdleTask.h"
 #include "InterruptHandler.h"
+#include "TimeValue.h"
 class Timer;
+class TimeSliceInterval;
+class DeferredWorkQueue;
 #if defined(__TARGET_CPU_ARM920T)
 	#include "../Mx1Devices/Mx1Timer.h"
 #endif
 #if defined(__TARGET_CPU_SA_1100)
 	#include "../Sa1110Devices/Sa1110Timer.h"
 #endif
+#if defined(__x86_64__) && defined(__linux__)
+	#include "../PosixDevices/PosixTimer.h"
+#endif
 
 //------------------------------------------------------------------------------------------------
 // * class TaskScheduler
 //
 // Keeps track of running tasks and schedules them to run based on their priorities.
+// Define USE_BANDED_READY_QUEUE to keep ready tasks in constant time priority bands
+// rather than a single sorted list.
+// Tasks of equal priority only take turns when they yield or block, unless a time slice is set.
 //------------------------------------------------------------------------------------------------
 
-class TaskScheduler : public TaskGroup
+#if defined(USE_BANDED_READY_QUEUE)
+	typedef BandedTaskGroup ReadyTaskGroup;
+#else
+	typedef TaskGroup ReadyTaskGroup;
+#endif
+
+class TaskScheduler : public ReadyTaskGroup
 {
 public:
 	// types
@@ -33,14 +51,23 @@ public:
 	inline static TaskScheduler *getCurrentTaskScheduler();
 	inline Task *getCurrentTask() const;
 	inline Timer *getTimer();
+	DeferredWorkQueue *getDeferredWorkQueue();
 	inline InterruptHandler *getFirstInterruptHandler(InterruptLevel level);
 
 	// testing
 	static inline Bool isInitialized();
+	Bool isTimingTimeSlice() const;
 
 	// behaviour
 	inline void start();
 
+	// time slicing
+	void setTimeSlice(TimeValue tickCount);
+
+	// modifying task priority queue
+	void addTask(Task *pTask);
+	void removeTask(Task *pTask);
+
 	// modifying interrupt handlers
 	inline void addInterruptHandler(InterruptHandler *pHandler);
 	inline void removeInterruptHandler(InterruptHandler *pHandler);
@@ -59,6 +86,16 @@ private:
 
 	// task scheduling
 	void schedule();
+	void updateTimeSlice();
+	void expireTimeSlice();
+	friend class TimeSliceInterval;
+
+	// task statistics
+	#if defined(USE_TASK_STATISTICS)
+		TimeValue getStatisticsTime();
+		void recordTaskSwitch(Task *pFromTask, Task *pToTask);
+		friend class Task;
+	#endif
 
 	// interrupt handling
 	void handleInterrupt(InterruptLevel level);
@@ -70,6 +107,9 @@ private:
 		};
 		__value_in_regs ReturnFromInterruptInfo returnFromInterrupt();
 	#endif
+	#if defined(__x86_64__) && defined(__linux__)
+		static void handleSignal(int signalNumber);
+	#endif
 	static SInt compareInterruptHandlers(
 		const Link *pInterruptHandler1,
 		const Link *pInterruptHandler2);
@@ -83,7 +123,14 @@ private:
 	#if defined(__TARGET_CPU_SA_1100)
 		static Sa1110Timer timer;
 	#endif
+	#if defined(__x86_64__) && defined(__linux__)
+		static PosixTimer timer;
+	#endif
 	Task *pCurrentTask;
+	DeferredWorkQueue *pDeferredWorkQueue;
+	TimeSliceInterval *pTimeSliceInterval;
+	TimeValue timeSlice;
+	Task *pTimeSlicedTask;
 	UInt unpreemptableSectionEntryCount;
 	UInt uninterruptableSectionEntryCount;
 	UInt interruptState;
@@ -124,7 +171,8 @@ inline Task *TaskScheduler::getCurrentTask() const
 
 inline Timer *TaskScheduler::getTimer()
 {
-	#if defined(_MSC_VER) && defined(_M_ARM) || defined(__ARMCC_VERSION)
+	#if defined(_MSC_VER) && defined(_M_ARM) || defined(__ARMCC_VERSION) \
+		|| defined(__x86_64__) && defined(__linux__)
 		return &timer;
 	#else
 		return null;
@@ -0,0 +1,39 @@
+#ifndef _TaskStatistics_h_
+#define _TaskStatistics_h_
+
+#include "../cPrimitiveTypes.h"
+#include "TimeValue.h"
+
+//------------------------------------------------------------------------------------------------
+// * struct TaskStatistics
+//
+// Accounting of the processor time used by a task, kept when USE_TASK_STATISTICS is defined.
+// Times are in ticks of the task scheduler's timer.
+//------------------------------------------------------------------------------------------------
+
+struct TaskStatistics
+{
+	// querying
+	inline TimeValue getAverageReadyLatency() const;
+
+	// representation
+	UInt64 runTickCount; // time spent running
+	UInt switchInCount; // number of times switched to
+	UInt voluntarySwitchCount; // number of times switched from after yielding, blocking or suspending
+	UInt preemptiveSwitchCount; // number of times switched from while still ready to run
+	TimeValue maximumReadyLatency; // longest time spent ready before running
+	UInt64 totalReadyLatency; // total time spent ready before running
+};
+
+//------------------------------------------------------------------------------------------------
+// * TaskStatistics::getAverageReadyLatency
+//
+// Returns the average time spent ready to run before being switched to.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue TaskStatistics::getAverageReadyLatency() const
+{
+	return switchInCount == 0 ? 0 : (TimeValue)(totalReadyLatency / switchInCount);
+}
+
+#endif // _TaskStatistics_h_
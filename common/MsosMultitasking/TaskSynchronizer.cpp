@@ -41,6 +41,13 @@ Bool TaskSynchronizer::waitUntil(TimeValue endTime, Timer *pTimer)
 	{
 		UninterruptableSection criticalSection;
 		timeout.beginTimingUntil(endTime);
+
+		// check if the end time has already passed, the task would never be unblocked
+		if(timeout.isExpired())
+		{
+			return !tryWait();
+		}
+
 		wait();
 	}
 
@@ -23,16 +23,7 @@ TimeInterval::TimeInterval(Timer &timer) :
 
 TimeInterval::~TimeInterval()
 {
-	UninterruptableSection criticalSection;
-
-	// check if the timer has not yet expired
-	if(!expired)
-	{
-		// the timer no longer needs this interval
-		timer.removeInterval(this);
-		timer.updateIntervals();
-		timer.tick();
-	}
+	stopTiming();
 }
 
 //------------------------------------------------------------------------------------------------
@@ -64,6 +55,30 @@ void TimeInterval::beginTimingUntil(TimeValue expiryTime)
 	timer.tick();
 }
 
+//------------------------------------------------------------------------------------------------
+// * TimeInterval::stopTiming
+//
+// Stops timing without handling expiry.
+// The time interval will be treated as expired.
+//------------------------------------------------------------------------------------------------
+
+void TimeInterval::stopTiming()
+{
+	UninterruptableSection criticalSection;
+
+	// check if the timer has not yet expired
+	if(!expired)
+	{
+		// set flag to indicate expiry
+		expired = true;
+
+		// the timer no longer needs this interval
+		timer.removeInterval(this);
+		timer.updateIntervals();
+		timer.tick();
+	}
+}
+
 //------------------------------------------------------------------------------------------------
 // * TimeInterval::expire
 //
@@ -77,13 +92,13 @@ void TimeInterval::expire()
 	// check if the timer has not yet expired
 	if(!expired)
 	{
-		// do something upon expiry
-		handleExpiry();
-
 		// set flag to indicate expiry
 		expired = true;
 
 		// the timer no longer needs this interval
 		timer.removeInterval(this);
+
+		// do something upon expiry (this may begin timing again)
+		handleExpiry();
 	}
 }
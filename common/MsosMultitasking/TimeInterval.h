@@ -5,6 +5,7 @@
 #include "../Collections/Link.h"
 #include "TimeValue.h"
 class Timer;
+class LinkedList;
 
 //------------------------------------------------------------------------------------------------
 // * class TimeInterval
@@ -31,6 +32,7 @@ public:
 	// timing
 	inline void beginTimingFor(TimeValue tickCount);
 	void beginTimingUntil(TimeValue expiryTime);
+	void stopTiming();
 
 protected:
 	// behaviour
@@ -50,9 +52,13 @@ private:
 	Timer &timer;
 	TimeValue expiryTime;
 	Bool expired;
+	#if defined(USE_TIMER_WHEEL)
+		LinkedList *pIntervalList;
+	#endif
 
 	// friends
 	friend class Timer;
+	friend class TimerWheel;
 };
 
 #include "Timer.h"
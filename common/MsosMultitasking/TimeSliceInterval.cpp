@@ -0,0 +1,14 @@
+#include "TimeSliceInterval.h"
+#include "TaskScheduler.h"
+
+//------------------------------------------------------------------------------------------------
+// * TimeSliceInterval::handleExpiry
+//
+// Handles the expiry of this time interval.
+//------------------------------------------------------------------------------------------------
+
+void TimeSliceInterval::handleExpiry()
+{
+	// the running task has used up its time slice
+	TaskScheduler::getCurrentTaskScheduler()->expireTimeSlice();
+}
@@ -0,0 +1,36 @@
+#ifndef _TimeSliceInterval_h_
+#define _TimeSliceInterval_h_
+
+#include "../cPrimitiveTypes.h"
+#include "TimeInterval.h"
+
+//------------------------------------------------------------------------------------------------
+// * class TimeSliceInterval
+//
+// This class is used by the task scheduler to end the time slice of the running task so that
+// tasks of equal priority take turns.
+//------------------------------------------------------------------------------------------------
+
+class TimeSliceInterval : public TimeInterval
+{
+public:
+	// constructor
+	inline TimeSliceInterval(Timer &timer);
+
+private:
+	// behaviour
+	void handleExpiry();
+};
+
+//------------------------------------------------------------------------------------------------
+// * TimeSliceInterval::TimeSliceInterval
+//
+// Constructor.
+//------------------------------------------------------------------------------------------------
+
+inline TimeSliceInterval::TimeSliceInterval(Timer &timer) :
+	TimeInterval(timer)
+{
+}
+
+#endif // _TimeSliceInterval_h_
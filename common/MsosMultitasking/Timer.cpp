@@ -27,11 +27,18 @@ void Timer::tick()
 	// keep checking for expired time intervals until we are sure there are no more
 	while(true)
 	{
-		// assume that no expired intervals
-		Bool intervalExpired = false;
+		// assume that no intervals have changed
+		Bool intervalsChanged = false;
 
 		// check for expired time intervals
 		const TimeValue currentTime = getTime();
+		#if defined(USE_TIMER_WHEEL)
+			// bring the due intervals up to date, cascaded slots need a new match
+			if(intervalWheel.advance(currentTime))
+			{
+				intervalsChanged = true;
+			}
+		#endif
 		TimeInterval *pInterval;
 		while((pInterval = getFirstInterval()) != null
 			&& compareTimes(currentTime, pInterval->getExpiryTime()) >= 0)
@@ -39,12 +46,12 @@ void Timer::tick()
 			// expire the interval
 			pInterval->expire();
 
-			// flag that an interval has expired
-			intervalExpired = true;
+			// flag that the intervals have changed
+			intervalsChanged = true;
 		}
 
-		// check if any intervals have expired
-		if(intervalExpired)
+		// check if any intervals have changed
+		if(intervalsChanged)
 		{
 			// intervals have changed
 			updateIntervals();
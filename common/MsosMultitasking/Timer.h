@@ -4,12 +4,17 @@
 #include "../cPrimitiveTypes.h"
 #include "../Collections/LinkedList.h"
 #include "TimeValue.h"
+#if defined(USE_TIMER_WHEEL)
+	#include "TimerWheel.h"
+#endif
 class TimeInterval;
 
 //------------------------------------------------------------------------------------------------
 // * class Timer
 //
 // Keeps track of time.
+// Define USE_TIMER_WHEEL to keep intervals in a constant time timing wheel
+// rather than a single sorted list.
 //------------------------------------------------------------------------------------------------
 
 class Timer
@@ -33,6 +38,8 @@ protected:
 	inline Timer();
 
 	// interval accessing
+	inline Bool hasIntervals() const;
+	inline TimeValue getNextMatchTime() const;
 	inline TimeInterval *getFirstInterval();
 	inline void addInterval(TimeInterval *pInterval);
 	inline void removeInterval(TimeInterval *pInterval);
@@ -45,6 +52,7 @@ protected:
 
 	// friends
 	friend class TimeInterval;
+	friend class TimerWheel;
 
 private:
 	// sort function
@@ -53,7 +61,11 @@ private:
 		const Link *pInterval2);
 
 	// representation
-	LinkedList intervalList;
+	#if defined(USE_TIMER_WHEEL)
+		TimerWheel intervalWheel;
+	#else
+		LinkedList intervalList;
+	#endif
 };
 
 #include "TimeInterval.h"
@@ -68,15 +80,52 @@ inline Timer::Timer()
 {
 }
 
+//------------------------------------------------------------------------------------------------
+// * Timer::hasIntervals
+//
+// Tests whether there are any intervals that have not yet expired.
+//------------------------------------------------------------------------------------------------
+
+inline Bool Timer::hasIntervals() const
+{
+	#if defined(USE_TIMER_WHEEL)
+		return !intervalWheel.isEmpty();
+	#else
+		return !intervalList.isEmpty();
+	#endif
+}
+
+//------------------------------------------------------------------------------------------------
+// * Timer::getNextMatchTime
+//
+// Returns the time at which tick() must next be called.
+// This is never later than the expiry time of the next interval that will be expired.
+// There must be intervals.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue Timer::getNextMatchTime() const
+{
+	#if defined(USE_TIMER_WHEEL)
+		return intervalWheel.getNextTime();
+	#else
+		return ((const TimeInterval *)intervalList.getFirst())->getExpiryTime();
+	#endif
+}
+
 //------------------------------------------------------------------------------------------------
 // * Timer::getFirstInterval
 //
 // Returns the next interval that will be expired.
+// When using the timing wheel, only intervals that are due are considered.
 //------------------------------------------------------------------------------------------------
 
 inline TimeInterval *Timer::getFirstInterval()
 {
-	return (TimeInterval *)intervalList.getFirst();
+	#if defined(USE_TIMER_WHEEL)
+		return (TimeInterval *)intervalWheel.getFirstInterval();
+	#else
+		return (TimeInterval *)intervalList.getFirst();
+	#endif
 }
 
 //------------------------------------------------------------------------------------------------
@@ -88,7 +137,16 @@ inline TimeInterval *Timer::getFirstInterval()
 
 inline void Timer::addInterval(TimeInterval *pInterval)
 {
-	intervalList.addSorted(pInterval, &Timer::compareIntervals);
+	#if defined(USE_TIMER_WHEEL)
+		// an empty wheel may have fallen far behind, bring it up to the current time
+		if(intervalWheel.isEmpty())
+		{
+			intervalWheel.setTime(getTime());
+		}
+		intervalWheel.addInterval(pInterval);
+	#else
+		intervalList.addSorted(pInterval, &Timer::compareIntervals);
+	#endif
 }
 
 //------------------------------------------------------------------------------------------------
@@ -99,7 +157,11 @@ inline void Timer::addInterval(TimeInterval *pInterval)
 
 inline void Timer::removeInterval(TimeInterval *pInterval)
 {
-	intervalList.remove(pInterval);
+	#if defined(USE_TIMER_WHEEL)
+		intervalWheel.removeInterval(pInterval);
+	#else
+		intervalList.remove(pInterval);
+	#endif
 }
 
 #endif // _Timer_h_
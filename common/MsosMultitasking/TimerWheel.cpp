@@ -0,0 +1,193 @@
+#if defined(USE_TIMER_WHEEL)
+
+#include "TimerWheel.h"
+#include "Timer.h"
+#include "TimeInterval.h"
+#include "../arithmetic/countLeadingZeros.h"
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::TimerWheel
+//
+// Constructor.
+//------------------------------------------------------------------------------------------------
+
+TimerWheel::TimerWheel()
+{
+	wheelTime = 0;
+	for(UInt level = 0; level < numberOfLevels; ++level)
+	{
+		usedSlots[level] = 0;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::getNextTime
+//
+// Returns the time at which the wheel must next be advanced.
+// This is the expiry time of the first due interval, or the start of the first used slot if
+// no interval is due. The wheel must not be empty.
+//------------------------------------------------------------------------------------------------
+
+TimeValue TimerWheel::getNextTime() const
+{
+	// the due intervals expire before any interval in a slot
+	const TimeInterval *pFirstInterval = (const TimeInterval *)dueIntervalList.getFirst();
+	if(pFirstInterval != null)
+	{
+		return pFirstInterval->getExpiryTime();
+	}
+
+	UInt level;
+	UInt distance;
+	findFirstSlot(&level, &distance);
+	return getSlotTime(level, distance);
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::addInterval
+//
+// Adds the specified <pInterval> to the wheel.
+// Due intervals are kept in time order, after any intervals that expire before it.
+//------------------------------------------------------------------------------------------------
+
+void TimerWheel::addInterval(TimeInterval *pInterval)
+{
+	const TimeValue expiryTime = pInterval->getExpiryTime();
+
+	// check if the interval expires within the current granule
+	if(compareTimes(expiryTime, wheelTime) < 0 || getSlotDistance(expiryTime, 0) == 0)
+	{
+		dueIntervalList.addSorted(pInterval, &Timer::compareIntervals);
+		pInterval->pIntervalList = &dueIntervalList;
+		return;
+	}
+
+	// find the lowest level that can reach the expiry time
+	UInt level = 0;
+	UInt distance = getSlotDistance(expiryTime, level);
+	while(distance >= numberOfSlots && level < numberOfLevels - 1)
+	{
+		distance = getSlotDistance(expiryTime, ++level);
+	}
+	if(distance >= numberOfSlots)
+	{
+		// too far away even for the top level, the interval will be cascaded back into it
+		distance = numberOfSlots - 1;
+	}
+
+	// hash the interval into its slot
+	const UInt slotNumber = (getSlotNumber(level) + distance) % numberOfSlots;
+	LinkedList *pSlot = &slots[level][slotNumber];
+	pSlot->addLast(pInterval);
+	pInterval->pIntervalList = pSlot;
+	usedSlots[level] |= 1u << slotNumber;
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::removeInterval
+//
+// Removes the specified <pInterval> from the wheel.
+//------------------------------------------------------------------------------------------------
+
+void TimerWheel::removeInterval(TimeInterval *pInterval)
+{
+	LinkedList *pList = pInterval->pIntervalList;
+	pList->remove(pInterval);
+
+	// check if a slot has been emptied
+	if(pList != &dueIntervalList && pList->isEmpty())
+	{
+		const UInt slotIndex = pList - &slots[0][0];
+		usedSlots[slotIndex / numberOfSlots] &= ~(1u << slotIndex % numberOfSlots);
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::advance
+//
+// Moves the wheel up to <currentTime>.
+// Every slot that begins at or before <currentTime> is cascaded, in time order, so that its
+// intervals are hashed again into lower levels or the due list.
+// Returns true if any slot was cascaded.
+//------------------------------------------------------------------------------------------------
+
+Bool TimerWheel::advance(TimeValue currentTime)
+{
+	Bool cascaded = false;
+
+	UInt level;
+	UInt distance;
+	while(findFirstSlot(&level, &distance))
+	{
+		// check if the first slot has been reached
+		const TimeValue slotTime = getSlotTime(level, distance);
+		if(compareTimes(slotTime, currentTime) > 0)
+		{
+			break;
+		}
+
+		// take the slot off the wheel
+		const UInt slotNumber = (getSlotNumber(level) + distance) % numberOfSlots;
+		LinkedList *pSlot = &slots[level][slotNumber];
+		usedSlots[level] &= ~(1u << slotNumber);
+
+		// move the wheel to the start of the slot and hash its intervals again,
+		// none of them can go back into the same slot
+		wheelTime = slotTime;
+		while(!pSlot->isEmpty())
+		{
+			addInterval((TimeInterval *)pSlot->removeFirst());
+		}
+
+		cascaded = true;
+	}
+
+	// none of the remaining slots have been reached
+	if(compareTimes(currentTime, wheelTime) > 0)
+	{
+		wheelTime = currentTime;
+	}
+
+	return cascaded;
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::findFirstSlot
+//
+// Finds the used slot that begins first.
+// A slot on a higher level is found before a slot on a lower level that begins at the same time,
+// so that its intervals are cascaded first.
+// Returns false if all slots are empty.
+//------------------------------------------------------------------------------------------------
+
+Bool TimerWheel::findFirstSlot(UInt *pLevel, UInt *pDistance) const
+{
+	Bool found = false;
+	TimeValue firstSlotTime = 0;
+	for(UInt level = 0; level < numberOfLevels; ++level)
+	{
+		const UInt used = usedSlots[level];
+		if(used != 0)
+		{
+			// rotate the used slots so that the slot of the wheel time is the lowest bit
+			const UInt slotNumber = getSlotNumber(level);
+			const UInt rotatedSlots = slotNumber == 0
+				? used
+				: used >> slotNumber | used << (numberOfSlots - slotNumber);
+			const UInt distance = indexOfLowestSetBit(rotatedSlots);
+
+			// check if the slot begins no later than the first found so far
+			const TimeValue slotTime = getSlotTime(level, distance);
+			if(!found || compareTimes(slotTime, firstSlotTime) <= 0)
+			{
+				found = true;
+				firstSlotTime = slotTime;
+				*pLevel = level;
+				*pDistance = distance;
+			}
+		}
+	}
+	return found;
+}
+
+#endif
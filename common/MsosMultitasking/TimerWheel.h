@@ -0,0 +1,157 @@
+#ifndef _TimerWheel_h_
+#define _TimerWheel_h_
+
+#include "../cPrimitiveTypes.h"
+#include "../Collections/LinkedList.h"
+#include "TimeValue.h"
+class TimeInterval;
+
+//------------------------------------------------------------------------------------------------
+// * class TimerWheel
+//
+// Keeps the intervals of a Timer in a hierarchical timing wheel so that intervals can be added
+// and removed in constant time.
+// Intervals that expire within the current granule (or have already expired) are kept sorted
+// in a short due list, every other interval is hashed into a slot of the lowest level that can
+// reach it. Slots are moved down a level (cascaded) as the wheel time reaches them.
+// The wheel time never gets ahead of the timer, so the first due interval is always the
+// earliest and the start of the earliest used slot is the next time the wheel must be advanced.
+//------------------------------------------------------------------------------------------------
+
+class TimerWheel
+{
+public:
+	// constructor
+	TimerWheel();
+
+	// testing
+	inline Bool isEmpty() const;
+
+	// querying
+	inline Link *getFirstInterval() const;
+	TimeValue getNextTime() const;
+
+	// modifying
+	void addInterval(TimeInterval *pInterval);
+	void removeInterval(TimeInterval *pInterval);
+
+	// time change handling
+	inline void setTime(TimeValue time);
+	Bool advance(TimeValue currentTime);
+
+private:
+	// wheel geometry
+	enum
+	{
+		granularityBits = 6,
+		slotBits = 5,
+		numberOfSlots = 1 << slotBits,
+		numberOfLevels = 5
+	};
+	static inline UInt getShift(UInt level);
+	inline UInt getSlotNumber(UInt level) const;
+	inline UInt getSlotDistance(TimeValue time, UInt level) const;
+	inline TimeValue getSlotTime(UInt level, UInt distance) const;
+	Bool findFirstSlot(UInt *pLevel, UInt *pDistance) const;
+
+	// representation
+	TimeValue wheelTime;
+	LinkedList dueIntervalList;
+	UInt usedSlots[numberOfLevels];
+	LinkedList slots[numberOfLevels][numberOfSlots];
+};
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::isEmpty
+//
+// Tests whether there are no intervals in the wheel.
+//------------------------------------------------------------------------------------------------
+
+inline Bool TimerWheel::isEmpty() const
+{
+	if(!dueIntervalList.isEmpty())
+	{
+		return false;
+	}
+	for(UInt level = 0; level < numberOfLevels; ++level)
+	{
+		if(usedSlots[level] != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::getFirstInterval
+//
+// Returns the first due interval, or null if no interval is due within the current granule.
+//------------------------------------------------------------------------------------------------
+
+inline Link *TimerWheel::getFirstInterval() const
+{
+	return dueIntervalList.getFirst();
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::setTime
+//
+// Moves the wheel to the given <time>.
+// Must only be used while the wheel is empty.
+//------------------------------------------------------------------------------------------------
+
+inline void TimerWheel::setTime(TimeValue time)
+{
+	wheelTime = time;
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::getShift
+//
+// Returns the number of time bits below the slot number of the given <level>.
+//------------------------------------------------------------------------------------------------
+
+inline UInt TimerWheel::getShift(UInt level)
+{
+	return granularityBits + level * slotBits;
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::getSlotNumber
+//
+// Returns the slot of the given <level> that the wheel time is in.
+//------------------------------------------------------------------------------------------------
+
+inline UInt TimerWheel::getSlotNumber(UInt level) const
+{
+	return ((UInt)wheelTime >> getShift(level)) % numberOfSlots;
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::getSlotDistance
+//
+// Returns the number of slots of the given <level> between the wheel time and <time>.
+// The <time> must not be before the wheel time.
+//------------------------------------------------------------------------------------------------
+
+inline UInt TimerWheel::getSlotDistance(TimeValue time, UInt level) const
+{
+	// mask off the bits that were shifted in so that the distance is right even if time wraps
+	const UInt shift = getShift(level);
+	return (((UInt)time >> shift) - ((UInt)wheelTime >> shift)) & (maxUInt >> shift);
+}
+
+//------------------------------------------------------------------------------------------------
+// * TimerWheel::getSlotTime
+//
+// Returns the time at which the slot <distance> slots after the wheel time on <level> begins.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue TimerWheel::getSlotTime(UInt level, UInt distance) const
+{
+	const UInt shift = getShift(level);
+	return (TimeValue)((((UInt)wheelTime >> shift) + distance) << shift);
+}
+
+#endif // _TimerWheel_h_
@@ -0,0 +1,249 @@
+#include "Task.h"
+#include "IntertaskEvent.h"
+#include "Timer.h"
+#include "sleep.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+static const UInt numberOfSwitches = 200000;
+static const UInt numberOfWakeUps = 2000;
+static const UInt wakeUpPeriodInMicroseconds = 1000;
+
+//------------------------------------------------------------------------------------------------
+// * class YieldingTask
+//------------------------------------------------------------------------------------------------
+
+class YieldingTask : public Task
+{
+public:
+	// constructor
+	YieldingTask(IntertaskEvent &completeEvent);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	IntertaskEvent &completeEvent;
+};
+
+YieldingTask::YieldingTask(IntertaskEvent &completeEvent) :
+	Task(defaultPriority, 10000),
+	completeEvent(completeEvent)
+{
+}
+
+void YieldingTask::main()
+{
+	// every yield switches to the other task of the same priority
+	for(UInt switchNumber = 0; switchNumber < numberOfSwitches / 2; ++switchNumber)
+	{
+		yield();
+	}
+	completeEvent.signal();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class PongTask
+//------------------------------------------------------------------------------------------------
+
+class PongTask : public Task
+{
+public:
+	// constructor
+	PongTask(IntertaskEvent &pingEvent, IntertaskEvent &pongEvent);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	IntertaskEvent &pingEvent;
+	IntertaskEvent &pongEvent;
+};
+
+PongTask::PongTask(IntertaskEvent &pingEvent, IntertaskEvent &pongEvent) :
+	Task(defaultPriority + 1, 10000),
+	pingEvent(pingEvent),
+	pongEvent(pongEvent)
+{
+}
+
+void PongTask::main()
+{
+	// answer every ping
+	while(true)
+	{
+		pongEvent.wait();
+		pingEvent.signal();
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class SpinningTask
+//------------------------------------------------------------------------------------------------
+
+class SpinningTask : public Task
+{
+public:
+	// constructor
+	SpinningTask(volatile Bool &spinning);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	volatile Bool &spinning;
+};
+
+SpinningTask::SpinningTask(volatile Bool &spinning) :
+	Task(lowPriority, 10000),
+	spinning(spinning)
+{
+}
+
+void SpinningTask::main()
+{
+	// keep the processor busy, so that every wake-up has to preempt this task
+	while(spinning)
+	{
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ContextSwitchBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class ContextSwitchBenchmarkTask : public Task
+{
+public:
+	// constructor
+	ContextSwitchBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	void measureYields();
+	void measureSignals();
+	void measureWakeUps();
+	void report(const char *pDescription, TimeValue elapsedTicks, UInt count);
+
+	// representation
+	Timer *pTimer;
+	IntertaskEvent completeEvent;
+	IntertaskEvent pingEvent;
+	IntertaskEvent pongEvent;
+};
+
+ContextSwitchBenchmarkTask::ContextSwitchBenchmarkTask() :
+	Task(defaultPriority + 2, 10000)
+{
+	pTimer = null;
+}
+
+void ContextSwitchBenchmarkTask::report(const char *pDescription, TimeValue elapsedTicks, UInt count)
+{
+	#if defined(PRINT)
+		const UInt64 nanoseconds = (UInt64)elapsedTicks * 1000000000 / pTimer->getFrequency();
+		std::cout << pDescription << ": " << (UInt)(nanoseconds / count) << "ns per switch\n";
+	#endif
+}
+
+void ContextSwitchBenchmarkTask::measureYields()
+{
+	// two tasks of the same priority hand the processor to each other
+	YieldingTask *pTask1 = new YieldingTask(completeEvent);
+	YieldingTask *pTask2 = new YieldingTask(completeEvent);
+	const TimeValue startTime = pTimer->getTime();
+	pTask1->resume();
+	pTask2->resume();
+	completeEvent.wait();
+	completeEvent.wait();
+	report("Yield", compareTimes(pTimer->getTime(), startTime), numberOfSwitches);
+}
+
+void ContextSwitchBenchmarkTask::measureSignals()
+{
+	// every ping switches to the pong task and its answer switches back
+	(new PongTask(pingEvent, pongEvent))->resume();
+	const TimeValue startTime = pTimer->getTime();
+	for(UInt pingNumber = 0; pingNumber < numberOfSwitches / 2; ++pingNumber)
+	{
+		pongEvent.signal();
+		pingEvent.wait();
+	}
+	report("Signal and wait", compareTimes(pTimer->getTime(), startTime), numberOfSwitches);
+}
+
+void ContextSwitchBenchmarkTask::measureWakeUps()
+{
+	// wake up from the timer interrupt periodically, preempting a busy task
+	volatile Bool spinning = true;
+	(new SpinningTask(spinning))->resume();
+	const TimeValue period = (TimeValue)((UInt64)wakeUpPeriodInMicroseconds * pTimer->getFrequency() / 1000000);
+	TimeValue wakeUpTime = pTimer->getTime() + period;
+	TimeValue totalLatency = 0;
+	TimeValue maximumLatency = 0;
+	for(UInt wakeUpNumber = 0; wakeUpNumber < numberOfWakeUps; ++wakeUpNumber)
+	{
+		sleepUntil(wakeUpTime, pTimer);
+		const TimeValue latency = compareTimes(pTimer->getTime(), wakeUpTime);
+		totalLatency += latency;
+		maximumLatency = maximum(maximumLatency, latency);
+		wakeUpTime += period;
+	}
+	spinning = false;
+
+	#if defined(PRINT)
+		std::cout << "Timer wake-up: " << (UInt)((UInt64)totalLatency * 1000000 / pTimer->getFrequency() / numberOfWakeUps)
+			<< "us average latency, " << (UInt)((UInt64)maximumLatency * 1000000 / pTimer->getFrequency())
+			<< "us maximum\n";
+	#endif
+}
+
+void ContextSwitchBenchmarkTask::main()
+{
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	// compare a voluntary switch, a switch through a synchronizer and a switch from an interrupt
+	measureYields();
+	measureSignals();
+	measureWakeUps();
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * contextSwitchBenchmark
+//------------------------------------------------------------------------------------------------
+
+void contextSwitchBenchmark()
+{
+	(new ContextSwitchBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
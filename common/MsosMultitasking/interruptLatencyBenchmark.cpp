@@ -0,0 +1,317 @@
+#include "Task.h"
+#include "TaskScheduler.h"
+#include "TimeInterval.h"
+#include "DeferredWork.h"
+#include "DeferredWorkQueue.h"
+#include "sleep.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+static const UInt numberOfProbes = 2000;
+static const UInt probePeriodInMicroseconds = 1000;
+static const UInt servicePeriodInMicroseconds = 1013;
+static const UInt serviceTimeInMicroseconds = 300;
+static const UInt lateLatencyInMicroseconds = serviceTimeInMicroseconds / 2;
+
+//------------------------------------------------------------------------------------------------
+// * class LatencyStatistics
+//------------------------------------------------------------------------------------------------
+
+class LatencyStatistics
+{
+public:
+	// constructor
+	LatencyStatistics(TimeValue lateLatency);
+
+	// modifying
+	void reset();
+	void addLatency(TimeValue latency);
+
+	// representation
+	UInt count;
+	UInt lateCount;
+	UInt64 totalLatency;
+	TimeValue maximumLatency;
+	TimeValue lateLatency;
+};
+
+LatencyStatistics::LatencyStatistics(TimeValue lateLatency) :
+	lateLatency(lateLatency)
+{
+	reset();
+}
+
+void LatencyStatistics::reset()
+{
+	count = 0;
+	lateCount = 0;
+	totalLatency = 0;
+	maximumLatency = 0;
+}
+
+void LatencyStatistics::addLatency(TimeValue latency)
+{
+	totalLatency += latency;
+	maximumLatency = maximum(maximumLatency, latency);
+	if(latency > lateLatency)
+	{
+		++lateCount;
+	}
+	++count;
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ProbeInterval
+//------------------------------------------------------------------------------------------------
+
+class ProbeInterval : public TimeInterval
+{
+public:
+	// constructor
+	ProbeInterval(Timer &timer, TimeValue period, TimeValue lateLatency);
+
+	// representation
+	LatencyStatistics statistics;
+
+protected:
+	// behaviour
+	void handleExpiry();
+
+private:
+	// representation
+	Timer &timer;
+	TimeValue period;
+};
+
+ProbeInterval::ProbeInterval(Timer &timer, TimeValue period, TimeValue lateLatency) :
+	TimeInterval(timer),
+	statistics(lateLatency),
+	timer(timer),
+	period(period)
+{
+}
+
+void ProbeInterval::handleExpiry()
+{
+	// the lateness of this interrupt is the latency that any other interrupt would see
+	statistics.addLatency(compareTimes(timer.getTime(), getExpiryTime()));
+	if(statistics.count < numberOfProbes)
+	{
+		beginTimingUntil(getExpiryTime() + period);
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ServiceInterval
+//------------------------------------------------------------------------------------------------
+
+class ServiceInterval : public TimeInterval
+{
+public:
+	// constructor
+	ServiceInterval(Timer &timer, TimeValue period, TimeValue serviceTime, TimeValue lateLatency,
+		Bool deferring);
+
+	// representation
+	LatencyStatistics workStatistics;
+
+protected:
+	// behaviour
+	void handleExpiry();
+
+private:
+	// servicing
+	void service();
+
+	// types
+	class ServiceWork : public DeferredWork
+	{
+	public:
+		inline ServiceWork(ServiceInterval &interval) :
+			interval(interval)
+		{
+		}
+
+	protected:
+		void handleWork();
+
+	private:
+		ServiceInterval &interval;
+	};
+	friend class ServiceWork;
+
+	// representation
+	Timer &timer;
+	TimeValue period;
+	TimeValue serviceTime;
+	TimeValue deferTime;
+	Bool deferring;
+	ServiceWork work;
+};
+
+ServiceInterval::ServiceInterval(Timer &timer, TimeValue period, TimeValue serviceTime,
+	TimeValue lateLatency, Bool deferring) :
+	TimeInterval(timer),
+	workStatistics(lateLatency),
+	timer(timer),
+	period(period),
+	serviceTime(serviceTime),
+	deferTime(0),
+	deferring(deferring),
+	work(*this)
+{
+}
+
+void ServiceInterval::service()
+{
+	// stand in for a driver copying data to and from its device
+	const TimeValue endTime = timer.getTime() + serviceTime;
+	while(compareTimes(endTime, timer.getTime()) > 0)
+	{
+	}
+}
+
+void ServiceInterval::handleExpiry()
+{
+	// either service the device in the interrupt handler, or only note the interrupt and leave
+	// the servicing to the deferred work queue
+	if(deferring)
+	{
+		deferTime = getExpiryTime();
+		work.defer();
+	}
+	else
+	{
+		service();
+	}
+	beginTimingUntil(getExpiryTime() + period);
+}
+
+void ServiceInterval::ServiceWork::handleWork()
+{
+	interval.workStatistics.addLatency(compareTimes(interval.timer.getTime(), interval.deferTime));
+	interval.service();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class InterruptLatencyBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class InterruptLatencyBenchmarkTask : public Task
+{
+public:
+	// constructor
+	InterruptLatencyBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	TimeValue getTicks(UInt microseconds) const;
+	void measure(const char *pDescription, Bool servicing, Bool deferring);
+	void report(const char *pDescription, const LatencyStatistics &statistics);
+
+	// representation
+	Timer *pTimer;
+};
+
+InterruptLatencyBenchmarkTask::InterruptLatencyBenchmarkTask() :
+	Task(realtimePriority, 10000)
+{
+	pTimer = null;
+}
+
+TimeValue InterruptLatencyBenchmarkTask::getTicks(UInt microseconds) const
+{
+	return (TimeValue)((UInt64)microseconds * pTimer->getFrequency() / 1000000);
+}
+
+void InterruptLatencyBenchmarkTask::report(const char *pDescription, const LatencyStatistics &statistics)
+{
+	#if defined(PRINT)
+		std::cout << pDescription << ": "
+			<< (UInt)(statistics.totalLatency * 1000000 / pTimer->getFrequency() / statistics.count)
+			<< "us average latency, "
+			<< (UInt)((UInt64)statistics.maximumLatency * 1000000 / pTimer->getFrequency())
+			<< "us maximum, " << statistics.lateCount << " of " << statistics.count
+			<< " later than " << lateLatencyInMicroseconds << "us\n";
+	#endif
+}
+
+void InterruptLatencyBenchmarkTask::measure(const char *pDescription, Bool servicing, Bool deferring)
+{
+	// probe the interrupt latency periodically, while another interrupt at a slightly different
+	// period keeps servicing its device, so that the two interrupts pass over each other
+	const TimeValue lateLatency = getTicks(lateLatencyInMicroseconds);
+	ProbeInterval probe(*pTimer, getTicks(probePeriodInMicroseconds), lateLatency);
+	ServiceInterval serviceInterval(*pTimer, getTicks(servicePeriodInMicroseconds),
+		getTicks(serviceTimeInMicroseconds), lateLatency, deferring);
+	if(servicing)
+	{
+		serviceInterval.beginTimingFor(getTicks(servicePeriodInMicroseconds));
+	}
+	probe.beginTimingFor(getTicks(probePeriodInMicroseconds));
+	while(probe.statistics.count < numberOfProbes)
+	{
+		sleepForMilliseconds(100);
+	}
+	serviceInterval.stopTiming();
+
+	report(pDescription, probe.statistics);
+	if(deferring)
+	{
+		report("  deferred work", serviceInterval.workStatistics);
+	}
+}
+
+void InterruptLatencyBenchmarkTask::main()
+{
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+
+	// compare the latency of an interrupt on its own, next to one which services its device in
+	// the interrupt handler, and next to one which defers the servicing
+	#if defined(PRINT)
+		std::cout << "Interrupt latency, " << serviceTimeInMicroseconds << "us of servicing every "
+			<< servicePeriodInMicroseconds << "us\n";
+	#endif
+	measure("No servicing", false, false);
+	measure("Servicing in the interrupt handler", true, false);
+	measure("Servicing in deferred work", true, true);
+
+	#if defined(PRINT) && defined(USE_STACK_PAINTING)
+		// the default queue was created by the first deferred work, check its stack size
+		std::cout << "Deferred work queue stack: "
+			<< DeferredWorkQueue::getDefaultQueue()->getPeakStackUsage() << " bytes peak\n";
+	#endif
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * interruptLatencyBenchmark
+//------------------------------------------------------------------------------------------------
+
+void interruptLatencyBenchmark()
+{
+	(new InterruptLatencyBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
@@ -0,0 +1,348 @@
+#include "Task.h"
+#include "PriorityMutex.h"
+#include "IntertaskEvent.h"
+#include "UninterruptableSection.h"
+#include "Timer.h"
+#include "sleep.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the realtime task locks the outer mutex, which the medium task holds while it waits for the
+// inner mutex, which the low task holds
+static PriorityMutex outerMutex;
+static PriorityMutex innerMutex;
+
+// the holder task holds the timed mutex until the release event, while the waiter task times
+// out waiting for it, both run above the high task so that it does not hold them up
+static PriorityMutex timedMutex;
+static IntertaskEvent releaseEvent;
+static const UInt waiterTimeoutInMilliseconds = 10;
+
+//------------------------------------------------------------------------------------------------
+// * spinForMilliseconds
+//------------------------------------------------------------------------------------------------
+
+static void spinForMilliseconds(UInt milliseconds)
+{
+	// keep the processor busy without blocking
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	const TimeValue endTime = pTimer->getTime() + pTimer->convertMilliseconds(milliseconds);
+	while(compareTimes(pTimer->getTime(), endTime) < 0)
+	{
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class LowTask
+//------------------------------------------------------------------------------------------------
+
+class LowTask : public Task
+{
+public:
+	// constructor
+	LowTask();
+
+protected:
+	// main entry point
+	void main();
+};
+
+LowTask::LowTask() :
+	Task(lowPriority, 20000)
+{
+}
+
+void LowTask::main()
+{
+	while(true)
+	{
+		innerMutex.lock();
+		spinForMilliseconds(1);
+		innerMutex.unlock();
+		sleepForMilliseconds(3);
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class MediumTask
+//------------------------------------------------------------------------------------------------
+
+class MediumTask : public Task
+{
+public:
+	// constructor
+	MediumTask();
+
+protected:
+	// main entry point
+	void main();
+};
+
+MediumTask::MediumTask() :
+	Task(mediumPriority, 20000)
+{
+}
+
+void MediumTask::main()
+{
+	while(true)
+	{
+		outerMutex.lock();
+		innerMutex.lock();
+		spinForMilliseconds(1);
+		innerMutex.unlock();
+		outerMutex.unlock();
+		sleepForMilliseconds(2);
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class HighTask
+//------------------------------------------------------------------------------------------------
+
+class HighTask : public Task
+{
+public:
+	// constructor
+	HighTask();
+
+protected:
+	// main entry point
+	void main();
+};
+
+HighTask::HighTask() :
+	Task(highPriority, 20000)
+{
+}
+
+void HighTask::main()
+{
+	// hog the processor, which starves the low and medium tasks unless they inherit a priority
+	while(true)
+	{
+		spinForMilliseconds(20);
+		sleepForMilliseconds(5);
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class HolderTask
+//------------------------------------------------------------------------------------------------
+
+class HolderTask : public Task
+{
+public:
+	// constructor
+	HolderTask();
+
+protected:
+	// main entry point
+	void main();
+};
+
+HolderTask::HolderTask() :
+	Task(highPriority + 1, 20000)
+{
+}
+
+void HolderTask::main()
+{
+	timedMutex.lock();
+	releaseEvent.wait();
+	timedMutex.unlock();
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class WaiterTask
+//------------------------------------------------------------------------------------------------
+
+class WaiterTask : public Task
+{
+public:
+	// constructor
+	WaiterTask();
+
+	// representation
+	Bool timedOut;
+
+protected:
+	// main entry point
+	void main();
+};
+
+WaiterTask::WaiterTask() :
+	Task(highPriority + 2, 20000)
+{
+	timedOut = false;
+}
+
+void WaiterTask::main()
+{
+	timedOut = timedMutex.lockForMilliseconds(waiterTimeoutInMilliseconds);
+	if(!timedOut)
+	{
+		timedMutex.unlock();
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class PeerTask
+//------------------------------------------------------------------------------------------------
+
+class PeerTask : public Task
+{
+public:
+	// constructor
+	PeerTask();
+
+protected:
+	// main entry point
+	void main();
+};
+
+PeerTask::PeerTask() :
+	Task(lowPriority + 1, 20000)
+{
+}
+
+void PeerTask::main()
+{
+	while(true)
+	{
+		sleepForMilliseconds(1);
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class RealtimeTask
+//------------------------------------------------------------------------------------------------
+
+class RealtimeTask : public Task
+{
+public:
+	// constructor
+	RealtimeTask(UInt numberOfLocks);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// testing
+	Bool checkTimeoutDuringPriorityWalk();
+
+	// representation
+	UInt numberOfLocks;
+};
+
+RealtimeTask::RealtimeTask(UInt numberOfLocks) :
+	Task(realtimePriority, 20000)
+{
+	this->numberOfLocks = numberOfLocks;
+}
+
+Bool RealtimeTask::checkTimeoutDuringPriorityWalk()
+{
+	// let the holder lock the timed mutex, and the waiter raise its priority by waiting for it
+	HolderTask holderTask;
+	WaiterTask waiterTask;
+	PeerTask peerTask;
+	holderTask.resume();
+	sleepForMilliseconds(2);
+	waiterTask.resume();
+	sleepForMilliseconds(2);
+	const Bool inherited = holderTask.getPriority() == waiterTask.getPriority();
+
+	// with time slicing, a second task becoming ready at this priority starts a time slice,
+	// which runs the timer while the priority of that task is being changed, and the timer
+	// times out the waiter, whose holder must lose the priority it inherited from it
+	TaskScheduler::getCurrentTaskScheduler()->setTimeSlice(
+		TaskScheduler::getCurrentTaskScheduler()->getTimer()->convertMilliseconds(1000));
+	peerTask.resume();
+	{
+		UninterruptableSection criticalSection;
+		spinForMilliseconds(2 * waiterTimeoutInMilliseconds);
+		peerTask.setPriority(getPriority());
+	}
+	const Bool restored = holderTask.getPriority() == holderTask.getBasePriority();
+	sleepForMilliseconds(2);
+	const Bool timedOut = waiterTask.timedOut;
+
+	// let the tasks finish before they are destroyed
+	peerTask.suspend();
+	TaskScheduler::getCurrentTaskScheduler()->setTimeSlice(0);
+	releaseEvent.signal();
+	sleepForMilliseconds(2);
+	return inherited && restored && timedOut;
+}
+
+void RealtimeTask::main()
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	TimeValue maximumBlockingTime = 0;
+	UInt64 totalBlockingTime = 0;
+	for(UInt lockNumber = 0; lockNumber < numberOfLocks; ++lockNumber)
+	{
+		sleepForMilliseconds(7);
+
+		// time how long the lock is held up by the lower priority tasks
+		const TimeValue startTime = pTimer->getTime();
+		outerMutex.lock();
+		const TimeValue blockingTime = compareTimes(pTimer->getTime(), startTime);
+		outerMutex.unlock();
+
+		if(blockingTime > maximumBlockingTime)
+		{
+			maximumBlockingTime = blockingTime;
+		}
+		totalBlockingTime += blockingTime;
+	}
+
+	#if defined(PRINT)
+		const UInt64 frequency = pTimer->getFrequency();
+		std::cout << "Realtime task blocking over " << numberOfLocks << " locks: "
+			<< "maximum " << (UInt)((UInt64)maximumBlockingTime * 1000000 / frequency) << "us, "
+			<< "average " << (UInt)(totalBlockingTime * 1000000 / frequency / numberOfLocks) << "us\n";
+	#endif
+
+	const Bool timeoutHandled = checkTimeoutDuringPriorityWalk();
+	#if defined(PRINT)
+		std::cout << "Timeout of a waiting task during a priority change: "
+			<< (timeoutHandled ? "inherited priority given back" : "INHERITED PRIORITY KEPT") << "\n";
+		exit(timeoutHandled ? 0 : 1);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * priorityInheritanceTest
+//------------------------------------------------------------------------------------------------
+
+void priorityInheritanceTest()
+{
+	(new LowTask())->resume();
+	(new MediumTask())->resume();
+	(new HighTask())->resume();
+	(new RealtimeTask(500))->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
@@ -0,0 +1,218 @@
+#include "Task.h"
+#include "IntertaskQueue.h"
+#include "IntertaskEvent.h"
+#include "Timer.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+// the first round moves single elements, the others move batches of these sizes
+static const UInt batchSizes[] = {1, 4, 16, 64};
+static const UInt numberOfRounds = 1 + sizeof(batchSizes) / sizeof(batchSizes[0]);
+static const UInt maximumBatchSize = 64;
+
+//------------------------------------------------------------------------------------------------
+// * class QueueBenchmark
+//------------------------------------------------------------------------------------------------
+
+class QueueBenchmark
+{
+public:
+	// constructor
+	QueueBenchmark(UInt numberOfElements, UInt queueCapacity);
+
+	// representation
+	UInt numberOfElements;
+	IntertaskValueQueue<UInt> queue;
+	IntertaskEvent roundCompleteEvent;
+	TimeValue roundStartTime;
+};
+
+QueueBenchmark::QueueBenchmark(UInt numberOfElements, UInt queueCapacity) :
+	queue(queueCapacity)
+{
+	this->numberOfElements = numberOfElements;
+	roundStartTime = 0;
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class QueueProducerTask
+//------------------------------------------------------------------------------------------------
+
+class QueueProducerTask : public Task
+{
+public:
+	// constructor
+	QueueProducerTask(QueueBenchmark &benchmark);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	QueueBenchmark &benchmark;
+};
+
+QueueProducerTask::QueueProducerTask(QueueBenchmark &benchmark) :
+	Task(defaultPriority, 10000),
+	benchmark(benchmark)
+{
+}
+
+void QueueProducerTask::main()
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	UInt items[maximumBatchSize];
+	for(UInt round = 0; round < numberOfRounds; ++round)
+	{
+		benchmark.roundStartTime = pTimer->getTime();
+		if(round == 0)
+		{
+			for(UInt element = 0; element < benchmark.numberOfElements; ++element)
+			{
+				benchmark.queue.addLast(element);
+			}
+		}
+		else
+		{
+			const UInt batchSize = batchSizes[round - 1];
+			for(UInt element = 0; element < benchmark.numberOfElements; element += batchSize)
+			{
+				for(UInt itemNumber = 0; itemNumber < batchSize; ++itemNumber)
+				{
+					items[itemNumber] = element + itemNumber;
+				}
+				benchmark.queue.addLastMany(items, batchSize, batchSize);
+			}
+		}
+
+		// let the consumer finish before starting the next round
+		benchmark.roundCompleteEvent.wait();
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class QueueConsumerTask
+//------------------------------------------------------------------------------------------------
+
+class QueueConsumerTask : public Task
+{
+public:
+	// constructor
+	QueueConsumerTask(QueueBenchmark &benchmark);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	void report(UInt round, TimeValue elapsedTicks, UInt errorCount);
+
+	// representation
+	QueueBenchmark &benchmark;
+};
+
+QueueConsumerTask::QueueConsumerTask(QueueBenchmark &benchmark) :
+	Task(defaultPriority + 1, 10000),
+	benchmark(benchmark)
+{
+}
+
+void QueueConsumerTask::report(UInt round, TimeValue elapsedTicks, UInt errorCount)
+{
+	#if defined(PRINT)
+		Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+		const UInt64 microseconds = (UInt64)elapsedTicks * 1000000 / pTimer->getFrequency();
+		if(round == 0)
+		{
+			std::cout << "Single elements";
+		}
+		else
+		{
+			std::cout << "Batches of " << batchSizes[round - 1];
+		}
+		std::cout << ": " << (UInt)microseconds << "us for " << benchmark.numberOfElements
+			<< " elements";
+		if(errorCount != 0)
+		{
+			std::cout << ", " << errorCount << " out of order";
+		}
+		std::cout << '\n';
+	#endif
+}
+
+void QueueConsumerTask::main()
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	UInt items[maximumBatchSize];
+	for(UInt round = 0; round < numberOfRounds; ++round)
+	{
+		UInt errorCount = 0;
+		if(round == 0)
+		{
+			for(UInt element = 0; element < benchmark.numberOfElements; ++element)
+			{
+				if(benchmark.queue.removeFirst() != element)
+				{
+					++errorCount;
+				}
+			}
+		}
+		else
+		{
+			// take whatever has been added, up to a batch at a time
+			const UInt batchSize = batchSizes[round - 1];
+			UInt element = 0;
+			while(element < benchmark.numberOfElements)
+			{
+				const UInt count = benchmark.queue.removeFirstMany(items, 1, batchSize);
+				for(UInt itemNumber = 0; itemNumber < count; ++itemNumber)
+				{
+					if(items[itemNumber] != element++)
+					{
+						++errorCount;
+					}
+				}
+			}
+		}
+		report(round, compareTimes(pTimer->getTime(), benchmark.roundStartTime), errorCount);
+
+		benchmark.roundCompleteEvent.signal();
+	}
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * queueBenchmark
+//------------------------------------------------------------------------------------------------
+
+void queueBenchmark()
+{
+	// the number of elements must be a multiple of every batch size
+	const UInt numberOfElements = 64 * 2000;
+	const UInt queueCapacity = 256;
+
+	QueueBenchmark *pBenchmark = new QueueBenchmark(numberOfElements, queueCapacity);
+	(new QueueConsumerTask(*pBenchmark))->resume();
+	(new QueueProducerTask(*pBenchmark))->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
@@ -0,0 +1,209 @@
+#include "Task.h"
+#include "TaskScheduler.h"
+#include "IntertaskEvent.h"
+#include "Timer.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+static const UInt numbersOfReadyTasks[] = {1, 8, 32, 128, 512};
+static const UInt numberOfReadyTaskCounts = arrayDimension(numbersOfReadyTasks);
+static const UInt numberOfRepetitions = 20000;
+
+//------------------------------------------------------------------------------------------------
+// * class ReadyTask
+//------------------------------------------------------------------------------------------------
+
+class ReadyTask : public Task
+{
+public:
+	// constructor
+	ReadyTask(UInt priority);
+
+protected:
+	// main entry point
+	void main();
+};
+
+ReadyTask::ReadyTask(UInt priority) :
+	Task(priority, 10000)
+{
+}
+
+void ReadyTask::main()
+{
+	// only waits in the ready queue, the benchmark deletes it before it gets to run
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class AnsweringTask
+//------------------------------------------------------------------------------------------------
+
+class AnsweringTask : public Task
+{
+public:
+	// constructor
+	AnsweringTask(IntertaskEvent &questionEvent, IntertaskEvent &answerEvent);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	IntertaskEvent &questionEvent;
+	IntertaskEvent &answerEvent;
+};
+
+AnsweringTask::AnsweringTask(IntertaskEvent &questionEvent, IntertaskEvent &answerEvent) :
+	Task(realtimePriority + 1, 10000),
+	questionEvent(questionEvent),
+	answerEvent(answerEvent)
+{
+}
+
+void AnsweringTask::main()
+{
+	// answer every question
+	while(true)
+	{
+		questionEvent.wait();
+		answerEvent.signal();
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class ReadyQueueBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class ReadyQueueBenchmarkTask : public Task
+{
+public:
+	// constructor
+	ReadyQueueBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	void measure(UInt numberOfReadyTasks, Bool spreadPriorities);
+	void report(TimeValue elapsedTicks);
+
+	// representation
+	Timer *pTimer;
+	IntertaskEvent questionEvent;
+	IntertaskEvent answerEvent;
+};
+
+ReadyQueueBenchmarkTask::ReadyQueueBenchmarkTask() :
+	Task(realtimePriority, 10000)
+{
+	pTimer = null;
+}
+
+void ReadyQueueBenchmarkTask::report(TimeValue elapsedTicks)
+{
+	#if defined(PRINT)
+		const UInt64 nanoseconds = (UInt64)elapsedTicks * 1000000000 / pTimer->getFrequency();
+		std::cout << "\t" << (UInt)(nanoseconds / numberOfRepetitions);
+	#endif
+}
+
+void ReadyQueueBenchmarkTask::measure(UInt numberOfReadyTasks, Bool spreadPriorities)
+{
+	// fill the ready queue with tasks below this one, either all of the default priority or
+	// spread evenly from low to just under high priority, none of them gets to run
+	ReadyTask **ppReadyTasks = new ReadyTask *[numberOfReadyTasks];
+	for(UInt taskNumber = 0; taskNumber < numberOfReadyTasks; ++taskNumber)
+	{
+		const UInt priority = spreadPriorities
+			? lowPriority + (UInt)((UInt64)taskNumber * (highPriority - lowPriority) / numberOfReadyTasks)
+			: defaultPriority;
+		ppReadyTasks[taskNumber] = new ReadyTask(priority);
+		ppReadyTasks[taskNumber]->resume();
+	}
+
+	// take a task of the default priority out of the ready queue and put it back, as blocking
+	// and waking up do
+	ReadyTask *pTask = ppReadyTasks[numberOfReadyTasks / 2];
+	TimeValue startTime = pTimer->getTime();
+	for(UInt repetition = 0; repetition < numberOfRepetitions; ++repetition)
+	{
+		pTask->suspend();
+		pTask->resume();
+	}
+	report(compareTimes(pTimer->getTime(), startTime));
+
+	// switch to a higher priority task and back, the ready tasks stay queued behind
+	startTime = pTimer->getTime();
+	for(UInt repetition = 0; repetition < numberOfRepetitions; ++repetition)
+	{
+		questionEvent.signal();
+		answerEvent.wait();
+	}
+	report(compareTimes(pTimer->getTime(), startTime));
+
+	// deleting a task takes it out of the ready queue
+	for(UInt taskNumber = 0; taskNumber < numberOfReadyTasks; ++taskNumber)
+	{
+		delete ppReadyTasks[taskNumber];
+	}
+	delete [] ppReadyTasks;
+}
+
+void ReadyQueueBenchmarkTask::main()
+{
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	(new AnsweringTask(questionEvent, answerEvent))->resume();
+
+	// compare the cost of scheduling with more and more tasks ready to run
+	#if defined(PRINT)
+		#if defined(USE_BANDED_READY_QUEUE)
+			std::cout << "Banded ready queue, ns per operation\n";
+		#else
+			std::cout << "Sorted list ready queue, ns per operation\n";
+		#endif
+		std::cout << "Ready tasks\tSame priority: remove and add\tswitch\tSpread priorities: remove and add\tswitch\n";
+	#endif
+	for(UInt countNumber = 0; countNumber < numberOfReadyTaskCounts; ++countNumber)
+	{
+		#if defined(PRINT)
+			std::cout << numbersOfReadyTasks[countNumber];
+		#endif
+		measure(numbersOfReadyTasks[countNumber], false);
+		measure(numbersOfReadyTasks[countNumber], true);
+		#if defined(PRINT)
+			std::cout << "\n";
+		#endif
+	}
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * readyQueueBenchmark
+//------------------------------------------------------------------------------------------------
+
+void readyQueueBenchmark()
+{
+	(new ReadyQueueBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
@@ -0,0 +1,155 @@
+#include "Task.h"
+#include "TaskScheduler.h"
+#include "IntertaskRingQueue.h"
+#include "TimeInterval.h"
+#include "sleep.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+static const UInt numberOfItems = 20000;
+static const UInt itemsPerInterrupt = 4;
+static const UInt queueCapacity = 16;
+static const UInt interruptPeriodInMicroseconds = 200;
+static const UInt itemsBetweenPauses = 1000;
+static const UInt pauseInMilliseconds = 2;
+static const UInt lostWakeupTimeoutInMilliseconds = 1000;
+
+//------------------------------------------------------------------------------------------------
+// * class ProducerInterval
+//------------------------------------------------------------------------------------------------
+
+class ProducerInterval : public TimeInterval
+{
+public:
+	// constructor
+	ProducerInterval(Timer &timer, TimeValue period, IntertaskRingQueue<UInt> &queue);
+
+	// representation
+	volatile UInt numberOfProducedItems;
+	volatile UInt numberOfDroppedItems;
+
+protected:
+	// behaviour
+	void handleExpiry();
+
+private:
+	// representation
+	TimeValue period;
+	IntertaskRingQueue<UInt> &queue;
+};
+
+ProducerInterval::ProducerInterval(Timer &timer, TimeValue period, IntertaskRingQueue<UInt> &queue) :
+	TimeInterval(timer),
+	period(period),
+	queue(queue)
+{
+	numberOfProducedItems = 0;
+	numberOfDroppedItems = 0;
+}
+
+void ProducerInterval::handleExpiry()
+{
+	// produce from the interrupt handler, an item that does not fit is dropped and produced again
+	// by the next interrupt, so that the consumer must see every item in order
+	for(UInt i = 0; i < itemsPerInterrupt && numberOfProducedItems < numberOfItems; ++i)
+	{
+		if(!queue.tryAddLast(numberOfProducedItems))
+		{
+			++numberOfDroppedItems;
+			break;
+		}
+		++numberOfProducedItems;
+	}
+	if(numberOfProducedItems < numberOfItems)
+	{
+		beginTimingUntil(getExpiryTime() + period);
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class RingQueueTestTask
+//------------------------------------------------------------------------------------------------
+
+class RingQueueTestTask : public Task
+{
+public:
+	// constructor
+	RingQueueTestTask();
+
+protected:
+	// main entry point
+	void main();
+};
+
+RingQueueTestTask::RingQueueTestTask() :
+	Task(highPriority, 20000)
+{
+}
+
+void RingQueueTestTask::main()
+{
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	IntertaskRingQueue<UInt> queue(queueCapacity);
+	ProducerInterval producer(*pTimer, pTimer->convertMicroseconds(interruptPeriodInMicroseconds),
+		queue);
+	producer.beginTimingFor(pTimer->convertMicroseconds(interruptPeriodInMicroseconds));
+
+	// consume every item in order, a wake up lost by the queue shows up as a timeout, and
+	// pausing now and then lets the interrupt handler fill the queue
+	UInt numberOfConsumedItems = 0;
+	UInt numberOfOutOfOrderItems = 0;
+	Bool timedOut = false;
+	while(numberOfConsumedItems < numberOfItems)
+	{
+		UInt item;
+		if(queue.removeFirst(&item, pTimer->convertMilliseconds(lostWakeupTimeoutInMilliseconds)))
+		{
+			timedOut = true;
+			break;
+		}
+		if(item != numberOfConsumedItems)
+		{
+			++numberOfOutOfOrderItems;
+		}
+		if(++numberOfConsumedItems % itemsBetweenPauses == 0)
+		{
+			sleepForMilliseconds(pauseInMilliseconds);
+		}
+	}
+	producer.stopTiming();
+
+	const Bool passed = !timedOut && numberOfOutOfOrderItems == 0 && queue.isEmpty()
+		&& producer.numberOfDroppedItems != 0;
+	#if defined(PRINT)
+		std::cout << "Interrupt handler producing " << numberOfItems << " items into a "
+			<< queue.getCapacity() << " slot queue: " << numberOfConsumedItems << " consumed, "
+			<< numberOfOutOfOrderItems << " out of order, " << producer.numberOfDroppedItems
+			<< " times full" << (timedOut ? ", consumer wake up LOST" : "")
+			<< (passed ? "" : " FAILED") << "\n";
+		exit(passed ? 0 : 1);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * ringQueueTest
+//------------------------------------------------------------------------------------------------
+
+void ringQueueTest()
+{
+	(new RingQueueTestTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
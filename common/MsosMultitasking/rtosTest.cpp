@@ -1,5 +1,6 @@
 #include "Task.h"
 #include "Mutex.h"
+#include "IntertaskEvent.h"
 #include "IntertaskQueue.h"
 #include "LockedSection.h"
 #if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
@@ -44,6 +45,61 @@ UInt NumberedTask::taskCount = 0;
 Mutex NumberedTask::taskCountMutex; 
 
 
+//------------------------------------------------------------------------------------------------
+// * class TimeoutTask
+//------------------------------------------------------------------------------------------------
+
+class TimeoutTask : public Task
+{
+public:
+	// constructor
+	TimeoutTask();
+
+	// representation
+	static volatile Bool passed;
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// testing
+	Bool check(const char *pDescription, Bool timedOut, Bool expectedTimedOut);
+};
+
+TimeoutTask::TimeoutTask() :
+	Task(realtimePriority, 10000)
+{
+}
+
+Bool TimeoutTask::check(const char *pDescription, Bool timedOut, Bool expectedTimedOut)
+{
+	#if defined(PRINT)
+		std::cout << "Timeout: " << pDescription << (timedOut ? " timed out" : " succeeded")
+			<< (timedOut == expectedTimedOut ? "" : " FAILED") << '\n';
+	#endif
+	return timedOut == expectedTimedOut;
+}
+
+void TimeoutTask::main()
+{
+	// an end time that has already passed must not block, the timeout could never unblock the
+	// task, so the wait only takes a signal that is already there, and reports a timeout otherwise
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	IntertaskEvent event;
+	Bool allPassed = check("unsignalled, end time passed",
+		event.waitUntil(pTimer->getTime() - pTimer->convertMilliseconds(1)), true);
+	allPassed = check("unsignalled, end time now", event.waitUntil(pTimer->getTime()), true)
+		&& allPassed;
+	event.signal();
+	allPassed = check("signalled, end time passed",
+		event.waitUntil(pTimer->getTime() - pTimer->convertMilliseconds(1)), false) && allPassed;
+	passed = allPassed && !event.isSignalled();
+}
+
+volatile Bool TimeoutTask::passed = false;
+
+
 //------------------------------------------------------------------------------------------------
 // * class Task1
 //------------------------------------------------------------------------------------------------
@@ -76,7 +132,7 @@ void Task1::main()
 
 		yield();
 
-		delete pBuffer;
+		delete [] pBuffer;
 	}
 }
 
@@ -179,8 +235,9 @@ void Consumer::main()
 	LockedSection lockedSection(consumerCountMutex); 
 	if(--consumerCount == 0)
 	{
+		// the timeout task runs first, if one of its waits hung it never passed
 		#if defined(PRINT)
-			exit(0);
+			exit(TimeoutTask::passed ? 0 : 1);
 		#endif
 	}
 }
@@ -200,6 +257,9 @@ void rtosTest()
 	const UInt numberOfConsumers = 3;
 	const UInt productQueueCapacity = 4;
 
+	// check the timeouts before the other tasks run
+	(new TimeoutTask())->resume();
+
 	// create a bunch of tasks
 	{
 		for(UInt taskNumber = 0; taskNumber < numberOfTask1s; ++taskNumber)
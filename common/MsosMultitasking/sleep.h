@@ -3,7 +3,8 @@
 
 #include "TaskScheduler.h"
 #include "IntertaskEvent.h"
-#if defined(__TARGET_CPU_ARM920T) || defined(__TARGET_CPU_SA_1100)
+#if defined(__TARGET_CPU_ARM920T) || defined(__TARGET_CPU_SA_1100) \
+	|| defined(__x86_64__) && defined(__linux__)
 	#define TIMER_SUPPORTED
 #endif
 
@@ -0,0 +1,201 @@
+#include "Task.h"
+#include "TaskScheduler.h"
+#include "IntertaskEvent.h"
+#include "sleep.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+static const UInt testStackSize = 32 * 1024;
+static const UInt frameSize = 1024;
+static const UInt numberOfDepths = 4;
+static const UInt depths[numberOfDepths] = {1, 2, 4, 8};
+static const UInt64 guardValue = 0x0123456789ABCDEFull;
+
+//------------------------------------------------------------------------------------------------
+// * useStack
+//------------------------------------------------------------------------------------------------
+
+static UInt useStack(UInt depth)
+{
+	// write to a whole frame at every level, so that it shows up in the stack usage
+	volatile UInt8 frame[frameSize];
+	for(UInt i = 0; i < frameSize; ++i)
+	{
+		frame[i] = (UInt8)depth;
+	}
+	return depth <= 1 ? frame[0] : useStack(depth - 1) + frame[frameSize - 1];
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class StackUserTask
+//------------------------------------------------------------------------------------------------
+
+class StackUserTask : public Task
+{
+public:
+	// constructors
+	StackUserTask(UInt priority);
+	StackUserTask(UInt priority, void *pStack, UInt stackSize);
+
+	// using the stack
+	void useFrames(UInt depth);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// representation
+	volatile UInt depth;
+	IntertaskEvent requestEvent;
+	IntertaskEvent doneEvent;
+};
+
+StackUserTask::StackUserTask(UInt priority) :
+	Task(priority, testStackSize)
+{
+	depth = 0;
+}
+
+StackUserTask::StackUserTask(UInt priority, void *pStack, UInt stackSize) :
+	Task(priority, pStack, stackSize)
+{
+	depth = 0;
+}
+
+void StackUserTask::useFrames(UInt depth)
+{
+	this->depth = depth;
+	requestEvent.signal();
+	doneEvent.wait();
+}
+
+void StackUserTask::main()
+{
+	for(;;)
+	{
+		requestEvent.wait();
+		useStack(depth);
+		doneEvent.signal();
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class StackUsageTestTask
+//------------------------------------------------------------------------------------------------
+
+class StackUsageTestTask : public Task
+{
+public:
+	// constructor
+	StackUsageTestTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// testing
+	#if defined(USE_STACK_PAINTING)
+		Bool check(const char *pDescription, StackUserTask &task);
+	#endif
+};
+
+StackUsageTestTask::StackUsageTestTask() :
+	Task(highPriority, 20000)
+{
+}
+
+#if defined(USE_STACK_PAINTING)
+	Bool StackUsageTestTask::check(const char *pDescription, StackUserTask &task)
+	{
+		// a task that has not run has only used the frame it starts from
+		const UInt startUsage = task.getPeakStackUsage();
+		Bool passed = startUsage < frameSize;
+		#if defined(PRINT)
+			std::cout << pDescription << ", " << task.getStackSize() << " bytes: " << startUsage
+				<< " bytes before running";
+		#endif
+
+		// every level of recursion adds a frame, and the peak stays when the recursion returns
+		task.resume();
+		UInt previousUsage = startUsage;
+		for(UInt depthNumber = 0; depthNumber < numberOfDepths; ++depthNumber)
+		{
+			task.useFrames(depths[depthNumber]);
+			const UInt usage = task.getPeakStackUsage();
+			passed = passed
+				&& usage >= startUsage + depths[depthNumber] * frameSize
+				&& usage >= previousUsage
+				&& usage < task.getStackSize();
+			previousUsage = usage;
+			#if defined(PRINT)
+				std::cout << ", " << usage << " after " << depths[depthNumber] << " frames";
+			#endif
+		}
+		task.useFrames(1);
+		passed = passed && task.getPeakStackUsage() == previousUsage;
+		task.suspend();
+
+		#if defined(PRINT)
+			std::cout << (passed ? "" : " FAILED") << "\n";
+		#endif
+		return passed;
+	}
+#endif
+
+void StackUsageTestTask::main()
+{
+	#if defined(USE_STACK_PAINTING)
+		// the caller supplied stack, between two guards which painting it must not overwrite
+		static struct
+		{
+			UInt64 guardBefore;
+			UInt64 stack[testStackSize / sizeof(UInt64)];
+			UInt64 guardAfter;
+		} suppliedStack = {guardValue, {0}, guardValue};
+
+		StackUserTask heapStackTask(mediumPriority);
+		StackUserTask suppliedStackTask(mediumPriority, suppliedStack.stack,
+			sizeof(suppliedStack.stack));
+		Bool passed = check("Heap stack", heapStackTask);
+		passed = check("Supplied stack", suppliedStackTask) && passed;
+		const Bool guarded = suppliedStack.guardBefore == guardValue
+			&& suppliedStack.guardAfter == guardValue;
+		passed = passed && guarded;
+		#if defined(PRINT)
+			std::cout << "Supplied stack guards: " << (guarded ? "intact" : "OVERWRITTEN") << "\n";
+			exit(passed ? 0 : 1);
+		#endif
+	#else
+		#if defined(PRINT)
+			std::cout << "Stack painting is off, build with DEFINES=-DUSE_STACK_PAINTING\n";
+			exit(0);
+		#endif
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * stackUsageTest
+//------------------------------------------------------------------------------------------------
+
+void stackUsageTest()
+{
+	(new StackUsageTestTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
@@ -0,0 +1,205 @@
+#include "Task.h"
+#include "TaskScheduler.h"
+#include "Timer.h"
+#include "UninterruptableSection.h"
+#include "sleep.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+static const UInt numberOfWorkers = 3;
+static const UInt timeSliceInMilliseconds = 5;
+static const UInt sharingTimeInMilliseconds = 200;
+static const UInt aloneTimeInMilliseconds = 100;
+
+// each worker would get sharingTime / (timeSlice * numberOfWorkers) turns, ask for a third
+static const UInt minimumTurnCount = sharingTimeInMilliseconds / timeSliceInMilliseconds
+	/ numberOfWorkers / 3;
+
+//------------------------------------------------------------------------------------------------
+// * class WorkerTask
+//------------------------------------------------------------------------------------------------
+
+class WorkerTask : public Task
+{
+public:
+	// constructor
+	WorkerTask();
+
+	// modifying
+	void resetCounts();
+
+	// representation
+	volatile UInt turnCount;
+	volatile UInt timedSpinCount;
+	volatile UInt untimedSpinCount;
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// the worker that ran last, so that each worker can count the turns it is given
+	static WorkerTask *volatile pLastWorker;
+};
+
+WorkerTask *volatile WorkerTask::pLastWorker = null;
+
+WorkerTask::WorkerTask() :
+	Task(mediumPriority, 20000)
+{
+	resetCounts();
+}
+
+void WorkerTask::resetCounts()
+{
+	turnCount = 0;
+	timedSpinCount = 0;
+	untimedSpinCount = 0;
+}
+
+void WorkerTask::main()
+{
+	// never yield or block, only the time slice makes room for the other workers
+	TaskScheduler *pScheduler = TaskScheduler::getCurrentTaskScheduler();
+	for(;;)
+	{
+		// count each spin as a whole, so that the counts are not reset in the middle of one
+		UninterruptableSection criticalSection;
+		if(pLastWorker != this)
+		{
+			pLastWorker = this;
+			++turnCount;
+		}
+		if(pScheduler->isTimingTimeSlice())
+		{
+			++timedSpinCount;
+		}
+		else
+		{
+			++untimedSpinCount;
+		}
+	}
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * class TimeSliceTestTask
+//------------------------------------------------------------------------------------------------
+
+class TimeSliceTestTask : public Task
+{
+public:
+	// constructor
+	TimeSliceTestTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// testing
+	Bool checkAlone(const char *pDescription);
+	Bool checkSharing();
+
+	// representation
+	WorkerTask workers[numberOfWorkers];
+};
+
+TimeSliceTestTask::TimeSliceTestTask() :
+	Task(realtimePriority, 20000)
+{
+}
+
+Bool TimeSliceTestTask::checkAlone(const char *pDescription)
+{
+	// a worker on its own at the top priority must run without a time slice being timed
+	workers[0].resetCounts();
+	sleepForMilliseconds(aloneTimeInMilliseconds);
+	const Bool passed = workers[0].timedSpinCount == 0 && workers[0].untimedSpinCount != 0;
+
+	#if defined(PRINT)
+		std::cout << pDescription << ": " << workers[0].timedSpinCount << " of "
+			<< workers[0].timedSpinCount + workers[0].untimedSpinCount
+			<< " spins with the time slice timed" << (passed ? "" : " FAILED") << "\n";
+	#endif
+	return passed;
+}
+
+Bool TimeSliceTestTask::checkSharing()
+{
+	// workers sharing the top priority must all be given turns while the time slice is timed
+	for(UInt workerNumber = 0; workerNumber < numberOfWorkers; ++workerNumber)
+	{
+		workers[workerNumber].resetCounts();
+	}
+	for(UInt workerNumber = 1; workerNumber < numberOfWorkers; ++workerNumber)
+	{
+		workers[workerNumber].resume();
+	}
+	sleepForMilliseconds(sharingTimeInMilliseconds);
+	for(UInt workerNumber = 1; workerNumber < numberOfWorkers; ++workerNumber)
+	{
+		workers[workerNumber].suspend();
+	}
+
+	Bool passed = true;
+	for(UInt workerNumber = 0; workerNumber < numberOfWorkers; ++workerNumber)
+	{
+		const WorkerTask &worker = workers[workerNumber];
+		const Bool workerPassed = worker.turnCount >= minimumTurnCount
+			&& worker.timedSpinCount != 0;
+		passed = passed && workerPassed;
+
+		#if defined(PRINT)
+			std::cout << "  worker " << workerNumber << ": " << worker.turnCount << " turns, "
+				<< worker.timedSpinCount << " of " << worker.timedSpinCount + worker.untimedSpinCount
+				<< " spins with the time slice timed" << (workerPassed ? "" : " FAILED") << "\n";
+		#endif
+	}
+	return passed;
+}
+
+void TimeSliceTestTask::main()
+{
+	TaskScheduler *pScheduler = TaskScheduler::getCurrentTaskScheduler();
+	pScheduler->setTimeSlice(pScheduler->getTimer()->convertMilliseconds(timeSliceInMilliseconds));
+
+	#if defined(PRINT)
+		std::cout << "Time slice of " << timeSliceInMilliseconds << "ms, " << numberOfWorkers
+			<< " CPU bound workers\n";
+	#endif
+	workers[0].resume();
+	Bool passed = checkAlone("One worker ready");
+	#if defined(PRINT)
+		std::cout << numberOfWorkers << " workers ready for " << sharingTimeInMilliseconds << "ms\n";
+	#endif
+	passed = checkSharing() && passed;
+	passed = checkAlone("One worker ready again") && passed;
+
+	#if defined(PRINT)
+		exit(passed ? 0 : 1);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * timeSliceTest
+//------------------------------------------------------------------------------------------------
+
+void timeSliceTest()
+{
+	(new TimeSliceTestTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
@@ -0,0 +1,159 @@
+#include "Task.h"
+#include "TimeInterval.h"
+#include "sleep.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * class BenchmarkInterval
+//------------------------------------------------------------------------------------------------
+
+class BenchmarkInterval : public TimeInterval
+{
+public:
+	// constructor
+	BenchmarkInterval(Timer &timer);
+
+	// representation
+	static UInt expiryCount;
+	static TimeValue maximumLateness;
+
+protected:
+	// behaviour
+	void handleExpiry();
+};
+
+BenchmarkInterval::BenchmarkInterval(Timer &timer) :
+	TimeInterval(timer)
+{
+}
+
+void BenchmarkInterval::handleExpiry()
+{
+	// keep track of how late the interval has been expired
+	const TimeValue lateness = compareTimes(
+		TaskScheduler::getCurrentTaskScheduler()->getTimer()->getTime(), getExpiryTime());
+	if(lateness > maximumLateness)
+	{
+		maximumLateness = lateness;
+	}
+	++expiryCount;
+}
+
+UInt BenchmarkInterval::expiryCount = 0;
+TimeValue BenchmarkInterval::maximumLateness = 0;
+
+
+//------------------------------------------------------------------------------------------------
+// * class TimerBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class TimerBenchmarkTask : public Task
+{
+public:
+	// constructor
+	TimerBenchmarkTask(UInt numberOfIntervals);
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// benchmarking
+	TimeValue getRandomDelay();
+	void report(const char *pDescription, TimeValue elapsedTicks);
+
+	// representation
+	UInt numberOfIntervals;
+	UInt seed;
+	Timer *pTimer;
+};
+
+TimerBenchmarkTask::TimerBenchmarkTask(UInt numberOfIntervals) :
+	Task(defaultPriority + 1, 10000)
+{
+	this->numberOfIntervals = numberOfIntervals;
+	seed = 1;
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+}
+
+TimeValue TimerBenchmarkTask::getRandomDelay()
+{
+	// spread the timeouts from a millisecond to a couple of seconds
+	seed = seed * 1664525 + 1013904223;
+	return pTimer->convertMilliseconds(1 + (seed >> 16) % 2000);
+}
+
+void TimerBenchmarkTask::report(const char *pDescription, TimeValue elapsedTicks)
+{
+	#if defined(PRINT)
+		const UInt64 microseconds = (UInt64)elapsedTicks * 1000000 / pTimer->getFrequency();
+		std::cout << pDescription << ": " << (UInt)microseconds << "us for "
+			<< numberOfIntervals << " intervals\n";
+	#endif
+}
+
+void TimerBenchmarkTask::main()
+{
+	BenchmarkInterval **ppIntervals = new BenchmarkInterval *[numberOfIntervals];
+	for(UInt intervalNumber = 0; intervalNumber < numberOfIntervals; ++intervalNumber)
+	{
+		ppIntervals[intervalNumber] = new BenchmarkInterval(*pTimer);
+	}
+
+	// start all of the intervals
+	TimeValue startTime = pTimer->getTime();
+	{
+		for(UInt intervalNumber = 0; intervalNumber < numberOfIntervals; ++intervalNumber)
+		{
+			ppIntervals[intervalNumber]->beginTimingFor(getRandomDelay());
+		}
+	}
+	report("Start", compareTimes(pTimer->getTime(), startTime));
+
+	// restart the intervals before they expire, as timeouts usually are
+	startTime = pTimer->getTime();
+	{
+		for(UInt intervalNumber = 0; intervalNumber < numberOfIntervals; ++intervalNumber)
+		{
+			ppIntervals[intervalNumber]->beginTimingFor(getRandomDelay());
+		}
+	}
+	report("Restart", compareTimes(pTimer->getTime(), startTime));
+
+	// let every interval expire
+	while(BenchmarkInterval::expiryCount < numberOfIntervals)
+	{
+		sleepForMilliseconds(100);
+	}
+	report("Maximum lateness", BenchmarkInterval::maximumLateness);
+
+	#if defined(PRINT)
+		exit(0);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * timerBenchmark
+//------------------------------------------------------------------------------------------------
+
+void timerBenchmark()
+{
+	const UInt numberOfIntervals = 4000;
+
+	(new TimerBenchmarkTask(numberOfIntervals))->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
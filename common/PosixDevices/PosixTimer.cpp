@@ -0,0 +1,94 @@
+#include "PosixTimer.h"
+#include "../multitasking/TaskScheduler.h"
+#include "../memoryUtilities.h"
+#include <signal.h>
+
+//------------------------------------------------------------------------------------------------
+// * PosixTimer::PosixTimer
+//
+// Constructor.
+//------------------------------------------------------------------------------------------------
+
+PosixTimer::PosixTimer()
+{
+	// add interrupt handler
+	TaskScheduler::getCurrentTaskScheduler()->addInterruptHandler(this);
+
+	// create a disarmed timer which will raise SIGALRM
+	sigevent event;
+	memoryZero(&event, sizeof(event));
+	event.sigev_notify = SIGEV_SIGNAL;
+	event.sigev_signo = SIGALRM;
+	timer_create(CLOCK_MONOTONIC, &event, &timerId);
+}
+
+//------------------------------------------------------------------------------------------------
+// * PosixTimer::~PosixTimer
+//
+// Destructor.
+//------------------------------------------------------------------------------------------------
+
+PosixTimer::~PosixTimer()
+{
+	// delete the timer (this also disarms it)
+	timer_delete(timerId);
+
+	// remove interrupt handler
+	TaskScheduler::getCurrentTaskScheduler()->removeInterruptHandler(this);
+}
+
+//------------------------------------------------------------------------------------------------
+// * PosixTimer::updateIntervals
+//
+// Handles a change in the list of intervals.
+// Schedules an interrupt for the first time interval to expire.
+//------------------------------------------------------------------------------------------------
+
+void PosixTimer::updateIntervals()
+{
+	// a zero time disarms the timer
+	itimerspec matchTime;
+	memoryZero(&matchTime, sizeof(matchTime));
+
+	// check if there are any time intervals
+	if(hasIntervals())
+	{
+		// match for the expiry time of the first interval or wheel slot (but no sooner than the next tick)
+		TimeValue ticksUntilExpiry = compareTimes(getNextMatchTime(), getTime());
+		if(ticksUntilExpiry < 1)
+		{
+			ticksUntilExpiry = 1;
+		}
+		matchTime.it_value.tv_sec = ticksUntilExpiry / frequency;
+		matchTime.it_value.tv_nsec = ticksUntilExpiry % frequency * (1000000000 / frequency);
+	}
+
+	timer_settime(timerId, 0, &matchTime, null);
+}
+
+//------------------------------------------------------------------------------------------------
+// * PosixTimer::handleInterrupt
+//
+// Handles interrupts.
+//------------------------------------------------------------------------------------------------
+
+Bool PosixTimer::handleInterrupt()
+{
+	// determine if this is a timer interrupt
+	if(hasIntervals())
+	{
+		if(compareTimes(getTime(), getNextMatchTime()) >= 0)
+		{
+			// handle the change in time
+			tick();
+			return true;
+		}
+
+		// the interrupt may be for someone else or the timer may have fired early,
+		// make sure that the next match time is still matched
+		updateIntervals();
+	}
+
+	// not a timer interrupt
+	return false;
+}
@@ -0,0 +1,105 @@
+#ifndef _PosixTimer_h_
+#define _PosixTimer_h_
+
+#include "../multitasking/Timer.h"
+#include "../multitasking/InterruptHandler.h"
+#include <time.h>
+
+//------------------------------------------------------------------------------------------------
+// * class PosixTimer
+//
+// Microsecond timer for POSIX hosts.
+// Time is read from the monotonic clock and a POSIX timer delivering SIGALRM takes the place
+// of a hardware match register interrupt.
+//------------------------------------------------------------------------------------------------
+
+class PosixTimer : public Timer, private InterruptHandler
+{
+public:
+	// constructor and destructor
+	PosixTimer();
+	~PosixTimer();
+
+	// querying
+	inline TimeValue getFrequency() const;
+	inline TimeValue convertSeconds(UInt seconds) const;
+	inline TimeValue convertMilliseconds(UInt milliseconds) const;
+	inline TimeValue convertMicroseconds(UInt microseconds) const;
+	inline TimeValue getTime() const;
+
+private:
+	// constants
+	enum
+	{
+		frequency = 1000000
+	};
+
+	// interval change handling
+	void updateIntervals();
+
+	// interrupt handling
+	Bool handleInterrupt();
+
+	// representation
+	timer_t timerId;
+};
+
+//------------------------------------------------------------------------------------------------
+// * PosixTimer::getFrequency
+//
+// Returns the number of ticks per second made by this timer.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue PosixTimer::getFrequency() const
+{
+	return frequency;
+}
+
+//------------------------------------------------------------------------------------------------
+// * PosixTimer::convertSeconds
+//
+// Converts <seconds> into clock ticks.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue PosixTimer::convertSeconds(UInt seconds) const
+{
+	return frequency * seconds;
+}
+
+//------------------------------------------------------------------------------------------------
+// * PosixTimer::convertMilliseconds
+//
+// Converts <milliseconds> into clock ticks.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue PosixTimer::convertMilliseconds(UInt milliseconds) const
+{
+	return frequency / 1000 * milliseconds;
+}
+
+//------------------------------------------------------------------------------------------------
+// * PosixTimer::convertMicroseconds
+//
+// Converts <microseconds> into clock ticks.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue PosixTimer::convertMicroseconds(UInt microseconds) const
+{
+	return microseconds;
+}
+
+//------------------------------------------------------------------------------------------------
+// * PosixTimer::getTime
+//
+// Returns the current time.
+//------------------------------------------------------------------------------------------------
+
+inline TimeValue PosixTimer::getTime() const
+{
+	// read the monotonic clock, the tick count wraps around like a hardware counter
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (TimeValue)(UInt)((UInt64)now.tv_sec * frequency + now.tv_nsec / 1000);
+}
+
+#endif // _PosixTimer_h_
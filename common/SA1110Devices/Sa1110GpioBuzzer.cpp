@@ -40,7 +40,7 @@ void Sa1110GpioBuzzer::generateTone(UInt duration, UInt period)
 {
 	// switch to a higher priority so that the frequency will be accurate
 	Task *pCurrentTask = TaskScheduler::getCurrentTaskScheduler()->getCurrentTask();
-	const UInt savedPriority = pCurrentTask->getPriority();
+	const UInt savedPriority = pCurrentTask->getBasePriority();
 	pCurrentTask->setPriority(maximum(savedPriority, Task::realtimePriority + 1000));
 
 	// oscillate the output pin
@@ -51,16 +51,15 @@ Sa1110Timer::~Sa1110Timer()
 void Sa1110Timer::updateIntervals()
 {
 	// check if there are any time intervals
-	const TimeInterval *pFirstInterval = getFirstInterval();
-	if(pFirstInterval == null)
+	if(!hasIntervals())
 	{
 		// there are no time intervals, disable matching
 		getTimerRegisters()->interruptEnableRegister = 0x0;
 	}
 	else
 	{
-		// match for the expiry time of the first interval
-		getTimerRegisters()->matchRegisters[0] = pFirstInterval->getExpiryTime();
+		// match for the expiry time of the first interval (or the next wheel slot)
+		getTimerRegisters()->matchRegisters[0] = getNextMatchTime();
 		getTimerRegisters()->interruptEnableRegister = 0x1;
 	}
 }
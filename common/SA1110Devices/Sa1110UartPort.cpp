@@ -12,11 +12,15 @@
 //------------------------------------------------------------------------------------------------
 
 Sa1110UartPort::Sa1110UartPort(Sa1110UartPort::Port port) :
-	port(port)
+	port(port),
+	interruptWork(this),
+	receiveQueue(queueCapacity),
+	transmitQueue(queueCapacity)
 {
-	receiveLength = 0;
-	transmitLength = 0;
+	receiverStopped = false;
 	inError = false;
+	errorForced = false;
+	errorMarkerPending = false;
 	synchronizing = false;
 
 	// port dependent initialization
@@ -88,34 +92,60 @@ Sa1110UartPort::~Sa1110UartPort()
 
 UInt Sa1110UartPort::read(void *pDestination, UInt length, TimeValue timeout)
 {
-	// do not continue if we are in an error state
-	if(isInError())
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	const TimeValue endTime = timeout == infiniteTime ? 0 : pTimer->getTime() + timeout;
+	UInt8 *pBytes = (UInt8 *)pDestination;
+	UInt actualLength = 0;
+	while(actualLength < length)
 	{
-		return 0;
-	}
+		// do not continue if we are in an error state
+		if(isInError())
+		{
+			break;
+		}
 
-	// setup receive state
-	pReceiveBuffer = (UInt8 *)pDestination;
-	receiveLength = length;
+		// take the next byte, only waiting for one when none has been queued
+		UInt16 received;
+		if(!receiveQueue.tryRemoveFirst(&received))
+		{
+			TimeValue remainingTime = infiniteTime;
+			if(timeout != infiniteTime)
+			{
+				remainingTime = compareTimes(endTime, pTimer->getTime());
+				if(remainingTime <= 0)
+				{
+					break;
+				}
+			}
+			if(receiveQueue.removeFirst(&received, remainingTime))
+			{
+				// read timed-out, return number of bytes actually read
+				break;
+			}
+		}
 
-	// enable receiver interrupt
-	maskInterrupts();
+		// let the deferred work continue receiving, now that the full queue has room again
+		if(receiverStopped)
+		{
+			receiverStopped = false;
+			interruptWork.defer();
+		}
 
-	// wait for completion of the read
-	if(receiveEvent.wait(timeout))
-	{
-		// read timed-out, cancel read and return number of bytes actually read
-		UninterruptableSection critialSection;
-		const UInt actualLength = length - receiveLength;
-		receiveLength = 0;
-		maskInterrupts();
-		return actualLength;
-	}
-	else
-	{
-		// entire read completed
-		return length;
+		// check for an error marker
+		if((received & receiveErrorMarker) != 0)
+		{
+			// an error ends the read, unless the stream has been reset since, in which case
+			// the bytes received before the error are stale
+			if(isInError())
+			{
+				break;
+			}
+			actualLength = 0;
+			continue;
+		}
+		pBytes[actualLength++] = (UInt8)received;
 	}
+	return actualLength;
 }
 
 //------------------------------------------------------------------------------------------------
@@ -126,34 +156,44 @@ UInt Sa1110UartPort::read(void *pDestination, UInt length, TimeValue timeout)
 
 UInt Sa1110UartPort::write(const void *pSource, UInt length, TimeValue timeout)
 {
-	// do not continue if we are in an error state
-	if(isInError())
+	Timer *pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	const TimeValue endTime = timeout == infiniteTime ? 0 : pTimer->getTime() + timeout;
+	const UInt8 *pBytes = (const UInt8 *)pSource;
+	UInt actualLength = 0;
+	while(actualLength < length)
 	{
-		return 0;
-	}
+		// do not continue if we are in an error state
+		if(isInError())
+		{
+			break;
+		}
 
-	// setup transmit state
-	pTransmitBuffer = (UInt8 *)pSource;
-	transmitLength = length;
+		// queue the next byte, only waiting for room when the queue is full
+		if(!transmitQueue.tryAddLast(pBytes[actualLength]))
+		{
+			// the transmitter has to be emptying the queue while we wait
+			maskInterrupts();
+			TimeValue remainingTime = infiniteTime;
+			if(timeout != infiniteTime)
+			{
+				remainingTime = compareTimes(endTime, pTimer->getTime());
+				if(remainingTime <= 0)
+				{
+					break;
+				}
+			}
+			if(transmitQueue.addLast(pBytes[actualLength], remainingTime))
+			{
+				// write timed-out, return number of bytes actually written
+				break;
+			}
+		}
+		++actualLength;
+	}
 
 	// enable transmitter interrupt
 	maskInterrupts();
-
-	// wait for completion of the write
-	if(transmitEvent.wait(timeout))
-	{
-		// write timed-out, cancel write and return number of bytes actually written
-		UninterruptableSection critialSection;
-		const UInt actualLength = length - transmitLength;
-		transmitLength = 0;
-		maskInterrupts();
-		return actualLength;
-	}
-	else
-	{
-		// entire write completed
-		return length;
-	}
+	return actualLength;
 }
 
 //------------------------------------------------------------------------------------------------
@@ -167,9 +207,11 @@ void Sa1110UartPort::forceError()
 	// check if an error has occurred
 	if(!isInError())
 	{
-		// force an error
-		UninterruptableSection criticalSection;
-		handleError();
+		// force an error, the deferred work wakes up the reading and writing tasks because it
+		// is the only one to touch their side of the queues
+		inError = true;
+		errorForced = true;
+		interruptWork.defer();
 	}
 }
 
@@ -279,15 +321,15 @@ void Sa1110UartPort::maskInterrupts()
 	// start with both receiver and transmitter enabled
 	UInt cr3 = 0x03;
 
-	// check if there is a pending read
-	if(receiveLength != 0)
+	// check if there is room for received bytes
+	if(!receiveQueue.isFull())
 	{
 		// enable receiver interrupt
 		cr3 |= 0x08;
 	}
 
-	// check if there is a pending write
-	if(transmitLength != 0)
+	// check if there are bytes to transmit
+	if(!transmitQueue.isEmpty())
 	{
 		// enable transmitter interrupt
 		cr3 |= 0x10;
@@ -301,6 +343,8 @@ void Sa1110UartPort::maskInterrupts()
 // * Sa1110UartPort::handleInterrupt
 //
 // Interrupt handler.
+// The interrupt stays masked until the deferred work has serviced the port, the FIFOs hold the
+// data meanwhile.
 //------------------------------------------------------------------------------------------------
 
 Bool Sa1110UartPort::handleInterrupt()
@@ -308,102 +352,131 @@ Bool Sa1110UartPort::handleInterrupt()
 	// determine if this interrupt is for us
 	if(Sa1110InterruptController::getCurrentInterruptController()->isPending(getInterruptNumber()))
 	{
-		// receive data
-		if(receiveLength != 0)
-		{
-			UInt sr1;
-			while(((sr1 = readRegister(utsr1)) & 0x02) != 0)
-			{
-				// receive one byte
-				*(pReceiveBuffer++) = readRegister(utdr0);
+		// service the port with interrupts enabled
+		Sa1110InterruptController::getCurrentInterruptController()->disable(getInterruptNumber());
+		interruptWork.defer();
 
-				// check for hardware detected errors
-				if((sr1 & 0x70) != 0)
-				{
-					// handle the error condition
-					handleError();
+		// interrupt handled
+		return true;
+	}
 
-					break;
-				}
+	// interrupt not for us
+	return false;
+}
 
-				// check if read completed
-				if(--receiveLength == 0)
-				{
-					// signal completion of a read
-					receiveEvent.signal();
+//------------------------------------------------------------------------------------------------
+// * Sa1110UartPort::handleDeferredInterrupt
+//
+// Services the port after an interrupt, then unmasks the interrupt again.
+// Received bytes are queued for the reading task and queued bytes are transmitted, only as many
+// as the queues and FIFOs have room for.
+//------------------------------------------------------------------------------------------------
 
-					// disable receiver interrupt
-					maskInterrupts();
+void Sa1110UartPort::handleDeferredInterrupt()
+{
+	// handle an error forced by a task
+	if(errorForced)
+	{
+		errorForced = false;
+		handleError();
+	}
 
-					break;
-				}
-			}
+	// check for other interrupt flags
+	UInt sr0 = readRegister(utsr0);
+	if(sr0 != 0)
+	{
+		// check for end of break
+		if(synchronizing && (sr0 & 0x10) != 0)
+		{
+			// synchronization complete
+			inError = false;
+			synchronizing = false;
+			synchronizationEvent.signal();
 		}
 
-		// transmit data
-		if(transmitLength != 0)
+		// check for begin of break
+		if((sr0 & 0x08) != 0)
 		{
-			while((readRegister(utsr1) & 0x04) != 0)
+			// synchronization initiated
+			handleError();
+
+			// flush receive FIFO
+			while((readRegister(utsr1) & 0x02) != 0)
 			{
-				// transmit one byte
-				writeRegister(utdr0, *(pTransmitBuffer++));
-	
-				// check if write completed
-				if(--transmitLength == 0)
-				{
-					// signal completion of write
-					transmitEvent.signal();
-	
-					// disable transmitter interrupt
-					maskInterrupts();
-	
-					break;
-				}
+				readRegister(utdr0);
 			}
 		}
 
-		// check for other interrupt flags
-		UInt sr0 = readRegister(utsr0);
-		if(sr0 != 0)
+		// clear the interrupts
+		writeRegister(utsr0, sr0);
+	}
+
+	// receive data
+	UInt sr1;
+	while(((sr1 = readRegister(utsr1)) & 0x02) != 0)
+	{
+		// drop bytes received in an error state
+		if(isInError())
 		{
-			// check for end of break
-			if(synchronizing && (sr0 & 0x10) != 0)
-			{
-				// synchronization complete
-				inError = false;
-				synchronizing = false;
-				synchronizationEvent.signal();
-			}
+			readRegister(utdr0);
+			continue;
+		}
 
-			// check for begin of break
-			if((sr0 & 0x08) != 0)
-			{
-				// synchronization initiated
-				handleError();
+		// leave the bytes in the FIFO until the reading task makes room for them
+		if(receiveQueue.isFull())
+		{
+			receiverStopped = true;
+			break;
+		}
 
-				// flush receive FIFO
-				while((readRegister(utsr1) & 0x02) != 0)
-				{
-					readRegister(utdr0);
-				}
-			}
+		// receive one byte
+		const UInt16 received = (UInt16)(readRegister(utdr0) & 0xFF);
 
-			// clear the interrupts
-			writeRegister(utsr0, sr0);
+		// check for hardware detected errors
+		if((sr1 & 0x70) != 0)
+		{
+			// handle the error condition
+			handleError();
+
+			break;
 		}
+		receiveQueue.tryAddLast(received);
+	}
 
-		// interrupt handled
-		return true;
+	// tell the reading task about an error, once there is room for the marker
+	if(errorMarkerPending)
+	{
+		if(receiveQueue.tryAddLast(receiveErrorMarker))
+		{
+			errorMarkerPending = false;
+		}
+		else
+		{
+			receiverStopped = true;
+		}
 	}
 
-	// interrupt not for us
-	return false;
+	// transmit data
+	UInt8 transmitted;
+	while((readRegister(utsr1) & 0x04) != 0 && transmitQueue.tryRemoveFirst(&transmitted))
+	{
+		// transmit one byte
+		writeRegister(utdr0, transmitted);
+	}
+
+	// disable the receiver interrupt while the receive queue is full and the transmitter
+	// interrupt once the transmit queue is empty
+	maskInterrupts();
+
+	// let the port interrupt again
+	Sa1110InterruptController::getCurrentInterruptController()->enable(getInterruptNumber());
 }
 
 //------------------------------------------------------------------------------------------------
 // * Sa1110UartPort::handleError
 //
 // Error handler.
+// This is only called by the deferred work.
 //------------------------------------------------------------------------------------------------
 
 void Sa1110UartPort::handleError()
@@ -411,15 +484,12 @@ void Sa1110UartPort::handleError()
 	// set flag to indicate an error
 	inError = true;
 
-	// terminate current transmissions
-	if(receiveLength != 0)
-	{
-		receiveLength = 0;
-		receiveEvent.signal();
-	}
-	if(transmitLength != 0)
+	// terminate current receptions, the marker wakes up a waiting reading task
+	errorMarkerPending = true;
+
+	// terminate current transmissions, discarding the queued bytes wakes up a waiting writing task
+	UInt8 discarded;
+	while(transmitQueue.tryRemoveFirst(&discarded))
 	{
-		transmitLength = 0;
-		transmitEvent.signal();
 	}
 }
@@ -5,11 +5,16 @@
 #include "../Communication/Stream.h"
 #include "../multitasking/InterruptHandler.h"
 #include "../multitasking/IntertaskEvent.h"
+#include "../multitasking/IntertaskRingQueue.h"
+#include "../multitasking/MemberDeferredWork.h"
 
 //------------------------------------------------------------------------------------------------
 // * class Sa1110UartPort
 //
 // Provides an interface to SA1110 serial ports 1, 2, and 3.
+// The interrupt handler only masks the port's interrupt, the FIFOs are serviced by deferred work.
+// The deferred work hands bytes to and from the reading and writing tasks through ring queues,
+// it is the only producer of the receive queue and the only consumer of the transmit queue.
 //------------------------------------------------------------------------------------------------
 
 class Sa1110UartPort :
@@ -56,10 +61,19 @@ private:
 	// interrupt handling
 	void maskInterrupts();
 	Bool handleInterrupt();
+	void handleDeferredInterrupt();
+	MemberDeferredWork(InterruptWork, Sa1110UartPort, handleDeferredInterrupt);
 
 	// error handling
 	void handleError();
 
+	// types
+	enum
+	{
+		queueCapacity = 256,
+		receiveErrorMarker = 0x100
+	};
+
 	// register accessing
 	enum RegisterAddress
 	{
@@ -77,19 +91,19 @@ private:
 	// representation
 	Port port;
 	UInt registerBase;
+	InterruptWork interruptWork;
 
-	// receive state
-	UInt8 *pReceiveBuffer;
-	UInt receiveLength;
-	IntertaskEvent receiveEvent;
+	// receive state, the received bytes are queued along with markers of errors
+	IntertaskRingQueue<UInt16> receiveQueue;
+	Bool receiverStopped;
 
 	// transmit state
-	const UInt8 *pTransmitBuffer;
-	UInt transmitLength;
-	IntertaskEvent transmitEvent;
+	IntertaskRingQueue<UInt8> transmitQueue;
 
 	// error state
 	Bool inError;
+	Bool errorForced;
+	Bool errorMarkerPending;
 	Bool synchronizing;
 	IntertaskEvent synchronizationEvent;
 };
@@ -2,14 +2,15 @@
 #define _timing_h_
 
 #include "../cPrimitiveTypes.h"
-#include "../Multitasking/TimeValue.h"
+#include "../multitasking/TimeValue.h"
 #if defined(_MSC_VER) && defined(_M_IX86)
 	#include "../arithmetic/constIntLog2.h"
 	#include <windows.h>
 #elif defined(_WIN32_WCE)
 	#include <windows.h>
-#elif defined(_MSC_VER) && defined(_M_ARM) || defined(__ARMCC_VERSION)
-	#include "../Multitasking/TaskScheduler.h"
+#elif defined(_MSC_VER) && defined(_M_ARM) || defined(__ARMCC_VERSION) \
+	|| defined(__x86_64__) && defined(__linux__)
+	#include "../multitasking/TaskScheduler.h"
 #endif
 
 
@@ -39,7 +40,8 @@ inline TimeValue timestamp()
 	#elif defined(_WIN32_WCE)
 		// use Windows API function
 		return GetTickCount();
-	#elif defined(_MSC_VER) && defined(_M_ARM) || defined(__ARMCC_VERSION)
+	#elif defined(_MSC_VER) && defined(_M_ARM) || defined(__ARMCC_VERSION) \
+		|| defined(__x86_64__) && defined(__linux__)
 		// use MSOS function
 		return TaskScheduler::getCurrentTaskScheduler()->getTimer()->getTime();
 	#endif
@@ -61,7 +63,8 @@ inline TimeValue getTimerFrequency()
 	#elif defined(_WIN32_WCE)
 		// use Windows API function
 		return 1000;
-	#elif defined(_MSC_VER) && defined(_M_ARM) || defined(__ARMCC_VERSION)
+	#elif defined(_MSC_VER) && defined(_M_ARM) || defined(__ARMCC_VERSION) \
+		|| defined(__x86_64__) && defined(__linux__)
 		// use MSOS function
 		return TaskScheduler::getCurrentTaskScheduler()->getTimer()->getFrequency();
 	#endif
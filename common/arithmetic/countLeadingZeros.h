@@ -0,0 +1,72 @@
+#ifndef _countLeadingZeros_h_
+#define _countLeadingZeros_h_
+
+#include "../cPrimitiveTypes.h"
+#if defined(_MSC_VER) && !defined(_M_ARM)
+	#include <intrin.h>
+#endif
+
+//------------------------------------------------------------------------------------------------
+// * countLeadingZeros
+//
+// Returns the number of zero bits above the most significant set bit of <x>.
+// Returns 32 if <x> is zero.
+// <x> is treated as a 32-bit value.
+//------------------------------------------------------------------------------------------------
+
+inline UInt countLeadingZeros(UInt x)
+{
+	#if defined(__GNUC__)
+		return x == 0 ? 32 : __builtin_clz(x);
+	#elif defined(_MSC_VER) && !defined(_M_ARM)
+		unsigned long index;
+		return _BitScanReverse(&index, x) ? 31 - index : 32;
+	#else
+		// the processor may not have a clz instruction (ARMv4), use a binary search
+		if(x == 0)
+		{
+			return 32;
+		}
+		UInt count = 0;
+		if((x & 0xFFFF0000) == 0)
+		{
+			count += 16;
+			x <<= 16;
+		}
+		if((x & 0xFF000000) == 0)
+		{
+			count += 8;
+			x <<= 8;
+		}
+		if((x & 0xF0000000) == 0)
+		{
+			count += 4;
+			x <<= 4;
+		}
+		if((x & 0xC0000000) == 0)
+		{
+			count += 2;
+			x <<= 2;
+		}
+		if((x & 0x80000000) == 0)
+		{
+			count += 1;
+		}
+		return count;
+	#endif
+}
+
+//------------------------------------------------------------------------------------------------
+// * indexOfLowestSetBit
+//
+// Returns the index of the least significant set bit of <x>.
+// The result is undefined if <x> is zero.
+//------------------------------------------------------------------------------------------------
+
+inline UInt indexOfLowestSetBit(UInt x)
+{
+	// isolate the lowest set bit
+	return 31 - countLeadingZeros(x & (0 - x));
+}
+
+#endif // _countLeadingZeros_h_
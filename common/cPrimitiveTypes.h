@@ -8,7 +8,11 @@ typedef bool Bool;
 typedef int Int;
 typedef char Int8;
 typedef short Int16;
-typedef long Int32;
+#if defined(__LP64__)
+	typedef int Int32;
+#else
+	typedef long Int32;
+#endif
 #if defined(_MSC_VER)
 	typedef __int64 Int64;
 #else
@@ -18,7 +22,11 @@ typedef long Int32;
 typedef signed int SInt;
 typedef signed char SInt8;
 typedef signed short SInt16;
-typedef signed long SInt32;
+#if defined(__LP64__)
+	typedef signed int SInt32;
+#else
+	typedef signed long SInt32;
+#endif
 #if defined(_MSC_VER)
 	typedef signed __int64 SInt64;
 #else
@@ -28,7 +36,11 @@ typedef signed long SInt32;
 typedef unsigned int UInt;
 typedef unsigned char UInt8;
 typedef unsigned short UInt16;
-typedef unsigned long UInt32;
+#if defined(__LP64__)
+	typedef unsigned int UInt32;
+#else
+	typedef unsigned long UInt32;
+#endif
 #if defined(_MSC_VER)
 	typedef unsigned __int64 UInt64;
 #else
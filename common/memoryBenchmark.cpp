@@ -0,0 +1,378 @@
+#include "multitasking/Task.h"
+#include "multitasking/Timer.h"
+#include "memoryUtilities.h"
+#if defined(_MSC_VER) && defined(_M_IX86) || defined(__GNUC__)
+	#define PRINT
+#endif
+#if defined(PRINT)
+	#if defined(__ARMCC_VERSION) && !defined(std)
+		#define std
+	#endif
+	#include <iostream>
+	#include <stdlib.h>
+#endif
+// memoryUtilities.h declares the library functions itself when it uses them
+#if defined(USE_ANSI_MEMORY_UTILITIES)
+	extern "C" Int memcmp(const void *, const void *, UInt);
+#else
+	#include <string.h>
+#endif
+
+// keep the compiler from turning the byte loops into library calls
+#if defined(__GNUC__)
+	#define BYTE_LOOP __attribute__((optimize("no-tree-loop-distribute-patterns", "no-tree-vectorize")))
+#else
+	#define BYTE_LOOP
+#endif
+
+// buffer sizes from 1 byte to 64 KB, with odd sizes around the block sizes
+static const UInt sizes[] =
+{
+	1, 2, 3, 4, 7, 8, 15, 16, 17, 31, 32, 63, 64, 100, 256, 1000, 1024, 4096, 16384, 65536
+};
+static const UInt numberOfSizes = arrayDimension(sizes);
+static const UInt maximumSize = 65536;
+static const UInt numberOfAlignments = 4;
+static const UInt bytesPerMeasurement = 256 * 1024;
+
+// buffers with room for every alignment
+static UInt32 sourceBuffer[(maximumSize + 2 * numberOfAlignments) / sizeof(UInt32)];
+static UInt32 destinationBuffer[(maximumSize + 2 * numberOfAlignments) / sizeof(UInt32)];
+static UInt32 referenceBuffer[(maximumSize + 2 * numberOfAlignments) / sizeof(UInt32)];
+
+//------------------------------------------------------------------------------------------------
+// * byte at a time reference implementations
+//------------------------------------------------------------------------------------------------
+
+BYTE_LOOP static void byteMemoryCopy(void *destination, const void *source, UInt lengthInBytes)
+{
+	UInt8 *pDestination = (UInt8 *)destination;
+	const UInt8 *pSource = (const UInt8 *)source;
+	while(lengthInBytes > 0)
+	{
+		*(pDestination++) = *(pSource++);
+		--lengthInBytes;
+	}
+}
+
+BYTE_LOOP static void byteMemorySet(void *destination, UInt8 value, UInt lengthInBytes)
+{
+	UInt8 *pDestination = (UInt8 *)destination;
+	while(lengthInBytes > 0)
+	{
+		*(pDestination++) = value;
+		--lengthInBytes;
+	}
+}
+
+BYTE_LOOP static SInt byteMemoryCompare(const void *source1, const void *source2, UInt lengthInBytes)
+{
+	const UInt8 *pSource1 = (const UInt8 *)source1;
+	const UInt8 *pSource2 = (const UInt8 *)source2;
+	while(lengthInBytes > 0)
+	{
+		if(*pSource1 != *pSource2)
+		{
+			return *pSource1 > *pSource2 ? 1 : -1;
+		}
+		++pSource1;
+		++pSource2;
+		--lengthInBytes;
+	}
+	return 0;
+}
+
+static SInt selectedMemoryCompare(const void *source1, const void *source2, UInt lengthInBytes)
+{
+	return arrayCompare((const UInt8 *)source1, (const UInt8 *)source2, lengthInBytes);
+}
+
+static SInt ansiMemoryCompare(const void *source1, const void *source2, UInt lengthInBytes)
+{
+	const SInt result = memcmp(source1, source2, lengthInBytes);
+	return result > 0 ? 1 : result < 0 ? -1 : 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * class MemoryBenchmarkTask
+//------------------------------------------------------------------------------------------------
+
+class MemoryBenchmarkTask : public Task
+{
+public:
+	// constructor
+	MemoryBenchmarkTask();
+
+protected:
+	// main entry point
+	void main();
+
+private:
+	// types
+	enum Operation
+	{
+		copyOperation,
+		setOperation,
+		compareOperation,
+		numberOfOperations
+	};
+	enum Implementation
+	{
+		byteImplementation,
+		selectedImplementation,
+		ansiImplementation,
+		numberOfImplementations
+	};
+
+	// measuring
+	void fillBuffers();
+	UInt measure(Operation operation, Implementation implementation, UInt size);
+	Bool check(Operation operation, UInt size);
+	UInt getMegabytesPerSecond(UInt size, UInt count, TimeValue ticks) const;
+
+	// representation
+	Timer *pTimer;
+	UInt numberOfMismatches;
+	volatile SInt compareResult;
+};
+
+MemoryBenchmarkTask::MemoryBenchmarkTask() :
+	Task(defaultPriority + 1, 10000)
+{
+	pTimer = TaskScheduler::getCurrentTaskScheduler()->getTimer();
+	numberOfMismatches = 0;
+	compareResult = 0;
+}
+
+void MemoryBenchmarkTask::fillBuffers()
+{
+	UInt seed = 1;
+	UInt8 *pSource = (UInt8 *)sourceBuffer;
+	for(UInt i = 0; i < sizeof(sourceBuffer); ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		pSource[i] = (UInt8)(seed >> 24);
+	}
+	byteMemoryCopy(destinationBuffer, sourceBuffer, sizeof(destinationBuffer));
+}
+
+UInt MemoryBenchmarkTask::getMegabytesPerSecond(UInt size, UInt count, TimeValue ticks) const
+{
+	if(ticks <= 0)
+	{
+		ticks = 1;
+	}
+	return (UInt)((UInt64)size * count * pTimer->getFrequency() / ((UInt64)ticks * 1000000));
+}
+
+UInt MemoryBenchmarkTask::measure(Operation operation, Implementation implementation, UInt size)
+{
+	const UInt count = maximum(bytesPerMeasurement / size, (UInt)16);
+	TimeValue ticks = 0;
+
+	// time every combination of source and destination alignment
+	for(UInt sourceAlignment = 0; sourceAlignment < numberOfAlignments; ++sourceAlignment)
+	{
+		for(UInt destinationAlignment = 0; destinationAlignment < numberOfAlignments; ++destinationAlignment)
+		{
+			const UInt8 *pSource = (const UInt8 *)sourceBuffer + sourceAlignment;
+			UInt8 *pDestination = (UInt8 *)destinationBuffer + destinationAlignment;
+			if(operation == compareOperation)
+			{
+				// compare equal buffers, which is the slowest case
+				byteMemoryCopy(pDestination, pSource, size);
+			}
+			const TimeValue startTime = pTimer->getTime();
+			for(UInt i = 0; i < count / (numberOfAlignments * numberOfAlignments) + 1; ++i)
+			{
+				switch(operation * numberOfImplementations + implementation)
+				{
+					case copyOperation * numberOfImplementations + byteImplementation:
+					{
+						byteMemoryCopy(pDestination, pSource, size);
+						break;
+					}
+					case copyOperation * numberOfImplementations + selectedImplementation:
+					{
+						memoryCopy(pDestination, pSource, size);
+						break;
+					}
+					case copyOperation * numberOfImplementations + ansiImplementation:
+					{
+						memcpy(pDestination, pSource, size);
+						break;
+					}
+					case setOperation * numberOfImplementations + byteImplementation:
+					{
+						byteMemorySet(pDestination, (UInt8)i, size);
+						break;
+					}
+					case setOperation * numberOfImplementations + selectedImplementation:
+					{
+						memorySet(pDestination, (UInt8)i, size);
+						break;
+					}
+					case setOperation * numberOfImplementations + ansiImplementation:
+					{
+						memset(pDestination, (UInt8)i, size);
+						break;
+					}
+					case compareOperation * numberOfImplementations + byteImplementation:
+					{
+						compareResult = byteMemoryCompare(pDestination, pSource, size);
+						break;
+					}
+					case compareOperation * numberOfImplementations + selectedImplementation:
+					{
+						compareResult = selectedMemoryCompare(pDestination, pSource, size);
+						break;
+					}
+					default:
+					{
+						compareResult = ansiMemoryCompare(pDestination, pSource, size);
+						break;
+					}
+				}
+			}
+			ticks += compareTimes(pTimer->getTime(), startTime);
+		}
+	}
+	return getMegabytesPerSecond(size, (count / (numberOfAlignments * numberOfAlignments) + 1)
+		* numberOfAlignments * numberOfAlignments, ticks);
+}
+
+Bool MemoryBenchmarkTask::check(Operation operation, UInt size)
+{
+	// check every combination of alignments against the byte at a time implementation
+	for(UInt sourceAlignment = 0; sourceAlignment < numberOfAlignments; ++sourceAlignment)
+	{
+		for(UInt destinationAlignment = 0; destinationAlignment < numberOfAlignments; ++destinationAlignment)
+		{
+			const UInt8 *pSource = (const UInt8 *)sourceBuffer + sourceAlignment;
+			UInt8 *pDestination = (UInt8 *)destinationBuffer + destinationAlignment;
+			UInt8 *pReference = (UInt8 *)referenceBuffer + destinationAlignment;
+			switch(operation)
+			{
+				case copyOperation:
+				{
+					byteMemorySet(destinationBuffer, 0xAA, size + 2 * numberOfAlignments);
+					byteMemorySet(referenceBuffer, 0xAA, size + 2 * numberOfAlignments);
+					memoryCopy(pDestination, pSource, size);
+					byteMemoryCopy(pReference, pSource, size);
+					if(byteMemoryCompare(destinationBuffer, referenceBuffer, size + 2 * numberOfAlignments) != 0)
+					{
+						return false;
+					}
+					break;
+				}
+				case setOperation:
+				{
+					byteMemorySet(destinationBuffer, 0xAA, size + 2 * numberOfAlignments);
+					byteMemorySet(referenceBuffer, 0xAA, size + 2 * numberOfAlignments);
+					memorySet(pDestination, 0x5C, size);
+					byteMemorySet(pReference, 0x5C, size);
+					if(byteMemoryCompare(destinationBuffer, referenceBuffer, size + 2 * numberOfAlignments) != 0)
+					{
+						return false;
+					}
+					break;
+				}
+				default:
+				{
+					// make the buffers equal, then differ at the first, middle and last byte
+					byteMemoryCopy(pDestination, pSource, size);
+					if(selectedMemoryCompare(pDestination, pSource, size) != 0)
+					{
+						return false;
+					}
+					const UInt positions[] = {0, size / 2, size - 1};
+					for(UInt i = 0; i < arrayDimension(positions); ++i)
+					{
+						const UInt8 savedByte = pDestination[positions[i]];
+						pDestination[positions[i]] = (UInt8)(savedByte + 0x80);
+						if(selectedMemoryCompare(pDestination, pSource, size)
+							!= byteMemoryCompare(pDestination, pSource, size))
+						{
+							return false;
+						}
+						pDestination[positions[i]] = savedByte;
+					}
+					break;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void MemoryBenchmarkTask::main()
+{
+	static const char *operationNames[numberOfOperations] = {"copy", "set", "compare"};
+
+	fillBuffers();
+
+	#if defined(PRINT)
+		std::cout << "MB/s over all source and destination alignments, byte loop / selected / ANSI"
+			#if defined(USE_ANSI_MEMORY_UTILITIES)
+				<< " (ANSI)\n";
+			#elif defined(USE_AVX_MEMORY_UTILITIES)
+				<< " (AVX)\n";
+			#elif defined(USE_SSE2_MEMORY_UTILITIES)
+				<< " (SSE2)\n";
+			#elif defined(USE_WIDE_MEMORY_UTILITIES)
+				<< " (words)\n";
+			#else
+				<< " (bytes)\n";
+			#endif
+		std::cout << "size\tcopy\t\t\tset\t\t\tcompare\n";
+	#endif
+
+	for(UInt sizeIndex = 0; sizeIndex < numberOfSizes; ++sizeIndex)
+	{
+		const UInt size = sizes[sizeIndex];
+		#if defined(PRINT)
+			std::cout << size;
+		#endif
+		for(UInt operation = 0; operation < numberOfOperations; ++operation)
+		{
+			if(!check((Operation)operation, size))
+			{
+				++numberOfMismatches;
+				#if defined(PRINT)
+					std::cout << "\n" << operationNames[operation] << " of " << size
+						<< " bytes differs from the byte loop\n";
+				#endif
+			}
+			for(UInt implementation = 0; implementation < numberOfImplementations; ++implementation)
+			{
+				const UInt rate = measure((Operation)operation, (Implementation)implementation, size);
+				#if defined(PRINT)
+					std::cout << (implementation == 0 ? "\t" : " / ") << rate;
+				#endif
+			}
+		}
+		#if defined(PRINT)
+			std::cout << "\n";
+		#endif
+	}
+
+	#if defined(PRINT)
+		std::cout << numberOfMismatches << " mismatches\n";
+		exit(numberOfMismatches == 0 ? 0 : 1);
+	#endif
+}
+
+
+//------------------------------------------------------------------------------------------------
+// * memoryBenchmark
+//------------------------------------------------------------------------------------------------
+
+void memoryBenchmark()
+{
+	(new MemoryBenchmarkTask())->resume();
+
+	// start the RTOS
+	TaskScheduler::getCurrentTaskScheduler()->start();
+
+	// we will never get here
+}
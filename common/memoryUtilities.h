@@ -2,10 +2,395 @@
 #define _memoryUtilities_h_
 
 #include "cPrimitiveTypes.h"
+#include "pointerArithmetic.h"
 
 #if defined(USE_ANSI_MEMORY_UTILITIES)
 	extern "C" void *memcpy(void *, const void *, UInt);
 	extern "C" void *memset(void *, Int, UInt);
+#elif !defined(USE_BYTE_MEMORY_UTILITIES)
+	// move whole words, or vectors where the host has them, through the middle of a buffer
+	#define USE_WIDE_MEMORY_UTILITIES
+	#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP) && _M_IX86_FP >= 2
+		#include <emmintrin.h>
+		#define USE_SSE2_MEMORY_UTILITIES
+	#endif
+	#if defined(__AVX__)
+		#include <immintrin.h>
+		#define USE_AVX_MEMORY_UTILITIES
+	#endif
+
+	// words from a source that is not aligned with the destination are shifted into place
+	#if defined(__ARMCC_VERSION) || defined(__BYTE_ORDER__)
+		#define USE_SHIFTED_MEMORY_COPY
+		#if defined(__ARMCC_VERSION) && defined(__BIG_ENDIAN) \
+			|| defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			#define SHIFT_WORDS_BIG_ENDIAN
+		#endif
+	#endif
+#endif
+
+#if defined(USE_WIDE_MEMORY_UTILITIES)
+
+//------------------------------------------------------------------------------------------------
+// * isWordAligned
+//
+// Tests whether <pointer> is on a multiple of the size of a 32 bit word.
+//------------------------------------------------------------------------------------------------
+
+inline Bool isWordAligned(const void *pointer)
+{
+	return (subtractPointers(pointer, null) & (sizeof(UInt32) - 1)) == 0;
+}
+
+//------------------------------------------------------------------------------------------------
+// * wideMemoryCopy
+//
+// Copies <lengthInBytes> bytes from the <source> buffer to the <destination> buffer, forwards,
+// like the byte loop does, so a destination below an overlapping source is still copied right.
+// The bytes up to a word boundary of the destination are copied one by one, then blocks of four
+// words, which the ARM compiler moves with ldm/stm, and the remaining bytes one by one. If the
+// source is not aligned with the destination, its words are loaded aligned and shifted into
+// place. x86 hosts copy vectors instead, storing them aligned where the copy is long.
+//------------------------------------------------------------------------------------------------
+
+inline void wideMemoryCopy(void *destination, const void *source, UInt lengthInBytes)
+{
+	UInt8 *pDestination = (UInt8 *)destination;
+	const UInt8 *pSource = (const UInt8 *)source;
+
+	#if defined(USE_SSE2_MEMORY_UTILITIES)
+		// vectors at both ends of the copy may overlap the middle, which is only done when that
+		// cannot change what a destination below an overlapping source receives
+		const Bool overlappingVectors = lengthInBytes >= 16
+			&& (pSource >= pDestination + 16 || pSource < pDestination);
+
+		// long copies store aligned vectors
+		if(lengthInBytes >= 64)
+		{
+			if(overlappingVectors)
+			{
+				// copy one unaligned vector and continue from the next vector boundary
+				_mm_storeu_si128((__m128i *)pDestination, _mm_loadu_si128((const __m128i *)pSource));
+				const UInt headLength = 16 - (subtractPointers(pDestination, null) & 15);
+				pDestination += headLength;
+				pSource += headLength;
+				lengthInBytes -= headLength;
+			}
+			else
+			{
+				// copy bytes up to a vector boundary of the destination
+				while((subtractPointers(pDestination, null) & 15) != 0)
+				{
+					*(pDestination++) = *(pSource++);
+					--lengthInBytes;
+				}
+			}
+
+			#if defined(USE_AVX_MEMORY_UTILITIES)
+				// copy blocks of two 32 byte vectors
+				while(lengthInBytes >= 64)
+				{
+					const __m256i vector0 = _mm256_loadu_si256((const __m256i *)pSource);
+					const __m256i vector1 = _mm256_loadu_si256((const __m256i *)(pSource + 32));
+					_mm256_storeu_si256((__m256i *)pDestination, vector0);
+					_mm256_storeu_si256((__m256i *)(pDestination + 32), vector1);
+					pDestination += 64;
+					pSource += 64;
+					lengthInBytes -= 64;
+				}
+			#else
+				// copy blocks of four 16 byte vectors
+				while(lengthInBytes >= 64)
+				{
+					const __m128i vector0 = _mm_loadu_si128((const __m128i *)pSource);
+					const __m128i vector1 = _mm_loadu_si128((const __m128i *)(pSource + 16));
+					const __m128i vector2 = _mm_loadu_si128((const __m128i *)(pSource + 32));
+					const __m128i vector3 = _mm_loadu_si128((const __m128i *)(pSource + 48));
+					_mm_store_si128((__m128i *)pDestination, vector0);
+					_mm_store_si128((__m128i *)(pDestination + 16), vector1);
+					_mm_store_si128((__m128i *)(pDestination + 32), vector2);
+					_mm_store_si128((__m128i *)(pDestination + 48), vector3);
+					pDestination += 64;
+					pSource += 64;
+					lengthInBytes -= 64;
+				}
+			#endif
+		}
+
+		// copy the remaining 16 byte vectors
+		while(lengthInBytes >= 16)
+		{
+			const __m128i vector = _mm_loadu_si128((const __m128i *)pSource);
+			_mm_storeu_si128((__m128i *)pDestination, vector);
+			pDestination += 16;
+			pSource += 16;
+			lengthInBytes -= 16;
+		}
+
+		// copy the last bytes with one vector that ends at the end of the buffers
+		if(lengthInBytes > 0 && overlappingVectors)
+		{
+			_mm_storeu_si128(
+				(__m128i *)(pDestination + lengthInBytes - 16),
+				_mm_loadu_si128((const __m128i *)(pSource + lengthInBytes - 16)));
+			return;
+		}
+	#else
+		// short copies are not worth aligning
+		if(lengthInBytes >= 16)
+		{
+			// copy bytes up to a word boundary of the destination
+			while(!isWordAligned(pDestination))
+			{
+				*(pDestination++) = *(pSource++);
+				--lengthInBytes;
+			}
+
+			UInt32 *pDestinationWord = (UInt32 *)pDestination;
+			if(isWordAligned(pSource))
+			{
+				// copy blocks of four words
+				const UInt32 *pSourceWord = (const UInt32 *)pSource;
+				while(lengthInBytes >= 4 * sizeof(UInt32))
+				{
+					const UInt32 word0 = pSourceWord[0];
+					const UInt32 word1 = pSourceWord[1];
+					const UInt32 word2 = pSourceWord[2];
+					const UInt32 word3 = pSourceWord[3];
+					pDestinationWord[0] = word0;
+					pDestinationWord[1] = word1;
+					pDestinationWord[2] = word2;
+					pDestinationWord[3] = word3;
+					pDestinationWord += 4;
+					pSourceWord += 4;
+					lengthInBytes -= 4 * sizeof(UInt32);
+				}
+
+				// copy the remaining words
+				while(lengthInBytes >= sizeof(UInt32))
+				{
+					*(pDestinationWord++) = *(pSourceWord++);
+					lengthInBytes -= sizeof(UInt32);
+				}
+				pSource = (const UInt8 *)pSourceWord;
+			}
+			#if defined(USE_SHIFTED_MEMORY_COPY)
+				else
+				{
+					// load aligned words that straddle the source and shift them into place,
+					// never loading beyond the word that holds the last byte needed
+					const UInt offset = subtractPointers(pSource, null) & (sizeof(UInt32) - 1);
+					const UInt32 *pSourceWord = (const UInt32 *)(pSource - offset);
+					const UInt firstShift = offset * 8;
+					const UInt secondShift = 32 - firstShift;
+					UInt32 word = *(pSourceWord++);
+					while(lengthInBytes >= sizeof(UInt32))
+					{
+						const UInt32 nextWord = *(pSourceWord++);
+						#if defined(SHIFT_WORDS_BIG_ENDIAN)
+							*(pDestinationWord++) = (word << firstShift) | (nextWord >> secondShift);
+						#else
+							*(pDestinationWord++) = (word >> firstShift) | (nextWord << secondShift);
+						#endif
+						word = nextWord;
+						lengthInBytes -= sizeof(UInt32);
+					}
+					pSource = (const UInt8 *)pSourceWord - sizeof(UInt32) + offset;
+				}
+			#endif
+			pDestination = (UInt8 *)pDestinationWord;
+		}
+	#endif
+
+	// copy the remaining bytes
+	while(lengthInBytes > 0)
+	{
+		*(pDestination++) = *(pSource++);
+		--lengthInBytes;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * wideMemorySet
+//
+// Copies <value> into the first <lengthInBytes> bytes of the <destination> buffer.
+// The bytes up to a word boundary are set one by one, then blocks of four words and the
+// remaining bytes. x86 hosts store vectors instead, aligned where the buffer is long.
+//------------------------------------------------------------------------------------------------
+
+inline void wideMemorySet(void *destination, UInt8 value, UInt lengthInBytes)
+{
+	UInt8 *pDestination = (UInt8 *)destination;
+
+	#if defined(USE_SSE2_MEMORY_UTILITIES)
+		const __m128i vector = _mm_set1_epi8((char)value);
+
+		// long buffers are set with aligned vectors
+		if(lengthInBytes >= 64)
+		{
+			// set one unaligned vector and continue from the next vector boundary
+			_mm_storeu_si128((__m128i *)pDestination, vector);
+			const UInt headLength = 16 - (subtractPointers(pDestination, null) & 15);
+			pDestination += headLength;
+			lengthInBytes -= headLength;
+
+			#if defined(USE_AVX_MEMORY_UTILITIES)
+				// set blocks of two 32 byte vectors
+				const __m256i wideVector = _mm256_set1_epi8((char)value);
+				while(lengthInBytes >= 64)
+				{
+					_mm256_storeu_si256((__m256i *)pDestination, wideVector);
+					_mm256_storeu_si256((__m256i *)(pDestination + 32), wideVector);
+					pDestination += 64;
+					lengthInBytes -= 64;
+				}
+			#else
+				// set blocks of four 16 byte vectors
+				while(lengthInBytes >= 64)
+				{
+					_mm_store_si128((__m128i *)pDestination, vector);
+					_mm_store_si128((__m128i *)(pDestination + 16), vector);
+					_mm_store_si128((__m128i *)(pDestination + 32), vector);
+					_mm_store_si128((__m128i *)(pDestination + 48), vector);
+					pDestination += 64;
+					lengthInBytes -= 64;
+				}
+			#endif
+		}
+
+		// set the remaining 16 byte vectors
+		while(lengthInBytes >= 16)
+		{
+			_mm_storeu_si128((__m128i *)pDestination, vector);
+			pDestination += 16;
+			lengthInBytes -= 16;
+		}
+
+		// set the last bytes with one vector that ends at the end of the buffer
+		if(lengthInBytes > 0 && pDestination - (UInt8 *)destination >= 16)
+		{
+			_mm_storeu_si128((__m128i *)(pDestination + lengthInBytes - 16), vector);
+			return;
+		}
+	#else
+		// short buffers are not worth aligning
+		if(lengthInBytes >= 16)
+		{
+			// set bytes up to a word boundary
+			while(!isWordAligned(pDestination))
+			{
+				*(pDestination++) = value;
+				--lengthInBytes;
+			}
+
+			// set blocks of four words
+			const UInt32 word = value * (UInt32)0x01010101;
+			UInt32 *pDestinationWord = (UInt32 *)pDestination;
+			while(lengthInBytes >= 4 * sizeof(UInt32))
+			{
+				pDestinationWord[0] = word;
+				pDestinationWord[1] = word;
+				pDestinationWord[2] = word;
+				pDestinationWord[3] = word;
+				pDestinationWord += 4;
+				lengthInBytes -= 4 * sizeof(UInt32);
+			}
+
+			// set the remaining words
+			while(lengthInBytes >= sizeof(UInt32))
+			{
+				*(pDestinationWord++) = word;
+				lengthInBytes -= sizeof(UInt32);
+			}
+			pDestination = (UInt8 *)pDestinationWord;
+		}
+	#endif
+
+	// set the remaining bytes
+	while(lengthInBytes > 0)
+	{
+		*(pDestination++) = value;
+		--lengthInBytes;
+	}
+}
+
+//------------------------------------------------------------------------------------------------
+// * wideMemoryCompare
+//
+// Lexicographicaly compares the first <lengthInBytes> bytes of <source1> and <source2>, the
+// same way arrayCompare does.
+// Equal words, or vectors on x86 hosts, are skipped as a whole, the bytes where the sources
+// differ are compared one by one. Sources that are not aligned with each other are compared
+// byte by byte on ARM.
+//------------------------------------------------------------------------------------------------
+
+inline SInt wideMemoryCompare(const void *source1, const void *source2, UInt lengthInBytes)
+{
+	const UInt8 *pSource1 = (const UInt8 *)source1;
+	const UInt8 *pSource2 = (const UInt8 *)source2;
+
+	#if defined(USE_SSE2_MEMORY_UTILITIES)
+		// skip equal 16 byte vectors
+		while(lengthInBytes >= 16)
+		{
+			const __m128i vector1 = _mm_loadu_si128((const __m128i *)pSource1);
+			const __m128i vector2 = _mm_loadu_si128((const __m128i *)pSource2);
+			if(_mm_movemask_epi8(_mm_cmpeq_epi8(vector1, vector2)) != 0xFFFF)
+			{
+				// the sources differ within this vector
+				break;
+			}
+			pSource1 += 16;
+			pSource2 += 16;
+			lengthInBytes -= 16;
+		}
+	#else
+		// short or mutually unaligned sources are compared byte by byte
+		if(lengthInBytes >= 16
+			&& ((subtractPointers(pSource1, null) ^ subtractPointers(pSource2, null))
+				& (sizeof(UInt32) - 1)) == 0)
+		{
+			// skip equal bytes up to a word boundary
+			while(!isWordAligned(pSource1) && *pSource1 == *pSource2)
+			{
+				++pSource1;
+				++pSource2;
+				--lengthInBytes;
+			}
+
+			// skip equal words
+			if(isWordAligned(pSource1))
+			{
+				const UInt32 *pSourceWord1 = (const UInt32 *)pSource1;
+				const UInt32 *pSourceWord2 = (const UInt32 *)pSource2;
+				while(lengthInBytes >= sizeof(UInt32) && *pSourceWord1 == *pSourceWord2)
+				{
+					++pSourceWord1;
+					++pSourceWord2;
+					lengthInBytes -= sizeof(UInt32);
+				}
+				pSource1 = (const UInt8 *)pSourceWord1;
+				pSource2 = (const UInt8 *)pSourceWord2;
+			}
+		}
+	#endif
+
+	// compare the remaining bytes
+	while(lengthInBytes > 0)
+	{
+		if(*pSource1 != *pSource2)
+		{
+			return *pSource1 > *pSource2 ? 1 : -1;
+		}
+		++pSource1;
+		++pSource2;
+		--lengthInBytes;
+	}
+
+	// no differences encounterred
+	return 0;
+}
+
 #endif
 
 //------------------------------------------------------------------------------------------------
@@ -34,6 +419,8 @@ inline void memoryCopy(void *destination, const void *source, UInt lengthInBytes
 {
 	#if defined(USE_ANSI_MEMORY_UTILITIES)
 		memcpy(destination, source, lengthInBytes);
+	#elif defined(USE_WIDE_MEMORY_UTILITIES)
+		wideMemoryCopy(destination, source, lengthInBytes);
 	#else
 		arrayCopy((UInt8 *)destination, (const UInt8 *)source, lengthInBytes);
 	#endif
@@ -81,13 +468,15 @@ inline void memorySet(void *destination, UInt8 value, UInt lengthInBytes)
 {
 	#if defined(USE_ANSI_MEMORY_UTILITIES)
 		memset(destination, value, lengthInBytes);
+	#elif defined(USE_WIDE_MEMORY_UTILITIES)
+		wideMemorySet(destination, value, lengthInBytes);
 	#else
 		arraySet((UInt8 *)destination, value, lengthInBytes);
 	#endif
 }
 
 //------------------------------------------------------------------------------------------------
-// * memorySet
+// * memoryZero
 //
 // Writes zeros into the first <lengthInBytes> bytes of the <destination> buffer.
 //------------------------------------------------------------------------------------------------
@@ -96,6 +485,8 @@ inline void memoryZero(void *destination, UInt lengthInBytes)
 {
 	#if defined(USE_ANSI_MEMORY_UTILITIES)
 		memset(destination, 0, lengthInBytes);
+	#elif defined(USE_WIDE_MEMORY_UTILITIES)
+		wideMemorySet(destination, 0, lengthInBytes);
 	#else
 		arraySet((UInt8 *)destination, (UInt8)0, lengthInBytes);
 	#endif
@@ -140,6 +531,23 @@ SInt arrayCompare(const T *source1, const T *source2, UInt length)
 	return 0;
 }
 
+#if defined(USE_WIDE_MEMORY_UTILITIES)
+
+//------------------------------------------------------------------------------------------------
+// * arrayCompare
+//
+// Lexicographicaly compares two byte arrays <source1> and <source2> of the same <length>, a
+// word or vector at a time.
+//------------------------------------------------------------------------------------------------
+
+template<>
+inline SInt arrayCompare(const UInt8 *source1, const UInt8 *source2, UInt length)
+{
+	return wideMemoryCompare(source1, source2, length);
+}
+
+#endif
+
 //------------------------------------------------------------------------------------------------
 // * findElementInArray
 //
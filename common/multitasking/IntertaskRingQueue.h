@@ -0,0 +1,5 @@
+#include "multitaskingCommon.h"
+
+#if defined(MSOS_MULTITASKING)
+	#include "../MsosMultitasking/IntertaskRingQueue.h"
+#endif
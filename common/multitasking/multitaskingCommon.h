@@ -2,6 +2,8 @@
 
 #if defined(_MSC_VER) && defined(_M_ARM) && !defined(UNDER_CE) || defined(__ARMCC_VERSION)
 	#define MSOS_MULTITASKING
+#elif defined(__x86_64__) && defined(__linux__)
+	#define MSOS_MULTITASKING
 #elif defined(WIN32)
 	#define WIN32_MULTITASKING
 #elif defined(UNDER_CE)
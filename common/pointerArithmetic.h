@@ -35,7 +35,7 @@ inline TPointer *subtractFromPointer(const TPointer *aPointer, TInteger anIntege
 
 inline SInt subtractPointers(const void *aPointer, const void *anotherPointer)
 {
-	return (SInt)aPointer - (SInt)anotherPointer;
+	return (SInt)((const UInt8 *)aPointer - (const UInt8 *)anotherPointer);
 }
 
 //------------------------------------------------------------------------------------------------
@@ -44,6 +44,6 @@ inline SInt subtractPointers(const void *aPointer, const void *anotherPointer)
 // Returns the offset in bytes to a member of a class or structure.
 //------------------------------------------------------------------------------------------------
 
-#define offsetToMember(Type, member) ((SInt)&(((Type *)null)->member))
+#define offsetToMember(Type, member) ((SInt)((UInt8 *)&(((Type *)null)->member) - (UInt8 *)null))
 
 #endif // _pointerArithmetic_h_
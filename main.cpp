@@ -6,9 +6,95 @@
 
 Int main()
 {
-	// run a simple multitasking test
-	extern void rtosTest();
-	rtosTest();
+	#if defined(CONTEXT_SWITCH_BENCHMARK)
+		// time task switches by yielding, by synchronizers and from the timer interrupt
+		extern void contextSwitchBenchmark();
+		contextSwitchBenchmark();
+	#elif defined(READY_QUEUE_BENCHMARK)
+		// time taking tasks out of the ready queue and switching with more and more tasks ready
+		extern void readyQueueBenchmark();
+		readyQueueBenchmark();
+	#elif defined(INTERRUPT_LATENCY_BENCHMARK)
+		// time the interrupt latency next to interrupts which service their device directly or defer it
+		extern void interruptLatencyBenchmark();
+		interruptLatencyBenchmark();
+	#elif defined(TIMER_BENCHMARK)
+		// time a few thousand concurrent timeouts
+		extern void timerBenchmark();
+		timerBenchmark();
+	#elif defined(TIME_SLICE_TEST)
+		// check that equal priority tasks take turns, and that only they start the time slice
+		extern void timeSliceTest();
+		timeSliceTest();
+	#elif defined(STACK_USAGE_TEST)
+		// check the peak stack usage found on painted heap and caller supplied stacks
+		extern void stackUsageTest();
+		stackUsageTest();
+	#elif defined(PRIORITY_INHERITANCE_TEST)
+		// time how long a realtime task is blocked through a chain of priority mutexes
+		extern void priorityInheritanceTest();
+		priorityInheritanceTest();
+	#elif defined(QUEUE_BENCHMARK)
+		// compare moving single elements and batches through an intertask queue
+		extern void queueBenchmark();
+		queueBenchmark();
+	#elif defined(RING_QUEUE_TEST)
+		// check that a ring queue passes every item from an interrupt handler to a task in order
+		extern void ringQueueTest();
+		ringQueueTest();
+	#elif defined(OBJECT_POOL_TEST)
+		// check acquiring from and releasing to an object pool, with and without blocking
+		extern void objectPoolTest();
+		objectPoolTest();
+	#elif defined(SLAB_BENCHMARK)
+		// compare the slab allocator in front of the heap with the heap alone
+		extern void slabBenchmark();
+		slabBenchmark();
+	#elif defined(HEAP_TIMING_TEST)
+		// time the worst case allocations and frees of the heap selected by HEAPTYPE
+		extern void heapTimingTest();
+		heapTimingTest();
+	#elif defined(HEAP_BENCHMARK)
+		// compare all of the heap types on synthetic workloads and a recorded trace
+		extern void heapBenchmark();
+		heapBenchmark();
+	#elif defined(MEMORY_BENCHMARK)
+		// compare the memory utilities with byte loops over all sizes and alignments
+		extern void memoryBenchmark();
+		memoryBenchmark();
+	#elif defined(CRC_BENCHMARK)
+		// compare the CRC table strategies for CRC16 and CRC32
+		extern void crcBenchmark();
+		crcBenchmark();
+	#elif defined(WINDOW_BENCHMARK)
+		// compare the throughput of packet pipeline depths over links with growing round trip times
+		extern void windowBenchmark();
+		windowBenchmark();
+	#elif defined(RETRANSMISSION_BENCHMARK)
+		// compare the goodput of selective retransmission and resynchronization over links with bit errors
+		extern void retransmissionBenchmark();
+		retransmissionBenchmark();
+	#elif defined(COALESCING_BENCHMARK)
+		// compare the message rates of small messages with and without coalescing packets into one write
+		extern void coalescingBenchmark();
+		coalescingBenchmark();
+	#elif defined(ZERO_COPY_BENCHMARK)
+		// compare the copies made by reading and writing channels with reserving and borrowing packet data
+		extern void zeroCopyBenchmark();
+		zeroCopyBenchmark();
+	#elif defined(CHANNEL_ID_BENCHMARK)
+		// compare the message rates of many channels with extended channel IDs
+		extern void channelIdBenchmark();
+		channelIdBenchmark();
+	#elif defined(PRIORITY_BENCHMARK)
+		// compare the latency of a control channel alongside a bulk channel with and without priority
+		extern void priorityBenchmark();
+		priorityBenchmark();
+	#else
+		// run a simple multitasking test
+		extern void rtosTest();
+		rtosTest();
+	#endif
 
 	// we will never get here
 	return 0;